@@ -0,0 +1,200 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Per-evaluation cost of the math kernels and cost functors in ceres_costs_utils.hpp.
+ *
+ * Kernels are timed with double and with ceres::Jet, the type autodiff feeds them.
+ * Functors are timed through their AutoDiffCostFunction, evaluate only (double) and
+ * evaluate plus Jacobian (Jet), one benchmark per Cost_function type.
+ *
+ * Write machine readable results with the usual Google Benchmark flags, for example
+ *   cost_functor_benchmark --benchmark_out=costs.json --benchmark_out_format=json
+ * or build the run_cost_functor_benchmark target.
+ */
+
+#include <benchmark/benchmark.h>
+#include <industrial_extrinsic_cal/ceres_costs_utils.hpp>
+#include <industrial_extrinsic_cal/synthetic_job.h>
+#include "ceres/jet.h"
+#include <vector>
+
+using namespace industrial_extrinsic_cal;
+
+namespace
+{
+  /* enough derivatives for a pose, the smallest block most functors differentiate */
+  typedef ceres::Jet<double, 6> Jet6;
+
+  /* seeds the first 6 values with unit derivatives, like autodiff does for a pose block */
+  template<typename T> void fill(const double *values, int n, T *out)
+  {
+    for(int i=0; i<n; i++) out[i] = T(values[i]);
+  }
+  template<> void fill<Jet6>(const double *values, int n, Jet6 *out)
+  {
+    for(int i=0; i<n; i++) out[i] = (i < 6) ? Jet6(values[i], i) : Jet6(values[i]);
+  }
+
+  const double ANGLE_AXIS_AND_POINT[9] = { 0.1, -0.2, 0.3, 0.05, -0.1, 1.2, 0.02, 0.03, 0.0 };
+  const double INTRINSICS_AND_OBS[11] = { 525.0, 525.0, 320.0, 240.0, -0.05, 0.01, 0.0, 0.001, -0.001, 330.0, 250.0 };
+
+  template<typename T> void BM_RotationProduct(benchmark::State &state)
+  {
+    const double aa1[3] = { 0.1, -0.2, 0.3 };
+    const double aa2[3] = { -0.4, 0.1, 0.2 };
+    double R1d[9], R2d[9];
+    ceres::AngleAxisToRotationMatrix(aa1, R1d);
+    ceres::AngleAxisToRotationMatrix(aa2, R2d);
+    T R1[9], R2[9], R3[9];
+    fill(R1d, 9, R1);
+    fill(R2d, 9, R2);
+    while(state.KeepRunning()){
+      rotationProduct(R1, R2, R3);
+      benchmark::DoNotOptimize(R3);
+    }
+  }
+
+  template<typename T> void BM_TransformPoint(benchmark::State &state)
+  {
+    T values[9], t_point[3];
+    fill(ANGLE_AXIS_AND_POINT, 9, values);
+    while(state.KeepRunning()){
+      transformPoint(&values[0], &values[3], &values[6], t_point);
+      benchmark::DoNotOptimize(t_point);
+    }
+  }
+
+  template<typename T> void BM_PoseTransformPoint(benchmark::State &state)
+  {
+    Pose6d pose(0.05, -0.1, 1.2, 0.1, -0.2, 0.3);
+    T point[3], t_point[3];
+    fill(&ANGLE_AXIS_AND_POINT[6], 3, point);
+    while(state.KeepRunning()){
+      poseTransformPoint(pose, point, t_point);
+      benchmark::DoNotOptimize(t_point);
+    }
+  }
+
+  template<typename T> void BM_CameraPntResidualDist(benchmark::State &state)
+  {
+    const double camera_point[3] = { 0.05, -0.1, 1.2 };
+    T point[3], p[11], residual[2];
+    fill(camera_point, 3, point);
+    fill(INTRINSICS_AND_OBS, 11, p);
+    while(state.KeepRunning()){
+      cameraPntResidualDist(point, p[4], p[5], p[6], p[7], p[8], p[0], p[1], p[2], p[3], p[9], p[10], residual);
+      benchmark::DoNotOptimize(residual);
+    }
+  }
+
+  template<typename T> void BM_CameraCircResidualDist(benchmark::State &state)
+  {
+    const double camera_point[3] = { 0.05, -0.1, 1.2 };
+    const double aa[3] = { 0.1, -0.2, 0.3 };
+    double Rd[9];
+    ceres::AngleAxisToRotationMatrix(aa, Rd);
+    T point[3], R[9], p[11], residual[2];
+    fill(camera_point, 3, point);
+    fill(Rd, 9, R);
+    fill(INTRINSICS_AND_OBS, 11, p);
+    T circle_diameter(0.02);
+    while(state.KeepRunning()){
+      cameraCircResidualDist(point, circle_diameter, R, p[4], p[5], p[6], p[7], p[8],
+			     p[0], p[1], p[2], p[3], p[9], p[10], residual);
+      benchmark::DoNotOptimize(residual);
+    }
+  }
+
+  /* one observation of the given cost type together with the blocks it reads */
+  class FunctorFixture
+  {
+  public:
+    explicit FunctorFixture(Cost_function cost_type) : job_(parameters(cost_type)), cost_function_(NULL)
+    {
+      if(!job_.generate()) return;
+      const ObservationDataPoint &ODP = job_.observations().items_[0];
+      cost_function_ = createObservationCost(ODP, ODP.camera_extrinsics_, ODP.camera_intrinsics_,
+					     ODP.target_pose_, ODP.point_position_, blocks_);
+      const std::vector<ceres::int32> &sizes = cost_function_->parameter_block_sizes();
+      jacobian_storage_.reserve(sizes.size()); // no reallocation, the pointers below stay valid
+      for(int i=0; i<(int)sizes.size(); i++){
+	jacobian_storage_.push_back(std::vector<double>(sizes[i]*cost_function_->num_residuals()));
+	jacobians_.push_back(&jacobian_storage_.back()[0]);
+      }
+    };
+
+    ~FunctorFixture(){ delete cost_function_; };
+
+    bool valid() const { return(cost_function_ != NULL); };
+
+    void evaluate(bool with_jacobian)
+    {
+      cost_function_->Evaluate(&blocks_[0], residual_, with_jacobian ? &jacobians_[0] : NULL);
+      benchmark::DoNotOptimize(residual_);
+    };
+
+  private:
+    static SyntheticJobParameters parameters(Cost_function cost_type)
+    {
+      SyntheticJobParameters p = defaultSyntheticJobParameters();
+      p.num_cameras = 1;
+      p.num_scenes = 1;
+      p.cost_type = cost_type;
+      return(p);
+    };
+
+    SyntheticJob job_;
+    ceres::CostFunction *cost_function_;
+    std::vector<P_BLOCK> blocks_;
+    std::vector<std::vector<double> > jacobian_storage_;
+    std::vector<double*> jacobians_;
+    double residual_[2];
+  };
+
+  void runFunctor(benchmark::State &state, bool with_jacobian)
+  {
+    Cost_function cost_type = (Cost_function) state.range(0);
+    FunctorFixture fixture(cost_type);
+    if(!fixture.valid()){
+      state.SkipWithError("no observation generated");
+      return;
+    }
+    state.SetLabel(costType2String(cost_type));
+    while(state.KeepRunning()){
+      fixture.evaluate(with_jacobian);
+    }
+  }
+
+  void BM_FunctorEvaluate(benchmark::State &state){ runFunctor(state, false); }
+  void BM_FunctorEvaluateJacobian(benchmark::State &state){ runFunctor(state, true); }
+}
+
+BENCHMARK_TEMPLATE(BM_RotationProduct, double);
+BENCHMARK_TEMPLATE(BM_RotationProduct, Jet6);
+BENCHMARK_TEMPLATE(BM_TransformPoint, double);
+BENCHMARK_TEMPLATE(BM_TransformPoint, Jet6);
+BENCHMARK_TEMPLATE(BM_PoseTransformPoint, double);
+BENCHMARK_TEMPLATE(BM_PoseTransformPoint, Jet6);
+BENCHMARK_TEMPLATE(BM_CameraPntResidualDist, double);
+BENCHMARK_TEMPLATE(BM_CameraPntResidualDist, Jet6);
+BENCHMARK_TEMPLATE(BM_CameraCircResidualDist, double);
+BENCHMARK_TEMPLATE(BM_CameraCircResidualDist, Jet6);
+BENCHMARK(BM_FunctorEvaluate)->DenseRange(0, cost_functions::NullCostType - 1);
+BENCHMARK(BM_FunctorEvaluateJacobian)->DenseRange(0, cost_functions::NullCostType - 1);
+
+BENCHMARK_MAIN();
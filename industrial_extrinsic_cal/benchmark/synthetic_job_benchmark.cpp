@@ -0,0 +1,197 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Times problem construction and solving of synthetic jobs, for each cost type and linear solver.
+ *
+ * usage: synthetic_job_benchmark [--cameras N] [--scenes M] [--rows R] [--cols C]
+ *                                [--noise pixels] [--outliers fraction] [--cost_type name|all]
+ *                                [--solver name|all] [--seed S] [--rotation_cache 0|1]
+ *                                [--loss none|huber|cauchy] [--loss_scale pixels] [--trim_rounds N]
+ *                                [--schur_ordering 0|1] [--csv file]
+ */
+
+#include <industrial_extrinsic_cal/synthetic_job.h>
+#include <industrial_extrinsic_cal/rotation_cache.h>
+#include <industrial_extrinsic_cal/robust_loss.h>
+#include <industrial_extrinsic_cal/outlier_trimmer.h>
+#include <boost/chrono.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace industrial_extrinsic_cal;
+
+namespace
+{
+  typedef struct
+  {
+    const char *name;
+    ceres::LinearSolverType type;
+  } SolverEntry;
+
+  const SolverEntry SOLVERS[] = {
+    { "DENSE_QR", ceres::DENSE_QR },
+    { "DENSE_NORMAL_CHOLESKY", ceres::DENSE_NORMAL_CHOLESKY },
+    { "SPARSE_NORMAL_CHOLESKY", ceres::SPARSE_NORMAL_CHOLESKY },
+    { "DENSE_SCHUR", ceres::DENSE_SCHUR },
+    { "SPARSE_SCHUR", ceres::SPARSE_SCHUR },
+    { "ITERATIVE_SCHUR", ceres::ITERATIVE_SCHUR },
+    { "CGNR", ceres::CGNR }
+  };
+  const int NUM_SOLVERS = sizeof(SOLVERS)/sizeof(SOLVERS[0]);
+
+  double elapsedMs(boost::chrono::steady_clock::time_point start)
+  {
+    using namespace boost::chrono;
+    return(duration_cast<microseconds>(steady_clock::now() - start).count()/1000.0);
+  }
+
+  void usage(const char *program)
+  {
+    fprintf(stderr, "usage: %s [--cameras N] [--scenes M] [--rows R] [--cols C] [--noise pixels]\n"
+	    "          [--outliers fraction] [--cost_type name|all] [--solver name|all] [--seed S]\n"
+	    "          [--rotation_cache 0|1] [--loss none|huber|cauchy] [--loss_scale pixels] [--trim_rounds N]\n"
+	    "          [--schur_ordering 0|1] [--csv file]\n",
+	    program);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  SyntheticJobParameters parameters = defaultSyntheticJobParameters();
+  std::string cost_type_arg("all");
+  std::string solver_arg("all");
+  std::string csv_file;
+  bool use_rotation_cache = true;
+  bool use_schur_ordering = true;
+  OutlierTrimParameters trim = defaultOutlierTrimParameters();
+  RobustLoss loss;
+  loss.type = loss_functions::NoLoss;
+  loss.scale = 1.0;
+
+  for(int i=1; i<argc; i++){
+    if(i+1 >= argc){ usage(argv[0]); return(1); }
+    std::string key(argv[i]);
+    const char *value = argv[++i];
+    if(key == "--cameras") parameters.num_cameras = atoi(value);
+    else if(key == "--scenes") parameters.num_scenes = atoi(value);
+    else if(key == "--rows") parameters.target_rows = atoi(value);
+    else if(key == "--cols") parameters.target_cols = atoi(value);
+    else if(key == "--noise") parameters.pixel_noise = atof(value);
+    else if(key == "--outliers") parameters.outlier_fraction = atof(value);
+    else if(key == "--seed") parameters.seed = atoi(value);
+    else if(key == "--cost_type") cost_type_arg = value;
+    else if(key == "--solver") solver_arg = value;
+    else if(key == "--rotation_cache") use_rotation_cache = (atoi(value) != 0);
+    else if(key == "--schur_ordering") use_schur_ordering = (atoi(value) != 0);
+    else if(key == "--loss"){
+      std::string loss_name(value);
+      loss.type = string2LossType(loss_name);
+      if(loss.type == loss_functions::NullLossType){ usage(argv[0]); return(1); }
+    }
+    else if(key == "--loss_scale") loss.scale = atof(value);
+    else if(key == "--trim_rounds") trim.max_rounds = atoi(value);
+    else if(key == "--csv") csv_file = value;
+    else { usage(argv[0]); return(1); }
+  }
+
+  std::vector<Cost_function> cost_types;
+  if(cost_type_arg == "all"){
+    for(int i=0; i<(int)cost_functions::NullCostType; i++) cost_types.push_back((Cost_function) i);
+  }
+  else{
+    Cost_function cost_type = string2CostType(cost_type_arg);
+    if(cost_type == cost_functions::NullCostType){
+      fprintf(stderr, "unknown cost type %s\n", cost_type_arg.c_str());
+      return(1);
+    }
+    cost_types.push_back(cost_type);
+  }
+
+  std::ofstream csv;
+  if(!csv_file.empty()){
+    csv.open(csv_file.c_str());
+    csv << "cost_type,solver,cameras,scenes,residual_blocks,parameter_blocks,build_ms,solve_ms,"
+	<< "iterations,initial_cost,final_cost,camera_position_error,usable,trimmed\n";
+  }
+
+  printf("%-46s %-24s %8s %10s %10s %6s %12s %12s\n", "cost_type", "solver", "residual",
+	 "build(ms)", "solve(ms)", "iter", "final_cost", "cam_err(m)");
+  for(int c=0; c<(int)cost_types.size(); c++){
+    parameters.cost_type = cost_types[c];
+    std::string cost_name = costType2String(cost_types[c]);
+    SyntheticJob job(parameters);
+    RobustLossTable losses;
+    losses.setDefault(loss);
+    job.setRobustLosses(losses);
+    if(!job.generate()){
+      printf("%-46s no observations generated\n", cost_name.c_str());
+      continue;
+    }
+
+    for(int s=0; s<NUM_SOLVERS; s++){
+      if(solver_arg != "all" && solver_arg != SOLVERS[s].name) continue;
+      job.reset();
+
+      boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+      ceres::Problem problem(trimProblemOptions());
+      RotationCache rotation_cache;
+      std::vector<ObservationResidual> residuals;
+      job.addToProblem(problem, use_rotation_cache ? &rotation_cache : NULL, &residuals);
+      double build_ms = elapsedMs(start);
+
+      ceres::Solver::Options options;
+      options.linear_solver_type = SOLVERS[s].type;
+      options.max_num_iterations = 200;
+      options.minimizer_progress_to_stdout = false;
+      if(use_rotation_cache) rotation_cache.attach(options);
+      if(use_schur_ordering){
+	SchurOrdering ordering;
+	job.addSchurEliminationBlocks(ordering);
+	ordering.apply(problem, options);
+      }
+      std::string invalid_reason;
+      if(!options.IsValid(&invalid_reason)){
+	printf("%-46s %-24s unavailable: %s\n", cost_name.c_str(), SOLVERS[s].name, invalid_reason.c_str());
+	continue;
+      }
+
+      ceres::Solver::Summary summary;
+      start = boost::chrono::steady_clock::now();
+      OutlierTrimmer trimmer(trim);
+      trimmer.solve(problem, residuals, options, summary);
+      double solve_ms = elapsedMs(start);
+      double camera_error = job.cameraPositionError();
+
+      printf("%-46s %-24s %8d %10.3lf %10.3lf %6d %12.4le %12.5lf%s\n", cost_name.c_str(), SOLVERS[s].name,
+	     problem.NumResidualBlocks(), build_ms, solve_ms, (int)summary.iterations.size(),
+	     summary.final_cost, camera_error, summary.IsSolutionUsable() ? "" : " (failed)");
+      if(csv.is_open()){
+	csv << cost_name << "," << SOLVERS[s].name << "," << parameters.num_cameras << ","
+	    << parameters.num_scenes << "," << problem.NumResidualBlocks() << ","
+	    << problem.NumParameterBlocks() << "," << build_ms << "," << solve_ms << ","
+	    << summary.iterations.size() << "," << summary.initial_cost << "," << summary.final_cost << ","
+	    << camera_error << "," << (summary.IsSolutionUsable() ? 1 : 0) << "," << trimmer.trimmed().size() << "\n";
+      }
+    }
+  }
+  return(0);
+}
@@ -20,8 +20,8 @@
 #define BASIC_TYPES_H_
 
 #include <vector>
+#include <string>
 #include <boost/shared_ptr.hpp>
-#include <tf/LinearMath/Matrix3x3.h>
 
 namespace industrial_extrinsic_cal
 {
@@ -52,6 +52,14 @@ namespace industrial_extrinsic_cal
     };
   } Point3d;
 
+  /*! Brief RotationMatrix a 3x3 rotation indexed as R[row][col], like tf::Matrix3x3 but without the ROS dependency */
+  typedef struct RotationMatrix
+  {
+    double m[3][3]; /**< row major elements */
+    double* operator[](int row) { return(m[row]); };
+    const double* operator[](int row) const { return(m[row]); };
+  } RotationMatrix;
+
   /*! Brief Pose6d defines a ceres_structure for a pose in 3D space 
    *   x,y,z have their natrual meanging
    *   ax,ay,az define the rotation part of the pose using angle axis notation
@@ -72,15 +80,15 @@ namespace industrial_extrinsic_cal
     /** @brief default constructor*/
     Pose6d();
 
-    /** @brief set the rotational part of pose using a tf::Matrix3x3 
+    /** @brief set the rotational part of pose using a 3x3 rotation matrix
      *    @param m a 3x3 matrix representing the rotation
      */
-    void setBasis( tf::Matrix3x3 & m);
+    void setBasis(const RotationMatrix & m);
 
-    /** @brief set the translational part of pose using a tf::Vector3 
+    /** @brief set the translational part of pose using a point
      *    @param v the translation components as a 3 vector
     */
-    void setOrigin(tf::Vector3 & v);
+    void setOrigin(const Point3d & v);
 
     /** @brief set the translational part of pose 
      *    @param tx  the x value of the translation vector
@@ -111,8 +119,8 @@ namespace industrial_extrinsic_cal
     */
     void setAngleAxis(double aax, double aay, double aaz);
 
-    /** @brief get the rotational part of pose as a tf::Matrix3x3 */
-    tf::Matrix3x3 getBasis() const;
+    /** @brief get the rotational part of pose as a 3x3 rotation matrix */
+    RotationMatrix getBasis() const;
 
     /** @brief get the euler angles  
      * @param ez angle of rotation around z axis 
@@ -121,8 +129,8 @@ namespace industrial_extrinsic_cal
      */
     void getEulerZYX(double &ez, double &ey, double &ex) const;
 
-    /** @brief get the translationalpart of pose as a tf::Vector3*/
-    tf::Vector3 getOrigin() const;
+    /** @brief get the translationalpart of pose as a point*/
+    Point3d getOrigin() const;
 
     //TODO  void get_eulerZYX(double &ez, double &ey, double &ex);
 
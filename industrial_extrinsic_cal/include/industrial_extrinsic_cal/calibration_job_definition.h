@@ -29,6 +29,17 @@
 #include <industrial_extrinsic_cal/ros_camera_observer.h>
 #include <industrial_extrinsic_cal/ceres_costs_utils.hpp>
 #include <industrial_extrinsic_cal/circle_cost_utils.hpp>
+#include <industrial_extrinsic_cal/multi_start_optimizer.h>
+#include <industrial_extrinsic_cal/rotation_cache.h>
+#include <industrial_extrinsic_cal/robust_loss.h>
+#include <industrial_extrinsic_cal/outlier_trimmer.h>
+#include <industrial_extrinsic_cal/quality_report.h>
+#include <industrial_extrinsic_cal/results_writer.h>
+#include <industrial_extrinsic_cal/sliding_window.h>
+#include <industrial_extrinsic_cal/continuous_capture.h>
+#include <industrial_extrinsic_cal/frame_quality.h>
+#include <industrial_extrinsic_cal/view_planner.h>
+#include <industrial_extrinsic_cal/work_queue.h>
 #include <boost/shared_ptr.hpp>
 #include <boost/foreach.hpp>
 #include "ceres/ceres.h"
@@ -37,18 +48,66 @@
 #include <yaml-cpp/yaml.h>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <set>
 
 namespace industrial_extrinsic_cal
 {
 
+/*! @brief parameter blocks of a target observed in one scene */
+typedef struct
+{
+  P_BLOCK pose; /*!< the target's pose in the scene */
+  std::vector<P_BLOCK> points; /*!< block of each of the target's points */
+} SceneTargetBlocks;
+
+/*! @brief what one camera captured in a scene, with the blocks and poses its observations refer to.
+ *  Taken when the scene is captured, so detection may run after the cameras and targets have moved on.
+ */
+typedef struct
+{
+  boost::shared_ptr<Camera> camera; /*!< the camera */
+  int scene_id; /*!< the scene */
+  P_BLOCK intrinsics; /*!< the camera's intrinsics */
+  P_BLOCK extrinsics; /*!< the camera's extrinsics in the scene */
+  Pose6d intermediate_frame; /*!< the camera's intermediate frame when the image was taken */
+  std::map<std::string, SceneTargetBlocks> targets; /*!< blocks of each target the camera looks for */
+  bool detected; /*!< true when observations already holds the detections */
+  cv::Mat image; /*!< the image, when detection is still to run */
+  DetectionSettings settings; /*!< what to look for in the image */
+  CameraObservations observations; /*!< the camera's observations */
+} CapturedCamera;
+
+/*! @brief settings of the scene pipeline of runObservations() */
+typedef struct
+{
+  int num_threads; /*!< threads detecting captured scenes, 0 observes one scene at a time */
+  int max_pending; /*!< captured scenes waiting for detection before the next trigger waits */
+} ScenePipelineParameters;
+
 /*! @brief defines and executes the calibration script */
 class CalibrationJob
 {
 public:
   /** @brief constructor */
   CalibrationJob(std::string camera_fn, std::string target_fn, std::string caljob_fn) :
-      camera_def_file_name_(camera_fn), target_def_file_name_(target_fn), caljob_def_file_name_(caljob_fn)
-  {  } ;
+      camera_def_file_name_(camera_fn), target_def_file_name_(target_fn), caljob_def_file_name_(caljob_fn),
+      multi_start_parameters_(defaultMultiStartParameters()),
+      outlier_trim_parameters_(defaultOutlierTrimParameters()),
+      quality_parameters_(defaultQualityParameters()),
+      sliding_window_(defaultSlidingWindowParameters()),
+      linear_solver_type_(ceres::DENSE_SCHUR),
+      image_stamped_poses_(true),
+      continuous_capture_parameters_(defaultContinuousCaptureParameters()),
+      view_plan_parameters_(defaultViewPlanParameters()),
+      stop_early_(false),
+      frame_quality_parameters_(defaultFrameQualityParameters()),
+      results_format_(RESULTS_LAUNCH),
+      listen_only_(false)
+  {
+    pipeline_parameters_.num_threads = 0;
+    pipeline_parameters_.max_pending = 4;
+  } ;
 
   /** @brief default destructor */
   ~CalibrationJob() {  } ;
@@ -73,6 +132,41 @@ public:
    */
   bool run();
 
+  /** @brief observes one scene with the current camera and target poses, without adding it to the job's observations
+   * @param scene_id id of the scene to observe
+   * @param wait_for_trigger false captures right away, as when monitoring a calibrated cell
+   * @param observations receives the observations, their blocks point into the job's parameters
+   * @return true if the scene exists
+   */
+  bool observeScene(int scene_id, bool wait_for_trigger, ObservationDataPointList &observations);
+
+  /** @brief loads each broadcasting transform interface as the listener of the same frame, so the job reads the
+   *  calibration others publish and never publishes one itself, as when monitoring a calibrated cell. Call before load().
+   * @param listen_only true to load listeners only
+   */
+  void setListenOnly(bool listen_only)
+  {
+    listen_only_ = listen_only;
+  }
+
+  /** @brief gets the pose and point blocks of the targets whose pose or points are known
+   * @param blocks receives the blocks, those of moving targets once their scene is observed
+   */
+  void getKnownTargetBlocks(std::vector<P_BLOCK> &blocks)
+  {
+    ceres_blocks_.getConstantTargetBlocks(blocks);
+  }
+
+  /** @brief re-calibrates incrementally from the last solution, between production cycles rather than from scratch
+   *  The scenes are observed again and join the window of recent scenes. Only the extrinsics of the cameras
+   *  which observed them, and target poses no older scene constrains, are solved, the rest keeps its value.
+   *  The window starts with the scenes of the last run().
+   * @param scene_ids the scenes to observe
+   * @param wait_for_trigger when true waits for each scene's trigger
+   * @return true if the solve produced a usable solution, the transforms are then pushed
+   */
+  bool runIncremental(const std::vector<int> &scene_ids, bool wait_for_trigger);
+
   /** @brief removes all camera observers from job
    *  @return true if successful
    */
@@ -108,6 +202,76 @@ public:
     return target_frames_;
   }
 
+  /**
+   * @brief turns on phase timing, run() then logs a summary table of where the time went
+   * @param trace_file_name when not empty, run() also writes a Chrome trace (json) of the phases to this file
+   */
+  void enableTracing(const std::string &trace_file_name);
+
+  /**
+   * @brief writes the collected observations and the current parameter values as a dataset,
+   *        which batch_solver can solve without ROS
+   * @param file_name the dataset file to write
+   * @return true if the file was written
+   */
+  bool saveObservationDataset(const std::string &file_name);
+
+  /**
+   * @brief set the number of perturbed starts and threads used by the optimization,
+   *        overrides the multi_start section of the caljob file
+   * @param parameters the multi-start parameters, num_starts of 1 solves once from the loaded poses
+   */
+  void setMultiStartParameters(const MultiStartParameters &parameters)
+  {
+    multi_start_parameters_ = parameters;
+  }
+
+  /** @brief sets the robust loss applied to the observations of each cost type
+   *  @param losses the loss of each cost type
+   */
+  void setRobustLosses(const RobustLossTable &losses)
+  {
+    robust_losses_ = losses;
+  }
+
+  /** @brief sets how outliers are trimmed after the solve
+   *  @param parameters rounds, chi-square threshold and pixel sigma, 0 rounds disables trimming
+   */
+  void setOutlierTrimParameters(const OutlierTrimParameters &parameters)
+  {
+    outlier_trim_parameters_ = parameters;
+  }
+
+  /** @brief the observations removed as outliers by the last runOptimization() */
+  const std::vector<TrimmedObservation>& getTrimmedObservations() const
+  {
+    return(trimmed_observations_);
+  }
+
+  /** @brief sets the threads and covariance settings of the quality report computed after the solve
+   *  @param parameters quality settings
+   */
+  void setQualityParameters(const QualityParameters &parameters)
+  {
+    quality_parameters_ = parameters;
+  }
+
+  /** @brief sets the window size and solver limits of runIncremental(), keeps the scenes already in the window
+   *  @param parameters window and solver limits
+   */
+  void setSlidingWindowParameters(const SlidingWindowParameters &parameters)
+  {
+    SlidingWindow window(parameters);
+    window.seed(sliding_window_.scenes());
+    sliding_window_ = window;
+  }
+
+  /** @brief reprojection errors and extrinsics covariance of the last runOptimization(), NULL before it */
+  boost::shared_ptr<QualityReport> getQualityReport() const
+  {
+    return(quality_report_);
+  }
+
   //    ::std::ostream& operator<<(::std::ostream& os, const CalibrationJob& C){ return os<< "TODO";}
 protected:
   /*!
@@ -128,16 +292,132 @@ protected:
    */
   bool loadCalJob();
 
-  /** @brief runs the data collection portion of the job
-   * @return true if successful
+  /** @brief runs the data collection portion of the job, failed scenes are handled by their failure policy
+   * @return false if a failed scene aborted the job
    */
   bool runObservations();
 
+  /** @brief triggers a scene's cameras and collects their observations, adds new cameras and targets to ceres_blocks_
+   * @param current_scene the scene
+   * @param wait_for_trigger when true waits for the scene's trigger before capturing
+   * @param observations receives the observations
+   * @return false if the trigger failed or a camera did not find its target
+   */
+  bool observeScene(ObservationScene &current_scene, bool wait_for_trigger, ObservationDataPointList &observations);
+
+  /** @brief observes a scene until it succeeds or the attempts run out, then applies its failure policy
+   * @param current_scene the scene
+   * @param wait_for_trigger when true waits for the scene's trigger before each capture
+   * @param attempts number of captures
+   * @param observations receives the observations, empty when the scene failed
+   * @param abort_job set when the scene failed and its policy aborts the job
+   * @return true if the scene succeeded
+   */
+  bool observeSceneWithPolicy(ObservationScene &current_scene, bool wait_for_trigger, int attempts,
+			      ObservationDataPointList &observations, bool &abort_job);
+
+  /** @brief logs a failed scene
+   * @return false if the scene's policy aborts the job
+   */
+  bool continueAfterFailure(ObservationScene &current_scene);
+
+  /** @brief streams a scene's cameras while its trigger moves the robot through a trajectory, then keeps the
+   *  frames with the most diverse target poses. Each kept frame becomes a scene of its own, with poses looked
+   *  up at the frame's stamp.
+   * @param current_scene the scene, its trigger returns once the trajectory is done
+   * @param next_scene_id id of the first generated scene, advanced past the generated scenes
+   * @param scenes receives the observations of each generated scene
+   * @return false if a camera could not capture continuously or kept no frame, or the trigger failed
+   */
+  bool captureContinuousScene(ObservationScene &current_scene, int &next_scene_id,
+			      std::vector<ObservationDataPointList> &scenes);
+
+  /** @brief adds a camera's observations of a scene, and the blocks they need, to a list of observations
+   * @param camera the camera which made the observations
+   * @param scene_id the scene
+   * @param stamp poses are looked up at this time, zero keeps the poses already pulled
+   * @param camera_observations the camera's observations
+   * @param observations receives the observation data points
+   * @return false if the poses were not available at the stamp
+   */
+  bool addCameraObservations(boost::shared_ptr<Camera> camera, int scene_id, const ros::Time &stamp,
+			     CameraObservations &camera_observations, ObservationDataPointList &observations);
+
+  /** @brief waits for a scene's trigger and captures an image with each of its cameras. The blocks the
+   *  observations will need are added to ceres_blocks_ and their poses pulled at each image's stamp.
+   * @param current_scene the scene
+   * @param wait_for_trigger when true waits for the scene's trigger before capturing
+   * @param detect_now true detects right away, false leaves detection to processCapturedScene()
+   * @param captured receives what each camera captured
+   * @return false if the trigger failed
+   */
+  bool captureScene(ObservationScene &current_scene, bool wait_for_trigger, bool detect_now,
+		    std::vector<CapturedCamera> &captured);
+
+  /** @brief true unless the target is predicted to be seen closer to edge on than the frame quality allows
+   * @param scene the scene, its commands give the camera's targets and cost types
+   * @param captured the camera's blocks, with the poses pulled for the scene
+   */
+  bool viewingAngleOk(const ObservationScene &scene, const CapturedCamera &captured) const;
+
+  /** @brief adds a camera's blocks of a scene, and those of its targets, to ceres_blocks_ if they are new.
+   *  All blocks of a scene are added before its poses are pulled, so one pull fills them all.
+   * @param camera the camera
+   * @param scene_id the scene
+   * @param targets the targets the camera looks for
+   */
+  void addCameraBlocks(boost::shared_ptr<Camera> camera, int scene_id,
+		       const std::vector<boost::shared_ptr<Target> > &targets);
+
+  /** @brief copies the block pointers of a camera and its targets in a scene, after their poses were pulled
+   * @param camera the camera
+   * @param scene_id the scene
+   * @param targets the targets the camera looks for
+   * @param captured receives the blocks and the intermediate frame
+   */
+  void getCameraBlocks(boost::shared_ptr<Camera> camera, int scene_id,
+		       const std::vector<boost::shared_ptr<Target> > &targets, CapturedCamera &captured);
+
+  /** @brief detects the targets in a captured scene when still needed and builds its observation data points.
+   *  Uses only the captured blocks, so it may run on any thread while the next scene is captured.
+   * @param captured what each camera captured
+   * @param observations receives the observation data points
+   * @return false if a camera did not find its target
+   */
+  static bool processCapturedScene(std::vector<CapturedCamera> &captured, ObservationDataPointList &observations);
+
+  /** @brief detection job of the scene pipeline, found is cleared under found_mutex when a target is not found */
+  static void processCapturedSceneJob(boost::shared_ptr<std::vector<CapturedCamera> > captured,
+				      ObservationDataPointList *observations, boost::mutex *found_mutex, char *found);
+
+  /** @brief adds newly observed scenes to the early stop's planner, linearized at the current estimates
+   * @param planner the planner of this run
+   * @param scenes the observations of the new scenes
+   * @param observed the views observed so far, the new ones are appended
+   * @return true once the predicted extrinsics uncertainty meets the view plan's target
+   */
+  bool extrinsicsCertain(ViewPlanner &planner, const std::vector<ObservationDataPointList> &scenes,
+			 std::vector<int> &observed);
+
   /** @brief runs the optimization portion of the job
    * @return true if successful
    */
   bool runOptimization();
 
+  /** @brief adds a residual block for every observation to a problem
+   *  @param problem the problem to populate
+   *  @param copies when not NULL, the residuals use these copies of the parameter blocks instead of ceres_blocks_
+   */
+  void addObservationsToProblem(ceres::Problem &problem, ParameterBlockCopies *copies);
+
+  /** @brief adds a residual block for every observation of some scenes to a problem
+   *  @param scenes observations of each scene
+   *  @param problem the problem to populate
+   *  @param copies when not NULL, the residuals use these copies of the parameter blocks instead of ceres_blocks_
+   */
+  void addScenesToProblem(const std::vector<ObservationDataPointList> &scenes, ceres::Problem &problem,
+			  ParameterBlockCopies *copies);
+
   /** @brief Adds a new camera
    *  @param camera_to_add camera to add
    *  @return true if successful
@@ -174,13 +454,24 @@ protected:
    */
   bool appendNewScene(boost::shared_ptr<Trigger> trig);
 
+  /** @brief logs the phase summary and writes the trace file, when tracing is enabled */
+  void reportPhaseTimes();
+
   /** @brief each camera and each target have a transform interface, push the current values to the interface */
   void pushTransforms();
 
   /** @brief each camera and each target have a transform interface, pull the current values from the interface 
    *    @param scene_id the id for the scene, only pull transforms from targets and cameras of this scene
+   *    @param stamp tf transforms are interpolated at this time, zero for the latest
+   *    @return false if a transform was not available in time
 */
-  void pullTransforms(int scene_id);
+  bool pullTransforms(int scene_id, const ros::Time &stamp = ros::Time(0));
+
+  /** @brief the transform interface to load for the one a camera or target file names
+   *  @param transform_interface the interface in the file
+   *  @return the interface, a broadcaster's listener counterpart when listen_only_ is set
+   */
+  std::string loadedTransformInterface(const std::string &transform_interface) const;
 
 private:
   std::vector<ObservationDataPointList> observation_data_point_list_; /*!< a list of observation data points */
@@ -193,8 +484,29 @@ private:
   std::vector<ROSCameraObserver> camera_observers_; /*!< interface to images from cameras */
   std::vector<Target> defined_target_set_; /*!< TODO Not sure if I'll use this one */
   CeresBlocks ceres_blocks_; /*!< This structure maintains the parameter sets for ceres */
-  ceres::Problem problem_; /*!< This is the object which solves non-linear optimization problems */
+  boost::shared_ptr<ceres::Problem> problem_; /*!< This is the object which solves non-linear optimization problems, rebuilt by each runOptimization */
+  RotationCache rotation_cache_; /*!< rotation matrices of the pose blocks in problem_, cleared whenever problem_ is rebuilt */
   std::vector<P_BLOCK> original_extrinsics_; /*!< This is the parameter block which holds the original camera extrinsics */
+  MultiStartParameters multi_start_parameters_; /*!< number of perturbed starts solved by runOptimization */
+  RobustLossTable robust_losses_; /*!< robust loss of each cost type */
+  OutlierTrimParameters outlier_trim_parameters_; /*!< outlier trimming after the solve */
+  std::vector<ObservationResidual> residuals_; /*!< observation of each residual block in problem_ */
+  std::vector<TrimmedObservation> trimmed_observations_; /*!< observations removed by the last solve */
+  QualityParameters quality_parameters_; /*!< settings of the quality report */
+  boost::shared_ptr<QualityReport> quality_report_; /*!< quality of the last solve, written next to the results by store() */
+  SlidingWindow sliding_window_; /*!< recent scenes of runIncremental(), seeded by run() */
+  ceres::LinearSolverType linear_solver_type_; /*!< linear solver of runOptimization, a Schur type uses the job's elimination ordering */
+  bool image_stamped_poses_; /*!< true looks up tf poses at each image's stamp, including the intermediate frame */
+  std::set<int> continuous_scenes_; /*!< scenes captured continuously along their trigger's trajectory */
+  ContinuousCaptureParameters continuous_capture_parameters_; /*!< workers and frame selection of continuous scenes */
+  ScenePipelineParameters pipeline_parameters_; /*!< detection threads overlapping the next scene's robot motion */
+  ViewPlanParameters view_plan_parameters_; /*!< uncertainty target of the early stop */
+  bool stop_early_; /*!< true stops the observations once the predicted extrinsics uncertainty meets the target */
+  FrameQualityParameters frame_quality_parameters_; /*!< checks of each frame before detection */
+  std::string trace_file_name_; /*!< Chrome trace output of the phase timers, empty for none */
+  std::string results_file_; /*!< where store() writes the transforms, empty for the launch directory of the package */
+  ResultsFormat results_format_; /*!< format of the results file */
+  bool listen_only_; /*!< true loads broadcasting transform interfaces as listeners */
 
 };//end class
 
@@ -73,6 +73,11 @@ public:
   /** @brief tells when camera has completed its observations */
   virtual bool observationsDone()=0;
 
+  /** @brief exposure time of the image the observations were made in
+   *  @return zero when the observer does not know it, the latest transforms are then used
+   */
+  virtual ros::Time getImageStamp() { return(ros::Time(0)); };
+
   std::string camera_name_; /*!< string camera_name_ unique name of a camera */
 
   /** @brief print this object TODO */
@@ -22,6 +22,9 @@
 #include <ros/console.h>
 #include <industrial_extrinsic_cal/basic_types.h>
 #include <industrial_extrinsic_cal/camera_definition.h>
+#include <industrial_extrinsic_cal/multi_start_optimizer.h>
+#include <industrial_extrinsic_cal/results_writer.h>
+#include <industrial_extrinsic_cal/schur_ordering.h>
 #include "boost/make_shared.hpp"
 #include "ceres/ceres.h"
 #include "ceres/rotation.h"
@@ -151,14 +154,34 @@ public:
    *          a number of copies of the point parameters might exist
    *          because the target was duplicated in each scene it was observed.
    *          However, the coordinates of the point in the target frame should not change
-   *          Therefore, only the first occurance (first scene) is used
+   *          Therefore, every scene shares the points of the first copy added (first scene),
+   *          the points of the later copies are never part of a problem
    */
   P_BLOCK getMovingTargetPointParameterBlock(std::string target_name, int pnt_id);
 
-  /*! @brief writes a single launch file with all the static tranforms 
-   *  @param filepath  the full path to the launch file being created
+  /*! @brief declares the blocks a Schur solver should eliminate, all target points, then the moving target poses
+   *  @param ordering receives the blocks, those which end up unused by the problem are ignored by it
    */
-  bool writeAllStaticTransforms(std::string filepath);
+  void addSchurEliminationBlocks(SchurOrdering &ordering);
+
+  /*! @brief gets the blocks of targets whose pose or points are known, see Target::fixed_pose_ and Target::fixed_points_
+   *  @param blocks receives the pose and point blocks to hold constant, some may be unused by a problem
+   */
+  void getConstantTargetBlocks(std::vector<P_BLOCK> &blocks);
+
+  /*! @brief holds the blocks of getConstantTargetBlocks() constant in a problem
+   *  @param problem the problem, blocks it does not hold are skipped
+   *  @param copies a multi-start's copies of the blocks which the problem holds instead, NULL for none
+   *  @return the number of blocks held constant
+   */
+  int holdConstantTargetBlocks(ceres::Problem &problem, ParameterBlockCopies *copies);
+
+  /*! @brief writes a single file with all the static tranforms, in one pass, replacing the old file atomically
+   *  @param filepath  the full path to the file being created
+   *  @param format  a launch file, a yaml file or a xacro macro
+   *  @return false if a transform could not be stored, the file is not written when one is missing
+   */
+  bool writeAllStaticTransforms(std::string filepath, ResultsFormat format = RESULTS_LAUNCH);
 
   /*! @brief writes info from static cameras to terminal */
   void displayStaticCameras();
@@ -184,10 +207,20 @@ public:
   /*! @brief sends transform to the interface*/
   void pushTransforms();
 
+  /*! @brief the tf frames and mutable joints pullTransforms() fetches for a scene
+   *    @param scene_id the scene, static cameras and targets are always included
+   *    @param frames receives (target frame, source frame) pairs
+   *    @param joint_names receives the names of mutable joints
+   */
+  void getTFFrames(int scene_id, std::vector<std::pair<std::string, std::string> > &frames,
+		   std::vector<std::string> &joint_names);
+
   /*! @brief gets transform from interface 
    *    @param scene_id the current scene's id. Pulls from all static cameras, static targets, and those from this scene
+   *    @param stamp tf transforms are interpolated at this time, such as an image's exposure, zero for the latest
+   *    @return false if a transform was not available in time, e.g. the stamp is older than the tf buffer
    */
-  void pullTransforms(int scene_id);
+  bool pullTransforms(int scene_id, const ros::Time &stamp = ros::Time(0));
 
   /*! @brief sets reference transform from interface, and may start a timer for broadcasting*/
   void setReferenceFrame(std::string ref_frame);
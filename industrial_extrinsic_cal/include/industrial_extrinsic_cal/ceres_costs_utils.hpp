@@ -23,6 +23,7 @@
 #include "ceres/rotation.h"
 #include <industrial_extrinsic_cal/basic_types.h>
 #include <industrial_extrinsic_cal/ceres_costs_utils.h>
+#include <industrial_extrinsic_cal/rotation_cache.h>
 
 namespace industrial_extrinsic_cal
 {
@@ -271,6 +272,7 @@ namespace industrial_extrinsic_cal
     Vperp[2] = -D_targety*R_TtoC[2] + D_targetx*R_TtoC[5] ;
     
     // Vector direction of Vperp is arbitrary, but need to specify direction closer to camera
+    using std::abs; // a double must not resolve to the integer abs(), Jets find ceres::abs by argument lookup
     T mysign = -abs(Vperp[2])/Vperp[2]; // Warning, division by zero could happen
     Vperp[0] = mysign*Vperp[0];
     Vperp[1] = mysign*Vperp[1];
@@ -377,6 +379,7 @@ namespace industrial_extrinsic_cal
     Vperp[2] = -D_targety*R_TtoC[2] + D_targetx*R_TtoC[5] ;
     
     // Vector direction of Vperp is arbitrary, but need to specify direction closer to camera
+    using std::abs; // a double must not resolve to the integer abs(), Jets find ceres::abs by argument lookup
     T mysign = -abs(Vperp[2])/Vperp[2]; // Warning, division by zero could happen
     Vperp[0] = mysign*Vperp[0];
     Vperp[1] = mysign*Vperp[1];
@@ -441,1499 +444,371 @@ namespace industrial_extrinsic_cal
 
   }
 
-  class CameraReprjErrorWithDistortion
-  {
-  public:
-    CameraReprjErrorWithDistortion(double ob_x, double ob_y) :
-      ox_(ob_x), oy_(ob_y)
-    {
-    }
-
-    template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters */
-                    const T* c_p2, /** intrinsic parameters */
-                    const T* point, /** point being projected, has 3 parameters */
-                    T* residual) const
-    {
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      T fx, fy, cx, cy, k1, k2, k3, p1, p2;
-      extractCameraIntrinsics(c_p2, fx, fy, cx, cy, k1, k2, k3, p1, p2);
-      T camera_point[3]; /** point in camera coordinates*/
-
-      /** transform point into camera coordinates */
-      transformPoint(camera_aa, camera_tx, point, camera_point);
-
-      /** compute project point into image plane and compute residual */
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraPntResidualDist(camera_point, k1, k2, k3, p1, p2, fx, fy, cx, cy, ox, oy,  residual);
-
-      return true;
-    } /** end of operator() */
-
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-    static ceres::CostFunction* Create(const double o_x, const double o_y)
-    {
-      return (new ceres::AutoDiffCostFunction<CameraReprjErrorWithDistortion, 2, 6, 9, 3>(new CameraReprjErrorWithDistortion(o_x, o_y)));
-    }
-    double ox_; /** observed x location of object in image */
-    double oy_; /** observed y location of object in image */
-  };
+  // REPROJECTION KERNEL
+  //
+  // Every cost type is the same chain: a point in target coordinates is moved by the target pose,
+  // then by a link pose, then by the camera extrinsics, and projected into the image.
+  // The cost types only differ in which of those quantities are known, so one functor is
+  // parameterized by compile time policies and each Cost_function is one instantiation of it.
+  // Policy flags are compile time constants, the branches on them are removed by the compiler.
+
+  /*! \brief the known quantities of an observation, those which are not estimated are taken from here */
+  typedef struct
+  {
+    double ox;			/**< observed x location of object in image */
+    double oy;			/**< observed y location of object in image */
+    double circle_diameter;	/**< diameter of circle being observed, circle projections only */
+    double intrinsics[9];	/**< fx, fy, cx, cy, k1, k2, k3, p1, p2 when the intrinsics are known */
+    Pose6d target_pose;		/**< transform from target to reference coordinates when the target is fixed */
+    Pose6d link_pose;		/**< transform from link to reference coordinates when a link is in the chain */
+    Point3d point;		/**< location of point in target coordinates when the point is known */
+    const RotationCacheEntry *camera_rotation; /**< cached rotation of the extrinsics block, NULL for none */
+    const RotationCacheEntry *target_rotation; /**< cached rotation of the target pose block, NULL for none */
+  } ReprojectionInputs;
+
+  /*! \brief inputs for an observation where nothing but the image location is known */
+  inline ReprojectionInputs reprojectionInputs(double ox, double oy)
+  {
+    ReprojectionInputs inputs;
+    inputs.ox = ox;
+    inputs.oy = oy;
+    inputs.circle_diameter = 0.0;
+    for(int i=0; i<9; i++) inputs.intrinsics[i] = 0.0;
+    inputs.point.x = inputs.point.y = inputs.point.z = 0.0;
+    inputs.camera_rotation = NULL;
+    inputs.target_rotation = NULL;
+    return(inputs);
+  }
 
-  // reprojection error of a single simple point observed by a camera with lens distortion
-  // typically used for intrinsic calibration
-  // location of target is known, and fixed, point's location within target is also known
-  // both extrinsic and intrinsic parameters of camera are being computed
-  class CameraReprjErrorWithDistortionPK
+  /*! \brief applies a known transform, R is column major */
+  template<typename T> inline void knownTransformPoint(const double R[9], const double tx[3], const T point[3], T t_point[3])
   {
-  public:
-    CameraReprjErrorWithDistortionPK(double ob_x, double ob_y, Point3d point) :
-      ox_(ob_x), oy_(ob_y), point_(point)
-    {
-    }
-
-    template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters */
-                    const T* c_p2, /** intrinsic parameters */
-                    T* residual) const
-    {
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      T fx, fy, cx, cy, k1, k2, k3, p1, p2;
-      extractCameraIntrinsics(c_p2, fx, fy, cx, cy, k1, k2, k3, p1, p2);
-      T camera_point[3];
-
-      /** transform point into camera coordinates */
-      transformPoint3d(camera_aa, camera_tx, point_, camera_point);
-
-      /** compute project point into image plane and compute residual */
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraPntResidualDist(camera_point, k1, k2, k3, p1, p2, fx, fy, cx, cy, ox, oy,  residual);
-      
-      return true;
-    } /** end of operator() */
-
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-    static ceres::CostFunction* Create(const double o_x, const double o_y, Point3d point)
-    {
-      return (new ceres::AutoDiffCostFunction<CameraReprjErrorWithDistortionPK, 2, 6, 9>(new CameraReprjErrorWithDistortionPK(o_x, o_y, point)));
+    for(int i=0; i<3; i++){
+      t_point[i] = R[i]*point[0] + R[i+3]*point[1] + R[i+6]*point[2] + tx[i];
     }
-    double ox_; /** observed x location of object in image */
-    double oy_; /** observed y location of object in image */
-    Point3d point_; /*! location of point in target coordinates */
-  };
+  }
 
-  // reprojection error of a single simple point observed by a camera with NO lens distortion
-  // should subscribe to a rectified image when using the error function
-  class CameraReprjError
+  /*! \brief applies a rotation matrix and translation, R is column major */
+  template<typename T> inline void matrixTransformPoint(const T R[9], const T tx[3], const T point[3], T t_point[3])
   {
-  public:
-    CameraReprjError(double ob_x, double ob_y, double fx, double fy, double cx, double cy) :
-      ox_(ob_x), oy_(ob_y), fx_(fx), fy_(fy), cx_(cx), cy_(cy)
-    {
+    for(int i=0; i<3; i++){
+      t_point[i] = R[i]*point[0] + R[i+3]*point[1] + R[i+6]*point[2] + tx[i];
     }
+  }
 
-    template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters */
-                    const T* point, /** point being projected, yes this is has 3 parameters */
-                    T* residual) const
-    {
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      T camera_point[3]; /** point in camera coordinates */
-
-      /** transform point into camera coordinates */
-      transformPoint(camera_aa, camera_tx, point, camera_point);
-
-      /** compute project point into image plane and compute residual */
-      T fx = T(fx_);
-      T fy = T(fy_);
-      T cx = T(cx_);
-      T cy = T(cy_);
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraPntResidual(camera_point, fx, fy, cx, cy, ox, oy,  residual);
-
-      return true;
-    } /** end of operator() */
-
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-    static ceres::CostFunction* Create(const double o_x, const double o_y, 
-				       const double fx, const double fy, 
-				       const double cx, const double cy)
-    {
-      return (new ceres::AutoDiffCostFunction<CameraReprjError, 2, 6, 3>(new CameraReprjError(o_x, o_y, fx, fy, cx, cy)));
-    }
-    double ox_; /** observed x location of object in image */
-    double oy_; /** observed y location of object in image */
-    double fx_; /*!< known focal length of camera in x */
-    double fy_; /*!< known focal length of camera in y */
-    double cx_; /*!< known optical center of camera in x */
-    double cy_; /*!< known optical center of camera in y */
-  };
-
-  // reprojection error of a single simple point observed by a camera with NO lens distortion
-  // should subscribe to a rectified image when using the error function
-  class CameraReprjErrorPK
+  /** @brief intrinsics policy: the 9 intrinsics are a parameter block */
+  struct FreeIntrinsics
   {
-  public:
-    CameraReprjErrorPK(double ob_x, double ob_y, double fx, double fy, double cx, double cy, Point3d point) :
-      ox_(ob_x), oy_(ob_y), fx_(fx), fy_(fy), cx_(cx), cy_(cy), point_(point)
-    {
-    }
-
-    template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters */
-                    T* residual) const
-    {
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      T camera_point[3]; /** point in camera coordinates */
-
-      /** transform point into camera coordinates */
-      transformPoint3d(camera_aa, camera_tx, point_, camera_point);
-
-      /** compute project point into image plane and compute residual */
-      T fx = T(fx_);
-      T fy = T(fy_);
-      T cx = T(cx_);
-      T cy = T(cy_);
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraPntResidual(camera_point, fx, fy, cx, cy, ox, oy,  residual);
-
-      return true;
-    } /** end of operator() */
-
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-    static ceres::CostFunction* Create(const double o_x, const double o_y, 
-				       const double fx, const double fy, 
-				       const double cx, const double cy,
-				       const Point3d point)
+    static const bool FREE = true;
+    template<typename T> static void get(const T* block, const double known[9], T intrinsics[9])
     {
-      return (new ceres::AutoDiffCostFunction<CameraReprjErrorPK, 2, 6>(new CameraReprjErrorPK(o_x, o_y, fx, fy, cx, cy, point)));
+      for(int i=0; i<9; i++) intrinsics[i] = block[i];
     }
-    double ox_; /** observed x location of object in image */
-    double oy_; /** observed y location of object in image */
-    double fx_; /*!< known focal length of camera in x */
-    double fy_; /*!< known focal length of camera in y */
-    double cx_; /*!< known optical center of camera in x */
-    double cy_; /*!< known optical center of camera in y */
-    Point3d point_; /*! location of point in target coordinates */
-
   };
 
-  // reprojection error of a single point attatched to a target observed by a camera with NO lens distortion
-  // should subscribe to a rectified image when using the error function
-  //
-  class TargetCameraReprjError
+  /** @brief intrinsics policy: the intrinsics are known */
+  struct KnownIntrinsics
   {
-  public:
-    TargetCameraReprjError(double ob_x, double ob_y, double fx, double fy, double cx, double cy) :
-      ox_(ob_x), oy_(ob_y), fx_(fx), fy_(fy), cx_(cx), cy_(cy)
+    static const bool FREE = false;
+    template<typename T> static void get(const T* block, const double known[9], T intrinsics[9])
     {
+      for(int i=0; i<9; i++) intrinsics[i] = T(known[i]);
     }
-
-    template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters */
-                    const T* const c_p2, /** 6Dof transform of target points into world frame */
-                    const T* const point, /** point described in target frame */
-                    T* residual) const
-    {
-
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      const T *target_aa(& c_p2[0]);
-      const T *target_tx(& c_p2[3]);
-
-      T world_point[3]; /** point in world coordinates */
-      T camera_point[3]; /** point in camera coordinates */
-
-      /** transform point into camera coordinates */
-      transformPoint(target_aa, target_tx, point, world_point);
-      transformPoint(camera_aa, camera_tx, world_point, camera_point);
-
-      /** compute project point into image plane and compute residual */
-      T fx = T(fx_);
-      T fy = T(fy_);
-      T cx = T(cx_);
-      T cy = T(cy_);
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraPntResidual(camera_point, fx, fy, cx, cy, ox, oy,  residual);
-
-      return true;
-    } /** end of operator() */
-
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-    static ceres::CostFunction* Create(const double o_x, const double o_y,
-				       const double fx, const double fy, 
-				       const double cx, const double cy)
-
-    {
-      return (new ceres::AutoDiffCostFunction<TargetCameraReprjError, 2, 6, 6, 3>(new TargetCameraReprjError(o_x, o_y, fx, fy, cx, cy)));
-    }
-    double ox_; /** observed x location of object in image */
-    double oy_; /** observed y location of object in image */
-    double fx_; /*!< known focal length of camera in x */
-    double fy_; /*!< known focal length of camera in y */
-    double cx_; /*!< known optical center of camera in x */
-    double cy_; /*!< known optical center of camera in y */
   };
 
-  // reprojection error of a single point attatched to a target observed by a camera with NO lens distortion
-  // should subscribe to a rectified image when using the error function
-  //
-  class TargetCameraReprjErrorPK
-  {
-  public:
-    TargetCameraReprjErrorPK(double ob_x, double ob_y, double fx, double fy, double cx, double cy, Point3d point) :
-      ox_(ob_x), oy_(ob_y), fx_(fx), fy_(fy), cx_(cx), cy_(cy), point_(point)
-    {
-    }
-
-    template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters */
-                    const T* const c_p2, /** 6Dof transform of target points into world frame */
-                    T* residual) const
-    {
-
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      const T *target_aa(& c_p2[0]);
-      const T *target_tx(& c_p2[3]);
-      T world_point[3]; /** point in world coordinates */
-      T camera_point[3]; /** point in camera coordinates */
-
-      /** transform point into camera coordinates */
-      transformPoint3d(target_aa, target_tx, point_, world_point);
-      transformPoint(camera_aa, camera_tx, world_point, camera_point);
-
-      /** compute project point into image plane and compute residual */
-      T fx = T(fx_);
-      T fy = T(fy_);
-      T cx = T(cx_);
-      T cy = T(cy_);
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraPntResidual(camera_point, fx, fy, cx, cy, ox, oy,  residual);
-
-      return true;
-    } /** end of operator() */
+  /** @brief distortion policy: apply k1, k2, k3, p1 and p2 */
+  struct Distorted { static const bool ENABLED = true; };
 
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-    static ceres::CostFunction* Create(const double o_x, const double o_y,
-				       const double fx, const double fy, 
-				       const double cx, const double cy,
-				       const Point3d point)
+  /** @brief distortion policy: rectified images, distortion terms are not evaluated */
+  struct Undistorted { static const bool ENABLED = false; };
 
-    {
-      return (new ceres::AutoDiffCostFunction<TargetCameraReprjErrorPK, 2, 6, 6>(new TargetCameraReprjErrorPK(o_x, o_y, fx, fy, cx, cy, point)));
-    }
-    double ox_; /** observed x location of object in image */
-    double oy_; /** observed y location of object in image */
-    double fx_; /*!< known focal length of camera in x */
-    double fy_; /*!< known focal length of camera in y */
-    double cx_; /*!< known optical center of camera in x */
-    double cy_; /*!< known optical center of camera in y */
-    Point3d point_; /*! location of point in target coordinates */
-  };
-
-  // reprojection error of a single point attatched to a target observed by a camera with NO lens distortion
-  // should subscribe to a rectified image when using the error function
-  //
-  class LinkTargetCameraReprjError
-  {
-  public:
-    LinkTargetCameraReprjError(double ob_x, double ob_y, double fx, double fy, double cx, double cy, Pose6d link_pose) :
-      ox_(ob_x), oy_(ob_y), fx_(fx), fy_(fy), cx_(cx), cy_(cy), link_pose_(link_pose)
-    {
-    }
+  /** @brief projection policy: the observation is the image of a point */
+  struct PointProjection { static const bool CIRCLE = false; };
 
-    template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters */
-                    const T* const c_p2, /** 6Dof transform of target points into world frame */
-                    const T* const point, /** point described in target frame that is being seen */
-                    T* residual) const
-    {
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      const T *target_aa(& c_p2[0]);
-      const T *target_tx(& c_p2[3]);
-      T link_point[3]; /** point in link coordinates */
-      T world_point[3]; /** point in world coordinates */
-      T camera_point[3]; /** point in camera coordinates */
-
-      /** transform point into camera coordinates */
-      transformPoint(target_aa, target_tx, point, link_point);
-      poseTransformPoint(link_pose_, link_point, world_point);
-      transformPoint(camera_aa, camera_tx, world_point, camera_point);
-
-      /** compute project point into image plane and compute residual */
-      T fx = T(fx_);
-      T fy = T(fy_);
-      T cx = T(cx_);
-      T cy = T(cy_);
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraPntResidual(camera_point, fx, fy, cx, cy, ox, oy,  residual);
+  /** @brief projection policy: the observation is the center of the ellipse imaged from a circle
+   *   lying in the target's xy plane, which needs the rotation from target to camera
+   */
+  struct CircleProjection { static const bool CIRCLE = true; };
 
-      return true;
-    } /** end of operator() */
+  /** @brief target policy: points are given in reference coordinates, there is no target pose */
+  struct NoTarget { static const bool PRESENT = false; static const bool FREE = false; };
 
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-    static ceres::CostFunction* Create(const double ox, const double oy,
-				       const double fx, const double fy, 
-				       const double cx, const double cy,
-				       Pose6d pose)
+  /** @brief target policy: the target pose is a parameter block */
+  struct FreeTarget { static const bool PRESENT = true; static const bool FREE = true; };
 
-    {
-      return (new ceres::AutoDiffCostFunction<LinkTargetCameraReprjError, 2, 6, 6, 3>(new LinkTargetCameraReprjError(ox, oy, fx, fy, cx, cy, pose)));
-    }
-    double ox_; /** observed x location of object in image */
-    double oy_; /** observed y location of object in image */
-    double fx_; /*!< known focal length of camera in x */
-    double fy_; /*!< known focal length of camera in y */
-    double cx_; /*!< known optical center of camera in x */
-    double cy_; /*!< known optical center of camera in y */
-    Pose6d link_pose_; /*!< transform from world to link coordinates */ 
-  };
+  /** @brief target policy: the target pose is known */
+  struct FixedTarget { static const bool PRESENT = true; static const bool FREE = false; };
 
-  // reprojection error of a single point attatched to a target observed by a camera with NO lens distortion
-  // should subscribe to a rectified image when using the error function
-  //
-  class LinkTargetCameraReprjErrorPK
+  /** @brief link policy: the camera observes the reference frame directly */
+  struct NoLink
   {
-  public:
-    LinkTargetCameraReprjErrorPK(double ob_x, double ob_y, double fx, double fy, double cx, double cy, Pose6d link_pose, Point3d point) :
-      ox_(ob_x), oy_(ob_y), fx_(fx), fy_(fy), cx_(cx), cy_(cy), link_pose_(link_pose), point_(point)
-    {
-    }
-
-    template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters */
-                    const T* const c_p2, /** 6Dof transform of target points into world frame */
-                    T* residual) const
-    {
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      const T *target_aa(& c_p2[0]);
-      const T *target_tx(& c_p2[3]);
-      T link_point[3]; /** point in link coordinates */
-      T world_point[3];/** point in worls coordinates */			   
-      T camera_point[3]; /** point in camera coordinates */
-
-      /** transform point into camera coordinates */
-      transformPoint3d(target_aa, target_tx, point_, link_point);
-      poseTransformPoint(link_pose_, link_point, world_point);
-      transformPoint(camera_aa, camera_tx, world_point, camera_point);
-
-      /** compute project point into image plane and compute residual */
-      T fx = T(fx_);
-      T fy = T(fy_);
-      T cx = T(cx_);
-      T cy = T(cy_);
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraPntResidual(camera_point, fx, fy, cx, cy, ox, oy,  residual);
-
-      return true;
-    } /** end of operator() */
-
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-    static ceres::CostFunction* Create(const double o_x, const double o_y,
-				       const double fx, const double fy, 
-				       const double cx, const double cy,
-				       Pose6d pose, Point3d point)
-
-    {
-      return (new ceres::AutoDiffCostFunction<LinkTargetCameraReprjErrorPK, 2, 6, 6>( new LinkTargetCameraReprjErrorPK(o_x, o_y, fx, fy, cx, cy, pose, point)));
-    }
-    double ox_; /** observed x location of object in image */
-    double oy_; /** observed y location of object in image */
-    double fx_; /*!< known focal length of camera in x */
-    double fy_; /*!< known focal length of camera in y */
-    double cx_; /*!< known optical center of camera in x */
-    double cy_; /*!< known optical center of camera in y */
-    Pose6d link_pose_; /*!< transform from world to link coordinates */ 
-    Point3d point_; /*! location of point in target coordinates */
+    static const bool PRESENT = false;
+    static Pose6d select(const Pose6d &link_pose) { return(link_pose); };
   };
 
-  // reprojection error of a single point attatched to a target observed by a camera with NO lens distortion
-  // should subscribe to a rectified image when using the error function
-  //
-  class LinkCameraTargetReprjError
+  /** @brief link policy: the target is mounted on a link, link_pose takes link to reference coordinates */
+  struct TargetOnLink
   {
-  public:
-    LinkCameraTargetReprjError(double ob_x, double ob_y, double fx, double fy, double cx, double cy, Pose6d link_pose) :
-      ox_(ob_x), oy_(ob_y), fx_(fx), fy_(fy), cx_(cx), cy_(cy), link_pose_(link_pose)
-    {
-      link_posei_ = link_pose_.getInverse();
-    }
-
-    template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters */
-                    const T* const c_p2, /** 6Dof transform of target points into world frame */
-                    const T* const point, /** point described in target frame that is being seen */
-                    T* residual) const
-    {
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      const T *target_aa(& c_p2[0]);
-      const T *target_tx(& c_p2[3]);
-      T world_point[3]; /** point in world coordinates */
-      T link_point[3]; /** point in link coordinates */
-      T camera_point[3];/** point in camera coordinates */
-
-      /** transform point into camera coordinates */
-      transformPoint(target_aa, target_tx, point, world_point);
-      poseTransformPoint(link_posei_, world_point, link_point);
-      transformPoint(camera_aa, camera_tx, link_point, camera_point);
-
-      /** compute project point into image plane and compute residual */
-      T fx = T(fx_);
-      T fy = T(fy_);
-      T cx = T(cx_);
-      T cy = T(cy_);
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraPntResidual(camera_point, fx, fy, cx, cy, ox, oy,  residual);
-
-      return true;
-    } /** end of operator() */
-
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-    static ceres::CostFunction* Create(const double ox, const double oy,
-				       const double fx, const double fy, 
-				       const double cx, const double cy,
-				       Pose6d pose)
-
-    {
-      return (new ceres::AutoDiffCostFunction<LinkCameraTargetReprjError, 2, 6, 6, 3>(new LinkCameraTargetReprjError(ox, oy, fx, fy, cx, cy, pose)));
-    }
-    double ox_; /*!< observed x location of object in image */
-    double oy_; /*!< observed y location of object in image */
-    double fx_; /*!< known focal length of camera in x */
-    double fy_; /*!< known focal length of camera in y */
-    double cx_; /*!< known optical center of camera in x */
-    double cy_; /*!< known optical center of camera in y */
-    Pose6d link_pose_; /*!< transform from world to link coordinates */ 
-    Pose6d link_posei_; /*!< transform from link to world coordinates */ 
+    static const bool PRESENT = true;
+    static Pose6d select(const Pose6d &link_pose) { return(link_pose); };
   };
 
-  // reprojection error of a single point attatched to a target observed by a camera with NO lens distortion
-  // should subscribe to a rectified image when using the error function
-  //
-  class LinkCameraTargetReprjErrorPK
+  /** @brief link policy: the camera is mounted on a link, the inverse of link_pose takes reference to link coordinates */
+  struct CameraOnLink
   {
-  public:
-    LinkCameraTargetReprjErrorPK(double ob_x, double ob_y, double fx, double fy, double cx, double cy, Pose6d link_pose, Point3d point) :
-      ox_(ob_x), oy_(ob_y), fx_(fx), fy_(fy), cx_(cx), cy_(cy), link_pose_(link_pose), point_(point)
-    {
-      link_posei_ = link_pose_.getInverse();
-    }
-
-    template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters */
-                    const T* const c_p2, /** 6Dof transform of target points into world frame */
-                    T* residual) const
-    {
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      const T *target_aa(& c_p2[0]);
-      const T *target_tx(& c_p2[3]);
-      T world_point[3]; /** point in world coordinates */
-      T link_point[3]; /** point in link coordinates */
-      T camera_point[3]; /** point in camera coordinates */
-
-      /** transform point into camera coordinates */
-      transformPoint3d(target_aa, target_tx, point_, world_point);
-      poseTransformPoint(link_posei_, world_point, link_point);
-      transformPoint(camera_aa, camera_tx, link_point, camera_point);
-
-      /** compute project point into image plane and compute residual */
-      T fx = T(fx_);
-      T fy = T(fy_);
-      T cx = T(cx_);
-      T cy = T(cy_);
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraPntResidual(camera_point, fx, fy, cx, cy, ox, oy,  residual);
-
-      return true;
-    } /** end of operator() */
-
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-    static ceres::CostFunction* Create(const double o_x, const double o_y,
-				       const double fx, const double fy, 
-				       const double cx, const double cy,
-				       Pose6d pose, Point3d pnt)
-
-    {
-      return (new ceres::AutoDiffCostFunction<LinkCameraTargetReprjErrorPK, 2, 6, 6>( new LinkCameraTargetReprjErrorPK(o_x, o_y, fx, fy, cx, cy, pose, pnt)));
-    }
-    double ox_; /** observed x location of object in image */
-    double oy_; /** observed y location of object in image */
-    double fx_; /*!< known focal length of camera in x */
-    double fy_; /*!< known focal length of camera in y */
-    double cx_; /*!< known optical center of camera in x */
-    double cy_; /*!< known optical center of camera in y */
-    Pose6d link_pose_; /*!< transform from world to link coordinates */ 
-    Pose6d link_posei_; /*!< transform from link to world coordinates */ 
-    Point3d point_; /*! location of point in target coordinates */
+    static const bool PRESENT = true;
+    static Pose6d select(const Pose6d &link_pose) { return(link_pose.getInverse()); };
   };
 
-  // WARNING, ASSUMES CIRCLE LIES IN XY PLANE OF WORLD
-  class  CircleCameraReprjErrorWithDistortion
+  /** @brief point policy: the point's location within the target is a parameter block */
+  struct FreePoint
   {
-  public:
-    CircleCameraReprjErrorWithDistortion(double ob_x, double ob_y, double c_dia) :
-      ox_(ob_x), oy_(ob_y), circle_diameter_(c_dia)
+    static const bool FREE = true;
+    template<typename T> static void get(const T* block, const Point3d &known, T point[3])
     {
+      point[0] = block[0];
+      point[1] = block[1];
+      point[2] = block[2];
     }
-
-    template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters [6]*/
-		    const T* const c_p2, /** intrinsic parameters of camera fx,fy,cx,cy,k1,k2,k2,p1,p2 [9]*/
-		    const T* const point, /** point described in target frame that is being seen [3]*/
-		    T* residual) const
-    {
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      T fx, fy, cx, cy, k1, k2, k3, p1, p2;      
-      extractCameraIntrinsics(c_p2, fx, fy, cx, cy, k1, k2, k3, p1, p2);
-      T camera_point[3];  /** point in camera coordinates*/       
-      T R_TtoC[9];
-
-      /** transform point into camera coordinates */
-      transformPoint(camera_aa, camera_tx, point, camera_point);
-      
-      // find rotation from target to camera frame
-      ceres::AngleAxisToRotationMatrix(camera_aa,R_TtoC);
-
-      /** compute project point into image plane and compute residual */
-      T circle_diameter = T(circle_diameter_);
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraCircResidualDist(camera_point, circle_diameter, R_TtoC, k1, k2, k3, p1,p2, fx, fy,cx,cy, ox, oy, residual);
-
-      return true;
-    } /** end of operator() */
-    
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-    static ceres::CostFunction* Create(const double o_x, const double o_y, const double c_dia)
-    {
-      return (new ceres::AutoDiffCostFunction<CircleCameraReprjErrorWithDistortion, 2, 6, 9, 3>(new CircleCameraReprjErrorWithDistortion(o_x, o_y, c_dia)));
-    }
-    double ox_; /** observed x location of object in image */
-    double oy_; /** observed y location of object in image */
-    double circle_diameter_; //** diameter of circle being observed */
   };
 
-  // WARNING, ASSUMES CIRCLE LIES IN XY PLANE OF WORLD
-  class  CircleCameraReprjErrorWithDistortionPK
+  /** @brief point policy: the point's location within the target is known */
+  struct KnownPoint
   {
-  public:
-    CircleCameraReprjErrorWithDistortionPK(double ob_x, double ob_y, double c_dia, Point3d point) :
-      ox_(ob_x), oy_(ob_y), circle_diameter_(c_dia), point_(point)
+    static const bool FREE = false;
+    template<typename T> static void get(const T* block, const Point3d &known, T point[3])
     {
+      point[0] = T(known.x);
+      point[1] = T(known.y);
+      point[2] = T(known.z);
     }
-
-    template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters [6] */
-		    const T* const c_p2, /** intrinsic parameters of camera fx,fy,cx,cy,k1,k2,k2,p1,p2 [9] */
-		    T* residual) const
-    {
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      T fx, fy, cx, cy, k1, k2, k3, p1, p2;      
-      extractCameraIntrinsics(c_p2, fx, fy, cx, cy, k1, k2, k3, p1, p2);
-      T camera_point[3]; /** point in camera coordinates */
-      T R_TtoC[9]; /** rotation from target to camera coordinates 
-
-      /** find point in camera coordinates */
-      transformPoint3d(camera_aa, camera_tx, point_, camera_point);
-
-      // find rotation from target to camera coordinates
-      T T2C_angle_axis[3];
-      T2C_angle_axis[0] = T(-camera_aa[0]);
-      T2C_angle_axis[1] = T(-camera_aa[1]);
-      T2C_angle_axis[2] = T(-camera_aa[2]);
-      ceres::AngleAxisToRotationMatrix(T2C_angle_axis, R_TtoC);
-
-      /** compute project point into image plane and compute residual */
-      T circle_diameter = T(circle_diameter_);
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraCircResidualDist(camera_point, circle_diameter, R_TtoC, k1, k2, k3, p1, p2, fx, fy,cx,cy, ox, oy, residual);
-
-      return true;
-    } /** end of operator() */
-
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-    static ceres::CostFunction* Create(const double o_x, const double o_y, const double c_dia, Point3d point)
-    {
-      return (new ceres::AutoDiffCostFunction<CircleCameraReprjErrorWithDistortionPK, 2, 6, 9>(											       new CircleCameraReprjErrorWithDistortionPK(o_x, o_y, c_dia, point)));
-    }
-    double ox_; /** observed x location of object in image */
-    double oy_; /** observed y location of object in image */
-    double circle_diameter_; //** diameter of circle being observed */
-    Point3d point_;
   };
 
-  class  CircleCameraReprjError
+  /*! \brief reprojection error of one observation, the policies select what is estimated.
+   *   Parameter blocks always come in the order extrinsics[6], intrinsics[9], target pose[6], point[3],
+   *   leaving out those which are known.
+   */
+  template<class Intrinsics, class Distortion, class Projection, class Target, class Link, class Point>
+  class ReprojectionError
   {
   public:
-    CircleCameraReprjError(double ob_x, double ob_y, double c_dia, double fx, double fy, double cx, double cy) :
-      ox_(ob_x), oy_(ob_y), circle_diameter_(c_dia), fx_(fx), fy_(fy), cx_(cx), cy_(cy)
-    {
-    }
+    typedef Target TargetPolicy; /**< the target policy, for the cost type's chain */
+    typedef Link LinkPolicy;	/**< the link policy, for the cost type's chain */
 
-    template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters [6]*/
-		    const T* const point, /** point described in target frame that is being seen [3]*/
-		    T* residual) const
-    {
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      T camera_point[3];  /** point in camera coordinates */ 
-      T R_TtoC[9]; /** rotation from target to camera coordinates */
-
-      /** transform point into camera coordinates */
-      transformPoint(camera_aa, camera_tx, point, camera_point);
-      
-      // find rotation from target to camera coordinates
-      ceres::AngleAxisToRotationMatrix(camera_aa,R_TtoC);
-
-      /** compute project point into image plane and compute residual */
-      T circle_diameter = T(circle_diameter_);
-      T fx = T(fx_);
-      T fy = T(fy_);
-      T cx = T(cx_);
-      T cy = T(cy_);
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraCircResidual(camera_point, circle_diameter, R_TtoC, fx, fy,cx,cy, ox, oy, residual);
+    /* position of each parameter block in the argument list of operator() */
+    static const int INTRINSICS_INDEX = 1;
+    static const int TARGET_INDEX = 1 + (Intrinsics::FREE ? 1 : 0);
+    static const int POINT_INDEX = TARGET_INDEX + (Target::FREE ? 1 : 0);
+    static const int NUM_BLOCKS = POINT_INDEX + (Point::FREE ? 1 : 0);
 
-      return true;
-    } /** end of operator() */
-    
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-    static ceres::CostFunction* Create(const double o_x, const double o_y, const double c_dia, 
-				       const double fx,  const double fy, const double cx, const double cy)
-    {
-      return (new ceres::AutoDiffCostFunction<CircleCameraReprjError, 2, 6, 3>(new CircleCameraReprjError(o_x, o_y, c_dia, fx, fy, cx, cy)));
-    }
-    double ox_; /** observed x location of object in image */
-    double oy_; /** observed y location of object in image */
-    double circle_diameter_; /** diameter of circle being observed */
-    double fx_; /** focal length of camera in x (pixels) */
-    double fy_; /** focal length of camera in y (pixels) */
-    double cx_; /** focal center of camera in x (pixels) */
-    double cy_; /** focal center of camera in y (pixels) */
-  };
+    /* sizes of the blocks after the extrinsics, 0 terminates the list */
+    static const int SIZE1 = Intrinsics::FREE ? 9 : (Target::FREE ? 6 : (Point::FREE ? 3 : 0));
+    static const int SIZE2 = Intrinsics::FREE ? (Target::FREE ? 6 : (Point::FREE ? 3 : 0)) : (Target::FREE && Point::FREE ? 3 : 0);
+    static const int SIZE3 = (Intrinsics::FREE && Target::FREE && Point::FREE) ? 3 : 0;
 
-  class  CircleCameraReprjErrorPK
-  {
-  public:
-    CircleCameraReprjErrorPK(double ob_x, double ob_y, double c_dia, double fx, double fy, double cx, double cy,  Point3d point) :
-      ox_(ob_x), oy_(ob_y), circle_diameter_(c_dia), fx_(fx), fy_(fy), cx_(cx), cy_(cy), point_(point)
+    explicit ReprojectionError(const ReprojectionInputs &inputs) :
+      ox_(inputs.ox), oy_(inputs.oy), circle_diameter_(inputs.circle_diameter), point_(inputs.point),
+      camera_rotation_(inputs.camera_rotation), target_rotation_(inputs.target_rotation)
     {
+      for(int i=0; i<9; i++) intrinsics_[i] = inputs.intrinsics[i];
+      // known poses are turned into rotation matrices once, rather than at every evaluation
+      ceres::AngleAxisToRotationMatrix(inputs.target_pose.pb_aa, target_R_);
+      for(int i=0; i<3; i++) target_tx_[i] = inputs.target_pose.pb_loc[i];
+      Pose6d link_pose = Link::select(inputs.link_pose);
+      ceres::AngleAxisToRotationMatrix(link_pose.pb_aa, link_R_);
+      for(int i=0; i<3; i++) link_tx_[i] = link_pose.pb_loc[i];
     }
 
     template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters [6] */
-		    T* residual) const
-    {
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      T camera_point[3]; /* point in camera coordinates */
-      T R_TtoC[9]; /** rotation from target to camera coordinates */
-
-      /** rotate and translate point into camera coordinates*/
-      transformPoint3d(camera_aa, camera_tx, point_, camera_point);
-
-      // find rotation from target to camera coordinates
-      ceres::AngleAxisToRotationMatrix(camera_aa, R_TtoC);
-
-      /** compute project point into image plane and compute residual */
-      T circle_diameter = T(circle_diameter_);
-      T fx = T(fx_);
-      T fy = T(fy_);
-      T cx = T(cx_);
-      T cy = T(cy_);
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraCircResidual(camera_point, circle_diameter, R_TtoC, fx, fy,cx,cy, ox, oy, residual);
-
-      return true;
-    } /** end of operator() */
-
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-  static ceres::CostFunction* Create(const double o_x, const double o_y, const double c_dia, 
-				     const double fx, const double fy, const double cx, const double cy,
-				     Point3d point)
-    {
-      return (new ceres::AutoDiffCostFunction<CircleCameraReprjErrorPK, 2, 6>(new CircleCameraReprjErrorPK(o_x, o_y, c_dia, fx, fy, cx, cy, point)));
-    }
-    double ox_; /** observed x location of object in image */
-    double oy_; /** observed y location of object in image */
-    double circle_diameter_; //** diameter of circle being observed */
-    double fx_; /** focal length of camera in x (pixels) */
-    double fy_; /** focal length of camera in y (pixels) */
-    double cx_; /** focal center of camera in x (pixels) */
-    double cy_; /** focal center of camera in y (pixels) */
-    Point3d point_; /** location of point in target coordinates */
-  };
-
-  class  CircleTargetCameraReprjErrorWithDistortion
-  {
-  public:
-    CircleTargetCameraReprjErrorWithDistortion(double ob_x, double ob_y, double c_dia) :
-      ox_(ob_x), oy_(ob_y), circle_diameter_(c_dia)
+    bool operator()(const T* const c_p1, T* residual) const
     {
+      const T* blocks[1] = { c_p1 };
+      return(evaluate(blocks, residual));
     }
 
     template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters [6]*/
-		    const T* const c_p2, /** intrinsic parameters of camera fx,fy,cx,cy,k1,k2,k2,p1,p2 [9]*/
-		    const T* const c_p3, /** 6Dof transform of target into world frame [6]*/
-		    const T* const point, /** point described in target frame that is being seen [3]*/
-		    T* residual) const
-    {
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      const T *target_aa(& c_p3[0]);
-      const T *target_tx(& c_p3[3]);
-      T fx, fy, cx, cy, k1, k2, k3, p1, p2;      
-      extractCameraIntrinsics(c_p2, fx, fy, cx, cy, k1, k2, k3, p1, p2);
-      T world_point[3]; /** point in world coordinates */
-      T camera_point[3];  /** point in camera coordinates*/ 
-      T R_WtoC[9]; // rotation from world to camera coordinates
-      T R_TtoW[9]; // rotation from target to world coordinates
-      T R_TtoC[9];  // rotation from target to camera coordinates (assume circle lies in x-y plane of target coordinates)
-
-      /** compute necessary rotation matrices */
-      ceres::AngleAxisToRotationMatrix(camera_aa, R_WtoC);  
-      ceres::AngleAxisToRotationMatrix(target_aa, R_TtoW);
-
-      /** transform point into camera coordinates */
-      transformPoint(target_aa, target_tx, point, world_point);
-      transformPoint(camera_aa, camera_tx, world_point, camera_point);
-
-      // find rotation from target to camera coordinates
-      rotationProduct(R_WtoC, R_TtoW, R_TtoC); // R_WtoC*R_TtoW = R_TtoC
-
-      /** compute project point into image plane and compute residual */
-      T circle_diameter = T(circle_diameter_);
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraCircResidualDist(camera_point, circle_diameter, R_TtoC, k1, k2, k3, p1, p2, fx, fy,cx,cy, ox, oy, residual);
-
-      return true;
-    } /** end of operator() */
-    
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-    static ceres::CostFunction* Create(const double o_x, const double o_y, const double c_dia)
-    {
-      return (new ceres::AutoDiffCostFunction<CircleTargetCameraReprjErrorWithDistortion, 2, 6, 6, 9, 3>(new CircleTargetCameraReprjErrorWithDistortion(o_x, o_y, c_dia)));
-    }
-    double ox_; /** observed x location of object in image */
-    double oy_; /** observed y location of object in image */
-    double circle_diameter_; //** diameter of circle being observed */
-  };
-
-  class  CircleTargetCameraReprjErrorWithDistortionPK
-  {
-  public:
-    CircleTargetCameraReprjErrorWithDistortionPK(double ob_x, double ob_y, double c_dia, Point3d point) :
-      ox_(ob_x), oy_(ob_y), circle_diameter_(c_dia), point_(point)
+    bool operator()(const T* const c_p1, const T* const c_p2, T* residual) const
     {
+      const T* blocks[2] = { c_p1, c_p2 };
+      return(evaluate(blocks, residual));
     }
 
     template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters [6] */
-		    const T* const c_p2,  /** 6Dof transform of target into world frame [6] */
-		    const T* const c_p3, /** intrinsic parameters of camera fx,fy,cx,cy,k1,k2,k2,p1,p2 [9] */
-		    T* residual) const
-    {
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      const T *target_aa(& c_p3[0]);
-      const T *target_tx(& c_p3[3]);
-      T fx, fy, cx, cy, k1, k2, k3, p1, p2;      
-      extractCameraIntrinsics(c_p2, fx, fy, cx, cy, k1, k2, k3, p1, p2);
-      T world_point[3]; /** point in world coordinates */
-      T camera_point[3]; /** point in world coordinates */
-      T R_WtoC[9]; // rotation from world to camera coordinates
-      T R_TtoW[9]; // rotation from target to world coordinates
-      T R_TtoC[9];  // rotation from target to camera coordinates (assume circle lies in x-y plane of target coordinates)
-
-      /** compute necessary rotation matrices */
-      ceres::AngleAxisToRotationMatrix(camera_aa, R_WtoC);  
-      ceres::AngleAxisToRotationMatrix(target_aa, R_TtoW);
-
-      /** transform point into camera coordinates */
-      transformPoint3d(target_aa, target_tx, point_, world_point);
-      transformPoint(camera_aa, camera_tx, world_point, camera_point);
-
-      // find rotation from target to camera coordinates
-      rotationProduct(R_WtoC, R_TtoW, R_TtoC); // R_WtoC*R_TtoW = R_TtoC
-
-      /** compute project point into image plane and compute residual */
-      T circle_diameter = T(circle_diameter_);
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraCircResidualDist(camera_point, circle_diameter, R_TtoC, k1, k2, k3, p1, p2, fx, fy,cx,cy, ox, oy, residual);
-
-      return true;
-    } /** end of operator() */
-
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-    static ceres::CostFunction* Create(const double o_x, const double o_y, const double c_dia, Point3d point)
-    {
-      return (new ceres::AutoDiffCostFunction<CircleTargetCameraReprjErrorWithDistortionPK, 2, 6, 6, 9>(											       new CircleTargetCameraReprjErrorWithDistortionPK(o_x, o_y, c_dia, point)));
-    }
-    double ox_; /** observed x location of object in image */
-    double oy_; /** observed y location of object in image */
-    double circle_diameter_; //** diameter of circle being observed */
-    Point3d point_;
-  };
-
-  class  CircleTargetCameraReprjError
-  {
-  public:
-    CircleTargetCameraReprjError(double ob_x, double ob_y, double c_dia, double fx, double fy, double cx, double cy) :
-      ox_(ob_x), oy_(ob_y), circle_diameter_(c_dia), fx_(fx), fy_(fy)
+    bool operator()(const T* const c_p1, const T* const c_p2, const T* const c_p3, T* residual) const
     {
+      const T* blocks[3] = { c_p1, c_p2, c_p3 };
+      return(evaluate(blocks, residual));
     }
 
     template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters [6]*/
-		    const T* const c_p2, /** 6Dof transform of target into world frame [6]*/
-		    const T* const point, /** point described in target frame that is being seen [3]*/
+    bool operator()(const T* const c_p1, const T* const c_p2, const T* const c_p3, const T* const c_p4,
 		    T* residual) const
     {
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      const T *target_aa(& c_p2[0]);
-      const T *target_tx(& c_p2[3]);
-      T world_point[3]; /** point in world coordinates */
-      T camera_point[3];  /** point in camera coordinates*/ 
-      T R_WtoC[9]; // rotation from world to camera coordinates
-      T R_TtoW[9]; // rotation from target to world coordinates
-      T R_TtoC[9];  // rotation from target to camera coordinates (assume circle lies in x-y plane of target coordinates)
-
-      /** compute necessary rotation matrices */
-      ceres::AngleAxisToRotationMatrix(camera_aa, R_WtoC);  
-      ceres::AngleAxisToRotationMatrix(target_aa, R_TtoW);
-      
-      /** transform point into camera coordinates */
-      transformPoint(target_aa, target_tx, point, world_point);
-      transformPoint(camera_aa, camera_tx, world_point, camera_point);
-      
-      /** find rotation from target to camera coordinates */
-      rotationProduct(R_WtoC, R_TtoW, R_TtoC); // R_WtoC*R_TtoW = R_TtoC
-      
-      /** compute project point into image plane and compute residual */
-      T circle_diameter = T(circle_diameter_);
-      T fx = T(fx_);
-      T fy = T(fy_);
-      T cx = T(cx_);
-      T cy = T(cy_);
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraCircResidual(camera_point, circle_diameter, R_TtoC, fx, fy,cx,cy, ox, oy, residual);
-
-      return true;
-    } /** end of operator() */
-    
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-    static ceres::CostFunction* Create(const double o_x, const double o_y, const double c_dia, 
-				       const double fx, const double fy, const double cx, const double cy)
-    {
-      return (new ceres::AutoDiffCostFunction<CircleTargetCameraReprjError, 2, 6, 6, 3>(new CircleTargetCameraReprjError(o_x, o_y, c_dia, fx, fy, cx, cy)));
+      const T* blocks[4] = { c_p1, c_p2, c_p3, c_p4 };
+      return(evaluate(blocks, residual));
     }
-    double ox_; /** observed x location of object in image */
-    double oy_; /** observed y location of object in image */
-    double circle_diameter_; //** diameter of circle being observed */
-    double fx_; /** focal length of camera in x (pixels) */
-    double fy_; /** focal length of camera in y (pixels) */
-    double cx_; /** focal center of camera in x (pixels) */
-    double cy_; /** focal center of camera in y (pixels) */
-  };
-
-  class  CircleTargetCameraReprjErrorPK
-  {
-  public:
-    CircleTargetCameraReprjErrorPK(double ob_x, double ob_y, double c_dia, double fx, double fy, double cx, double cy, Point3d point) :
-      ox_(ob_x), oy_(ob_y), circle_diameter_(c_dia), fx_(fx), fy_(fy), cx_(cx), cy_(cy), point_(point)
-    {
-    }
-
-    template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters [6] */
-		    const T* const c_p2,  /** 6Dof transform of target into world frame [6] */
-		    T* residual) const
-    {
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      const T *target_aa(& c_p2[0]);
-      const T *target_tx(& c_p2[3]);
-      T world_point[3]; /** point in world coordinates */
-      T camera_point[3]; /** point in camera coordinates */
-      T R_WtoC[9]; // rotation from world to camera coordinates
-      T R_TtoW[9]; // rotation from target to world coordinates
-      T R_TtoC[9];  // rotation from target to camera coordinates (assume circle lies in x-y plane of target coordinates)
-
-      /** compute necessary rotation matrices */
-      ceres::AngleAxisToRotationMatrix(camera_aa, R_WtoC);  
-      ceres::AngleAxisToRotationMatrix(target_aa, R_TtoW);
-
-      /** transform point into camera frame */
-      transformPoint3d(target_aa, target_tx, point_, world_point);
-      transformPoint(camera_aa, camera_tx, world_point, camera_point);
-
-      /** find rotation from target to camera coordinates */
-      rotationProduct(R_WtoC, R_TtoW, R_TtoC); // R_WtoC*R_TtoW = R_TtoC
-      
-      /** compute project point into image plane and compute residual */
-      T circle_diameter = T(circle_diameter_);
-      T fx = T(fx_);
-      T fy = T(fy_);
-      T cx = T(cx_);
-      T cy = T(cy_);
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraCircResidual(camera_point, circle_diameter, R_TtoC, fx, fy,cx,cy, ox, oy, residual);
-
-      return true;
-    } /** end of operator() */
 
     /** Factory to hide the construction of the CostFunction object from */
     /** the client code. */
-    static ceres::CostFunction* Create(const double o_x, const double o_y, const double c_dia,
-				       const double fx, const double fy, const double cx, const double cy,
-				       Point3d point)
-    {
-      return (new ceres::AutoDiffCostFunction<CircleTargetCameraReprjErrorPK, 2, 6, 6>(											       new CircleTargetCameraReprjErrorPK(o_x, o_y, c_dia, fx, fy, cx, cy, point)));
-    }
-    double ox_; /** observed x location of object in image */
-    double oy_; /** observed y location of object in image */
-    double circle_diameter_; //** diameter of circle being observed */
-    double fx_; /** focal length of camera in x (pixels) */
-    double fy_; /** focal length of camera in y (pixels) */
-    double cx_; /** focal center of camera in x (pixels) */
-    double cy_; /** focal center of camera in y (pixels) */
-    Point3d point_;
-  };
-
-  class  LinkCircleTargetCameraReprjError
-  {
-  public:
-    LinkCircleTargetCameraReprjError(double ob_x, double ob_y, double c_dia, double fx, double fy, double cx, double cy, Pose6d link_pose) :
-      ox_(ob_x), oy_(ob_y), circle_diameter_(c_dia), fx_(fx), fy_(fy), cx_(cx), cy_(cy), link_pose_(link_pose)
-    {
-    }
-
-    template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters [6]*/
-		    const T* const c_p2, /** 6Dof transform of target into world frame [6]*/
-		    const T* const point, /** point described in target frame that is being seen [3]*/
-		    T* residual) const
-    {
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      const T *target_aa(& c_p2[0]);
-      const T *target_tx(& c_p2[3]);
-      T link_point[3]; /** point in link coordinates */
-      T world_point[3]; /** point in world coordinates */
-      T camera_point[3];  /** point in camera coordinates*/ 
-      T R_WtoC[9]; // rotation from world to camera coordinates
-      T R_TtoL[9]; // rotation from target to linkcoordinates
-      T R_LtoW[9]; // rotation from link to world coordinates
-      T R_TtoC[9];  // rotation from target to camera coordinates (assume circle lies in x-y plane of target coordinates)
-      T R_LtoC[9]; // rotation from link to camera coordinates
-
-      /** get necessary rotation matrices */
-      ceres::AngleAxisToRotationMatrix(camera_aa, R_WtoC);  
-      ceres::AngleAxisToRotationMatrix(target_aa, R_TtoL);
-      poseRotationMatrix(link_pose_, R_LtoW);
-
-      /** transform point into camera coordinates */
-      transformPoint(target_aa, target_tx, point, link_point);
-      poseTransformPoint(link_pose_, link_point, world_point);
-      transformPoint(camera_aa, camera_tx, world_point, camera_point);
-      
-      /** find rotation from target to camera coordinates */
-      rotationProduct(R_WtoC, R_LtoW, R_LtoC);
-      rotationProduct(R_LtoC, R_TtoL, R_TtoC); // R_WtoC*R_LtoW*R_TtoL = R_TtoC
-      
-      /** compute project point into image plane and compute residual */
-      T circle_diameter = T(circle_diameter_);
-      T fx = T(fx_);
-      T fy = T(fy_);
-      T cx = T(cx_);
-      T cy = T(cy_);
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraCircResidual(camera_point, circle_diameter, R_TtoC, fx, fy,cx,cy, ox, oy, residual);
-
-      return true;
-    } /** end of operator() */
-    
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-    static ceres::CostFunction* Create(const double o_x, const double o_y, const double c_dia,
-				       const double fx,  const double fy,
-				       const double cx,  const double cy,
-				       const Pose6d pose)
-    {
-      return (new ceres::AutoDiffCostFunction<LinkCircleTargetCameraReprjError, 2, 6, 6, 3>(new LinkCircleTargetCameraReprjError(o_x, o_y, c_dia, fx, fy, cx, cy, pose)));
-    }
-    double ox_; /** observed x location of object in image */
-    double oy_; /** observed y location of object in image */
-    double circle_diameter_; /** diameter of circle being observed */
-    Pose6d link_pose_; /** transform from link to world coordinates*/
-    double fx_; /** focal length of camera in x (pixels) */
-    double fy_; /** focal length of camera in y (pixels) */
-    double cx_; /** focal center of camera in x (pixels) */
-    double cy_; /** focal center of camera in y (pixels) */ 
- };
-
-  class  LinkCircleTargetCameraReprjErrorPK
-  {
-  public:
-  LinkCircleTargetCameraReprjErrorPK(double ob_x, double ob_y, double c_dia, double fx, double fy, double cx, double cy, 
-				     Pose6d link_pose, Point3d point) :
-    ox_(ob_x), oy_(ob_y), circle_diameter_(c_dia), fx_(fx), fy_(fy), cx_(cx), cy_(cy), link_pose_(link_pose), point_(point)
-    {
+    static ceres::CostFunction* Create(const ReprojectionInputs &inputs)
+    {
+      return (new ceres::AutoDiffCostFunction<ReprojectionError, 2, 6, SIZE1, SIZE2, SIZE3>(new ReprojectionError(inputs)));
+    }
+
+    /** @brief creates the cost function and lists the blocks it expects, in order
+     *  @param inputs the known quantities
+     *  @param extrinsics, intrinsics, target_pose, point candidate blocks, only the estimated ones are used
+     *  @param parameter_blocks output, the blocks to pass to AddResidualBlock
+     *  @param rotation_cache when not NULL, the estimated pose blocks are registered and their rotations read from it
+     */
+    static ceres::CostFunction* Create(const ReprojectionInputs &inputs,
+				       P_BLOCK extrinsics, P_BLOCK intrinsics, P_BLOCK target_pose, P_BLOCK point,
+				       std::vector<P_BLOCK> &parameter_blocks, RotationCache *rotation_cache)
+    {
+      if(rotation_cache != NULL){
+	ReprojectionInputs cached_inputs = inputs;
+	cached_inputs.camera_rotation = rotation_cache->add(extrinsics);
+	if(Target::FREE) cached_inputs.target_rotation = rotation_cache->add(target_pose);
+	return(Create(cached_inputs, extrinsics, intrinsics, target_pose, point, parameter_blocks, NULL));
+      }
+      parameter_blocks.clear();
+      parameter_blocks.push_back(extrinsics);
+      if(Intrinsics::FREE) parameter_blocks.push_back(intrinsics);
+      if(Target::FREE) parameter_blocks.push_back(target_pose);
+      if(Point::FREE) parameter_blocks.push_back(point);
+      return(Create(inputs));
     }
 
+  private:
     template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters [6] */
-		    const T* const c_p2,  /** 6Dof transform of target into world frame [6] */
-		    T* residual) const
+    bool evaluate(const T* const* blocks, T* residual) const
     {
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      const T *target_aa(& c_p2[0]);
-      const T *target_tx(& c_p2[3]);
-      T link_point[3]; /** point in link coordinates */
-      T world_point[3];/** point in world coordinates */
-      T camera_point[3]; /** point in camera coordinates */
-      T R_WtoC[9]; // rotation from world to camera coordinates
-      T R_TtoL[9]; // rotation from target to linkcoordinates
-      T R_LtoW[9]; // rotation from link to world coordinates
-      T R_LtoC[9]; // rotation from link to camera coordinataes
-      T R_TtoC[9];  // rotation from target to camera coordinates (assume circle lies in x-y plane of target coordinates)
-
-      /** compute necessary rotation matrices */
-      ceres::AngleAxisToRotationMatrix(camera_aa, R_WtoC);  
-      ceres::AngleAxisToRotationMatrix(target_aa, R_TtoL);
-      poseRotationMatrix(link_pose_,R_LtoW);
-
-      /** transform point into camera frame */
-      transformPoint3d(target_aa, target_tx, point_, link_point);
-      poseTransformPoint(link_pose_, link_point, world_point);
-      transformPoint(camera_aa, camera_tx, world_point, camera_point);
-
-      /** find rotation from target to camera coordinates */
-      rotationProduct(R_WtoC, R_LtoW, R_LtoC);
-      rotationProduct(R_LtoC, R_TtoL, R_TtoC); // R_WtoC*R_LtoW*R_TtoL = R_TtoC
-      
-      /** compute project point into image plane and compute residual */
-      T circle_diameter = T(circle_diameter_);
-      T fx = T(fx_);
-      T fy = T(fy_);
-      T cx = T(cx_);
-      T cy = T(cy_);
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraCircResidual(camera_point, circle_diameter, R_TtoC, fx, fy,cx,cy, ox, oy, residual);
+      const T *camera_aa(&blocks[0][0]);
+      const T *camera_tx(&blocks[0][3]);
+      const T *intrinsics_block = Intrinsics::FREE ? blocks[INTRINSICS_INDEX] : NULL;
+      const T *target_block = Target::FREE ? blocks[TARGET_INDEX] : NULL;
+      const T *point_block = Point::FREE ? blocks[POINT_INDEX] : NULL;
 
-      return true;
-    } /** end of operator() */
-
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-    static ceres::CostFunction* Create(const double o_x, const double o_y, const double c_dia,
-				       const double fx,  const double fy,
-				       const double cx,  const double cy,
-				       const Pose6d pose, Point3d point)
-    {
-      return (new ceres::AutoDiffCostFunction<LinkCircleTargetCameraReprjErrorPK, 2, 6, 6>
-	      (
-	       new LinkCircleTargetCameraReprjErrorPK(o_x, o_y, c_dia, fx, fy, cx, cy, pose, point)
-	       )
-	      );
-    }
-    double ox_; /** observed x location of object in image */
-    double oy_; /** observed y location of object in image */
-    double circle_diameter_; //** diameter of circle being observed */
-    Pose6d link_pose_; /** transform from link to world coordinates*/
-    double fx_; /** focal length of camera in x (pixels) */
-    double fy_; /** focal length of camera in y (pixels) */
-    double cx_; /** focal center of camera in x (pixels) */
-    double cy_; /** focal center of camera in y (pixels) */
-    Point3d point_; /** point expressed in target coordinates */
-  };
-
-
-  class  LinkCameraCircleTargetReprjError
-  {
-  public:
-    LinkCameraCircleTargetReprjError(double ob_x, double ob_y, double c_dia,
-				     double fx, double fy, double cx, double cy, Pose6d link_pose) :
-      ox_(ob_x), oy_(ob_y), circle_diameter_(c_dia), fx_(fx), fy_(fy), cx_(cx), cy_(cy), link_pose_(link_pose)
-    {
-      link_posei_ = link_pose_.getInverse();
-    }
+      /** move the point from target, through link, to camera coordinates */
+      T point[3];
+      Point::get(point_block, point_, point);
+      T world_point[3]; /** point in reference coordinates, or link coordinates when the target is on a link */
+      T R_target[9]; /** rotation of an estimated target pose */
+      if(!Target::PRESENT){
+	for(int i=0; i<3; i++) world_point[i] = point[i];
+      }
+      else if(Target::FREE){
+	cachedRotationMatrix(target_rotation_, &target_block[0], R_target);
+	matrixTransformPoint(R_target, &target_block[3], point, world_point);
+      }
+      else{
+	knownTransformPoint(target_R_, target_tx_, point, world_point);
+      }
+      T link_point[3];
+      if(Link::PRESENT){
+	knownTransformPoint(link_R_, link_tx_, world_point, link_point);
+      }
+      else{
+	for(int i=0; i<3; i++) link_point[i] = world_point[i];
+      }
+      T R_camera[9];
+      cachedRotationMatrix(camera_rotation_, camera_aa, R_camera);
+      T camera_point[3];
+      matrixTransformPoint(R_camera, camera_tx, link_point, camera_point);
 
-    template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters [6]*/
-		    const T* const c_p2, /** 6Dof transform of target into world frame [6]*/
-		    const T* const point, /** point described in target frame that is being seen [3]*/
-		    T* residual) const
-    {
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      const T *target_aa(& c_p2[0]);
-      const T *target_tx(& c_p2[3]);
-      T world_point[3]; /** point in world coordinates */
-      T link_point[3]; /** point in link coordinates */
-      T camera_point[3];  /** point in camera coordinates*/ 
-      T R_LtoC[9]; // rotation from link to camera coordinates
-      T R_WtoL[9]; // rotation from world to link coordinates
-      T R_WtoC[9]; // rotation from world to camera coordinates, and intermediate transform
-      T R_TtoW[9]; // rotation from target to world coordinates
-      T R_TtoC[9];  // rotation from target to camera coordinates (assume circle lies in x-y plane of target coordinates)
-
-      /** compute necessary rotation matrices */
-      ceres::AngleAxisToRotationMatrix(camera_aa, R_LtoC);  
-      poseRotationMatrix(link_pose_, R_WtoL);
-      ceres::AngleAxisToRotationMatrix(target_aa, R_TtoW);
-      
-      /** transform point into camera coordinates */
-      transformPoint(target_aa, target_tx, point, world_point);
-      poseTransformPoint(link_posei_, world_point, link_point);
-      transformPoint(camera_aa, camera_tx, link_point, camera_point);
-      
-      /** find rotation from target to camera coordinates */
-      rotationProduct(R_LtoC,R_WtoL, R_WtoC);
-      rotationProduct(R_WtoC, R_TtoW, R_TtoC); 
-      
-      /** compute project point into image plane and compute residual */
-      T circle_diameter = T(circle_diameter_);
-      T fx = T(fx_);
-      T fy = T(fy_);
-      T cx = T(cx_);
-      T cy = T(cy_);
+      T k[9]; /** fx, fy, cx, cy, k1, k2, k3, p1, p2 */
+      Intrinsics::get(intrinsics_block, intrinsics_, k);
       T ox = T(ox_);
       T oy = T(oy_);
-      cameraCircResidual(camera_point, circle_diameter, R_TtoC, fx, fy,cx,cy, ox, oy, residual);
-
-      return true;
-    } /** end of operator() */
-    
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-    static ceres::CostFunction* Create(const double o_x, const double o_y, const double c_dia,
-				       double fx, double fy, double cx, double cy, const Pose6d pose)
-    {
-      return (new ceres::AutoDiffCostFunction<LinkCameraCircleTargetReprjError, 2, 6, 6, 3>
-	      (new LinkCameraCircleTargetReprjError(o_x, o_y, c_dia, fx, fy, cx, cy, pose)));
-    }
-    double ox_; /** observed x location of object in image */
-    double oy_; /** observed y location of object in image */
-    double circle_diameter_; /** diameter of circle being observed */
-    Pose6d link_pose_; /** transform from link to world coordinates*/
-    Pose6d link_posei_; /** transform from world to link coordinates*/
-    double fx_; /** focal length of camera in x (pixels) */
-    double fy_; /** focal length of camera in y (pixels) */
-    double cx_; /** focal center of camera in x (pixels) */
-    double cy_; /** focal center of camera in y (pixels) */
-
-  };
 
-  class  LinkCameraCircleTargetReprjErrorPK
-  {
-  public:
-    LinkCameraCircleTargetReprjErrorPK(const double &ob_x, const double &ob_y, const double &c_dia,
-				       const double &fx, const double &fy, const double &cx, const double &cy,
-				       const Pose6d &link_pose, const Point3d &point) :
-      ox_(ob_x), oy_(ob_y), circle_diameter_(c_dia), fx_(fx), fy_(fy), cx_(cx), cy_(cy), link_pose_(link_pose), point_(point)
-    {
-      link_posei_ = link_pose_.getInverse();
-    }
+      if(!Projection::CIRCLE){
+	if(Distortion::ENABLED){
+	  cameraPntResidualDist(camera_point, k[4], k[5], k[6], k[7], k[8], k[0], k[1], k[2], k[3], ox, oy, residual);
+	}
+	else{
+	  cameraPntResidual(camera_point, k[0], k[1], k[2], k[3], ox, oy, residual);
+	}
+	return true;
+      }
 
-    void test_residual(const double *c_p1, const double  *c_p2, double *residual)
-    {
-      const double *camera_aa(&c_p1[0]);
-      const double *camera_tx(&c_p1[3]);
-      const double *target_aa(&c_p2[0]);
-      const double *target_tx(&c_p2[3]);
-      double point[3]; /** point in target coordinates */
-      double world_point[3]; /** point in world coordinates */
-      double link_point[3]; /** point in link coordinates */
-      double camera_point[3];  /** point in camera coordinates*/ 
-      double R_LtoC[9]; // rotation from link to camera coordinates
-      double R_WtoL[9]; // rotation from world to link coordinates
-      double R_WtoC[9]; // rotation from world to camera coordinates, and intermediate transform
-      double R_TtoW[9]; // rotation from target to world coordinates
-      double R_TtoC[9];  // rotation from target to camera coordinates (assume circle lies in x-y plane of target coordinates)
-      /** get necessary rotation matrices */
-      ceres::AngleAxisToRotationMatrix(camera_aa, R_LtoC);  
-      printf("camera_aa = %6.3lf %6.3lf %6.3lf\n", camera_aa[0], camera_aa[1], camera_aa[2]);
-      printf("R_camera \n");
-      for(int i=0;i<3;i++){
-	for(int j=0;j<3;j++){
-	  printf("%6.3lf",R_LtoC[i+j*3]);
-	  }
-	printf("\n");
+      /** find rotation from target to camera coordinates, R_WtoC*R_LtoW*R_TtoL = R_TtoC */
+      T R_TtoC[9];
+      for(int i=0; i<9; i++) R_TtoC[i] = R_camera[i];
+      if(Link::PRESENT){
+	T R_link[9], R_product[9];
+	for(int i=0; i<9; i++) R_link[i] = T(link_R_[i]);
+	rotationProduct(R_TtoC, R_link, R_product);
+	for(int i=0; i<9; i++) R_TtoC[i] = R_product[i];
       }
-      poseRotationMatrix(link_posei_,R_WtoL);
-      printf("R_inverse link\n");
-      for(int i=0;i<3;i++){
-	for(int j=0;j<3;j++){
-	  printf("%6.3lf",R_WtoL[i+j*3]);
-	  }
-	printf("\n");
+      if(Target::PRESENT){
+	T R_product[9];
+	if(!Target::FREE){
+	  for(int i=0; i<9; i++) R_target[i] = T(target_R_[i]);
+	}
+	rotationProduct(R_TtoC, R_target, R_product);
+	for(int i=0; i<9; i++) R_TtoC[i] = R_product[i];
       }
 
-      ceres::AngleAxisToRotationMatrix(target_aa, R_TtoW);
-      printf("R_target\n");
-      for(int i=0;i<3;i++){
-	for(int j=0;j<3;j++){
-	  printf("%6.3lf",R_TtoW[i+j*3]);
-	  }
-	printf("\n");
-      }
-      
-      printf("point_ = %6.3lf  %6.3lf %6.3lf\n", point_.x, point_.y, point_.z);
-      /** transform point into camera coordinates */
-      transformPoint3d(target_aa, target_tx, point_, world_point);
-      printf("world_point = %6.3lf  %6.3lf %6.3lf\n", world_point[0], world_point[1], world_point[2]);
-      poseTransformPoint(link_posei_, world_point, link_point);
-      printf("link_point = %6.3lf  %6.3lf %6.3lf\n", link_point[0], link_point[1], link_point[2]);
-      transformPoint(camera_aa, camera_tx, link_point, camera_point);
-      printf("camera_point = %6.3lf  %6.3lf %6.3lf\n", camera_point[0], camera_point[1], camera_point[2]);
-
-      /** find rotation from target to camera coordinates */
-      rotationProduct(R_LtoC, R_WtoL, R_WtoC);
-      rotationProduct(R_WtoC, R_TtoW, R_TtoC); 
-
-      /** compute project point into image plane and compute residual */
-      double circle_diameter = circle_diameter_;
-      double fx = fx_;
-      double fy = fy_;
-      double cx = cx_;
-      double cy = cy_;
-      double ox = ox_;
-      double oy = oy_;
-      //      cameraCircResidual(camera_point, circle_diameter, R_TtoC, fx, fy,cx,cy, ox, oy, residual);
-      cameraPntResidual(camera_point, fx, fy,cx,cy, ox, oy, residual);
-      
-    }
-    template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters [6] */
-		    const T* const c_p2,  /** 6Dof transform of target into world frame [6] */
-		    T* residual) const
-    {
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      const T *target_aa(&c_p2[0]);
-      const T *target_tx(&c_p2[3]);
-      T point[3]; /** point in target coordinates */
-      T world_point[3]; /** point in world coordinates */
-      T link_point[3]; /** point in link coordinates */
-      T camera_point[3];  /** point in camera coordinates*/ 
-      T R_LtoC[9]; // rotation from link to camera coordinates
-      T R_WtoL[9]; // rotation from world to link coordinates
-      T R_WtoC[9]; // rotation from world to camera coordinates, and intermediate transform
-      T R_TtoW[9]; // rotation from target to world coordinates
-      T R_TtoC[9];  // rotation from target to camera coordinates (assume circle lies in x-y plane of target coordinates)
-
-      /** get necessary rotation matrices */
-      ceres::AngleAxisToRotationMatrix(camera_aa, R_LtoC);  
-      poseRotationMatrix(link_posei_,R_WtoL);
-      ceres::AngleAxisToRotationMatrix(target_aa, R_TtoW);
-
-      /** transform point into camera coordinates */
-      transformPoint3d(target_aa, target_tx, point_, world_point);
-      poseTransformPoint(link_posei_, world_point, link_point);
-      transformPoint(camera_aa, camera_tx, link_point, camera_point);
-
-      /** find rotation from target to camera coordinates */
-      rotationProduct(R_LtoC, R_WtoL, R_WtoC);
-      rotationProduct(R_WtoC, R_TtoW, R_TtoC); 
-
-      /** compute project point into image plane and compute residual */
       T circle_diameter = T(circle_diameter_);
-      T fx = T(fx_);
-      T fy = T(fy_);
-      T cx = T(cx_);
-      T cy = T(cy_);
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraCircResidual(camera_point, circle_diameter, R_TtoC, fx, fy,cx,cy, ox, oy, residual);
-
+      if(Distortion::ENABLED){
+	cameraCircResidualDist(camera_point, circle_diameter, R_TtoC, k[4], k[5], k[6], k[7], k[8],
+			       k[0], k[1], k[2], k[3], ox, oy, residual);
+      }
+      else{
+	cameraCircResidual(camera_point, circle_diameter, R_TtoC, k[0], k[1], k[2], k[3], ox, oy, residual);
+      }
       return true;
-    } /** end of operator() */
+    } /** end of evaluate() */
 
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-    static ceres::CostFunction* Create(const double &o_x, const double &o_y, const double &c_dia,
-				       const double &fx,  const double &fy,
-				       const double &cx, const double &cy,
-				       const Pose6d &pose, Point3d &point)
-    {
-      return (new ceres::AutoDiffCostFunction<LinkCameraCircleTargetReprjErrorPK, 2, 6, 6>
-	      (new LinkCameraCircleTargetReprjErrorPK(o_x, o_y, c_dia, fx, fy, cx, cy, pose, point)));
-    }
     double ox_; /** observed x location of object in image */
     double oy_; /** observed y location of object in image */
-    double circle_diameter_; //** diameter of circle being observed */
-    Pose6d link_pose_; /** transform from link to world coordinates*/
-    Pose6d link_posei_; /** transform from world to link coordinates*/
-    double fx_; /** focal length of camera in x (pixels) */
-    double fy_; /** focal length of camera in y (pixels) */
-    double cx_; /** focal center of camera in x (pixels) */
-    double cy_; /** focal center of camera in y (pixels) */
-    Point3d point_; /** point expressed in target coordinates */
-
+    double circle_diameter_; /** diameter of circle being observed */
+    double intrinsics_[9]; /** known intrinsics */
+    Point3d point_; /** known location of point in target coordinates */
+    double target_R_[9]; /** rotation of the known target pose, column major */
+    double target_tx_[3]; /** translation of the known target pose */
+    double link_R_[9]; /** rotation of the link transform, column major */
+    double link_tx_[3]; /** translation of the link transform */
+    const RotationCacheEntry *camera_rotation_; /** cached rotation of the extrinsics, may be NULL */
+    const RotationCacheEntry *target_rotation_; /** cached rotation of the target pose, may be NULL */
   };
 
-  class  FixedCircleTargetCameraReprjErrorPK
-  {
-  public:
-    FixedCircleTargetCameraReprjErrorPK(const double &ob_x, const double &ob_y, const double &c_dia,
-					const double &fx, const double &fy, const double &cx, const double &cy,
-					const Pose6d &target_pose,
-					const Pose6d &camera_mounting_pose,
-					const Point3d &point) :
-      ox_(ob_x), oy_(ob_y), circle_diameter_(c_dia), fx_(fx), fy_(fy), cx_(cx), cy_(cy), 
-      target_pose_(target_pose), camera_mounting_pose_(camera_mounting_pose), point_(point)
-    {
-      // compute pose which transforms point in target frame to the mounting frame
-      mount_to_target_pose_ = camera_mounting_pose_.getInverse() * target_pose_;
-    }
+  // The cost types, see createObservationCost() for the table which maps Cost_function to these
 
-    void test_residual(const double *c_p1, double *resid)
-    {
-      const double *camera_aa(&c_p1[0]);
-      const double *camera_tx(&c_p1[3]);
-      double mount_point[3]; /** point in world coordinates */
-      double camera_point[3];  /** point in camera coordinates */ 
-      double point[3]; /** point in world coordinates  */
-      point[0] = point_.x;
-      point[1] = point_.y;
-      point[2] = point_.z;
-      /** transform point into camera coordinates */
-      poseTransformPoint(mount_to_target_pose_, point, mount_point);
-      printf("mount_point = %6.3lf  %6.3lf %6.3lf\n", mount_point[0], mount_point[1], mount_point[2]);
-      transformPoint(camera_aa, camera_tx, mount_point, camera_point);
-      printf("camera_point = %6.3lf  %6.3lf %6.3lf\n", camera_point[0], camera_point[1], camera_point[2]);
-
-      double R_optical_to_mount[9]; /** rotation from optical to camera mounting frame */
-      double R_mount_to_target[9]; /** rotation from mounting frame to target frame */
-
-      /** get necessary rotation matrices */
-      ceres::AngleAxisToRotationMatrix(camera_aa, R_optical_to_mount);  
-      poseRotationMatrix(mount_to_target_pose_, R_mount_to_target);
-
-      /** compute project point into image plane and compute residual */
-      double circle_diameter = circle_diameter_;
-      double fx = fx_;
-      double fy = fy_;
-      double cx = cx_;
-      double cy = cy_;
-      double ox = ox_;
-      double oy = oy_;
-      cameraCircResidual(camera_point, circle_diameter, R_mount_to_target, fx, fy,cx,cy, ox, oy, resid);
-    }
-    template<typename T>
-    bool operator()(const T* const c_p1, /** extrinsic parameters [6] */
-		    T* resid) const
-    {
-      const T *camera_aa(&c_p1[0]);
-      const T *camera_tx(&c_p1[3]);
-      T mount_point[3]; /** point in world coordinates */
-      T camera_point[3];  /** point in camera coordinates */ 
-      T R_optical_to_mount[9]; /** rotation from optical to camera mounting frame */
-      T R_mount_to_target[9]; /** rotation from mounting frame to target frame */
-      T R_optical_to_target[9]; /** rotation from optical frame to target frame */
-      T point[3];
-      point[0] = T(point_.x);
-      point[1] = T(point_.y);
-      point[2] = T(point_.z);
-
-      /** get necessary rotation matrices */
-      ceres::AngleAxisToRotationMatrix(camera_aa, R_optical_to_mount);  
-      poseRotationMatrix(mount_to_target_pose_,R_mount_to_target);
-
-      /** transform point into camera coordinates */
-      poseTransformPoint(mount_to_target_pose_, point, mount_point);
-      transformPoint(camera_aa, camera_tx, mount_point, camera_point);
-
-      /** find rotation from target to camera coordinates */
-      rotationProduct(R_optical_to_mount, R_mount_to_target, R_optical_to_target);
+  // reprojection error of a single simple point observed by a camera with lens distortion
+  // both extrinsic and intrinsic parameters of camera are being computed
+  typedef ReprojectionError<FreeIntrinsics, Distorted, PointProjection, NoTarget, NoLink, FreePoint> CameraReprjErrorWithDistortion;
+  typedef ReprojectionError<FreeIntrinsics, Distorted, PointProjection, NoTarget, NoLink, KnownPoint> CameraReprjErrorWithDistortionPK;
 
-      /** compute project point into image plane and compute residual */
-      T circle_diameter = T(circle_diameter_);
-      T fx = T(fx_);
-      T fy = T(fy_);
-      T cx = T(cx_);
-      T cy = T(cy_);
-      T ox = T(ox_);
-      T oy = T(oy_);
-      cameraCircResidual(camera_point, circle_diameter, R_optical_to_target, fx, fy,cx,cy, ox, oy, resid);
-      return true;
-    } /** end of operator() */
+  // reprojection error of a single simple point observed by a camera with NO lens distortion
+  // should subscribe to a rectified image when using the error function
+  typedef ReprojectionError<KnownIntrinsics, Undistorted, PointProjection, NoTarget, NoLink, FreePoint> CameraReprjError;
+  typedef ReprojectionError<KnownIntrinsics, Undistorted, PointProjection, NoTarget, NoLink, KnownPoint> CameraReprjErrorPK;
 
-    /** Factory to hide the construction of the CostFunction object from */
-    /** the client code. */
-    static ceres::CostFunction* Create(const double &o_x, const double &o_y, const double &c_dia,
-				       const double &fx,  const double &fy,
-				       const double &cx, const double &cy,
-				       const Pose6d &target_pose, 
-				       const Pose6d &camera_mounting_pose,
-				       Point3d &point)
-    {
-      return (new ceres::AutoDiffCostFunction< FixedCircleTargetCameraReprjErrorPK, 2, 6>
-	      (new FixedCircleTargetCameraReprjErrorPK(o_x, o_y, c_dia, fx, fy, cx, cy, target_pose, camera_mounting_pose, point)));
-    }
-    double ox_; /** observed x location of object in image */
-    double oy_; /** observed y location of object in image */
-    double circle_diameter_; //** diameter of circle being observed */
-    Pose6d target_pose_; /** pose of target relative to the reference coordinate frame */
-    Pose6d camera_mounting_pose_; /** pose camera mounting frame relative to the reference coordinate frame */
-    Pose6d mount_to_target_pose_; /** pose of target frame relative to camera's mounting frame */
-    double fx_; /** focal length of camera in x (pixels) */
-    double fy_; /** focal length of camera in y (pixels) */
-    double cx_; /** focal center of camera in x (pixels) */
-    double cy_; /** focal center of camera in y (pixels) */
-    Point3d point_; /** point expressed in target coordinates */
-  };
+  // reprojection error of a single point attatched to a target observed by a camera with NO lens distortion
+  typedef ReprojectionError<KnownIntrinsics, Undistorted, PointProjection, FreeTarget, NoLink, FreePoint> TargetCameraReprjError;
+  typedef ReprojectionError<KnownIntrinsics, Undistorted, PointProjection, FreeTarget, NoLink, KnownPoint> TargetCameraReprjErrorPK;
+  typedef ReprojectionError<KnownIntrinsics, Undistorted, PointProjection, FreeTarget, TargetOnLink, FreePoint> LinkTargetCameraReprjError;
+  typedef ReprojectionError<KnownIntrinsics, Undistorted, PointProjection, FreeTarget, TargetOnLink, KnownPoint> LinkTargetCameraReprjErrorPK;
+  typedef ReprojectionError<KnownIntrinsics, Undistorted, PointProjection, FreeTarget, CameraOnLink, FreePoint> LinkCameraTargetReprjError;
+  typedef ReprojectionError<KnownIntrinsics, Undistorted, PointProjection, FreeTarget, CameraOnLink, KnownPoint> LinkCameraTargetReprjErrorPK;
+
+  // circle observations, WARNING without a target the circle is assumed to lie in the XY plane of the world
+  typedef ReprojectionError<FreeIntrinsics, Distorted, CircleProjection, NoTarget, NoLink, FreePoint> CircleCameraReprjErrorWithDistortion;
+  typedef ReprojectionError<FreeIntrinsics, Distorted, CircleProjection, NoTarget, NoLink, KnownPoint> CircleCameraReprjErrorWithDistortionPK;
+  typedef ReprojectionError<KnownIntrinsics, Undistorted, CircleProjection, NoTarget, NoLink, FreePoint> CircleCameraReprjError;
+  typedef ReprojectionError<KnownIntrinsics, Undistorted, CircleProjection, NoTarget, NoLink, KnownPoint> CircleCameraReprjErrorPK;
+  typedef ReprojectionError<FreeIntrinsics, Distorted, CircleProjection, FreeTarget, NoLink, FreePoint> CircleTargetCameraReprjErrorWithDistortion;
+  typedef ReprojectionError<FreeIntrinsics, Distorted, CircleProjection, FreeTarget, NoLink, KnownPoint> CircleTargetCameraReprjErrorWithDistortionPK;
+  typedef ReprojectionError<KnownIntrinsics, Undistorted, CircleProjection, FreeTarget, NoLink, FreePoint> CircleTargetCameraReprjError;
+  typedef ReprojectionError<KnownIntrinsics, Undistorted, CircleProjection, FreeTarget, NoLink, KnownPoint> CircleTargetCameraReprjErrorPK;
+  typedef ReprojectionError<KnownIntrinsics, Undistorted, CircleProjection, FreeTarget, TargetOnLink, FreePoint> LinkCircleTargetCameraReprjError;
+  typedef ReprojectionError<KnownIntrinsics, Undistorted, CircleProjection, FreeTarget, TargetOnLink, KnownPoint> LinkCircleTargetCameraReprjErrorPK;
+  typedef ReprojectionError<KnownIntrinsics, Undistorted, CircleProjection, FreeTarget, CameraOnLink, FreePoint> LinkCameraCircleTargetReprjError;
+  typedef ReprojectionError<KnownIntrinsics, Undistorted, CircleProjection, FreeTarget, CameraOnLink, KnownPoint> LinkCameraCircleTargetReprjErrorPK;
+
+  // the target is fixed and known, the camera is mounted on a link (its mounting frame)
+  typedef ReprojectionError<KnownIntrinsics, Undistorted, CircleProjection, FixedTarget, CameraOnLink, KnownPoint> FixedCircleTargetCameraReprjErrorPK;
 
 } // end of namespace
 #endif
@@ -0,0 +1,121 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONTINUOUS_CAPTURE_H_
+#define CONTINUOUS_CAPTURE_H_
+
+#include <industrial_extrinsic_cal/camera_definition.h>
+#include <industrial_extrinsic_cal/ros_camera_observer.h>
+#include <industrial_extrinsic_cal/pose_diversity.h>
+#include <industrial_extrinsic_cal/ros_transform_interface.h>
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+#include <sensor_msgs/Image.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <deque>
+#include <vector>
+
+namespace industrial_extrinsic_cal
+{
+
+  /*! \brief settings of a continuous capture */
+  typedef struct
+  {
+    int num_threads;			/**< detection workers */
+    int queue_size;			/**< images waiting for a worker, newer images are dropped when it is full */
+    PoseDiversityParameters selection;	/**< which frames are kept */
+  } ContinuousCaptureParameters;
+
+  /*! \brief fills in the defaults, all hardware threads, 8 waiting images, default selection */
+  ContinuousCaptureParameters defaultContinuousCaptureParameters();
+
+  /*! \brief a frame in which the target was found */
+  typedef struct
+  {
+    ros::Time stamp;			/**< the image's stamp, transforms are looked up at this time */
+    CameraObservations observations;	/**< the target's points found in the image */
+    FrameCandidate candidate;		/**< target pose in the camera and fit quality, used for the selection */
+  } CapturedFrame;
+
+  /*! \brief Streams a camera's images while the robot moves through a trajectory. A pool of workers finds the
+   *         target in every image as it arrives and estimates its pose from the camera's intrinsics. Only the
+   *         detections are kept, not the images. Once stopped, the frames are chosen for pose diversity and
+   *         detection quality, and each chosen frame becomes a scene.
+   */
+  class ContinuousCapture
+  {
+  public:
+    /*! \brief Constructor
+     *  \param camera the camera, its observer must be a ROSCameraObserver with the target added
+     *  \param parameters threads, queue and frame selection
+     */
+    ContinuousCapture(boost::shared_ptr<Camera> camera, const ContinuousCaptureParameters &parameters);
+
+    /*! \brief Destructor, stops the capture */
+    ~ContinuousCapture();
+
+    /*! \brief subscribes to the camera's images and starts the workers
+     *  \return false if the camera's observer can not detect in streamed images
+     */
+    bool start();
+
+    /*! \brief unsubscribes, lets the workers finish the waiting images and joins them */
+    void stop();
+
+    /*! \brief tf frames a worker snapshots at each frame's stamp as soon as the target is found in it, the frame
+     *         is dropped if they are not available. Set before start().
+     *  \param frames pairs as pulled for the scenes built from the frames, see SharedTransformListener::snapshot()
+     */
+    void setTFFrames(const std::vector<TFFramePair> &frames) { tf_frames_ = frames; };
+
+    /*! \brief the frames chosen for pose diversity and quality, in time order */
+    std::vector<CapturedFrame> selectFrames() const;
+
+    /*! \brief number of images received, detected and dropped because the workers fell behind */
+    void counts(int &received, int &detected, int &dropped) const;
+
+  private:
+    void imageCallback(const sensor_msgs::ImageConstPtr &image);
+    void worker();
+    bool estimatePose(const CameraObservations &observations, FrameCandidate &candidate) const;
+
+    boost::shared_ptr<Camera> camera_;
+    boost::shared_ptr<ROSCameraObserver> observer_;
+    ContinuousCaptureParameters parameters_;
+    bool check_frames_; /**< the observer's focus and saturation checks are enabled */
+    std::vector<TFFramePair> tf_frames_; /**< snapshot at each detected frame's stamp */
+    ros::NodeHandle nh_;
+    ros::CallbackQueue callback_queue_; /**< images are received on their own queue, the caller's spinner may be busy */
+    boost::shared_ptr<ros::AsyncSpinner> spinner_;
+    ros::Subscriber image_sub_;
+    boost::thread_group workers_;
+    mutable boost::mutex mutex_;
+    boost::condition_variable image_ready_;
+    std::deque<sensor_msgs::ImageConstPtr> waiting_; /**< images not yet taken by a worker */
+    std::vector<CapturedFrame> frames_; /**< frames in which the target was found */
+    bool running_;
+    bool stopping_;
+    int received_;
+    int dropped_;
+    int unposed_; /**< frames dropped because their poses were not available */
+  };
+
+}//end namespace industrial_extrinsic_cal
+
+#endif /* CONTINUOUS_CAPTURE_H_ */
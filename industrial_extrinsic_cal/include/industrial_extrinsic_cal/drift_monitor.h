@@ -0,0 +1,90 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DRIFT_MONITOR_H_
+#define DRIFT_MONITOR_H_
+
+#include <industrial_extrinsic_cal/observation_data_point.h>
+#include <industrial_extrinsic_cal/quality_report.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace industrial_extrinsic_cal
+{
+
+  /*! \brief settings of the drift monitor */
+  typedef struct
+  {
+    double threshold;		/**< rms reprojection error (pixels) above which a camera's calibration is suspect */
+    int consecutive;		/**< updates in a row above the threshold before a camera is declared drifted */
+    int min_observations;	/**< fewer observations of a camera in an update are ignored, e.g. a partly hidden target */
+    int max_observations;	/**< observations evaluated per camera and update, bounds the cost of an update, 0 is unlimited */
+  } DriftParameters;
+
+  /*! \brief fills in the defaults, 2 pixels three times in a row, at least 4 and at most 200 observations */
+  DriftParameters defaultDriftParameters();
+
+  /*! \brief drift state of one camera */
+  typedef struct
+  {
+    ReprojectionStatistics last;	/**< reprojection error of the camera in the last update which observed it */
+    int above_threshold;		/**< consecutive updates above the threshold */
+    bool drifted;			/**< true once above_threshold reaches the consecutive count */
+  } CameraDrift;
+
+  /*! \brief Watches a calibrated cell for drift. Each update evaluates the reprojection error of live observations
+   *         of targets with known poses against the stored calibration, without solving, and flags the cameras whose
+   *         error stays above a threshold. Only the residuals are evaluated, no jacobians, so an update is cheap.
+   */
+  class DriftMonitor
+  {
+  public:
+    /*! \brief Constructor
+     *  \param parameters threshold and observation counts
+     */
+    explicit DriftMonitor(const DriftParameters &parameters);
+
+    /*! \brief Destructor */
+    ~DriftMonitor(){};
+
+    /*! \brief evaluates one set of observations, their blocks hold the stored calibration
+     *  \param observations observations of one scene
+     *  \param known_target_blocks pose blocks of the targets whose pose is known, see Target::fixed_pose_,
+     *         observations of other targets are skipped since their pose was estimated along with the cameras
+     *  \return false if a cost could not be built or evaluated
+     */
+    bool update(const ObservationDataPointList &observations, const std::vector<P_BLOCK> &known_target_blocks);
+
+    /*! \brief drift state of each camera observed so far */
+    const std::map<std::string, CameraDrift>& cameras() const { return(cameras_); };
+
+    /*! \brief true if any camera has drifted */
+    bool drifted() const;
+
+    /*! \brief forgets every camera's state, e.g. after a re-calibration */
+    void reset() { cameras_.clear(); };
+
+  private:
+    DriftParameters parameters_;
+    std::map<std::string, CameraDrift> cameras_;
+  };
+
+}//end namespace industrial_extrinsic_cal
+
+#endif /* DRIFT_MONITOR_H_ */
@@ -0,0 +1,80 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRAME_QUALITY_H_
+#define FRAME_QUALITY_H_
+
+#include <industrial_extrinsic_cal/basic_types.h>
+#include <industrial_extrinsic_cal/ceres_costs_utils.h>
+#include <opencv2/core/core.hpp>
+
+namespace industrial_extrinsic_cal
+{
+
+  /*! \brief settings of the checks made on a frame before the target is searched for */
+  typedef struct
+  {
+    double min_focus;		/**< smallest variance of the Laplacian, lower is blurred, 0 disables */
+    int saturation_level;	/**< pixels at or above this gray level are saturated */
+    double max_saturated_fraction; /**< largest fraction of saturated pixels, 1 disables */
+    double max_viewing_angle;	/**< largest predicted angle between the target's normal and the line of sight (rad), 0 disables */
+    int max_regrabs;		/**< frames grabbed again after a frame fails, before detection is skipped */
+    int stride;			/**< every stride'th row and column is measured, bounds the cost on large images */
+  } FrameQualityParameters;
+
+  /*! \brief fills in the defaults, every check disabled, 2 regrabs, saturation at 250, every second pixel */
+  FrameQualityParameters defaultFrameQualityParameters();
+
+  /*! \brief true if any of the image checks is enabled */
+  bool frameChecksEnabled(const FrameQualityParameters &parameters);
+
+  /*! \brief the measures of one frame */
+  typedef struct
+  {
+    double focus;		/**< variance of the Laplacian */
+    double saturated_fraction;	/**< fraction of pixels at or above the saturation level */
+    const char *failure;	/**< the check the frame failed, NULL if it passed */
+  } FrameQuality;
+
+  /*! \brief measures focus and saturation in one pass over a sample of the pixels, about a millisecond for a VGA region
+   *  \param image a mono8 image, such as the region searched for the target, other types always pass
+   *  \param parameters thresholds and sampling stride
+   *  \param quality receives the measures
+   *  \return true if the frame is worth searching
+   */
+  bool checkFrameQuality(const cv::Mat &image, const FrameQualityParameters &parameters, FrameQuality &quality);
+
+  /*! \brief pose of a target in a camera as a cost type composes it: extrinsics, then the link, then the target
+   *  \param cost_type its chain decides which way the link goes, see costChain()
+   *  \param extrinsics the camera's extrinsics block
+   *  \param target_pose the target's pose block
+   *  \param intermediate_frame the link pose of a camera or target on a robot link
+   *  \param target_in_camera receives the pose
+   *  \return false if the cost type has no target pose, so nothing is predicted
+   */
+  bool predictTargetInCamera(Cost_function cost_type, const double *extrinsics, const double *target_pose,
+			     const Pose6d &intermediate_frame, Pose6d &target_in_camera);
+
+  /*! \brief angle between a target's normal, its z axis, and the line of sight from the camera (rad)
+   *  \return the angle, negative when the target sits at the camera's origin
+   */
+  double viewingAngle(const Pose6d &target_in_camera);
+
+}//end namespace industrial_extrinsic_cal
+
+#endif /* FRAME_QUALITY_H_ */
@@ -0,0 +1,153 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MULTI_START_OPTIMIZER_H_
+#define MULTI_START_OPTIMIZER_H_
+
+#include <industrial_extrinsic_cal/basic_types.h>
+#include <boost/function.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/thread/mutex.hpp>
+#include "ceres/ceres.h"
+#include <map>
+#include <vector>
+
+namespace industrial_extrinsic_cal
+{
+
+  /*! \brief settings for solving a job from several perturbed initial conditions */
+  typedef struct
+  {
+    int num_starts;		/**< number of starts, 1 disables multi-start */
+    int num_threads;		/**< number of starts solved concurrently */
+    double rotation_noise;	/**< std deviation of angle axis perturbation (radians) */
+    double translation_noise;	/**< std deviation of position perturbation (meters) */
+    unsigned int seed;		/**< seed of the first perturbed start, start i uses seed+i */
+  } MultiStartParameters;
+
+  /*! \brief outcome of one start, filled in by MultiStartOptimizer::solve() */
+  typedef struct
+  {
+    double initial_cost;	/**< cost at the start's (perturbed) initial condition */
+    double final_cost;		/**< cost when the start's solve terminated */
+    int iterations;		/**< number of solver iterations */
+    bool usable;		/**< whether the solve produced a usable solution */
+  } StartSummary;
+
+  /*! \brief fills in the defaults, a single start using all hardware threads */
+  MultiStartParameters defaultMultiStartParameters();
+
+  /*! \brief A private copy of every parameter block used by one start.
+   *         Camera extrinsics and target poses are perturbed when first copied,
+   *         intrinsics and points are copied unchanged.
+   */
+  class ParameterBlockCopies
+  {
+  public:
+    /*! \brief Constructor
+     *  \param rotation_noise std deviation of angle axis perturbation, 0 for an exact copy
+     *  \param translation_noise std deviation of position perturbation, 0 for an exact copy
+     *  \param seed seed for this start's random number generator
+     */
+    ParameterBlockCopies(double rotation_noise, double translation_noise, unsigned int seed);
+
+    /*! \brief Destructor */
+    ~ParameterBlockCopies(){};
+
+    /*! \brief returns the (perturbed) copy of a camera extrinsics block */
+    P_BLOCK extrinsics(const P_BLOCK original);
+
+    /*! \brief returns the copy of a camera intrinsics block */
+    P_BLOCK intrinsics(const P_BLOCK original);
+
+    /*! \brief returns the (perturbed) copy of a target pose block */
+    P_BLOCK targetPose(const P_BLOCK original);
+
+    /*! \brief returns the copy of a target point block */
+    P_BLOCK point(const P_BLOCK original);
+
+    /*! \brief resets an existing copy to the original's values, for blocks which are held constant
+     *  \param original the original block
+     *  \return the copy, NULL if the block has not been copied
+     */
+    P_BLOCK unperturbed(const P_BLOCK original);
+
+    /*! \brief drops the copies of blocks which did not end up in the problem, such as the pose of a fixed target
+     *  \param problem_blocks the parameter blocks of the problem built from these copies
+     */
+    void keepOnly(const std::vector<double*> &problem_blocks);
+
+    /*! \brief writes the values of every copy back into its original block */
+    void copyBack();
+
+  private:
+    /*! \brief finds or creates the copy of a block */
+    P_BLOCK getCopy(const P_BLOCK original, int size, bool perturb);
+
+    std::map<P_BLOCK, std::vector<double> > copies_; /*!< copies keyed by the original block */
+    double rotation_noise_;
+    double translation_noise_;
+    boost::mt19937 rng_;
+  };
+
+  /*! \brief signature of the function which adds a job's residuals to a problem.
+   *         When copies is NULL the original parameter blocks are used.
+   */
+  typedef boost::function<void (ceres::Problem &problem, ParameterBlockCopies *copies)> ProblemBuilder;
+
+  /*! \brief Solves a job from several perturbed starts on separate problems, keeping the lowest final cost */
+  class MultiStartOptimizer
+  {
+  public:
+    /*! \brief Constructor
+     *  \param parameters number of starts, threads and perturbation size
+     */
+    explicit MultiStartOptimizer(const MultiStartParameters &parameters);
+
+    /*! \brief Destructor */
+    ~MultiStartOptimizer(){};
+
+    /*! \brief builds and solves every start, then copies the best solution into the original blocks
+     *  \param builder adds the residuals of the job to a problem
+     *  \param options solver options used by each start, each start runs single threaded
+     *  \param best_cost final cost of the winning start
+     *  \return true if at least one start produced a usable solution
+     */
+    bool solve(ProblemBuilder builder, const ceres::Solver::Options &options, double &best_cost);
+
+    /*! \brief the outcome of every start of the last solve(), indexed by start */
+    const std::vector<StartSummary>& startSummaries() const { return(summaries_); }
+
+    /*! \brief the start copied back by the last solve(), -1 if none was usable */
+    int bestStart() const { return(best_start_); }
+
+  private:
+    /*! \brief worker loop, solves starts until none are left */
+    void solveStarts(ProblemBuilder builder, const ceres::Solver::Options &options);
+
+    MultiStartParameters parameters_;
+    std::vector<ParameterBlockCopies> starts_; /*!< parameter copies of each start */
+    std::vector<StartSummary> summaries_;	/*!< outcome of each start */
+    int best_start_;				/*!< index of the start with the lowest usable final cost */
+    int next_start_;				/*!< index of the next start to be solved */
+    boost::mutex mutex_;			/*!< protects next_start_ */
+  };
+
+}//end namespace industrial_extrinsic_cal
+
+#endif /* MULTI_START_OPTIMIZER_H_ */
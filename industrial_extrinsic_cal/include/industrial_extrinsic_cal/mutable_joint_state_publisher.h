@@ -24,15 +24,21 @@
 #include <industrial_extrinsic_cal/set_mutable_joint_states.h>
 #include <industrial_extrinsic_cal/get_mutable_joint_states.h>
 #include <industrial_extrinsic_cal/store_mutable_joint_states.h>
+#include <industrial_extrinsic_cal/mutable_joint_states_transaction.h>
 #include <sensor_msgs/JointState.h>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <map>
+#include <string>
 namespace industrial_extrinsic_cal
 {
 
   /** @brief 
    *        This object continuously broadcasts a vector of joint states
-   *        It provides 3 services
+   *        It provides 4 services
    *        get the joint values
    *        set the joint values
+   *        set and get the joint values of many transforms in one transaction
    *        store the joint names and current values to a yaml file
    *        The intent is to provide a seamless interface for extrinsic calibration of "static" transforms
    *        The static transform publisher does not allow updating its values, typically this involves updating the urdf
@@ -41,6 +47,9 @@ namespace industrial_extrinsic_cal
    *        Calibration routines call the service tied to setCallBack() so that path planners use updated pose info
    *        Calibration routines also call the service tied to storeCallBack() so that future launches also use updated 
    *        pose info without having to modify their urdf/xacro files. 
+   *        The joint states are published as soon as a service changes them, and at the ~keep_alive_rate (Hz) otherwise.
+   *        Services run in the threads of a multi-threaded spinner, they write the joints under a lock into a back
+   *        buffer which the publishing thread copies to its front buffer, so no message is built from a half set transform.
    */
   class MutableJointStatePublisher
   {
@@ -67,6 +76,12 @@ namespace industrial_extrinsic_cal
     bool getCallBack(industrial_extrinsic_cal::get_mutable_joint_states::Request &req,
 					       industrial_extrinsic_cal::get_mutable_joint_states::Response &res);
 
+    /** @brief sets, then gets, any number of joints in one call, e.g. those of every transform of a caljob.
+     *            Nothing is set unless every name is known, the unknown names are returned.
+     */
+    bool transactionCallBack(industrial_extrinsic_cal::mutable_joint_states_transaction::Request &req,
+			     industrial_extrinsic_cal::mutable_joint_states_transaction::Response &res);
+
     /** @brief writes the mutable joint states to the yaml file*/
     bool storeCallBack(industrial_extrinsic_cal::store_mutable_joint_states::Request &req,
 						 industrial_extrinsic_cal::store_mutable_joint_states::Response &res);
@@ -74,16 +89,35 @@ namespace industrial_extrinsic_cal
     /** @brief publishes the joint states as a joint state message*/
     bool publishJointStates();
 
+    /** @brief publishes whenever the joints change, and at the keep alive rate, until ros shuts down */
+    void run();
 
   private:
     bool loadFromYamlFile();
+
+    /** @brief sets a joint in the back buffer, the caller holds mutex_
+     *   @return false if there is no such joint
+     */
+    bool setJoint(const std::string &name, double value);
+
+    /** @brief wakes the publishing thread, the caller holds mutex_ */
+    void notifyChanged();
+
     std::string yaml_file_name_;
-    std::map<std::string, double> joints_;
+    std::map<std::string, double> joints_; /**< the back buffer, values by name, written by the services */
+    std::map<std::string, int> joint_index_; /**< position of each joint in the messages */
+    sensor_msgs::JointState back_; /**< the next message, kept up to date with joints_ */
+    sensor_msgs::JointState front_; /**< the message being published, only the publishing thread uses it */
+    bool changed_; /**< the joints changed since the last publication */
+    double keep_alive_rate_; /**< publications per second while nothing changes */
+    boost::mutex mutex_; /**< guards joints_, back_ and changed_ */
+    boost::condition_variable changed_cond_; /**< signalled when a service changes a joint */
     ros::NodeHandle nh_;
     ros::Publisher joint_state_pub_;
     ros::ServiceServer get_server_;
     ros::ServiceServer set_server_;
     ros::ServiceServer store_server_;
+    ros::ServiceServer transaction_server_;
     std::string node_name_;
   };
 
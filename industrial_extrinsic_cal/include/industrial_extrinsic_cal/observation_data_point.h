@@ -21,6 +21,8 @@
 
 #include <industrial_extrinsic_cal/basic_types.h>
 #include <industrial_extrinsic_cal/ceres_costs_utils.h>
+#include "ceres/ceres.h"
+#include <vector>
 
 namespace industrial_extrinsic_cal
 {
@@ -117,6 +119,44 @@ public:
   std::vector<ObservationDataPoint> items_;
 };
 
+class RotationCache;
+
+/** @brief every reprojection cost is an x and y image error */
+const int RESIDUALS_PER_OBSERVATION = 2;
+
+/** @brief how a cost type composes the pose of a target in a camera */
+typedef struct
+{
+  bool target_present;	/**< false when the points are given in reference coordinates */
+  bool camera_on_link;	/**< the camera is mounted on the link, the link pose is inverted */
+  bool target_on_link;	/**< the target is mounted on the link */
+} CostChain;
+
+/**
+ * @brief builds the cost function of an observation according to its cost type
+ * @param ODP the observation, known quantities (intrinsics, point, target pose) are read from its blocks
+ * @param extrinsics camera extrinsics block to estimate, usually ODP.camera_extrinsics_
+ * @param intrinsics camera intrinsics block to estimate, usually ODP.camera_intrinsics_
+ * @param target_pose target pose block to estimate, usually ODP.target_pose_
+ * @param point_position point block to estimate, usually ODP.point_position_
+ * @param parameter_blocks output, the blocks the cost function depends on in the order it expects them
+ * @param rotation_cache when not NULL, the estimated pose blocks are registered with it and
+ *                       the cost function reads their rotation matrices from it
+ * @return the cost function, NULL if the cost type is unknown
+ */
+ceres::CostFunction* createObservationCost(const ObservationDataPoint &ODP,
+					   P_BLOCK extrinsics, P_BLOCK intrinsics,
+					   P_BLOCK target_pose, P_BLOCK point_position,
+					   std::vector<P_BLOCK> &parameter_blocks,
+					   RotationCache *rotation_cache = NULL);
+
+/**
+ * @brief the chain of a cost type, taken from the policies of its cost function
+ * @param cost_type the cost type
+ * @param chain output
+ * @return false if the cost type is unknown
+ */
+bool costChain(Cost_function cost_type, CostChain &chain);
 
 }//end namespace industrial_extrinsic_cal
 
@@ -0,0 +1,99 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OBSERVATION_DATASET_H_
+#define OBSERVATION_DATASET_H_
+
+#include <industrial_extrinsic_cal/basic_types.h>
+#include <industrial_extrinsic_cal/observation_data_point.h>
+#include <industrial_extrinsic_cal/multi_start_optimizer.h>
+#include <industrial_extrinsic_cal/outlier_trimmer.h>
+#include <industrial_extrinsic_cal/robust_loss.h>
+#include <industrial_extrinsic_cal/schur_ordering.h>
+#include "ceres/ceres.h"
+#include <string>
+#include <vector>
+
+namespace industrial_extrinsic_cal
+{
+
+  /*! \brief A self contained copy of a calibration problem: the observations and every parameter block they use.
+   *         Datasets are written by a calibration job and solved elsewhere without ROS, for example by batch_solver.
+   *         The file is plain text, one line per parameter block followed by one line per observation.
+   */
+  class ObservationDataset
+  {
+  public:
+    /*! \brief Constructor, creates an empty dataset */
+    ObservationDataset(){};
+
+    /*! \brief Destructor */
+    ~ObservationDataset(){};
+
+    /*! \brief copies observations and the current values of their parameter blocks into the dataset
+     *  \param lists observation lists, such as one per scene
+     */
+    void setObservations(const std::vector<ObservationDataPointList> &lists);
+
+    /*! \brief writes the dataset
+     *  \param file_name the file to write
+     *  \return true if the file was written
+     */
+    bool write(const std::string &file_name) const;
+
+    /*! \brief replaces the dataset with the contents of a file
+     *  \param file_name the file to read
+     *  \return true if the file was read and is consistent
+     */
+    bool read(const std::string &file_name);
+
+    /*! \brief adds a residual block for every observation to a problem, matches ProblemBuilder
+     *  \param problem the problem
+     *  \param copies when not NULL the blocks of a multi-start start are used instead of the dataset's own
+     *  \param rotation_cache when not NULL the cost functions read pose rotations from it
+     *  \param residuals when not NULL the observation of each added block is appended, for OutlierTrimmer
+     */
+    void addToProblem(ceres::Problem &problem, ParameterBlockCopies *copies, RotationCache *rotation_cache = NULL,
+		      std::vector<ObservationResidual> *residuals = NULL);
+
+    /*! \brief declares the blocks a Schur solver should eliminate, the points, then the target poses seen in a single scene
+     *  \param ordering receives the blocks of the dataset, use it with a problem built without copies
+     */
+    void addSchurEliminationBlocks(SchurOrdering &ordering) const;
+
+    /*! \brief sets the robust loss applied to the observations by addToProblem() */
+    void setRobustLosses(const RobustLossTable &losses) { robust_losses_ = losses; };
+
+    /*! \brief the observations, their blocks point into the dataset */
+    const ObservationDataPointList& observations() const { return(observations_); };
+
+    /*! \brief the parameter blocks of the dataset, in file order */
+    const std::vector<std::vector<double> >& blocks() const { return(blocks_); };
+
+  private:
+    ObservationDataset(const ObservationDataset &);
+    ObservationDataset& operator=(const ObservationDataset &);
+
+    std::vector<std::vector<double> > blocks_; /*!< sized once, the observations point into it */
+    ObservationDataPointList observations_;
+    RobustLossTable robust_losses_; /*!< loss of each residual block */
+  };
+
+}//end namespace industrial_extrinsic_cal
+
+#endif /* OBSERVATION_DATASET_H_ */
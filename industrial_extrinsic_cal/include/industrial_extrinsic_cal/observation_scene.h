@@ -29,6 +29,13 @@
 namespace industrial_extrinsic_cal
 {
 
+/*! \brief what a job does when a scene's trigger fails or a camera does not find its target */
+enum SceneFailurePolicy
+{
+  SKIP_SCENE, /*!< the job continues without the scene */
+  RETRY_SCENE, /*!< the scene is triggered and captured again, then skipped */
+  ABORT_JOB /*!< the job stops */
+};
 
 /*! \brief a command to take a set of observations from a group of cameras upon a trigger event */
 class ObservationScene
@@ -38,13 +45,14 @@ public:
    *   \param Trigger the type of trigger to initiate this observation
    */
   ObservationScene(boost::shared_ptr<Trigger> trigger, int scene_id) :
-      scene_id_(scene_id)
+      scene_id_(scene_id), failure_policy_(SKIP_SCENE), max_retries_(0)
   {
     trigger_ = trigger;
   };
 
   /*! \brief destructor, clears observation command list*/
-  ObservationScene()
+  ObservationScene() :
+      failure_policy_(SKIP_SCENE), max_retries_(0)
   {
     observation_command_list_.clear();
     cameras_in_scene_.clear();
@@ -107,12 +115,37 @@ public:
     trigger_ = trigger;
   };
 
+  /*!
+   * \brief set what the job does when this scene fails
+   * @param policy skip, retry or abort
+   * @param max_retries captures after the first, when the policy is to retry
+   */
+  void setFailurePolicy(SceneFailurePolicy policy, int max_retries)
+  {
+    failure_policy_ = policy;
+    max_retries_ = max_retries < 0 ? 0 : max_retries;
+  };
+
+  /*! \brief gets what the job does when this scene fails */
+  SceneFailurePolicy getFailurePolicy()
+  {
+    return (failure_policy_);
+  };
+
+  /*! \brief number of times the scene may be captured */
+  int getMaxAttempts()
+  {
+    return (failure_policy_ == RETRY_SCENE ? 1 + max_retries_ : 1);
+  };
+
   std::vector<ObservationCmd> observation_command_list_; /*!< list of observations for a scene */
   std::vector<boost::shared_ptr<Camera> > cameras_in_scene_; /*!< list of cameras in this scene */
 
 private:
   boost::shared_ptr<Trigger>  trigger_; /*!< event to trigger the observations in this command */
   int scene_id_; /*!< unique identifier of this scene */
+  SceneFailurePolicy failure_policy_; /*!< what the job does when this scene fails */
+  int max_retries_; /*!< captures after the first, when the policy is to retry */
 };
 // end of class ObservationScene
 
@@ -0,0 +1,103 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OUTLIER_TRIMMER_H_
+#define OUTLIER_TRIMMER_H_
+
+#include <industrial_extrinsic_cal/observation_data_point.h>
+#include "ceres/ceres.h"
+#include <string>
+#include <vector>
+
+namespace industrial_extrinsic_cal
+{
+
+  /*! \brief settings of the outlier trim loop */
+  typedef struct
+  {
+    int max_rounds;		/**< number of times observations are removed and the problem re-solved, 0 disables trimming */
+    double chi_square_threshold;/**< squared residual norm over pixel_sigma^2 above which an observation is removed */
+    double pixel_sigma;		/**< expected std deviation of an inlier's image location (pixels) */
+  } OutlierTrimParameters;
+
+  /*! \brief fills in the defaults, disabled, 95% quantile of chi-square with 2 degrees of freedom, 1 pixel sigma */
+  OutlierTrimParameters defaultOutlierTrimParameters();
+
+  /*! \brief options for a problem which OutlierTrimmer may trim, residual blocks are removed without scanning the whole problem */
+  ceres::Problem::Options trimProblemOptions();
+
+  /*! \brief the residual block of one observation, identifies it in reports */
+  typedef struct
+  {
+    ceres::ResidualBlockId id;	/**< the block in the problem */
+    std::string camera_name;	/**< camera which made the observation */
+    std::string target_name;	/**< target which was observed */
+    int scene_id;		/**< scene of the observation */
+    int point_id;		/**< point of the target */
+  } ObservationResidual;
+
+  /*! \brief identifies a residual block by its observation */
+  ObservationResidual observationResidual(ceres::ResidualBlockId id, const ObservationDataPoint &ODP);
+
+  /*! \brief an observation removed by the trim loop */
+  typedef struct
+  {
+    ObservationResidual observation;	/**< the observation, its block is no longer in the problem */
+    double chi_square;			/**< squared residual norm over pixel_sigma^2 when it was removed */
+    int round;				/**< trim round which removed it, starting at 1 */
+  } TrimmedObservation;
+
+  /*! \brief Solves a problem, then repeatedly removes the residual blocks of observations whose
+   *         squared reprojection error exceeds a chi-square threshold and solves again.
+   *         The threshold is applied to the residuals without their robust loss.
+   */
+  class OutlierTrimmer
+  {
+  public:
+    /*! \brief Constructor
+     *  \param parameters rounds, threshold and pixel sigma
+     */
+    explicit OutlierTrimmer(const OutlierTrimParameters &parameters);
+
+    /*! \brief Destructor */
+    ~OutlierTrimmer(){};
+
+    /*! \brief solves and trims
+     *  \param problem the problem, trimmed residual blocks are removed from it
+     *  \param residuals the observation of each residual block, trimmed ones are removed
+     *  \param options solver options
+     *  \param summary summary of the last solve
+     *  \return true if the last solve produced a usable solution
+     */
+    bool solve(ceres::Problem &problem, std::vector<ObservationResidual> &residuals,
+	       const ceres::Solver::Options &options, ceres::Solver::Summary &summary);
+
+    /*! \brief every observation removed by the last solve */
+    const std::vector<TrimmedObservation>& trimmed() const { return(trimmed_); };
+
+    /*! \brief the number of removed observations per scene and camera, followed by each removed observation */
+    std::string report() const;
+
+  private:
+    OutlierTrimParameters parameters_;
+    std::vector<TrimmedObservation> trimmed_;
+  };
+
+}//end namespace industrial_extrinsic_cal
+
+#endif /* OUTLIER_TRIMMER_H_ */
@@ -0,0 +1,121 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PHASE_TIMER_H_
+#define PHASE_TIMER_H_
+
+#include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+#include <string>
+#include <vector>
+
+namespace industrial_extrinsic_cal
+{
+
+  /*! \brief one timed execution of a phase */
+  typedef struct
+  {
+    const char *name;		/**< name of the phase, must be a string literal */
+    boost::int64_t start_us;	/**< start time in microseconds since the tracer was created */
+    boost::int64_t duration_us;	/**< duration in microseconds */
+    unsigned int thread;	/**< small integer identifying the thread */
+  } PhaseEvent;
+
+  /*! \brief Process wide collector of phase timings.
+   *         Disabled by default, in which case a ScopedPhaseTimer costs one flag test.
+   */
+  class PhaseTracer
+  {
+  public:
+    /*! \brief the one tracer of this process */
+    static PhaseTracer& instance();
+
+    /*! \brief turns collection on or off */
+    void enable(bool on) { enabled_ = on; };
+
+    /*! \brief true when collection is on */
+    bool enabled() const { return(enabled_); };
+
+    /*! \brief microseconds since the tracer was created */
+    boost::int64_t now() const;
+
+    /*! \brief adds a completed phase */
+    void record(const char *name, boost::int64_t start_us, boost::int64_t duration_us);
+
+    /*! \brief removes all recorded phases */
+    void clear();
+
+    /*! \brief writes the recorded phases as a Chrome trace (chrome://tracing, Perfetto)
+     *  \param file_name the json file to write
+     *  \return true if the file was written
+     */
+    bool writeChromeTrace(const std::string &file_name) const;
+
+    /*! \brief a table with the count, total, mean and max duration of each phase */
+    std::string summary() const;
+
+  private:
+    PhaseTracer();
+    PhaseTracer(const PhaseTracer &);
+    PhaseTracer& operator=(const PhaseTracer &);
+
+    volatile bool enabled_;
+    boost::int64_t origin_us_;		/*!< creation time, all event times are relative to it */
+    std::vector<PhaseEvent> events_;
+    mutable boost::mutex mutex_;	/*!< protects events_ */
+  };
+
+  /*! \brief times the enclosing scope and records it with the PhaseTracer, when tracing is enabled */
+  class ScopedPhaseTimer
+  {
+  public:
+    /*! \brief Constructor
+     *  \param name name of the phase, must be a string literal
+     */
+    explicit ScopedPhaseTimer(const char *name) : name_(name), start_us_(-1)
+    {
+      PhaseTracer &tracer = PhaseTracer::instance();
+      if(tracer.enabled()) start_us_ = tracer.now();
+    };
+
+    /*! \brief Destructor, records the phase */
+    ~ScopedPhaseTimer()
+    {
+      if(start_us_ < 0) return;
+      PhaseTracer &tracer = PhaseTracer::instance();
+      tracer.record(name_, start_us_, tracer.now() - start_us_);
+    };
+
+  private:
+    const char *name_;
+    boost::int64_t start_us_;
+  };
+
+}//end namespace industrial_extrinsic_cal
+
+/* Define INDUSTRIAL_EXTRINSIC_CAL_NO_TRACING to compile all phase timers out */
+#ifdef INDUSTRIAL_EXTRINSIC_CAL_NO_TRACING
+#define CAL_PHASE_TIMER(name)
+#else
+#define CAL_PHASE_TIMER_CAT2(a, b) a##b
+#define CAL_PHASE_TIMER_CAT(a, b) CAL_PHASE_TIMER_CAT2(a, b)
+#define CAL_PHASE_TIMER(name) \
+  industrial_extrinsic_cal::ScopedPhaseTimer CAL_PHASE_TIMER_CAT(phase_timer_, __LINE__)(name)
+#endif
+
+#endif /* PHASE_TIMER_H_ */
@@ -0,0 +1,64 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef POSE_DIVERSITY_H_
+#define POSE_DIVERSITY_H_
+
+#include <industrial_extrinsic_cal/basic_types.h>
+#include <vector>
+
+namespace industrial_extrinsic_cal
+{
+
+  /*! \brief settings of the frame selection of a continuous capture */
+  typedef struct
+  {
+    int max_frames;		/**< most frames kept */
+    double min_rotation;	/**< a kept frame differs from every other kept frame by this rotation (rad) ... */
+    double min_translation;	/**< ... or by this translation (m) */
+    double min_quality;		/**< frames of lower quality are never kept */
+  } PoseDiversityParameters;
+
+  /*! \brief fills in the defaults, 20 frames, 0.1 rad, 5 cm, quality 0.25 (a 3 pixel rms fit) */
+  PoseDiversityParameters defaultPoseDiversityParameters();
+
+  /*! \brief a frame which may be kept */
+  typedef struct
+  {
+    Pose6d pose;	/**< pose of the target in the camera when the frame was taken */
+    double quality;	/**< detection quality in (0,1], 1 is best */
+  } FrameCandidate;
+
+  /*! \brief how different two poses are, in units of the minimum rotation and translation
+   *  \return the larger of the relative rotation over min_rotation and the relative translation over min_translation
+   */
+  double poseDistance(const Pose6d &a, const Pose6d &b, const PoseDiversityParameters &parameters);
+
+  /*! \brief chooses frames for pose diversity and detection quality. The best frame is kept first, then
+   *         repeatedly the frame whose distance to the kept ones, weighted by its quality, is largest,
+   *         until max_frames are kept or no frame is at least a unit distance from all kept frames.
+   *  \param candidates the frames
+   *  \param parameters the frame count, the distance units and the lowest quality
+   *  \return indices of the kept frames, in the order they were chosen
+   */
+  std::vector<int> selectDiverseFrames(const std::vector<FrameCandidate> &candidates,
+				       const PoseDiversityParameters &parameters);
+
+}//end namespace industrial_extrinsic_cal
+
+#endif /* POSE_DIVERSITY_H_ */
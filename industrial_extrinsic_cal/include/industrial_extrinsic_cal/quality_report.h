@@ -0,0 +1,134 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef QUALITY_REPORT_H_
+#define QUALITY_REPORT_H_
+
+#include <industrial_extrinsic_cal/basic_types.h>
+#include <industrial_extrinsic_cal/observation_data_point.h>
+#include <industrial_extrinsic_cal/outlier_trimmer.h>
+#include "ceres/ceres.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace industrial_extrinsic_cal
+{
+
+  /*! \brief settings of the post-solve quality stage */
+  typedef struct
+  {
+    int num_threads;		/**< threads used to evaluate residuals and compute covariance */
+    bool compute_covariance;	/**< false skips the covariance of the extrinsics */
+    ceres::CovarianceAlgorithmType covariance_algorithm; /**< a sparse algorithm scales to large jobs */
+    double pixel_sigma;		/**< std deviation of an observation (pixels), scales the covariance */
+  } QualityParameters;
+
+  /*! \brief fills in the defaults, all hardware threads, sparse QR covariance, 1 pixel sigma */
+  QualityParameters defaultQualityParameters();
+
+  /*! \brief reprojection error of a group of observations */
+  typedef struct
+  {
+    int num_observations;	/**< observations in the group */
+    double sum_squares;		/**< sum of squared reprojection errors (pixels^2) */
+    double max_error;		/**< largest reprojection error (pixels) */
+  } ReprojectionStatistics;
+
+  /*! \brief marginal covariance of one camera's extrinsics */
+  typedef struct
+  {
+    std::string name;		/**< camera, with the scene for cameras which move between scenes */
+    const double *block;	/**< the extrinsics block */
+    bool valid;			/**< false when the covariance could not be computed, e.g. the problem is rank deficient */
+    double covariance[36];	/**< row major, ax ay az x y z */
+  } ExtrinsicsCovariance;
+
+  /*! \brief Measures a solved calibration: RMS reprojection error of the whole job, of each camera and of each scene,
+   *         and the marginal covariance of every camera's extrinsics.
+   *         The report lets an operator accept or reject a calibration without running it again.
+   */
+  class QualityReport
+  {
+  public:
+    /*! \brief Constructor
+     *  \param parameters threads and covariance settings
+     */
+    explicit QualityReport(const QualityParameters &parameters);
+
+    /*! \brief Destructor */
+    ~QualityReport(){};
+
+    /*! \brief registers the extrinsics block of each camera in the observations, once per block
+     *  \param observations observations of a job, such as one scene
+     */
+    void addExtrinsics(const ObservationDataPointList &observations);
+
+    /*! \brief evaluates the reprojection errors and the covariances
+     *  \param problem the solved problem
+     *  \param residuals the observation of each residual block in the problem
+     *  \return true if the reprojection errors were evaluated, covariance failures only invalidate those entries
+     */
+    bool compute(ceres::Problem &problem, const std::vector<ObservationResidual> &residuals);
+
+    /*! \brief reprojection error of all observations */
+    const ReprojectionStatistics& overall() const { return(overall_); };
+
+    /*! \brief reprojection error of each camera */
+    const std::map<std::string, ReprojectionStatistics>& cameras() const { return(cameras_); };
+
+    /*! \brief reprojection error of each scene */
+    const std::map<int, ReprojectionStatistics>& scenes() const { return(scenes_); };
+
+    /*! \brief covariance of each registered extrinsics block */
+    const std::vector<ExtrinsicsCovariance>& extrinsics() const { return(extrinsics_); };
+
+    /*! \brief root mean square of a group's reprojection errors (pixels) */
+    static double rms(const ReprojectionStatistics &statistics);
+
+    /*! \brief a group without observations */
+    static ReprojectionStatistics emptyStatistics();
+
+    /*! \brief adds one observation's reprojection error to a group
+     *  \param statistics the group
+     *  \param residuals the RESIDUALS_PER_OBSERVATION image errors of the observation, without robust loss
+     */
+    static void accumulate(ReprojectionStatistics &statistics, const double *residuals);
+
+    /*! \brief a few lines for the log */
+    std::string summary() const;
+
+    /*! \brief writes the report as yaml
+     *  \param file_name the file to write
+     *  \return true if the file was written
+     */
+    bool write(const std::string &file_name) const;
+
+  private:
+    bool computeCovariance(ceres::Problem &problem);
+
+    QualityParameters parameters_;
+    ReprojectionStatistics overall_;
+    std::map<std::string, ReprojectionStatistics> cameras_;
+    std::map<int, ReprojectionStatistics> scenes_;
+    std::vector<ExtrinsicsCovariance> extrinsics_;
+  };
+
+}//end namespace industrial_extrinsic_cal
+
+#endif /* QUALITY_REPORT_H_ */
@@ -0,0 +1,93 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RESULTS_WRITER_H_
+#define RESULTS_WRITER_H_
+
+#include <industrial_extrinsic_cal/basic_types.h>
+#include <string>
+#include <vector>
+
+namespace industrial_extrinsic_cal
+{
+
+  /*! \brief file formats of stored calibration results */
+  typedef enum
+  {
+    RESULTS_LAUNCH,	/**< a launch file of static_transform_publisher nodes */
+    RESULTS_YAML,	/**< a list of parent frame, child frame, position and quaternion */
+    RESULTS_XACRO	/**< a xacro macro of fixed joints, to be included in the workcell's urdf */
+  } ResultsFormat;
+
+  /*! \brief parses "launch", "yaml" or "xacro"
+   *  \return false if the name is unknown
+   */
+  bool string2ResultsFormat(const std::string &name, ResultsFormat &format);
+
+  /*! \brief one calibrated transform, pose takes points in the child frame into the parent frame */
+  typedef struct
+  {
+    std::string parent_frame;
+    std::string child_frame;
+    Pose6d pose;
+  } StoredTransform;
+
+  /*! \brief writes a file as a whole or not at all: the contents go to a temporary file in the same directory
+   *         which is flushed to disk and renamed over the file, an interrupted write leaves the old file in place
+   *  \param file_name the file
+   *  \param contents everything the file holds
+   *  \return false if the temporary file could not be written or renamed
+   */
+  bool writeFileAtomically(const std::string &file_name, const std::string &contents);
+
+  /*! \brief Collects the calibrated transforms of a job and stores them in one pass,
+   *         instead of each transform interface opening the results file to append its own lines.
+   */
+  class ResultsWriter
+  {
+  public:
+    /*! \brief Constructor */
+    ResultsWriter(){};
+
+    /*! \brief Destructor */
+    ~ResultsWriter(){};
+
+    /*! \brief adds a transform, a child frame added again replaces the earlier one */
+    void add(const std::string &parent_frame, const std::string &child_frame, const Pose6d &pose);
+
+    /*! \brief the transforms in the order they were added */
+    const std::vector<StoredTransform>& transforms() const { return(transforms_); };
+
+    /*! \brief the contents of a results file
+     *  \param format the file format
+     */
+    std::string format(ResultsFormat format) const;
+
+    /*! \brief formats the transforms and writes them with writeFileAtomically()
+     *  \param file_name the results file
+     *  \param format the file format
+     */
+    bool write(const std::string &file_name, ResultsFormat format) const;
+
+  private:
+    std::vector<StoredTransform> transforms_;
+  };
+
+}//end namespace industrial_extrinsic_cal
+
+#endif /* RESULTS_WRITER_H_ */
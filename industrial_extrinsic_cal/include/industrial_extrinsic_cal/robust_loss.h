@@ -0,0 +1,90 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ROBUST_LOSS_H_
+#define ROBUST_LOSS_H_
+
+#include <industrial_extrinsic_cal/ceres_costs_utils.h>
+#include "ceres/ceres.h"
+#include <map>
+#include <string>
+
+namespace industrial_extrinsic_cal
+{
+  // the robust losses which may be applied to a residual block
+  namespace loss_functions{
+    enum Loss_function{
+      NoLoss,
+      HuberLoss,
+      CauchyLoss,
+      NullLossType
+    };
+  }// end of namespace loss_functions
+  typedef loss_functions::Loss_function Loss_function;
+
+  /*! @brief converts a string (none, huber or cauchy) to a loss type
+   *   @param loss_type_str The loss type string
+   *   @returns The loss type, NullLossType if the string is not a loss type
+   */
+  Loss_function string2LossType(std::string &loss_type_str);
+
+  /*! @brief converts a loss type to a string
+   *   @param loss_type The loss type
+   *   @returns The loss type as a string
+   */
+  std::string lossType2String(Loss_function loss_type);
+
+  /*! \brief a robust loss and its scale, residuals below the scale (pixels) are treated as inliers */
+  typedef struct
+  {
+    Loss_function type;	/**< the loss */
+    double scale;	/**< the residual norm at which the loss departs from least squares */
+  } RobustLoss;
+
+  /*! \brief The robust loss of each cost type, a default applies to cost types without their own entry */
+  class RobustLossTable
+  {
+  public:
+    /*! \brief Constructor, least squares for every cost type */
+    RobustLossTable();
+
+    /*! \brief Destructor */
+    ~RobustLossTable(){};
+
+    /*! \brief sets the loss of all cost types without their own entry */
+    void setDefault(const RobustLoss &loss) { default_loss_ = loss; };
+
+    /*! \brief sets the loss of one cost type */
+    void set(Cost_function cost_type, const RobustLoss &loss) { losses_[cost_type] = loss; };
+
+    /*! \brief the loss of a cost type */
+    RobustLoss get(Cost_function cost_type) const;
+
+    /*! \brief creates the loss function of a cost type, owned by the problem it is added to
+     *  \return the loss function, NULL for least squares
+     */
+    ceres::LossFunction* create(Cost_function cost_type) const;
+
+  private:
+    RobustLoss default_loss_;
+    std::map<Cost_function, RobustLoss> losses_;
+  };
+
+}//end namespace industrial_extrinsic_cal
+
+#endif /* ROBUST_LOSS_H_ */
@@ -22,6 +22,7 @@
 #include <industrial_extrinsic_cal/camera_observer.hpp>
 #include <industrial_extrinsic_cal/basic_types.h>
 #include <industrial_extrinsic_cal/ceres_costs_utils.h> 
+#include <industrial_extrinsic_cal/frame_quality.h>
 
 #include <iostream>
 #include <sstream>
@@ -56,6 +57,20 @@ typedef pattern_options::pattern_options_ PatternOption;
 namespace industrial_extrinsic_cal
 {
 
+  /**
+   *  @brief what a ROSCameraObserver looks for in an image, a copy outlives changes to the observer's targets
+   */
+  typedef struct
+  {
+    boost::shared_ptr<Target> target; /**< the target */
+    cv::Rect roi; /**< region of the image searched */
+    PatternOption pattern; /**< pattern of the target */
+    int pattern_rows; /**< rows of the pattern */
+    int pattern_cols; /**< columns of the pattern */
+    bool sym_circle; /**< circle grid is symmetric */
+    Cost_function cost_type; /**< cost type of the observations */
+  } DetectionSettings;
+
   class ROSCameraObserver : public CameraObserver
   {
   public:
@@ -103,8 +118,63 @@ namespace industrial_extrinsic_cal
     /** @brief tells when camera has completed its observations */
     bool observationsDone();
 
+    /**
+     * @brief finds the target in an image, without changing the observer, so several threads may detect at once
+     * @param image a mono image from this camera
+     * @param cam_obs output observations of the target, empty when it is not found
+     * @return true if the target was found
+     */
+    bool detect(const cv::Mat &image, CameraObservations &cam_obs) const;
+
+    /**
+     * @brief finds a target in an image with settings copied from an observer, the observer may since look
+     *        for another target
+     * @param image a mono image
+     * @param settings the target, roi and pattern to look for
+     * @param cam_obs output observations of the target, empty when it is not found
+     * @return true if the target was found
+     */
+    static bool detect(const cv::Mat &image, const DetectionSettings &settings, CameraObservations &cam_obs);
+
+    /** @brief what the observer currently looks for */
+    DetectionSettings getDetectionSettings() const;
+
+    /** @brief mono image taken by the last triggerCamera(), empty if none */
+    cv::Mat getImage() const;
+
+    /** @brief image topic of the camera */
+    const std::string& getImageTopic() const { return(image_topic_); };
+
+    /** @brief header stamp of the image taken by the last triggerCamera() */
+    ros::Time getImageStamp() { return(image_stamp_); };
+
+    /** @brief sets the checks each frame passes before detection, and how often a failed frame is grabbed again */
+    void setFrameQualityParameters(const FrameQualityParameters &parameters) { frame_quality_parameters_ = parameters; };
+
+    /** @brief the checks each frame passes before detection */
+    const FrameQualityParameters& getFrameQualityParameters() const { return(frame_quality_parameters_); };
+
+    /**
+     * @brief checks focus and saturation in the region of interest of an image
+     * @param image a mono image from this camera
+     * @param quality receives the measures
+     * @return true if the target should be searched for
+     */
+    bool checkFrame(const cv::Mat &image, FrameQuality &quality) const;
+
+    /** @brief false when every frame grabbed by the last triggerCamera() failed its checks, detection is skipped */
+    bool frameUsable() const { return(frame_usable_); };
+
   private:
 
+    /** @brief finds the pattern's points in the region of interest of an image */
+    static bool findPattern(const cv::Mat &image_roi, const DetectionSettings &settings,
+			    std::vector<cv::Point2f> &points);
+
+    /** @brief the observations of the target's points found in an image */
+    static void toObservations(const std::vector<cv::Point2f> &points, const DetectionSettings &settings,
+			       CameraObservations &cam_obs);
+
     /**
      * @brief name of pattern being looked for
      */
@@ -166,6 +236,21 @@ namespace industrial_extrinsic_cal
      */
     ros::NodeHandle nh_;
 
+    /**
+     *  @brief header stamp of the last image, the exposure time when the driver stamps its images
+     */
+    ros::Time image_stamp_;
+
+    /**
+     *  @brief focus, saturation and viewing angle checks made before detection
+     */
+    FrameQualityParameters frame_quality_parameters_;
+
+    /**
+     *  @brief true when the last image passed its checks
+     */
+    bool frame_usable_;
+
     /**
      *  @brief ROS subscriber to image_topic_
      */
@@ -23,17 +23,288 @@
 #include <ros/ros.h> 
 #include <tf/transform_listener.h>
 #include <tf/transform_broadcaster.h>
+#include <tf2_ros/static_transform_broadcaster.h>
 
 #include <industrial_extrinsic_cal/transform_interface.hpp>
 #include <industrial_extrinsic_cal/basic_types.h> // for Pose6d
 #include <industrial_extrinsic_cal/get_mutable_joint_states.h>
 #include <industrial_extrinsic_cal/set_mutable_joint_states.h>
 #include <industrial_extrinsic_cal/store_mutable_joint_states.h>
+#include <industrial_extrinsic_cal/mutable_joint_states_transaction.h>
 #include <boost/make_shared.hpp>
+#include <boost/thread/mutex.hpp>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace industrial_extrinsic_cal
 {
 
+  /** @brief converts a tf transform to a Pose6d, Pose6d itself does not depend on tf
+   *   @param transform the tf transform
+   *   @return the equivalent pose
+   */
+  Pose6d poseFromTF(const tf::Transform &transform);
+
+  /** @brief converts a Pose6d to a tf transform
+   *   @param pose the pose
+   *   @return the equivalent tf transform
+   */
+  tf::Transform poseToTF(const Pose6d &pose);
+
+  /** @brief (target frame, source frame) of a tf lookup */
+  typedef std::pair<std::string, std::string> TFFramePair;
+
+  /** @brief The one tf listener of the process. Each listener subscribes to /tf and buffers the whole tree,
+   *            so the transform interfaces share this one instead of owning their own.
+   *            A batch looks up all the frames of a scene at one time stamp, waiting once for the tree to
+   *            reach that time rather than once per interface. The stamp may be an image's exposure time, so
+   *            poses of a moving robot are interpolated at the moment the image was taken. Lookups of frames outside the batch wait for the latest data.
+   *            Every wait is bounded by the ~tf_wait_time parameter (s): a stamp older than the tf buffer never becomes
+   *            available, and the caller must be able to fail the scene instead of waiting forever.
+   */
+  class SharedTransformListener
+  {
+  public:
+    /** @brief the listener of the process, created on first use, after ros::init */
+    static SharedTransformListener& instance();
+
+    /** @brief looks up the transform which takes points in to_frame into from_frame
+     *   @param from_frame the starting frame
+     *   @param to_frame the ending frame
+     *   @return the batch's pose when the pair is in the current batch, the latest otherwise,
+     *              identity when the transform is not available in time, see failures()
+     */
+    Pose6d lookup(const std::string &from_frame, const std::string &to_frame);
+
+    /** @brief number of lookups which were not available in time since the process started,
+     *            a caller compares the counts before and after its lookups
+     */
+    int failures() const { return(failures_); };
+
+    /** @brief looks up every pair at one time stamp and keeps the poses until endBatch().
+     *            Pairs in a snapshot() at the same stamp are taken from it rather than looked up again.
+     *   @param frames the pairs to look up
+     *   @param stamp the poses are interpolated at this time, zero for now
+     *   @return false if a pair was not available in time, the batch then holds the pairs which were
+     */
+    bool beginBatch(const std::vector<TFFramePair> &frames, const ros::Time &stamp = ros::Time(0));
+
+    /** @brief forgets the batch's poses, later lookups wait for the latest data again */
+    void endBatch();
+
+    /** @brief looks up the pairs at a stamp now, while it is still in the tf buffer, and keeps them for a later batch
+     *            at that stamp. A continuous capture snapshots each frame as it is detected, its scenes are only
+     *            built once the trajectory is done, by which time early frames may have left the buffer.
+     *            May be called from any thread.
+     *   @param frames the pairs to look up
+     *   @param stamp the stamp of the batch which will use them
+     *   @return false if a pair was not available in time, nothing is kept then
+     */
+    bool snapshot(const std::vector<TFFramePair> &frames, const ros::Time &stamp);
+
+    /** @brief forgets every snapshot */
+    void clearSnapshots();
+
+  private:
+    SharedTransformListener();
+    SharedTransformListener(const SharedTransformListener &);
+    SharedTransformListener& operator=(const SharedTransformListener &);
+
+    /** @brief length of the tf buffer, the ~tf_cache_time parameter, 10 seconds by default */
+    static ros::Duration cacheTime();
+
+    /** @brief waits at most wait_time_ for the transform at the stamp
+     *   @return false if it did not become available
+     */
+    bool lookupAt(const std::string &from_frame, const std::string &to_frame, const ros::Time &stamp, Pose6d &pose);
+
+    tf::TransformListener tf_listener_; /**< the listener, buffers the tree for the whole process */
+    ros::Duration wait_time_; /**< longest wait for one transform, the ~tf_wait_time parameter, 5 seconds by default */
+    std::map<TFFramePair, Pose6d> batch_; /**< poses of the current batch */
+    int failures_; /**< lookups which were not available in time */
+    std::map<ros::Time, std::map<TFFramePair, Pose6d> > snapshots_; /**< poses looked up ahead of their batch */
+    boost::mutex snapshot_mutex_; /**< snapshots are taken by capture workers */
+  };
+
+  /** @brief fetches a batch of frames for its lifetime, e.g. while a scene's transforms are pulled */
+  class ScopedTransformBatch
+  {
+  public:
+    /** @brief looks up the frames at one time stamp
+     *   @param frames the pairs to look up, nothing is fetched when empty
+     *   @param stamp the poses are interpolated at this time, zero for now
+     */
+    explicit ScopedTransformBatch(const std::vector<TFFramePair> &frames, const ros::Time &stamp = ros::Time(0));
+
+    /** @brief ends the batch */
+    ~ScopedTransformBatch();
+
+    /** @brief false if a frame was not available at the stamp */
+    bool ok() const { return(ok_); };
+
+  private:
+    bool active_;
+    bool ok_;
+  };
+
+  /** @brief a transform interface whose pose is broadcast to tf by the SharedTransformBroadcaster */
+  class TransformBroadcastSource
+  {
+  public:
+    /** @brief Default destructor */
+    virtual ~TransformBroadcastSource(){};
+
+    /** @brief the transform to broadcast
+     *   @param transform set to the current pose, the broadcaster stamps it
+     *   @return false while there is nothing to broadcast, e.g. the reference frame is not yet defined
+     */
+    virtual bool getBroadcastTransform(tf::StampedTransform &transform) = 0;
+  };
+
+  /** @brief Broadcasts the transforms of all calibrated frames of the process in one tf message per period,
+   *            instead of a timer and a message per frame. The rate is the ~tf_broadcast_rate parameter (Hz).
+   *            Once a calibration is final, publishStatic() moves its frames to /tf_static, latched for late subscribers.
+   *            Each frame is on one channel only, /tf until it is stored and /tf_static from then on.
+   */
+  class SharedTransformBroadcaster
+  {
+  public:
+    /** @brief the broadcaster of the process, created on first use, after ros::init */
+    static SharedTransformBroadcaster& instance();
+
+    /** @brief adds a source, it is broadcast from the next period on
+     *   @param source the source, it must be removed before it is destroyed
+     */
+    void add(TransformBroadcastSource *source);
+
+    /** @brief removes a source */
+    void remove(TransformBroadcastSource *source);
+
+    /** @brief a source's pose changed, sends all transforms now rather than at the next period.
+     *            The frames already on /tf_static are latched again with their new pose.
+     */
+    void update();
+
+    /** @brief sets the broadcast rate
+     *   @param rate periods per second
+     */
+    void setRate(double rate);
+
+    /** @brief latches every current frame on /tf_static, they leave the periodic broadcast on /tf */
+    void publishStatic();
+
+  private:
+    SharedTransformBroadcaster();
+    SharedTransformBroadcaster(const SharedTransformBroadcaster &);
+    SharedTransformBroadcaster& operator=(const SharedTransformBroadcaster &);
+
+    void timerCallback(const ros::TimerEvent & timer_event);
+    /** @brief sends the transforms of the sources not yet stored on /tf
+     *   @param latch also latch those of the stored sources on /tf_static again
+     */
+    void send(bool latch);
+
+    ros::NodeHandle nh_;
+    ros::Timer timer_; /**< one timer for all sources */
+    tf::TransformBroadcaster tf_broadcaster_; /**< sends on /tf */
+    tf2_ros::StaticTransformBroadcaster static_broadcaster_; /**< sends on /tf_static */
+    std::vector<TransformBroadcastSource*> sources_;
+    std::set<TransformBroadcastSource*> static_sources_; /**< the sources latched on /tf_static, never sent on /tf */
+    boost::mutex mutex_; /**< the timer runs in the spinner's thread */
+  };
+
+  /** @brief The mutable joint states of all transform interfaces of the process, read and written in one
+   *            transaction with the mutable joint state publisher instead of a service call per interface.
+   *            A read fetches every joint of a scene's interfaces, pullTransform() then takes its values from the cache.
+   *            A write collects the values every pushTransform() sets and sends them together when it commits.
+   *            Outside a read or write, or when the publisher has no transaction service, the interfaces
+   *            call the get and set services themselves.
+   */
+  class SharedMutableJoints
+  {
+  public:
+    /** @brief the joints of the process, created on first use, after ros::init */
+    static SharedMutableJoints& instance();
+
+    /** @brief fetches the values of the joints in one call and keeps them until endRead()
+     *   @param joint_names the joints, duplicates are fetched once
+     *   @return false if the transaction failed, the cache is then empty
+     */
+    bool beginRead(const std::vector<std::string> &joint_names);
+
+    /** @brief forgets the fetched values */
+    void endRead();
+
+    /** @brief values of the joints from the current read
+     *   @param joint_names the joints
+     *   @param joint_values receives one value per name
+     *   @return false if any joint is not in the cache, the caller then asks the publisher itself
+     */
+    bool cached(const std::vector<std::string> &joint_names, std::vector<double> &joint_values);
+
+    /** @brief starts collecting the values set by the interfaces */
+    void beginWrite();
+
+    /** @brief queues values for the commit of the current write
+     *   @return false if no write is open, the caller then sets them itself
+     */
+    bool queue(const std::vector<std::string> &joint_names, const std::vector<double> &joint_values);
+
+    /** @brief sends every queued value in one transaction, all or none are set
+     *   @return false if the publisher refused or could not be reached
+     */
+    bool commitWrite();
+
+  private:
+    SharedMutableJoints();
+    SharedMutableJoints(const SharedMutableJoints &);
+    SharedMutableJoints& operator=(const SharedMutableJoints &);
+
+    /** @brief calls the transaction service, or the get and set services of a publisher without it */
+    bool call(industrial_extrinsic_cal::mutable_joint_states_transaction::Request &request,
+	      industrial_extrinsic_cal::mutable_joint_states_transaction::Response &response);
+
+    ros::NodeHandle nh_;
+    ros::ServiceClient transaction_client_;
+    ros::ServiceClient get_client_; /**< fallback of a publisher without the transaction service */
+    ros::ServiceClient set_client_; /**< fallback of a publisher without the transaction service */
+    std::map<std::string, double> values_; /**< values of the current read */
+    bool writing_; /**< true between beginWrite() and commitWrite() */
+    std::vector<std::string> write_names_; /**< joints queued for the commit, in the order they were set */
+    std::map<std::string, double> write_values_; /**< the last value queued for each joint */
+    boost::mutex mutex_; /**< interfaces may be pulled from capture threads */
+  };
+
+  /** @brief reads the joints for its lifetime, e.g. while a scene's transforms are pulled */
+  class ScopedMutableJointRead
+  {
+  public:
+    /** @brief fetches the joints
+     *   @param joint_names the joints, nothing is fetched when empty
+     */
+    explicit ScopedMutableJointRead(const std::vector<std::string> &joint_names);
+
+    /** @brief ends the read */
+    ~ScopedMutableJointRead();
+
+  private:
+    bool active_;
+  };
+
+  /** @brief collects the joints set during its lifetime and commits them together when it ends */
+  class ScopedMutableJointWrite
+  {
+  public:
+    /** @brief begins the write */
+    ScopedMutableJointWrite();
+
+    /** @brief commits the write */
+    ~ScopedMutableJointWrite();
+  };
+
   /** @brief this object is intened to be used for targets, not cameras
    *            It simply listens to a pose from ref to transform frame, this must be set in a urdf
    *            push does nothing
@@ -61,6 +332,9 @@ namespace industrial_extrinsic_cal
     /** @brief get the transform from tf */
     Pose6d pullTransform();
 
+    /** @brief the reference to transform frame pair */
+    void getTFFrames(std::vector<std::pair<std::string, std::string> > &frames);
+
     /** @brief this is a listener interface, does nothing */
     bool store(std::string &filePath) { return(true);};
 
@@ -72,7 +346,6 @@ namespace industrial_extrinsic_cal
 
   private:
     Pose6d pose_;
-    tf::TransformListener tf_listener_;
     tf::StampedTransform transform_;
   };
 
@@ -104,6 +377,9 @@ namespace industrial_extrinsic_cal
     /** @brief this returns the transform from the optical frame to the reference frame as returned by tf */
     Pose6d pullTransform();
 
+    /** @brief the optical to reference frame pair */
+    void getTFFrames(std::vector<std::pair<std::string, std::string> > &frames);
+
     /** @brief as a listener interface, this does nothing because transform defined by urdf*/
     bool store(std::string &filePath) {return(true);};
 
@@ -115,7 +391,6 @@ namespace industrial_extrinsic_cal
 
   private:
     Pose6d pose_;
-    tf::TransformListener tf_listener_;
     tf::StampedTransform transform_;
   };
 
@@ -148,6 +423,9 @@ namespace industrial_extrinsic_cal
     /** @brief get the transform from the hardware or display */
     Pose6d pullTransform();
 
+    /** @brief the optical to reference frame pair */
+    void getTFFrames(std::vector<std::pair<std::string, std::string> > &frames);
+
     /** @brief as a listener interface, this does nothing. Transform is defined by urdf */
     bool store(std::string &filePath){ return(true);};
 
@@ -160,7 +438,6 @@ namespace industrial_extrinsic_cal
   private:
     std::string housing_frame_; /**< housing frame name note, this is not used, but kept be symetry with broadcaster param list */
     Pose6d pose_; /**< pose associated with the transform from reference frame to housing frame */
-    tf::TransformListener tf_listener_; /**< listener used to get the transform/pose_ from tf */
   };
 
   /** @brief This transform interface is used when the pose determined through calibration
@@ -168,7 +445,7 @@ namespace industrial_extrinsic_cal
       /* the pose from the yaml file is broadcast immediately 
       /* Once calibrated, the pose may be pushed, then the updated pose will be observed by tf
   */
-  class ROSBroadcastTransInterface : public TransformInterface
+  class ROSBroadcastTransInterface : public TransformInterface, public TransformBroadcastSource
   {
   public:
 
@@ -181,7 +458,7 @@ namespace industrial_extrinsic_cal
     /**
      * @brief Default destructor
      */
-    ~ROSBroadcastTransInterface()  {  } ;
+    ~ROSBroadcastTransInterface();
 
     /** @brief  updates the pose being broadcast*/
     bool pushTransform(Pose6d & pose);
@@ -189,21 +466,25 @@ namespace industrial_extrinsic_cal
     /** @brief this is a broadcaster, this should return the value of the construtor, or the last value used in pullTransform(pose) */
     Pose6d pullTransform() {return(pose_);};
 
-    /** @brief appends data as a static transform publisher to the file */
-    bool store(std::string &filePath);
+    /** @brief does nothing, the transform is written with the rest of the job's results, see getStoredTransform() */
+    bool store(std::string &filePath) { return(true);};
+
+    /** @brief always true, the calibrated pose is stored as a static transform */
+    bool hasStoredTransform() { return(true);};
+
+    /** @brief the calibrated pose as the static transform it is broadcast as */
+    bool getStoredTransform(std::string &parent_frame, std::string &child_frame, Pose6d &pose);
 
     /** @brief sets the reference frame of the transform interface, sometimes not used */
     void setReferenceFrame(std::string &ref_frame);
 
-    /** @brief a timer callback that continuously broadcast the current pose as a tf */
-    void timerCallback(const ros::TimerEvent & timer_event);
+    /** @brief the current pose as a tf, sent by the shared broadcaster */
+    bool getBroadcastTransform(tf::StampedTransform &transform);
    
   private:
     Pose6d pose_; /**< pose associated with the transform */
-    ros::Timer timer_; /**< need a timer to initiate broadcast of transform */
     tf::StampedTransform transform_; /**< the broadcaster needs this which we get values from pose_ */
-    tf::TransformBroadcaster tf_broadcaster_; /**< the broadcaster to tf */
-    bool ref_frame_defined_; /**< the broadcaster can't start until the reference frame is defined, this is set then */
+    bool ref_frame_defined_; /**< nothing is broadcast until the reference frame is defined, this is set then */
   };
 
   /** @brief This transform interface is used when the camera pose  is determined through calibration
@@ -212,7 +493,7 @@ namespace industrial_extrinsic_cal
       /* Once calibrated, the pose may be pushed to tf
   */
 
-  class ROSCameraBroadcastTransInterface : public TransformInterface
+  class ROSCameraBroadcastTransInterface : public TransformInterface, public TransformBroadcastSource
   {
   public:
 
@@ -225,7 +506,7 @@ namespace industrial_extrinsic_cal
     /**
      * @brief Default destructor
      */
-    ~ROSCameraBroadcastTransInterface()  {  } ;
+    ~ROSCameraBroadcastTransInterface();
 
     /** @brief  updates the pose being broadcast*/
     bool pushTransform(Pose6d & pose);
@@ -233,21 +514,25 @@ namespace industrial_extrinsic_cal
     /** @brief this is a broadcaster, this should return the value of the construtor, or the last value used in pullTransform(pose) */
     Pose6d pullTransform() {return(pose_);};
 
-    /** @brief appends data as a static transform publisher to the file */
-    bool store(std::string &filePath);
+    /** @brief does nothing, the transform is written with the rest of the job's results, see getStoredTransform() */
+    bool store(std::string &filePath) { return(true);};
+
+    /** @brief always true, the calibrated pose is stored as a static transform */
+    bool hasStoredTransform() { return(true);};
+
+    /** @brief the calibrated pose as the static transform it is broadcast as */
+    bool getStoredTransform(std::string &parent_frame, std::string &child_frame, Pose6d &pose);
 
     /** @brief sets the reference frame of the transform interface, sometimes not used */
     void setReferenceFrame(std::string &ref_frame);
 
-    /** @brief a timer callback that continuously broadcast the current pose as a tf */
-    void timerCallback(const ros::TimerEvent & timer_event);
+    /** @brief the current pose as a tf, sent by the shared broadcaster */
+    bool getBroadcastTransform(tf::StampedTransform &transform);
    
   private:
     Pose6d pose_; /**< pose associated with the transform */
-    ros::Timer timer_; /**< need a timer to initiate broadcast of transform */
     tf::StampedTransform transform_; /**< the broadcaster needs this which we get values from pose_ */
-    tf::TransformBroadcaster tf_broadcaster_; /**< the broadcaster to tf */
-    bool ref_frame_defined_; /**< the broadcaster can't start until the reference frame is defined, this is set then */
+    bool ref_frame_defined_; /**< nothing is broadcast until the reference frame is defined, this is set then */
   };
 
 
@@ -256,7 +541,7 @@ namespace industrial_extrinsic_cal
       /* the pose in the camera yaml file is broadcast imediately 
       /* Once calibrated, the pose may be pushed to tf
   */
-  class ROSCameraHousingBroadcastTInterface : public TransformInterface
+  class ROSCameraHousingBroadcastTInterface : public TransformInterface, public TransformBroadcastSource
   {
   public:
 
@@ -269,7 +554,7 @@ namespace industrial_extrinsic_cal
     /**
      * @brief Default destructor
      */
-    ~ROSCameraHousingBroadcastTInterface()  {  } ;
+    ~ROSCameraHousingBroadcastTInterface();
 
     /** @brief  updates the pose being broadcast*/
     bool pushTransform(Pose6d & Pose);
@@ -277,22 +562,29 @@ namespace industrial_extrinsic_cal
     /** @brief returns the pose used in construction, or the one most recently pushed */
     Pose6d pullTransform(){ return(pose_);};
 
-    /** @brief appends pose as a static transform publisher to the file */
-    bool store(std::string &filePath);
+    /** @brief does nothing, the transform is written with the rest of the job's results, see getStoredTransform() */
+    bool store(std::string &filePath) { return(true);};
+
+    /** @brief always true, the calibrated pose is stored as a static transform */
+    bool hasStoredTransform() { return(true);};
+
+    /** @brief the calibrated pose as the static transform it is broadcast as */
+    bool getStoredTransform(std::string &parent_frame, std::string &child_frame, Pose6d &pose);
 
     /** @brief sets the reference frame of the transform interface, sometimes not used */
     void setReferenceFrame(std::string &ref_frame);
 
-    /** @brief a timer callback that continuously broadcast the current pose as a tf */
-    void timerCallback(const ros::TimerEvent & timer_event);
+    /** @brief the current pose as a tf, sent by the shared broadcaster */
+    bool getBroadcastTransform(tf::StampedTransform &transform);
    
   private:
+    /** @brief looks up the housing in tf and computes ref2housing_ from pose_, outside the broadcaster's lock */
+    void resolveHousing();
+
     Pose6d pose_; /**< pose associated with the transform */
-    ros::Timer timer_; /**< need a timer to initiate broadcast of transform */
+    Pose6d ref2housing_; /**< the broadcast pose of the housing, updated by each push */
     tf::StampedTransform transform_; /**< the broadcaster needs this which we get values from pose_ */
-    tf::TransformBroadcaster tf_broadcaster_; /**< the broadcaster to tf */
-    tf::TransformListener tf_listener_; // need this to get the tranform from housing to optical frame from tf
-    bool ref_frame_defined_; /**< the broadcaster can't start until the reference frame is defined, this is set then */
+    bool ref_frame_defined_; /**< nothing is broadcast until the reference frame is defined, this is set then */
     std::string housing_frame_; /**< frame name for the housing */
   };
 
@@ -344,6 +636,12 @@ namespace industrial_extrinsic_cal
     /** @brief get the transform from the mutable transform publisher, and compute the optical to reference frame pose*/
     Pose6d pullTransform();
 
+    /** @brief the optical to housing and the reference to mounting frame pairs */
+    void getTFFrames(std::vector<std::pair<std::string, std::string> > &frames);
+
+    /** @brief the 6 joints between the mounting and the housing frame */
+    void getMutableJoints(std::vector<std::string> &joint_names);
+
     /** @brief as a listener interface, tells the mutable transform publisher to store its current values in its yaml file */
     bool store(std::string &filePath);
 
@@ -360,7 +658,6 @@ namespace industrial_extrinsic_cal
     std::string housing_frame_; /**< housing frame name */
     std::string mounting_frame_; /**< mounting frame name */
     Pose6d pose_; /**< pose associated with the transform from reference frame to housing frame */
-    tf::TransformListener tf_listener_; /**< listener used to get the transform/pose_ from tf */
     ros::ServiceClient get_client_; /**< a client for calling the service to get the joint values associated with the transform */
     ros::ServiceClient set_client_; /**< a client for calling the service to set the joint values associated with the transform */
     ros::ServiceClient store_client_; /**< a client for calling the service to store the joint values associated with the transform */
@@ -413,6 +710,9 @@ namespace industrial_extrinsic_cal
     /** @brief get the transform from the mutable transform publisher, and compute the optical to reference frame pose*/
     Pose6d pullTransform();
 
+    /** @brief the 6 joints between the parent and the transform frame */
+    void getMutableJoints(std::vector<std::string> &joint_names);
+
     /** @brief as a listener interface, tells the mutable transform publisher to store its current values in its yaml file */
     bool store(std::string &filePath);
 
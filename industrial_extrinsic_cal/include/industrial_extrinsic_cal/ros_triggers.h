@@ -26,39 +26,206 @@
 #include <industrial_extrinsic_cal/manual_triggerAction.h>
 #include <industrial_extrinsic_cal/robot_joint_values_triggerAction.h>
 #include <industrial_extrinsic_cal/robot_pose_triggerAction.h>
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+#include <std_msgs/Empty.h>
+#include <std_srvs/Empty.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <string>
 
 namespace industrial_extrinsic_cal
 {
-  class ROSParamTrigger : public Trigger
+  /*! \brief A trigger which blocks without using the cpu until a notification arrives, and wakes within
+   *         milliseconds of it. Notifications are received on a callback queue and spinner shared by all event
+   *         triggers, so they arrive while the calling thread waits, whatever that thread's spinner is doing.
+   *         Subscriptions and services exist only during a wait, triggers sharing a name in different scenes
+   *         never see each other's notifications. poll() checks for a trigger which sends no notification,
+   *         at intervals doubling from the minimum to the maximum poll interval.
+   */
+  class ROSEventTrigger : public Trigger
+  {
+  public:
+    /*! \brief Constructor, starts the shared spinner on first use
+     *  \param min_poll_interval first interval between polls (seconds)
+     *  \param max_poll_interval the intervals double up to this (seconds)
+     */
+    ROSEventTrigger(double min_poll_interval, double max_poll_interval);
+
+    /*! \brief Destructor
+     */
+    virtual ~ROSEventTrigger();
+
+    /*! \brief waits for a notification, or a successful poll, consumes it. Each attempt lasts the timeout,
+     *         retries only wait longer, a retry can not resend a notification.
+     *  \return false if ros shut down, or every attempt timed out
+     */
+    bool waitForTrigger();
+
+  protected:
+    /*! \brief a notification arrived, wakes the waiting thread, ignored when no thread waits
+     */
+    void notify();
+
+    /*! \brief called as a wait begins, before any poll, subscribes or advertises the trigger's source
+     */
+    virtual void beginWait() {};
+
+    /*! \brief called as a wait ends, shuts down what beginWait() started
+     */
+    virtual void endWait() {};
+
+    /*! \brief checks for the trigger without a notification, called without the trigger's lock
+     */
+    virtual bool poll() { return(false); };
+
+    /*! \brief resets the trigger's source after the trigger is consumed
+     */
+    virtual void consumed() {};
+
+    /*! \brief what the trigger waits for, for the log
+     */
+    virtual std::string description() const = 0;
+
+    ros::NodeHandle nh_;	/**< node handle using the shared callback queue */
+
+  private:
+    boost::mutex mutex_;
+    boost::condition_variable notified_;
+    bool waiting_;		/**< a thread waits for the trigger */
+    bool triggered_;		/**< a notification arrived during the wait */
+    double min_poll_interval_;
+    double max_poll_interval_;
+  };
+
+  /*! \brief Waits for a std_msgs/Empty message on a topic
+   */
+  class ROSTopicTrigger : public ROSEventTrigger
   {
   public:
     /*! \brief Constructor,
+     *  \param topic_name the topic
      */
-    ROSParamTrigger(const std::string & parameter_name) 
-      {
-	parameter_name_ = parameter_name;  
-	nh_.setParam(parameter_name_.c_str(),false);
-      };
+    ROSTopicTrigger(const std::string & topic_name);
+
     /*! \brief Destructor
      */
-    ~ROSParamTrigger(){};
-    /*! \brief Initiates and waits for trigger to finish
+    ~ROSTopicTrigger(){};
+
+  protected:
+    void beginWait();
+    void endWait();
+    std::string description() const;
+
+  private:
+    void callback(const std_msgs::EmptyConstPtr &msg);
+
+    std::string topic_name_;	/**< name of the topic */
+    ros::Subscriber sub_;
+  };
+
+  /*! \brief Waits for a call of a std_srvs/Empty service, the call returns right away.
+   *         The service is advertised only during the wait, so scenes may share its name.
+   */
+  class ROSServiceTrigger : public ROSEventTrigger
+  {
+  public:
+    /*! \brief Constructor,
+     *  \param service_name the service this trigger advertises
      */
-    bool waitForTrigger()
-    {
-      ROS_ERROR("ROSParamTrigger:  waiting for %s to be true",parameter_name_.c_str());
-      bool pval = false;
-      while(!pval){
-	nh_.getParam(parameter_name_.c_str(),pval);
-      }
-      nh_.setParam(parameter_name_.c_str(),false);
-      return(true);
-    };
-  private: 
-    ros::NodeHandle nh_;
-    std::string parameter_name_;
+    ROSServiceTrigger(const std::string & service_name);
+
+    /*! \brief Destructor
+     */
+    ~ROSServiceTrigger(){};
+
+  protected:
+    void beginWait();
+    void endWait();
+    std::string description() const;
+
+  private:
+    bool callback(std_srvs::Empty::Request &req, std_srvs::Empty::Response &res);
+
+    std::string service_name_;	/**< name of the service */
+    ros::ServiceServer server_;
   };
 
+  /*! \brief Waits for a boolean parameter to become true, then sets it back to false.
+   *         Polls the parameter cache, which the master updates, at intervals backing off to half a second.
+   *         A std_msgs/Empty message on the topic of the same name triggers it right away.
+   */
+  class ROSParamTrigger : public ROSEventTrigger
+  {
+  public:
+    /*! \brief Constructor,
+     *  \param parameter_name the parameter, also the name of the topic
+     */
+    ROSParamTrigger(const std::string & parameter_name);
+
+    /*! \brief Destructor
+     */
+    ~ROSParamTrigger(){};
+
+  protected:
+    void beginWait();
+    void endWait();
+    bool poll();
+    void consumed();
+    std::string description() const;
+
+  private:
+    void topicCallback(const std_msgs::EmptyConstPtr &msg);
+
+    std::string parameter_name_; /**< name of the parameter */
+    ros::Subscriber sub_;
+  };
+
+  /*! \brief sends a goal to an action server and waits for its result. An attempt which does not finish within
+   *         the timeout is cancelled, it and a goal which does not succeed are sent again up to retries times.
+   *  \param client the action client
+   *  \param goal the goal
+   *  \param server_name name of the server, for the log
+   *  \param timeout seconds an attempt may take, including the wait for the server, 0 waits forever
+   *  \param retries attempts after the first
+   *  \return true if the goal succeeded
+   */
+  template<class Client, class Goal>
+  bool sendGoalAndWait(Client &client, const Goal &goal, const std::string &server_name, double timeout, int retries)
+  {
+    for(int attempt=1; attempt<=retries+1 && ros::ok(); attempt++){
+      ros::Time start = ros::Time::now();
+      if(!client.waitForServer(ros::Duration(timeout))){ // 0 waits forever
+	ROS_ERROR("server %s not available within %.1f seconds, attempt %d of %d",
+		  server_name.c_str(), timeout, attempt, retries+1);
+	continue;
+      }
+      client.sendGoal(goal);
+      bool done = false;
+      while(!done && ros::ok()){
+	ros::Duration wait(5.0);
+	if(timeout > 0.0){
+	  double remaining = timeout - (ros::Time::now() - start).toSec();
+	  if(remaining <= 0.0) break;
+	  if(remaining < wait.toSec()) wait = ros::Duration(remaining);
+	}
+	done = client.waitForResult(wait);
+	ROS_INFO("Current State: %s", client.getState().toString().c_str());
+      }
+      if(!done){
+	ROS_ERROR("server %s did not finish within %.1f seconds, attempt %d of %d",
+		  server_name.c_str(), timeout, attempt, retries+1);
+	client.cancelGoal();
+	continue;
+      }
+      if(client.getState() == actionlib::SimpleClientGoalState::SUCCEEDED) return(true);
+      ROS_ERROR("server %s ended in state %s, attempt %d of %d", server_name.c_str(),
+		client.getState().toString().c_str(), attempt, retries+1);
+    }
+    return(false);
+  }
+
   typedef actionlib::SimpleActionClient<industrial_extrinsic_cal::manual_triggerAction> ManualClient;
 
   class ROSActionServerTrigger : public Trigger
@@ -82,16 +249,9 @@ namespace industrial_extrinsic_cal
     bool waitForTrigger()
     {
       ROS_INFO("ROSActionServerTrigger: waiting for trigger server %s to complete ",server_name_.c_str());
-      client_->waitForServer();
       industrial_extrinsic_cal::manual_triggerGoal goal;
       goal.display_message = action_message_;
-      client_->sendGoal(goal);
-      do{
-	client_->waitForResult(ros::Duration(5.0));
-	ROS_INFO("Current State: %s", client_->getState().toString().c_str());
-      } while(client_->getState() != actionlib::SimpleClientGoalState::SUCCEEDED
-	      && client_->getState() != actionlib::SimpleClientGoalState::ABORTED);
-      return(true);  /**< TODO implement a timeout, cancels action and with returns false*/
+      return(sendGoalAndWait(*client_, goal, server_name_, timeout_, retries_));
     };
   private: 
     ManualClient *client_;
@@ -129,20 +289,13 @@ namespace industrial_extrinsic_cal
     bool waitForTrigger()
     {
       ROS_INFO("ROSRobotJointValuesActionServerTrigger: waiting for trigger server %s to complete ",server_name_.c_str());
-      client_->waitForServer();
       industrial_extrinsic_cal::robot_joint_values_triggerGoal goal;
       goal.joint_values.clear();
       for(int i=0; i<(int)joint_values_.size();i++){
 	goal.joint_values.push_back(joint_values_[i]);
       }
       ROS_INFO("SENDING GOAL");
-      client_->sendGoal(goal);
-      do{
-	client_->waitForResult(ros::Duration(5.0));
-	ROS_INFO("Current State: %s", client_->getState().toString().c_str());
-      } while(client_->getState() != actionlib::SimpleClientGoalState::SUCCEEDED
-	      && client_->getState() != actionlib::SimpleClientGoalState::ABORTED);
-      return(true);  /**< TODO implement a timeout, cancels action and with returns false*/
+      return(sendGoalAndWait(*client_, goal, server_name_, timeout_, retries_));
     };
   private: 
     RobotJointValuesClient *client_;
@@ -176,16 +329,9 @@ namespace industrial_extrinsic_cal
     bool waitForTrigger()
     {
       ROS_INFO("ROSRobotPoseActionServerTrigger: waiting for trigger server %s to complete ",server_name_.c_str());
-      client_->waitForServer();
       industrial_extrinsic_cal::robot_pose_triggerGoal goal;
       goal.pose = pose_;
-      client_->sendGoal(goal);
-      do{
-	client_->waitForResult(ros::Duration(5.0));
-	ROS_INFO("Current State: %s", client_->getState().toString().c_str());
-      } while(client_->getState() != actionlib::SimpleClientGoalState::SUCCEEDED
-	      && client_->getState() != actionlib::SimpleClientGoalState::ABORTED);
-      return(true);  /**< TODO implement a timeout, cancels action and with returns false*/
+      return(sendGoalAndWait(*client_, goal, server_name_, timeout_, retries_));
     };
   private: 
     Robot_Pose_Client *client_;
@@ -0,0 +1,111 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ROTATION_CACHE_H_
+#define ROTATION_CACHE_H_
+
+#include "ceres/ceres.h"
+#include "ceres/rotation.h"
+#include <map>
+
+namespace industrial_extrinsic_cal
+{
+
+  /*! \brief rotation matrix of one angle-axis parameter block, and its derivative, at the current evaluation point */
+  typedef struct
+  {
+    const double *angle_axis;	/**< the block, its first 3 values are the angle-axis */
+    double aa[3];		/**< angle-axis at which R and dR were computed */
+    double R[9];		/**< rotation matrix, column major like ceres::AngleAxisToRotationMatrix */
+    double dR[9][3];		/**< dR[i][k] is the derivative of R[i] with respect to aa[k] */
+  } RotationCacheEntry;
+
+  /*! \brief Computes the rotation matrix of every camera and target pose block once per evaluation point.
+   *         Without it, each residual converts the same angle-axis blocks again, with Jets, thousands of times per iteration.
+   *         Cost functions hold the entry of their blocks and read it with cachedRotationMatrix().
+   *         The cache is refreshed by the solver through ceres::EvaluationCallback, see attach().
+   *         An entry that does not match the block's current value is ignored, so a stale cache is slow, never wrong.
+   */
+  class RotationCache : public ceres::EvaluationCallback
+  {
+  public:
+    /*! \brief Constructor, creates an empty cache */
+    RotationCache(){};
+
+    /*! \brief Destructor */
+    virtual ~RotationCache(){};
+
+    /*! \brief registers a block, the returned pointer stays valid until clear()
+     *  \param angle_axis the block, its first 3 values are the angle-axis
+     *  \return the entry of the block, computed at the block's current value
+     */
+    const RotationCacheEntry* add(const double *angle_axis);
+
+    /*! \brief removes every entry, call it when the problem whose cost functions hold them is replaced */
+    void clear() { entries_.clear(); };
+
+    /*! \brief recomputes every entry from the current values of the blocks */
+    void update();
+
+    /*! \brief called by the solver before it evaluates residuals, the blocks then hold the evaluation point */
+    virtual void PrepareForEvaluation(bool evaluate_jacobians, bool new_evaluation_point);
+
+    /*! \brief has the solver refresh the cache before each evaluation
+     *  \param options the options passed to ceres::Solve, the cache must outlive the solve
+     */
+    void attach(ceres::Solver::Options &options);
+
+    /*! \brief number of registered blocks */
+    int size() const { return((int)entries_.size()); };
+
+  private:
+    RotationCache(const RotationCache &);
+    RotationCache& operator=(const RotationCache &);
+
+    std::map<const double*, RotationCacheEntry> entries_; /*!< keyed by block, map nodes do not move */
+  };
+
+  /*! \brief value part of a scalar, used to check a cache entry against the evaluation point */
+  inline double rotationCacheValue(double x) { return(x); }
+  template<typename S, int N> inline S rotationCacheValue(const ceres::Jet<S, N> &x) { return(x.a); }
+
+  /*! \brief ceres compliant rotation matrix of an angle-axis, read from a cache entry when it matches
+   *  @param entry the cache entry of the block angle_axis came from, NULL to always compute
+   *  @param angle_axis ax, ay, and az
+   *  @param R the rotation matrix, column major
+   */
+  template<typename T> inline void cachedRotationMatrix(const RotationCacheEntry *entry, const T angle_axis[3], T R[9])
+  {
+    if(entry == NULL ||
+       entry->aa[0] != rotationCacheValue(angle_axis[0]) ||
+       entry->aa[1] != rotationCacheValue(angle_axis[1]) ||
+       entry->aa[2] != rotationCacheValue(angle_axis[2])){
+      ceres::AngleAxisToRotationMatrix(angle_axis, R);
+      return;
+    }
+    // the differences are zero valued and carry the derivatives of angle_axis, first order is exact at this point
+    T d[3];
+    for(int k=0; k<3; k++) d[k] = angle_axis[k] - T(entry->aa[k]);
+    for(int i=0; i<9; i++){
+      R[i] = T(entry->R[i]) + entry->dR[i][0]*d[0] + entry->dR[i][1]*d[1] + entry->dR[i][2]*d[2];
+    }
+  }
+
+}//end namespace industrial_extrinsic_cal
+
+#endif /* ROTATION_CACHE_H_ */
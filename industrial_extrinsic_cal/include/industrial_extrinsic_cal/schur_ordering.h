@@ -0,0 +1,65 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SCHUR_ORDERING_H_
+#define SCHUR_ORDERING_H_
+
+#include "ceres/ceres.h"
+#include <vector>
+
+namespace industrial_extrinsic_cal
+{
+
+  /*! \brief Builds the elimination ordering of a Schur linear solver from the roles of the parameter blocks.
+   *         Target points and moving target poses are declared for elimination, cameras and everything else
+   *         form the reduced camera system. Left alone, Ceres guesses the eliminated group from the problem's
+   *         graph, which is slow to find and may not be the one that keeps the reduced system small.
+   *         Blocks sharing a residual cannot be eliminated together, the earlier declaration wins and the later
+   *         one joins the reduced system.
+   */
+  class SchurOrdering
+  {
+  public:
+    /*! \brief Constructor, nothing declared */
+    SchurOrdering(){};
+
+    /*! \brief Destructor */
+    ~SchurOrdering(){};
+
+    /*! \brief declares a block for elimination, declare points before poses
+     *  \param block the parameter block, ignored if it is not in the problem when the ordering is applied
+     */
+    void eliminate(const double *block);
+
+    /*! \brief number of declared blocks */
+    int size() const { return((int)eliminate_.size()); };
+
+    /*! \brief sets the linear solver ordering of the options, only for the Schur solvers
+     *  \param problem the problem to be solved with options, every one of its blocks is placed in a group
+     *  \param options its linear_solver_ordering is set
+     *  \return number of eliminated blocks, 0 when no ordering was set and Ceres chooses its own
+     */
+    int apply(ceres::Problem &problem, ceres::Solver::Options &options) const;
+
+  private:
+    std::vector<const double*> eliminate_; /*!< declared blocks in priority order */
+  };
+
+}//end namespace industrial_extrinsic_cal
+
+#endif /* SCHUR_ORDERING_H_ */
@@ -0,0 +1,94 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SLIDING_WINDOW_H_
+#define SLIDING_WINDOW_H_
+
+#include <industrial_extrinsic_cal/observation_data_point.h>
+#include "ceres/ceres.h"
+#include <vector>
+
+namespace industrial_extrinsic_cal
+{
+
+  /*! \brief settings of an incremental re-calibration */
+  typedef struct
+  {
+    int window_scenes;		/**< most recent scenes kept, including the new ones */
+    int max_num_iterations;	/**< solver iterations, the solve starts at the last solution */
+    double max_solver_time;	/**< solver time limit (seconds) */
+  } SlidingWindowParameters;
+
+  /*! \brief fills in the defaults, 8 scenes, 20 iterations, half a second */
+  SlidingWindowParameters defaultSlidingWindowParameters();
+
+  /*! \brief The recent scenes of an incremental re-calibration. New scenes replace older observations of the same
+   *         scene and push the oldest out of the window. Only the blocks the new scenes can correct are solved:
+   *         the extrinsics of the cameras which observed them and the target poses no older scene constrains.
+   *         Everything else is held at the last solution, the older scenes anchor the correction.
+   */
+  class SlidingWindow
+  {
+  public:
+    /*! \brief Constructor
+     *  \param parameters window size and solver limits
+     */
+    explicit SlidingWindow(const SlidingWindowParameters &parameters);
+
+    /*! \brief Destructor */
+    ~SlidingWindow(){};
+
+    /*! \brief starts the window from the scenes of a full solve, keeps the most recent ones
+     *  \param scenes observations of each scene, oldest first
+     */
+    void seed(const std::vector<ObservationDataPointList> &scenes);
+
+    /*! \brief adds newly observed scenes, they become the scenes whose blocks are solved
+     *  \param scenes observations of each new scene
+     */
+    void add(const std::vector<ObservationDataPointList> &scenes);
+
+    /*! \brief observations of every scene in the window, oldest first */
+    const std::vector<ObservationDataPointList>& scenes() const { return(scenes_); };
+
+    /*! \brief number of scenes added by the last add() which are still in the window */
+    int numNewScenes() const { return(num_new_); };
+
+    /*! \brief empties the window */
+    void clear();
+
+    /*! \brief holds constant every block of a problem built from scenes(), except those the new scenes correct
+     *  \param problem the problem, blocks already constant stay constant
+     *  \return number of blocks left free, those already constant are not counted
+     */
+    int holdUnaffectedConstant(ceres::Problem &problem) const;
+
+    /*! \brief sets the iteration and time limits, and a dense solver suited to the few free blocks */
+    void configure(ceres::Solver::Options &options) const;
+
+  private:
+    void trim();
+
+    SlidingWindowParameters parameters_;
+    std::vector<ObservationDataPointList> scenes_; /*!< the window, the last num_new_ are the new scenes */
+    int num_new_;
+  };
+
+}//end namespace industrial_extrinsic_cal
+
+#endif /* SLIDING_WINDOW_H_ */
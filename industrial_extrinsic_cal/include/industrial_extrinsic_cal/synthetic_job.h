@@ -0,0 +1,132 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SYNTHETIC_JOB_H_
+#define SYNTHETIC_JOB_H_
+
+#include <industrial_extrinsic_cal/basic_types.h>
+#include <industrial_extrinsic_cal/ceres_costs_utils.h>
+#include <industrial_extrinsic_cal/observation_data_point.h>
+#include <industrial_extrinsic_cal/outlier_trimmer.h>
+#include <industrial_extrinsic_cal/robust_loss.h>
+#include <industrial_extrinsic_cal/schur_ordering.h>
+#include <boost/random/mersenne_twister.hpp>
+#include "ceres/ceres.h"
+#include <vector>
+
+namespace industrial_extrinsic_cal
+{
+
+  /*! \brief describes the synthetic job to generate */
+  typedef struct
+  {
+    int num_cameras;		/**< cameras placed on a ring looking at the target */
+    int num_scenes;		/**< each scene moves the target, or the link for Link* cost types */
+    int target_rows;		/**< rows of the target's point grid */
+    int target_cols;		/**< columns of the target's point grid */
+    double point_spacing;	/**< distance between grid points (meters) */
+    double circle_diameter;	/**< diameter of the circles, used by Circle* cost types (meters) */
+    double pixel_noise;		/**< std deviation of the noise added to each observation (pixels) */
+    double outlier_fraction;	/**< fraction of observations replaced by outliers */
+    double outlier_magnitude;	/**< largest displacement of an outlier (pixels) */
+    double rotation_noise;	/**< std deviation of the initial guess angle axis error (radians) */
+    double translation_noise;	/**< std deviation of the initial guess position error (meters) */
+    Cost_function cost_type;	/**< cost type used by every observation */
+    unsigned int seed;		/**< random seed, the same seed generates the same job */
+  } SyntheticJobParameters;
+
+  /*! \brief a 4 camera, 10 scene circle grid job with 0.2 pixel noise and no outliers */
+  SyntheticJobParameters defaultSyntheticJobParameters();
+
+  /*! \brief Generates a calibration job with known ground truth, without cameras or ROS.
+   *         The observations are created by evaluating the job's own cost functions at the true
+   *         parameter values, so every Cost_function type gets consistent data.
+   */
+  class SyntheticJob
+  {
+  public:
+    /*! \brief Constructor
+     *  \param parameters description of the job
+     */
+    explicit SyntheticJob(const SyntheticJobParameters &parameters);
+
+    /*! \brief Destructor */
+    ~SyntheticJob(){};
+
+    /*! \brief creates the true and initial parameters and the observations
+     *  \return true if at least one observation landed in an image
+     */
+    bool generate();
+
+    /*! \brief restores the estimated parameters to the initial guess, so the job can be solved again */
+    void reset();
+
+    /*! \brief moves one observation's image location, to place an outlier where it is known
+     *  \param index the observation
+     *  \param dx, dy displacement (pixels)
+     */
+    void displaceObservation(int index, double dx, double dy);
+
+    /*! \brief sets the robust loss applied to the observations by addToProblem() */
+    void setRobustLosses(const RobustLossTable &losses) { robust_losses_ = losses; };
+
+    /*! \brief adds a residual block for every observation to a problem
+     *  \param rotation_cache when not NULL the cost functions read pose rotations from it, attach it to the solver options
+     *  \param residuals when not NULL the observation of each added block is appended, for OutlierTrimmer
+     *  \return number of residual blocks added
+     */
+    int addToProblem(ceres::Problem &problem, RotationCache *rotation_cache = NULL,
+		     std::vector<ObservationResidual> *residuals = NULL);
+
+    /*! \brief declares the blocks a Schur solver should eliminate, the target points, then the target poses which move each scene */
+    void addSchurEliminationBlocks(SchurOrdering &ordering);
+
+    /*! \brief root mean square distance between the estimated and true camera positions (meters) */
+    double cameraPositionError() const;
+
+    /*! \brief the generated observations, their blocks point into the estimated parameters */
+    const ObservationDataPointList& observations() const { return(observations_); };
+
+  private:
+    /*! \brief the parameters of a job, one set holds the truth, one the estimate */
+    typedef struct
+    {
+      std::vector<CameraParameters> cameras;	/**< extrinsics and intrinsics of each camera */
+      std::vector<Pose6d> target_poses;		/**< one per scene */
+      std::vector<Point3d> points;		/**< points of the target grid */
+    } JobBlocks;
+
+    /*! \brief a random pose with the given spread about a nominal pose */
+    void perturb(P_BLOCK pose, double rotation_sigma, double translation_sigma);
+
+    /*! \brief true when the cost type estimates one target pose per scene */
+    bool targetMovesEachScene() const;
+
+    SyntheticJobParameters parameters_;
+    JobBlocks truth_;			/*!< ground truth */
+    JobBlocks initial_;			/*!< initial guess */
+    JobBlocks estimate_;		/*!< parameters being optimized */
+    std::vector<Pose6d> link_poses_;	/*!< known link pose of each scene, used by Link* cost types */
+    ObservationDataPointList observations_;
+    RobustLossTable robust_losses_;	/*!< loss of each residual block */
+    boost::mt19937 rng_;
+  };
+
+}//end namespace industrial_extrinsic_cal
+
+#endif /* SYNTHETIC_JOB_H_ */
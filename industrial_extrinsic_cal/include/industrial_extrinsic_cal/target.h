@@ -28,7 +28,7 @@ namespace industrial_extrinsic_cal
   {
   public:
   /*! \brief constructor*/
-    Target(){};
+    Target() : fixed_pose_(false), fixed_points_(false), is_moving_(false) {};
 
   /*! \brief destructor*/
     ~Target(){};
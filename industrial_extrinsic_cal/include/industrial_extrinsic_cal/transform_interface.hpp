@@ -21,6 +21,9 @@
 
 #include <industrial_extrinsic_cal/basic_types.h> /* Pose6d,Roi,Observation,CameraObservations */
 #include <ros/ros.h>
+#include <string>
+#include <utility>
+#include <vector>
 namespace industrial_extrinsic_cal
 {
 
@@ -69,6 +72,29 @@ namespace industrial_extrinsic_cal
       Pose6d Identity;// default constructor is all zero's for translation and anlge axis. 
       return(Identity);
       };
+
+    /** @brief frames the next pullTransform() looks up in tf, so a scene's transforms can be fetched together
+     *    @param frames receives (target frame, source frame) pairs, interfaces which do not listen to tf add none
+     */
+    virtual void getTFFrames(std::vector<std::pair<std::string, std::string> > &frames) {};
+
+    /** @brief mutable joints the next pullTransform() reads and pushTransform() sets, so they can be batched
+     *    @param joint_names receives the names, interfaces without mutable joints add none
+     */
+    virtual void getMutableJoints(std::vector<std::string> &joint_names) {};
+
+    /** @brief true if the interface's result is a static transform, given by getStoredTransform() and written
+     *    with the rest of a job's results in one pass, false if store() keeps the results some other way, or not at all
+     */
+    virtual bool hasStoredTransform() { return(false); };
+
+    /** @brief the static transform of an interface that hasStoredTransform()
+     *    @param parent_frame receives the parent frame of the transform
+     *    @param child_frame receives the calibrated frame
+     *    @param pose receives the pose of the child frame in the parent frame
+     *    @return false if there is no transform to store
+     */
+    virtual bool getStoredTransform(std::string &parent_frame, std::string &child_frame, Pose6d &pose) { return(false); };
   protected:
     std::string ref_frame_; /*!< name of reference frame for transform (parent frame_id in  Rviz) */
     std::string transform_frame_; /*!< name of frame being defined (frame_id in Rviz) */
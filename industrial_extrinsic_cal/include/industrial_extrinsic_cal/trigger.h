@@ -26,18 +26,32 @@ namespace industrial_extrinsic_cal
 class Trigger
 { /** Trigger */
  public:
-    /*! \brief Constructor,
+    /*! \brief Constructor, waits forever without retries
      */
-  Trigger() { };
+  Trigger() : timeout_(0.0), retries_(0) { };
 
     /*! \brief Destructor
      */
   virtual ~Trigger(){};
 
     /*! \brief Initiates and waits for trigger to finish
+     *  \return false if the trigger failed, or did not finish within the timeout after every retry
      */
     virtual bool waitForTrigger()=0;
 
+    /*! \brief limits the wait
+     *  \param timeout seconds an attempt may take before it is abandoned, 0 waits forever
+     *  \param retries attempts made after the first one fails or times out
+     */
+    void setLimits(double timeout, int retries)
+    {
+      timeout_ = timeout;
+      retries_ = retries < 0 ? 0 : retries;
+    };
+
+ protected:
+    double timeout_; /*!< seconds per attempt, 0 waits forever */
+    int retries_; /*!< attempts after the first */
 } ;
 
  class NoWaitTrigger: public Trigger
@@ -0,0 +1,163 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VIEW_PLANNER_H_
+#define VIEW_PLANNER_H_
+
+#include <industrial_extrinsic_cal/basic_types.h>
+#include <industrial_extrinsic_cal/observation_data_point.h>
+#include <Eigen/Core>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace industrial_extrinsic_cal
+{
+
+  /*! \brief how the planner ranks views */
+  typedef enum
+  {
+    MIN_TRACE,		/**< smallest trace of the extrinsics covariance, each variance over its target's square */
+    MAX_DETERMINANT	/**< largest determinant of the extrinsics information */
+  } ViewPlanCriterion;
+
+  /*! \brief parses "trace" or "determinant"
+   *  \return false if the name is unknown
+   */
+  bool string2ViewPlanCriterion(const std::string &name, ViewPlanCriterion &criterion);
+
+  /*! \brief settings of the view planner */
+  typedef struct
+  {
+    int max_views;		/**< most views in a plan, 0 is unlimited */
+    double max_rotation_std;	/**< the plan is done once every extrinsics rotation std deviation is below this (rad) ... */
+    double max_position_std;	/**< ... and every position std deviation is below this (m) */
+    double pixel_sigma;		/**< std deviation of an observation (pixels) */
+    double prior_rotation_std;	/**< std deviation of the extrinsics rotation before any view (rad) */
+    double prior_position_std;	/**< std deviation of the extrinsics position before any view (m) */
+    ViewPlanCriterion criterion;/**< how views are ranked */
+  } ViewPlanParameters;
+
+  /*! \brief fills in the defaults, unlimited views, 0.005 rad and 2 mm targets, 1 pixel sigma, a 1 rad and 1 m prior, trace */
+  ViewPlanParameters defaultViewPlanParameters();
+
+  /*! \brief predicted uncertainty of one extrinsics block */
+  typedef struct
+  {
+    std::string name;		/**< camera, with the scene for cameras which move between scenes */
+    const double *block;	/**< the extrinsics block */
+    double std_dev[6];		/**< ax ay az x y z */
+  } ExtrinsicsUncertainty;
+
+  /*! \brief Chooses views, such as the scenes of a caljob, by the information they add to the camera extrinsics.
+   *         Each view's observations are linearized at the current values of their blocks. Views are chosen
+   *         greedily, each one the best by the criterion given those already chosen, until every extrinsics block
+   *         meets the uncertainty target.
+   *
+   *         The prediction approximates the full problem's covariance. Every estimated block other than an
+   *         extrinsics block is marginalized out of each view's information on its own, by a Schur complement over
+   *         that view's observations only, and the views' marginal informations are then summed. A block shared
+   *         between views, such as a free target point or a target pose seen in several scenes, is therefore
+   *         treated as a separate unknown in each view, and whatever the views together would learn about it is
+   *         lost. Since the Schur complement of a sum is at least the sum of the Schur complements, the predicted
+   *         uncertainty is conservative: a plan meets its target in the real solve, possibly with views to spare.
+   *         Blocks known exactly, see setConstantBlocks(), are not marginalized and cost no information.
+   */
+  class ViewPlanner
+  {
+  public:
+    /*! \brief Constructor
+     *  \param parameters view count, uncertainty target, noise and prior
+     */
+    explicit ViewPlanner(const ViewPlanParameters &parameters);
+
+    /*! \brief Destructor */
+    ~ViewPlanner(){};
+
+    /*! \brief blocks known exactly, such as the poses and points of known targets, they are not eliminated */
+    void setConstantBlocks(const std::vector<P_BLOCK> &blocks);
+
+    /*! \brief linearizes the observations of a view and stores the information they add to the extrinsics
+     *  \param view_id identifies the view, such as a scene id, adding an id again replaces the view
+     *  \param observations observations of the view, their blocks hold the current estimates
+     *  \return false if a cost could not be built or evaluated
+     */
+    bool addView(int view_id, const ObservationDataPointList &observations);
+
+    /*! \brief number of views added */
+    int numViews() const { return((int)views_.size()); };
+
+    /*! \brief chooses views until the uncertainty target is met
+     *  \param observed views already taken, they are part of every plan
+     *  \param selected the chosen views in the order they should be taken, without the observed ones
+     *  \return true if the observed and chosen views meet the uncertainty target
+     */
+    bool plan(const std::vector<int> &observed, std::vector<int> &selected);
+
+    /*! \brief predicts the uncertainty of a set of views, see uncertainty()
+     *  \param views the views
+     *  \return true if they meet the uncertainty target
+     */
+    bool predict(const std::vector<int> &views);
+
+    /*! \brief uncertainty of each extrinsics block from the last plan() or predict() */
+    const std::vector<ExtrinsicsUncertainty>& uncertainty() const { return(uncertainty_); };
+
+    /*! \brief a few lines for the log, the predicted std deviations */
+    std::string summary() const;
+
+    /*! \brief forgets every view */
+    void clear();
+
+  private:
+    /*! \brief the information a view adds to the extrinsics blocks it observes */
+    typedef struct
+    {
+      std::vector<int> blocks;		/**< indices into extrinsics_ */
+      Eigen::MatrixXd information;	/**< 6 rows and columns per block, other blocks eliminated */
+    } ViewInformation;
+
+    /*! \brief the covariance of the prior alone */
+    Eigen::MatrixXd priorCovariance() const;
+
+    /*! \brief covariance after a view is added, by the Woodbury identity
+     *  \param covariance updated in place
+     *  \param view the view
+     */
+    void addToCovariance(Eigen::MatrixXd &covariance, const ViewInformation &view) const;
+
+    /*! \brief how much better the criterion gets when a view is added, larger is better */
+    double gain(const Eigen::MatrixXd &covariance, const ViewInformation &view) const;
+
+    /*! \brief fills uncertainty_ from a covariance
+     *  \return true if every block meets the target
+     */
+    bool setUncertainty(const Eigen::MatrixXd &covariance);
+
+    ViewPlanParameters parameters_;
+    std::set<const double*> constant_blocks_;
+    std::vector<ExtrinsicsUncertainty> extrinsics_;	/*!< every extrinsics block of the added views */
+    std::map<const double*, int> extrinsics_index_;	/*!< index of each block in extrinsics_ */
+    std::map<int, ViewInformation> views_;
+    std::vector<ExtrinsicsUncertainty> uncertainty_;
+  };
+
+}//end namespace industrial_extrinsic_cal
+
+#endif /* VIEW_PLANNER_H_ */
@@ -0,0 +1,78 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WORK_QUEUE_H_
+#define WORK_QUEUE_H_
+
+#include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <deque>
+
+namespace industrial_extrinsic_cal
+{
+
+  /*! \brief A fixed pool of threads running jobs in the order they are pushed. The number of jobs waiting or
+   *         running is bounded, push() blocks until one finishes, so a fast producer can not run far ahead.
+   */
+  class WorkQueue
+  {
+  public:
+    typedef boost::function<void ()> Job;
+
+    /*! \brief Constructor, starts the threads
+     *  \param num_threads threads running jobs, at least 1
+     *  \param max_pending jobs waiting or running before push() blocks, at least num_threads
+     */
+    WorkQueue(int num_threads, int max_pending);
+
+    /*! \brief Destructor, finishes the jobs already pushed */
+    ~WorkQueue();
+
+    /*! \brief queues a job, blocks while max_pending jobs are waiting or running
+     *  \param job the job, it must not throw
+     */
+    void push(const Job &job);
+
+    /*! \brief waits until every pushed job has run, then stops the threads. Jobs can not be pushed afterwards. */
+    void finish();
+
+    /*! \brief number of jobs waiting or running */
+    int pending() const;
+
+  private:
+    WorkQueue(const WorkQueue &);
+    WorkQueue& operator=(const WorkQueue &);
+
+    void worker();
+
+    int max_pending_;
+    boost::thread_group workers_;
+    mutable boost::mutex mutex_;
+    boost::condition_variable job_ready_; /**< signalled when a job is pushed or the queue finishes */
+    boost::condition_variable job_done_; /**< signalled when a job finishes */
+    std::deque<Job> jobs_; /**< jobs not yet taken by a thread */
+    int running_; /**< jobs taken by a thread and not yet finished */
+    bool finishing_;
+    bool finished_;
+  };
+
+}//end namespace industrial_extrinsic_cal
+
+#endif /* WORK_QUEUE_H_ */
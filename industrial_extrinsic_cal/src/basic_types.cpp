@@ -16,6 +16,8 @@
  * limitations under the License.
  */
 #include <stdio.h>
+#include <math.h>
+#include <algorithm>
 #include <industrial_extrinsic_cal/basic_types.h>
 
 namespace industrial_extrinsic_cal
@@ -34,7 +36,7 @@ namespace industrial_extrinsic_cal
   {
     x=y=z=ax=ay=az=0.0;
   }
-  void Pose6d::setBasis( tf::Matrix3x3 & m)
+  void Pose6d::setBasis(const RotationMatrix & m)
   { 
     // see Google ceres rotation.h for the source of these computations, I copied them
     // from the RotationMatrixToAngleAxis()
@@ -73,11 +75,11 @@ namespace industrial_extrinsic_cal
     }
   }
 
-  void Pose6d::setOrigin(tf::Vector3 & v)
+  void Pose6d::setOrigin(const Point3d & v)
   {
-    x = v.m_floats[0];
-    y = v.m_floats[1];
-    z = v.m_floats[2];
+    x = v.x;
+    y = v.y;
+    z = v.z;
   }
 
   void Pose6d::setOrigin(double tx, double ty, double tz)
@@ -100,7 +102,7 @@ namespace industrial_extrinsic_cal
     double sc = si*ch;
     double ss = si*sh;
 
-    tf::Matrix3x3 m;
+    RotationMatrix m;
     m[0][0] = cj*ch;  m[0][1] = sj*sc - cs;     m[0][2] = sj*cc + ss;
     m[1][0] = cj*sh;  m[1][1] = sj*ss + cc;   m[1][2] = sj*cs - sc;
     m[2][0] = -sj;      m[2][1] = cj*si;           m[2][2] =cj*ci ;
@@ -123,9 +125,9 @@ namespace industrial_extrinsic_cal
     az = aaz;
   }
 
-  tf::Matrix3x3 Pose6d::getBasis() const
+  RotationMatrix Pose6d::getBasis() const
   {
-    tf::Matrix3x3 R;
+    RotationMatrix R;
     double angle = sqrt(ax*ax + ay*ay + az*az);
     if(angle < .0001){
       R[0][0] = 1.0;  R[0][1] = 0.0;  R[0][2] = 0.0;
@@ -145,9 +147,12 @@ namespace industrial_extrinsic_cal
     return(R);
   }
 
-  tf::Vector3 Pose6d::getOrigin() const
+  Point3d Pose6d::getOrigin() const
   {
-    tf::Vector3 V(x, y, z);
+    Point3d V;
+    V.x = x;
+    V.y = y;
+    V.z = z;
     return(V);
   }
 
@@ -157,7 +162,7 @@ namespace industrial_extrinsic_cal
      double theta;
      double psi;
      double phi;
-     tf::Matrix3x3 R = this->getBasis();
+     RotationMatrix R = this->getBasis();
      
      if( fabs(R[2][0]) != 1.0 ){ // cos(theta) = 0.0
        theta = -asin(R[2][0]);
@@ -207,7 +212,7 @@ namespace industrial_extrinsic_cal
   Pose6d Pose6d::getInverse() const
   {
     double newx,newy,newz;
-    tf::Matrix3x3 R = getBasis();
+    RotationMatrix R = getBasis();
     newx =-( R[0][0] * x + R[1][0] * y + R[2][0] * z);
     newy = -(R[0][1] * x + R[1][1] * y + R[2][1] * z);
     newz = -(R[0][2] * x + R[1][2] * y + R[2][2] * z);
@@ -217,7 +222,7 @@ namespace industrial_extrinsic_cal
 
   void Pose6d::show(std::string message)
   {
-    tf::Matrix3x3 basis = this->getBasis();
+    RotationMatrix basis = this->getBasis();
     double ez_yaw, ey_pitch, ex_roll;
     double qx, qy, qz, qw;
     this->getEulerZYX(ez_yaw,ey_pitch,ex_roll);
@@ -234,12 +239,12 @@ namespace industrial_extrinsic_cal
 
   Pose6d Pose6d::operator * ( Pose6d pose2) const
   {
-    tf::Matrix3x3  R1   = getBasis();
-    tf::Matrix3x3 R2 = pose2.getBasis();
-    tf::Vector3 T1     = getOrigin();
-    tf::Vector3 T2     = pose2.getOrigin();
+    RotationMatrix  R1   = getBasis();
+    RotationMatrix R2 = pose2.getBasis();
+    Point3d T1     = getOrigin();
+    Point3d T2     = pose2.getOrigin();
     
-    tf::Matrix3x3 R3;
+    RotationMatrix R3;
     R3[0][0] = R1[0][0] * R2[0][0] + R1[0][1]*R2[1][0] + R1[0][2]*R2[2][0]; 
     R3[1][0] = R1[1][0] * R2[0][0] + R1[1][1]*R2[1][0] + R1[1][2]*R2[2][0];
     R3[2][0] = R1[2][0] * R2[0][0] + R1[2][1]*R2[1][0] + R1[2][2]*R2[2][0];
@@ -253,14 +258,12 @@ namespace industrial_extrinsic_cal
      R3[2][2] = R1[2][0] * R2[0][2] + R1[2][1]*R2[1][2] + R1[2][2]*R2[2][2];
 
     double tempx, tempy, tempz;
-    tempx = R1[0][0] * T2.x() + R1[0][1]*T2.y() + R1[0][2]*T2.z() + T1.x();
-    tempy = R1[1][0] * T2.x() + R1[1][1]*T2.y() + R1[1][2]*T2.z() + T1.y();
-    tempz = R1[2][0] * T2.x() + R1[2][1]*T2.y() + R1[2][2]*T2.z() + T1.z();
-    tf::Vector3 T3(tempx, tempy, tempz);
-
+    tempx = R1[0][0] * T2.x + R1[0][1]*T2.y + R1[0][2]*T2.z + T1.x;
+    tempy = R1[1][0] * T2.x + R1[1][1]*T2.y + R1[1][2]*T2.z + T1.y;
+    tempz = R1[2][0] * T2.x + R1[2][1]*T2.y + R1[2][2]*T2.z + T1.z;
     Pose6d pose;
     pose.setBasis(R3);
-    pose.setOrigin(T3);
+    pose.setOrigin(tempx, tempy, tempz);
 
     return(pose);
   }
@@ -20,13 +20,17 @@
 #include <industrial_extrinsic_cal/ros_transform_interface.h>
 #include <boost/foreach.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/bind.hpp>
 #include <ros/package.h>
+#include <algorithm>
 #include <geometry_msgs/Pose.h>
 #include <actionlib/client/simple_action_client.h>
 #include <industrial_extrinsic_cal/manual_triggerAction.h>
 #include <industrial_extrinsic_cal/trigger.h>
 #include <industrial_extrinsic_cal/ros_triggers.h>
 #include <industrial_extrinsic_cal/ceres_costs_utils.h>
+#include <industrial_extrinsic_cal/phase_timer.h>
+#include <industrial_extrinsic_cal/observation_dataset.h>
 
 using std::string;
 using boost::shared_ptr;
@@ -35,10 +39,85 @@ using ceres::CostFunction;
 
 namespace industrial_extrinsic_cal
 {
+  namespace
+  {
+    /* reads the optional loss and scale of a robust_loss entry, keeps the values already in loss when absent */
+    bool parseRobustLoss(const YAML::Node &node, RobustLoss &loss)
+    {
+      if (const YAML::Node *loss_node = node.FindValue("loss"))
+	{
+	  std::string loss_string;
+	  (*loss_node) >> loss_string;
+	  loss.type = string2LossType(loss_string);
+	  if (loss.type == loss_functions::NullLossType)
+	    {
+	      ROS_ERROR("robust_loss: unknown loss %s, use none, huber or cauchy", loss_string.c_str());
+	      return false;
+	    }
+	}
+      if (const YAML::Node *scale_node = node.FindValue("scale"))
+	(*scale_node) >> loss.scale;
+      return true;
+    }
 
+    /* how a scene fails and how long its trigger may take */
+    typedef struct
+    {
+      SceneFailurePolicy policy;
+      int retries;
+      double trigger_timeout;
+      int trigger_retries;
+    } SceneFailureSettings;
+
+    /* reads the optional on_failure, retries, trigger_timeout and trigger_retries, keeps the values already
+       in settings when absent */
+    bool parseSceneFailure(const YAML::Node &node, SceneFailureSettings &settings)
+    {
+      if (const YAML::Node *policy_node = node.FindValue("on_failure"))
+	{
+	  std::string policy;
+	  (*policy_node) >> policy;
+	  if (policy == "skip") settings.policy = SKIP_SCENE;
+	  else if (policy == "retry") settings.policy = RETRY_SCENE;
+	  else if (policy == "abort") settings.policy = ABORT_JOB;
+	  else
+	    {
+	      ROS_ERROR("on_failure: unknown policy %s, use skip, retry or abort", policy.c_str());
+	      return false;
+	    }
+	}
+      if (const YAML::Node *retries = node.FindValue("retries"))
+	(*retries) >> settings.retries;
+      if (const YAML::Node *timeout = node.FindValue("trigger_timeout"))
+	(*timeout) >> settings.trigger_timeout;
+      if (const YAML::Node *trigger_retries = node.FindValue("trigger_retries"))
+	(*trigger_retries) >> settings.trigger_retries;
+      return true;
+    }
+
+    /* reads the optional fixed_pose and fixed_points of a target definition, both default to false */
+    void readFixedTargetFlags(const YAML::Node &node, Target &target)
+    {
+      if (const YAML::Node *fixed_pose = node.FindValue("fixed_pose"))
+	(*fixed_pose) >> target.fixed_pose_;
+      if (const YAML::Node *fixed_points = node.FindValue("fixed_points"))
+	(*fixed_points) >> target.fixed_points_;
+    }
+  }
+
+  std::string CalibrationJob::loadedTransformInterface(const std::string &transform_interface) const
+  {
+    if (!listen_only_) return transform_interface;
+    // the listener of the same frame, a housing listener reads the camera_housing_frame the broadcaster ignores
+    if (transform_interface == "ros_bti") return "ros_lti";
+    if (transform_interface == "ros_camera_bti") return "ros_camera_lti";
+    if (transform_interface == "ros_camera_housing_bti") return "ros_camera_housing_lti";
+    return transform_interface;
+  }
 
   bool CalibrationJob::load()
   {
+    CAL_PHASE_TIMER("CalibrationJob::load");
     if(CalibrationJob::loadCamera())
       {
 	ROS_INFO_STREAM("Successfully read in cameras ");
@@ -108,6 +187,7 @@ namespace industrial_extrinsic_cal
 		(*camera_parameters)[i]["image_topic"] >> temp_topic;
 		(*camera_parameters)[i]["camera_optical_frame"] >> camera_optical_frame;
 		(*camera_parameters)[i]["transform_interface"] >> transform_interface;
+		transform_interface = loadedTransformInterface(transform_interface);
 		(*camera_parameters)[i]["angle_axis_ax"] >> temp_parameters.angle_axis[0];
 		(*camera_parameters)[i]["angle_axis_ay"] >> temp_parameters.angle_axis[1];
 		(*camera_parameters)[i]["angle_axis_az"] >> temp_parameters.angle_axis[2];
@@ -137,6 +217,14 @@ namespace industrial_extrinsic_cal
 		  (*camera_parameters)[i]["trig_param"] >> trig_param;
 		  temp_camera->trigger_ = make_shared<ROSParamTrigger>(trig_param);
 		}
+		else if(trigger_name == std::string("ROS_TOPIC_TRIGGER")){
+		  (*camera_parameters)[i]["trig_topic"] >> trig_param;
+		  temp_camera->trigger_ = make_shared<ROSTopicTrigger>(trig_param);
+		}
+		else if(trigger_name == std::string("ROS_SERVICE_TRIGGER")){
+		  (*camera_parameters)[i]["trig_service"] >> trig_param;
+		  temp_camera->trigger_ = make_shared<ROSServiceTrigger>(trig_param);
+		}
 		else if(trigger_name == std::string("ROS_ACTION_TRIGGER")){
 		  (*camera_parameters)[i]["trig_action_server"] >> trig_action_server;
 		  (*camera_parameters)[i]["trig_action_msg"] >> trig_action_msg;
@@ -222,6 +310,7 @@ namespace industrial_extrinsic_cal
 		(*camera_parameters)[i]["image_topic"] >> temp_topic;
 		(*camera_parameters)[i]["camera_optical_frame"] >> camera_optical_frame;
 		(*camera_parameters)[i]["transform_interface"] >> transform_interface;
+		transform_interface = loadedTransformInterface(transform_interface);
 		(*camera_parameters)[i]["angle_axis_ax"] >> temp_parameters.angle_axis[0];
 		(*camera_parameters)[i]["angle_axis_ay"] >> temp_parameters.angle_axis[1];
 		(*camera_parameters)[i]["angle_axis_az"] >> temp_parameters.angle_axis[2];
@@ -252,6 +341,14 @@ namespace industrial_extrinsic_cal
 		  (*camera_parameters)[i]["trig_param"] >> trig_param;
 		  temp_camera->trigger_ = make_shared<ROSParamTrigger>(trig_param);
 		}
+		else if(trigger_name == std::string("ROS_TOPIC_TRIGGER")){
+		  (*camera_parameters)[i]["trig_topic"] >> trig_param;
+		  temp_camera->trigger_ = make_shared<ROSTopicTrigger>(trig_param);
+		}
+		else if(trigger_name == std::string("ROS_SERVICE_TRIGGER")){
+		  (*camera_parameters)[i]["trig_service"] >> trig_param;
+		  temp_camera->trigger_ = make_shared<ROSServiceTrigger>(trig_param);
+		}
 		else  if(trigger_name == std::string("ROS_ACTION_TRIGGER")){
 		  (*camera_parameters)[i]["trig_action_server"] >> trig_action_server;
 		  (*camera_parameters)[i]["trig_action_message"] >> trig_action_msg;
@@ -392,6 +489,7 @@ namespace industrial_extrinsic_cal
 		(*target_parameters)[i]["position_y"] >> temp_target->pose_.y;
 		(*target_parameters)[i]["position_z"] >> temp_target->pose_.z;
 		(*target_parameters)[i]["transform_interface"] >> transform_interface;
+		transform_interface = loadedTransformInterface(transform_interface);
 
 		// install target's transform interface
 		if(transform_interface == std::string("ros_lti")){ 
@@ -429,6 +527,7 @@ namespace industrial_extrinsic_cal
 		    temp_pnt3d.z = temp_pnt[2];
 		    temp_target->pts_.push_back(temp_pnt3d);
 		  }
+		readFixedTargetFlags((*target_parameters)[i], *temp_target);
 		if(temp_target->is_moving_ == true){
 		  ROS_ERROR("Static Target set to moving????");
 		}
@@ -453,6 +552,7 @@ namespace industrial_extrinsic_cal
 		(*target_parameters)[i]["target_name"] >> temp_target->target_name_;
 		(*target_parameters)[i]["target_frame"] >> temp_frame;
 		(*target_parameters)[i]["transform_interface"] >> transform_interface;
+		transform_interface = loadedTransformInterface(transform_interface);
 		// install target's transform interface
 		if(transform_interface == std::string("ros_lti")){ 
 		  temp_ti = make_shared<ROSListenerTransInterface>(temp_target->target_frame_);
@@ -497,6 +597,7 @@ namespace industrial_extrinsic_cal
 		(*target_parameters)[i]["position_y"] >> temp_target->pose_.y;
 		(*target_parameters)[i]["position_z"] >> temp_target->pose_.z;
 		(*target_parameters)[i]["transform_interface"] >> transform_interface;
+		transform_interface = loadedTransformInterface(transform_interface);
 		if(transform_interface == std::string("ros_lti")){
 		  temp_ti = make_shared<ROSListenerTransInterface>(temp_target->target_frame_);
 		}
@@ -525,6 +626,7 @@ namespace industrial_extrinsic_cal
 		    temp_pnt3d.z = temp_pnt[2];
 		    temp_target->pts_.push_back(temp_pnt3d);
 		  }
+		readFixedTargetFlags((*target_parameters)[i], *temp_target);
 		ceres_blocks_.addMovingTarget(temp_target, scene_id);
 		target_frames_.push_back(temp_frame);
 	      }
@@ -575,6 +677,182 @@ namespace industrial_extrinsic_cal
 	caljob_doc["reference_frame"] >> reference_frame;
 	ceres_blocks_.setReferenceFrame(reference_frame);
 	caljob_doc["optimization_parameters"] >> opt_params;
+	// optional multi-start section, solves from several perturbed initial poses and keeps the best
+	if (const YAML::Node *multi_start = caljob_doc.FindValue("multi_start"))
+	  {
+	    if (const YAML::Node *node = multi_start->FindValue("starts"))
+	      (*node) >> multi_start_parameters_.num_starts;
+	    if (const YAML::Node *node = multi_start->FindValue("threads"))
+	      (*node) >> multi_start_parameters_.num_threads;
+	    if (const YAML::Node *node = multi_start->FindValue("rotation_noise"))
+	      (*node) >> multi_start_parameters_.rotation_noise;
+	    if (const YAML::Node *node = multi_start->FindValue("translation_noise"))
+	      (*node) >> multi_start_parameters_.translation_noise;
+	    if (const YAML::Node *node = multi_start->FindValue("seed"))
+	      (*node) >> multi_start_parameters_.seed;
+	    ROS_INFO("multi-start: %d starts on %d threads", multi_start_parameters_.num_starts,
+		     multi_start_parameters_.num_threads);
+	  }
+	// optional robust loss, a default for all cost types and overrides for some of them
+	if (const YAML::Node *robust_loss = caljob_doc.FindValue("robust_loss"))
+	  {
+	    RobustLoss loss;
+	    if (!parseRobustLoss(*robust_loss, loss)) return false;
+	    robust_losses_.setDefault(loss);
+	    if (const YAML::Node *cost_types = robust_loss->FindValue("cost_types"))
+	      {
+		for (unsigned int i = 0; i < cost_types->size(); i++)
+		  {
+		    (*cost_types)[i]["cost_type"] >> cost_type_string;
+		    cost_type = string2CostType(cost_type_string);
+		    if (cost_type == cost_functions::NullCostType)
+		      {
+			ROS_ERROR("robust_loss: unknown cost type %s", cost_type_string.c_str());
+			return false;
+		      }
+		    RobustLoss cost_type_loss = loss;
+		    if (!parseRobustLoss((*cost_types)[i], cost_type_loss)) return false;
+		    robust_losses_.set(cost_type, cost_type_loss);
+		  }
+	      }
+	  }
+	// optional outlier trimming, observations above the chi-square threshold are removed and the job re-solved
+	if (const YAML::Node *trimming = caljob_doc.FindValue("outlier_trimming"))
+	  {
+	    if (const YAML::Node *node = trimming->FindValue("rounds"))
+	      (*node) >> outlier_trim_parameters_.max_rounds;
+	    if (const YAML::Node *node = trimming->FindValue("chi_square_threshold"))
+	      (*node) >> outlier_trim_parameters_.chi_square_threshold;
+	    if (const YAML::Node *node = trimming->FindValue("pixel_sigma"))
+	      (*node) >> outlier_trim_parameters_.pixel_sigma;
+	    ROS_INFO("outlier trimming: %d rounds, chi-square threshold %lf", outlier_trim_parameters_.max_rounds,
+		     outlier_trim_parameters_.chi_square_threshold);
+	  }
+	// optional linear solver, SPARSE_SCHUR or ITERATIVE_SCHUR suit jobs with many free target points
+	if (const YAML::Node *node = caljob_doc.FindValue("linear_solver"))
+	  {
+	    std::string linear_solver;
+	    (*node) >> linear_solver;
+	    if (!ceres::StringToLinearSolverType(linear_solver, &linear_solver_type_))
+	      {
+		ROS_ERROR("unknown linear_solver %s", linear_solver.c_str());
+		return false;
+	      }
+	  }
+	// optional sliding window of runIncremental(), quick re-calibration from the last solution
+	if (const YAML::Node *window = caljob_doc.FindValue("sliding_window"))
+	  {
+	    SlidingWindowParameters parameters = defaultSlidingWindowParameters();
+	    if (const YAML::Node *node = window->FindValue("scenes"))
+	      (*node) >> parameters.window_scenes;
+	    if (const YAML::Node *node = window->FindValue("iterations"))
+	      (*node) >> parameters.max_num_iterations;
+	    if (const YAML::Node *node = window->FindValue("max_time"))
+	      (*node) >> parameters.max_solver_time;
+	    setSlidingWindowParameters(parameters);
+	  }
+	// optional, false looks up poses at capture time instead of at the image stamps, for drivers with bad stamps
+	if (const YAML::Node *node = caljob_doc.FindValue("image_stamped_poses"))
+	  (*node) >> image_stamped_poses_;
+	// optional detection threads, the next scene's trigger starts while the last scene's images are processed
+	if (const YAML::Node *pipeline = caljob_doc.FindValue("scene_pipeline"))
+	  {
+	    if (const YAML::Node *node = pipeline->FindValue("threads"))
+	      (*node) >> pipeline_parameters_.num_threads;
+	    if (const YAML::Node *node = pipeline->FindValue("max_pending"))
+	      (*node) >> pipeline_parameters_.max_pending;
+	  }
+	// optional scenes captured while their trigger moves the robot through a trajectory
+	if (const YAML::Node *continuous = caljob_doc.FindValue("continuous_capture"))
+	  {
+	    std::vector<int> scene_ids;
+	    if (const YAML::Node *node = continuous->FindValue("scenes"))
+	      (*node) >> scene_ids;
+	    continuous_scenes_ = std::set<int>(scene_ids.begin(), scene_ids.end());
+	    ContinuousCaptureParameters &parameters = continuous_capture_parameters_;
+	    if (const YAML::Node *node = continuous->FindValue("threads"))
+	      (*node) >> parameters.num_threads;
+	    if (const YAML::Node *node = continuous->FindValue("queue_size"))
+	      (*node) >> parameters.queue_size;
+	    if (const YAML::Node *node = continuous->FindValue("max_frames"))
+	      (*node) >> parameters.selection.max_frames;
+	    if (const YAML::Node *node = continuous->FindValue("min_rotation"))
+	      (*node) >> parameters.selection.min_rotation;
+	    if (const YAML::Node *node = continuous->FindValue("min_translation"))
+	      (*node) >> parameters.selection.min_translation;
+	    if (const YAML::Node *node = continuous->FindValue("min_quality"))
+	      (*node) >> parameters.selection.min_quality;
+	  }
+	// optional checks of each frame before detection, a failed frame is grabbed again
+	if (const YAML::Node *frame_quality = caljob_doc.FindValue("frame_quality"))
+	  {
+	    FrameQualityParameters &parameters = frame_quality_parameters_;
+	    if (const YAML::Node *node = frame_quality->FindValue("min_focus"))
+	      (*node) >> parameters.min_focus;
+	    if (const YAML::Node *node = frame_quality->FindValue("saturation_level"))
+	      (*node) >> parameters.saturation_level;
+	    if (const YAML::Node *node = frame_quality->FindValue("max_saturated_fraction"))
+	      (*node) >> parameters.max_saturated_fraction;
+	    if (const YAML::Node *node = frame_quality->FindValue("max_viewing_angle"))
+	      (*node) >> parameters.max_viewing_angle;
+	    if (const YAML::Node *node = frame_quality->FindValue("max_regrabs"))
+	      (*node) >> parameters.max_regrabs;
+	    if (const YAML::Node *node = frame_quality->FindValue("stride"))
+	      (*node) >> parameters.stride;
+	  }
+	// optional view plan, the scenes chosen by view_planner and an early stop once the extrinsics are certain enough
+	std::vector<int> planned_scenes;
+	if (const YAML::Node *plan = caljob_doc.FindValue("view_plan"))
+	  {
+	    if (const YAML::Node *node = plan->FindValue("scenes"))
+	      (*node) >> planned_scenes;
+	    if (const YAML::Node *node = plan->FindValue("stop_early"))
+	      (*node) >> stop_early_;
+	    if (const YAML::Node *node = plan->FindValue("max_rotation_std"))
+	      (*node) >> view_plan_parameters_.max_rotation_std;
+	    if (const YAML::Node *node = plan->FindValue("max_position_std"))
+	      (*node) >> view_plan_parameters_.max_position_std;
+	    if (stop_early_ && pipeline_parameters_.num_threads > 0)
+	      {
+		ROS_WARN("view_plan stop_early is not applied to a scene_pipeline");
+	      }
+	  }
+	// optional results file of store(), by default a launch file in the package's launch directory
+	if (const YAML::Node *results = caljob_doc.FindValue("results"))
+	  {
+	    if (const YAML::Node *node = results->FindValue("file"))
+	      (*node) >> results_file_;
+	    if (const YAML::Node *node = results->FindValue("format"))
+	      {
+		std::string format;
+		(*node) >> format;
+		if (!string2ResultsFormat(format, results_format_))
+		  {
+		    ROS_ERROR("unknown results format %s, use launch, yaml or xacro", format.c_str());
+		    return false;
+		  }
+	      }
+	  }
+	// optional quality report settings, the report is always computed after the solve
+	if (const YAML::Node *quality = caljob_doc.FindValue("quality_report"))
+	  {
+	    if (const YAML::Node *node = quality->FindValue("threads"))
+	      (*node) >> quality_parameters_.num_threads;
+	    if (const YAML::Node *node = quality->FindValue("covariance"))
+	      (*node) >> quality_parameters_.compute_covariance;
+	    if (const YAML::Node *node = quality->FindValue("pixel_sigma"))
+	      (*node) >> quality_parameters_.pixel_sigma;
+	  }
+	// optional failure handling of every scene, a scene may override it, by default a failed scene is skipped
+	SceneFailureSettings job_failure;
+	job_failure.policy = SKIP_SCENE;
+	job_failure.retries = 1;
+	job_failure.trigger_timeout = 0.0;
+	job_failure.trigger_retries = 0;
+	if (const YAML::Node *failure = caljob_doc.FindValue("scene_failure"))
+	  {
+	    if (!parseSceneFailure(*failure, job_failure)) return false;
+	  }
 	// read in all scenes
 	if (const YAML::Node *caljob_scenes = caljob_doc.FindValue("scenes"))
 	  {
@@ -598,6 +876,14 @@ namespace industrial_extrinsic_cal
 		  (*caljob_scenes)[i]["trig_param"] >> trig_param;
 		  temp_trigger = make_shared<ROSParamTrigger>(trig_param);
 		}
+		else if(trigger_name == std::string("ROS_TOPIC_TRIGGER")){
+		  (*caljob_scenes)[i]["trig_topic"] >> trig_param;
+		  temp_trigger = make_shared<ROSTopicTrigger>(trig_param);
+		}
+		else if(trigger_name == std::string("ROS_SERVICE_TRIGGER")){
+		  (*caljob_scenes)[i]["trig_service"] >> trig_param;
+		  temp_trigger = make_shared<ROSServiceTrigger>(trig_param);
+		}
 		else if(trigger_name == std::string("ROS_ACTION_TRIGGER")){
 		  (*caljob_scenes)[i]["trig_action_server"] >> trig_action_server;
 		  (*caljob_scenes)[i]["trig_action_msg"] >> trig_action_msg;
@@ -625,6 +911,15 @@ namespace industrial_extrinsic_cal
 		  temp_trigger = make_shared<ROSRobotPoseActionServerTrigger>(trig_action_server, pose);
 		}
 
+		SceneFailureSettings scene_failure = job_failure;
+		if (!parseSceneFailure((*caljob_scenes)[i], scene_failure)) return false;
+		if (!temp_trigger)
+		  {
+		    ROS_ERROR("scene %d has an unknown trigger %s", scene_id_num, trigger_name.c_str());
+		    return false;
+		  }
+		temp_trigger->setLimits(scene_failure.trigger_timeout, scene_failure.trigger_retries);
+		scene_list_.at(i).setFailurePolicy(scene_failure.policy, scene_failure.retries);
 		scene_list_.at(i).setTrigger(temp_trigger);
 
 		scene_list_.at(i).setSceneId(scene_id_num);
@@ -652,6 +947,38 @@ namespace industrial_extrinsic_cal
 		  }
 	      }
 	  }
+	// every observer checks its frames the same way
+	BOOST_FOREACH(ObservationScene &scene, scene_list_)
+	  {
+	    BOOST_FOREACH(shared_ptr<Camera> camera, scene.cameras_in_scene_)
+	      {
+		shared_ptr<ROSCameraObserver> observer =
+		  boost::dynamic_pointer_cast<ROSCameraObserver>(camera->camera_observer_);
+		if (observer) observer->setFrameQualityParameters(frame_quality_parameters_);
+	      }
+	  }
+	// only the planned scenes, in the planned order
+	if (!planned_scenes.empty())
+	  {
+	    std::vector<ObservationScene> planned_list;
+	    BOOST_FOREACH(int scene_id, planned_scenes)
+	      {
+		bool found = false;
+		BOOST_FOREACH(ObservationScene &scene, scene_list_)
+		  {
+		    if (scene.get_id() != scene_id) continue;
+		    planned_list.push_back(scene);
+		    found = true;
+		  }
+		if (!found)
+		  {
+		    ROS_ERROR("view_plan has scene %d, the caljob has no such scene", scene_id);
+		    return false;
+		  }
+	      }
+	    ROS_INFO("view plan keeps %d of %d scenes", (int) planned_list.size(), (int) scene_list_.size());
+	    scene_list_.swap(planned_list);
+	  }
       } // end try
     catch (YAML::ParserException& e)
       {
@@ -665,18 +992,132 @@ namespace industrial_extrinsic_cal
   bool CalibrationJob::run()
   {
     ROS_INFO("Running observations");
-    runObservations();
+    if(!runObservations()){
+      ROS_ERROR("Observations aborted");
+      reportPhaseTimes();
+      return(false);
+    }
     ROS_INFO("Running optimization");
     bool optimization_ran_ok = runOptimization();
     if(optimization_ran_ok){
       pushTransforms(); // sends updated transforms to their intefaces
+      sliding_window_.seed(observation_data_point_list_); // later incremental runs start from this solution
     }
     else{
       ROS_ERROR("Optimization failed");
     }
+    reportPhaseTimes();
     return(optimization_ran_ok);
   }
 
+  bool CalibrationJob::runIncremental(const std::vector<int> &scene_ids, bool wait_for_trigger)
+  {
+    std::vector<ObservationDataPointList> new_scenes;
+    BOOST_FOREACH(int scene_id, scene_ids)
+      {
+	ObservationScene *scene = NULL;
+	BOOST_FOREACH(ObservationScene &current_scene, scene_list_)
+	  {
+	    if (current_scene.get_id() == scene_id) scene = &current_scene;
+	  }
+	if (scene == NULL)
+	  {
+	    ROS_ERROR("no scene with id %d", scene_id);
+	    return false;
+	  }
+	ObservationDataPointList observations;
+	bool abort_job = false;
+	if (!observeSceneWithPolicy(*scene, wait_for_trigger, scene->getMaxAttempts(), observations, abort_job))
+	  {
+	    if (abort_job) return false;
+	    continue;
+	  }
+	new_scenes.push_back(observations);
+      }
+    sliding_window_.add(new_scenes);
+    if (sliding_window_.numNewScenes() == 0)
+      {
+	ROS_ERROR("the new scenes have no observations");
+	return false;
+      }
+
+    bool solved;
+    {
+      CAL_PHASE_TIMER("CalibrationJob::runIncremental");
+      // the cost functions of the previous problem held the cache's entries
+      rotation_cache_.clear();
+      problem_ = make_shared<ceres::Problem>();
+      residuals_.clear();
+      addScenesToProblem(sliding_window_.scenes(), *problem_, NULL);
+      int num_free = sliding_window_.holdUnaffectedConstant(*problem_);
+
+      ceres::Solver::Options options;
+      ceres::Solver::Summary summary;
+      sliding_window_.configure(options);
+      rotation_cache_.attach(options);
+      {
+	CAL_PHASE_TIMER("ceres::Solve");
+	ceres::Solve(options, problem_.get(), &summary);
+      }
+      solved = summary.IsSolutionUsable();
+      ROS_INFO("incremental re-calibration of %d blocks over %d scenes, cost %lf to %lf in %lf s", num_free,
+	       (int) sliding_window_.scenes().size(), summary.initial_cost, summary.final_cost,
+	       summary.total_time_in_seconds);
+    }
+    if (!solved)
+      {
+	ROS_ERROR("no usable solution");
+	reportPhaseTimes();
+	return false;
+      }
+
+    // reprojection errors only, the covariance would cost more than the solve
+    QualityParameters quality_parameters = quality_parameters_;
+    quality_parameters.compute_covariance = false;
+    quality_report_ = make_shared<QualityReport>(quality_parameters);
+    if (quality_report_->compute(*problem_, residuals_))
+      {
+	ROS_INFO("%s", quality_report_->summary().c_str());
+      }
+    pushTransforms();
+    reportPhaseTimes();
+    return true;
+  }
+
+  void CalibrationJob::enableTracing(const std::string &trace_file_name)
+  {
+    trace_file_name_ = trace_file_name;
+    PhaseTracer::instance().enable(true);
+  }
+
+  bool CalibrationJob::saveObservationDataset(const std::string &file_name)
+  {
+    ObservationDataset dataset;
+    dataset.setObservations(observation_data_point_list_);
+    if(!dataset.write(file_name)){
+      ROS_ERROR("could not write observation dataset %s", file_name.c_str());
+      return(false);
+    }
+    ROS_INFO("wrote %d observations to %s", (int) dataset.observations().items_.size(), file_name.c_str());
+    return(true);
+  }
+
+  void CalibrationJob::reportPhaseTimes()
+  {
+    PhaseTracer &tracer = PhaseTracer::instance();
+    if(!tracer.enabled()) return;
+    ROS_INFO_STREAM("Calibration job phase times:\n" << tracer.summary());
+    if(!trace_file_name_.empty()){
+      if(tracer.writeChromeTrace(trace_file_name_)){
+	ROS_INFO("Wrote phase trace to %s", trace_file_name_.c_str());
+      }
+      else{
+	ROS_ERROR("Could not write phase trace to %s", trace_file_name_.c_str());
+      }
+    }
+    tracer.clear(); // the next run reports only its own phases
+  }
+
   bool CalibrationJob::runObservations()
   {
     // the result of this function are twofold
@@ -685,119 +1126,572 @@ namespace industrial_extrinsic_cal
     // extrinsics and intrinsics for each static camera
     // The whole target for once every static target (parameter blocks are in  Pose6d and an array of points)
     // The whole target once a scene for each moving target
+    CAL_PHASE_TIMER("CalibrationJob::runObservations");
     observation_data_point_list_.clear(); // clear previously recorded observations
 
+    // scenes generated by continuous captures are numbered after the job's own scenes
+    int next_scene_id = 0;
+    BOOST_FOREACH(ObservationScene &scene, scene_list_)
+      {
+	next_scene_id = std::max(next_scene_id, scene.get_id() + 1);
+      }
+
+    // the observations of each scene, filled in by the pipeline's threads, sized up front so they never move
+    std::vector<std::vector<ObservationDataPointList> > scene_observations(scene_list_.size());
+    std::vector<char> scene_found(scene_list_.size(), 1); // cleared by the pipeline when a target is not found
+    boost::mutex scene_found_mutex;
+    bool abort_job = false;
+    shared_ptr<WorkQueue> pipeline;
+    if (pipeline_parameters_.num_threads > 0)
+      {
+	pipeline = make_shared<WorkQueue>(pipeline_parameters_.num_threads, pipeline_parameters_.max_pending);
+      }
+
+    // the early stop predicts the extrinsics uncertainty of the scenes observed so far
+    ViewPlanParameters plan_parameters = view_plan_parameters_;
+    plan_parameters.pixel_sigma = quality_parameters_.pixel_sigma;
+    ViewPlanner planner(plan_parameters);
+    std::vector<int> observed_views;
+    bool stop_early = stop_early_ && !pipeline;
+    bool certain = false;
+
     // For each scene
-    BOOST_FOREACH(ObservationScene current_scene, scene_list_)
+    for (int i = 0; i < (int) scene_list_.size(); i++)
       {
+	ObservationScene &current_scene = scene_list_[i];
 	int scene_id = current_scene.get_id();
 	ROS_DEBUG_STREAM("Processing Scene " << scene_id+1<<" of "<< scene_list_.size());
 	ROS_INFO("Processing Scene  %d of %d",scene_id, (int) scene_list_.size());
 
-	BOOST_FOREACH(shared_ptr<Camera> current_camera, current_scene.cameras_in_scene_)
-	  {			// clear camera of existing observations
-	    current_camera->camera_observer_->clearObservations(); // clear any recorded data
-	    current_camera->camera_observer_->clearTargets(); // clear all targets
-	    if(current_camera->isMoving()){
-	      ROS_ERROR("Camera %s is moving in scene %d",current_camera->camera_name_.c_str(), scene_id);
+	// a scene which failed on the pipeline may abort the job before the robot moves again
+	{
+	  boost::mutex::scoped_lock lock(scene_found_mutex);
+	  for (int j = 0; j < i && !abort_job; j++)
+	    {
+	      abort_job = !scene_found[j] && scene_list_[j].getFailurePolicy() == ABORT_JOB;
 	    }
+	}
+	if (abort_job) break;
+
+	bool scene_ok = false;
+	if (continuous_scenes_.count(scene_id))
+	  {
+	    for (int attempt = 1; attempt <= current_scene.getMaxAttempts() && !scene_ok; attempt++)
+	      {
+		scene_observations[i].clear();
+		scene_ok = captureContinuousScene(current_scene, next_scene_id, scene_observations[i]);
+	      }
+	  }
+	else if (!pipeline)
+	  {
+	    scene_observations[i].resize(1);
+	    scene_ok = observeSceneWithPolicy(current_scene, true, current_scene.getMaxAttempts(),
+					      scene_observations[i][0], abort_job);
+	    if (abort_job) break;
+	    if (!scene_ok) scene_observations[i].clear();
+	    certain = stop_early && extrinsicsCertain(planner, scene_observations[i], observed_views);
+	    if (certain) break;
+	    continue;
+	  }
+	else
+	  {
+	    // detection runs on the pipeline while the next scene's trigger moves the robot
+	    shared_ptr<std::vector<CapturedCamera> > captured = make_shared<std::vector<CapturedCamera> >();
+	    for (int attempt = 1; attempt <= current_scene.getMaxAttempts() && !scene_ok; attempt++)
+	      {
+		scene_ok = captureScene(current_scene, true, false, *captured);
+	      }
+	    if (scene_ok)
+	      {
+		scene_observations[i].resize(1);
+		pipeline->push(boost::bind(&CalibrationJob::processCapturedSceneJob, captured, &scene_observations[i][0],
+					   &scene_found_mutex, &scene_found[i]));
+	      }
+	  }
+	if (!scene_ok)
+	  {
+	    scene_observations[i].clear();
+	    if (!continueAfterFailure(current_scene)) abort_job = true;
+	    if (abort_job) break;
+	  }
+	else if (stop_early && continuous_scenes_.count(scene_id))
+	  {
+	    certain = extrinsicsCertain(planner, scene_observations[i], observed_views);
+	    if (certain) break;
+	  }
+      } //end for each scene
+    if (certain)
+      {
+	ROS_INFO("the extrinsics uncertainty target is met after %d scenes, the remaining scenes are skipped\n%s",
+		 (int) observed_views.size(), planner.summary().c_str());
+      }
+
+    if (pipeline)
+      {
+	CAL_PHASE_TIMER("pipeline drain");
+	pipeline->finish();
+      }
+
+    // scenes in which the pipeline did not find every target
+    for (int i = 0; i < (int) scene_list_.size() && !abort_job; i++)
+      {
+	if (scene_found[i]) continue;
+	ObservationScene &current_scene = scene_list_[i];
+	scene_observations[i].clear();
+	ROS_WARN("scene %d, a camera did not find its target", current_scene.get_id());
+	if (current_scene.getMaxAttempts() > 1)
+	  {
+	    scene_observations[i].resize(1);
+	    if (observeSceneWithPolicy(current_scene, true, current_scene.getMaxAttempts() - 1, scene_observations[i][0],
+				       abort_job)) continue;
+	    scene_observations[i].clear();
+	  }
+	else if (!continueAfterFailure(current_scene))
+	  {
+	    abort_job = true;
+	  }
+      }
+    if (abort_job)
+      {
+	ROS_ERROR("observations aborted, the job's failure policy stops it");
+	return false;
+      }
+    for (int i = 0; i < (int) scene_observations.size(); i++)
+      {
+	observation_data_point_list_.insert(observation_data_point_list_.end(), scene_observations[i].begin(),
+					    scene_observations[i].end());
+      }
+    return true;
+  }
+
+  bool CalibrationJob::extrinsicsCertain(ViewPlanner &planner, const std::vector<ObservationDataPointList> &scenes,
+					 std::vector<int> &observed)
+  {
+    std::vector<P_BLOCK> constant_blocks;
+    ceres_blocks_.getConstantTargetBlocks(constant_blocks);
+    planner.setConstantBlocks(constant_blocks);
+    BOOST_FOREACH(const ObservationDataPointList &observations, scenes)
+      {
+	if (observations.items_.empty()) continue;
+	int view_id = observations.items_[0].scene_id_;
+	if (!planner.addView(view_id, observations))
+	  {
+	    ROS_WARN("scene %d could not be fully linearized for the early stop", view_id);
+	  }
+	observed.push_back(view_id);
+      }
+    return planner.predict(observed);
+  }
+
+  bool CalibrationJob::observeScene(int scene_id, bool wait_for_trigger, ObservationDataPointList &observations)
+  {
+    BOOST_FOREACH(ObservationScene &current_scene, scene_list_)
+      {
+	if (current_scene.get_id() == scene_id) return observeScene(current_scene, wait_for_trigger, observations);
+      }
+    ROS_ERROR("no scene with id %d", scene_id);
+    return false;
+  }
+
+  bool CalibrationJob::observeScene(ObservationScene &current_scene, bool wait_for_trigger,
+				    ObservationDataPointList &observations)
+  {
+    std::vector<CapturedCamera> captured;
+    if (!captureScene(current_scene, wait_for_trigger, true, captured)) return false;
+    return processCapturedScene(captured, observations);
+  }
+
+  bool CalibrationJob::observeSceneWithPolicy(ObservationScene &current_scene, bool wait_for_trigger, int attempts,
+					      ObservationDataPointList &observations, bool &abort_job)
+  {
+    for (int attempt = 1; attempt <= attempts; attempt++)
+      {
+	observations.items_.clear();
+	if (observeScene(current_scene, wait_for_trigger, observations)) return true;
+	ROS_WARN("scene %d failed, attempt %d of %d", current_scene.get_id(), attempt, attempts);
+      }
+    observations.items_.clear();
+    abort_job = !continueAfterFailure(current_scene);
+    return false;
+  }
+
+  bool CalibrationJob::continueAfterFailure(ObservationScene &current_scene)
+  {
+    if (current_scene.getFailurePolicy() == ABORT_JOB)
+      {
+	ROS_ERROR("scene %d failed, aborting the job", current_scene.get_id());
+	return false;
+      }
+    ROS_WARN("scene %d failed, continuing without it", current_scene.get_id());
+    return true;
+  }
+
+  bool CalibrationJob::captureScene(ObservationScene &current_scene, bool wait_for_trigger, bool detect_now,
+				    std::vector<CapturedCamera> &captured)
+  {
+    CAL_PHASE_TIMER("CalibrationJob::captureScene");
+    int scene_id = current_scene.get_id();
+    captured.clear();
+
+    BOOST_FOREACH(shared_ptr<Camera> current_camera, current_scene.cameras_in_scene_)
+      {			// clear camera of existing observations
+	current_camera->camera_observer_->clearObservations(); // clear any recorded data
+	current_camera->camera_observer_->clearTargets(); // clear all targets
+	if(current_camera->isMoving()){
+	  ROS_ERROR("Camera %s is moving in scene %d",current_camera->camera_name_.c_str(), scene_id);
+	}
+      }
+
+    BOOST_FOREACH(ObservationCmd o_command, current_scene.observation_command_list_)
+      {	// add each target and roi each camera's list of observations
+	o_command.camera->camera_observer_->addTarget(o_command.target, o_command.roi, o_command.cost_type);
+      }
+
+    if (wait_for_trigger)
+      {
+	CAL_PHASE_TIMER("trigger wait");
+	if (!current_scene.get_trigger()->waitForTrigger()) // this indicates scene is ready to capture
+	  {
+	    ROS_ERROR("trigger of scene %d failed", scene_id);
+	    return false;
 	  }
+      }
 
+    // every camera and target block of the scene exists before the first pull, so one pull fills them all
+    std::vector<std::vector<shared_ptr<Target> > > camera_targets;
+    BOOST_FOREACH(shared_ptr<Camera> camera, current_scene.cameras_in_scene_)
+      {
+	std::vector<shared_ptr<Target> > targets;
 	BOOST_FOREACH(ObservationCmd o_command, current_scene.observation_command_list_)
-	  {	// add each target and roi each camera's list of observations
-	    o_command.camera->camera_observer_->addTarget(o_command.target, o_command.roi, o_command.cost_type);
+	  {
+	    if (o_command.camera == camera) targets.push_back(o_command.target);
+	  }
+	addCameraBlocks(camera, scene_id, targets);
+	camera_targets.push_back(targets);
+      }
+    if (!image_stamped_poses_ && !pullTransforms(scene_id)) return false; // gets transforms of targets and cameras from their interfaces
+
+    BOOST_FOREACH( shared_ptr<Camera> current_camera, current_scene.cameras_in_scene_)
+      {// trigger the cameras
+	current_camera->camera_observer_->triggerCamera();
+      }
+
+    // for each camera in scene take its image, and add camera parameters to ceres_blocks
+    bool pulled = !image_stamped_poses_;
+    ros::Time pulled_stamp(0);
+    for (int i = 0; i < (int) current_scene.cameras_in_scene_.size(); i++)
+      {
+	shared_ptr<Camera> camera = current_scene.cameras_in_scene_[i];
+	// wait until observation is done
+	{
+	  CAL_PHASE_TIMER("image wait");
+	  while (!camera->camera_observer_->observationsDone()) ;
+	}
+
+	// poses at the image's exposure time, so a scene can be captured while the robot moves slowly
+	// cameras triggered together often share a stamp, their poses are pulled once
+	if (image_stamped_poses_)
+	  {
+	    ros::Time image_stamp = camera->camera_observer_->getImageStamp();
+	    if (!pulled || image_stamp != pulled_stamp)
+	      {
+		if (!pullTransforms(scene_id, image_stamp))
+		  {
+		    ROS_ERROR("camera %s has no poses for its image of scene %d", camera->camera_name_.c_str(), scene_id);
+		    return false;
+		  }
+		pulled = true;
+		pulled_stamp = image_stamp;
+	      }
 	  }
-	
-	current_scene.get_trigger()->waitForTrigger(); // this indicates scene is ready to capture
-
-	pullTransforms(scene_id); // gets transforms of targets and cameras from their interfaces
-	
-	BOOST_FOREACH( shared_ptr<Camera> current_camera, current_scene.cameras_in_scene_)
-	  {// trigger the cameras
-	    P_BLOCK tmp;
-	    current_camera->camera_observer_->triggerCamera();
+
+	CapturedCamera camera_capture;
+	getCameraBlocks(camera, scene_id, camera_targets[i], camera_capture);
+
+	// only a ROSCameraObserver can detect in an image after it moved on to the next scene
+	shared_ptr<ROSCameraObserver> observer = boost::dynamic_pointer_cast<ROSCameraObserver>(camera->camera_observer_);
+	// a frame which failed its checks, or a target seen nearly edge on, is not searched at all
+	bool skip_detection = (observer && !observer->frameUsable()) || !viewingAngleOk(current_scene, camera_capture);
+	camera_capture.detected = detect_now || !observer || skip_detection;
+	if (skip_detection)
+	  {
+	    ROS_WARN("camera %s skips detection in scene %d", camera->camera_name_.c_str(), scene_id);
 	  }
+	else if (camera_capture.detected)
+	  {
+	    camera->getObservations(camera_capture.observations);
+	  }
+	else
+	  {
+	    camera_capture.image = observer->getImage();
+	    camera_capture.settings = observer->getDetectionSettings();
+	  }
+	captured.push_back(camera_capture);
+      }//end for each camera
+    return true;
+  }
+
+  bool CalibrationJob::viewingAngleOk(const ObservationScene &scene, const CapturedCamera &captured) const
+  {
+    if (frame_quality_parameters_.max_viewing_angle <= 0.0) return true;
+    BOOST_FOREACH(const ObservationCmd &o_command, scene.observation_command_list_)
+      {
+	if (o_command.camera != captured.camera) continue;
+	std::map<std::string, SceneTargetBlocks>::const_iterator blocks =
+	  captured.targets.find(o_command.target->target_name_);
+	if (blocks == captured.targets.end()) continue;
+	Pose6d target_in_camera;
+	if (!predictTargetInCamera(o_command.cost_type, captured.extrinsics, blocks->second.pose,
+				   captured.intermediate_frame, target_in_camera)) continue;
+	double angle = viewingAngle(target_in_camera);
+	if (angle > frame_quality_parameters_.max_viewing_angle)
+	  {
+	    ROS_WARN("camera %s is predicted to see target %s at %.2lf rad from its normal",
+		     captured.camera->camera_name_.c_str(), o_command.target->target_name_.c_str(), angle);
+	    return false;
+	  }
+      }
+    return true;
+  }
 
-	// collect results
-	P_BLOCK intrinsics;
-	P_BLOCK extrinsics;
-	P_BLOCK target_pose;
-	P_BLOCK pnt_pos;
-	std::string camera_name;
-	std::string target_name;
-	int target_type;
-	Cost_function cost_type;
-
-	// for each camera in scene get a list of observations, and add camera parameters to ceres_blocks
-	ObservationDataPointList listpercamera;
-	BOOST_FOREACH( shared_ptr<Camera> camera, current_scene.cameras_in_scene_)
+  void CalibrationJob::addCameraBlocks(shared_ptr<Camera> camera, int scene_id,
+				       const std::vector<shared_ptr<Target> > &targets)
+  {
+    // each of these does nothing if the block already exists
+    if (camera->isMoving())
+      {
+	ceres_blocks_.addMovingCamera(camera, scene_id);
+      }
+    else
+      {
+	ceres_blocks_.addStaticCamera(camera);
+      }
+    BOOST_FOREACH(shared_ptr<Target> target, targets)
+      {
+	if (target->is_moving_)
+	  {
+	    ceres_blocks_.addMovingTarget(target, scene_id);
+	  }
+	else
 	  {
-	    // wait until observation is done
-	    while (!camera->camera_observer_->observationsDone()) ;
+	    ceres_blocks_.addStaticTarget(target);
+	  }
+      }
+  }
+
+  void CalibrationJob::getCameraBlocks(shared_ptr<Camera> camera, int scene_id,
+				       const std::vector<shared_ptr<Target> > &targets, CapturedCamera &captured)
+  {
+    captured.camera = camera;
+    captured.scene_id = scene_id;
+    std::string camera_name = camera->camera_name_;
+    if (camera->isMoving())
+      {
+	captured.intrinsics = ceres_blocks_.getMovingCameraParameterBlockIntrinsics(camera_name);
+	captured.extrinsics = ceres_blocks_.getMovingCameraParameterBlockExtrinsics(camera_name, scene_id);
+      }
+    else
+      {
+	captured.intrinsics = ceres_blocks_.getStaticCameraParameterBlockIntrinsics(camera_name);
+	captured.extrinsics = ceres_blocks_.getStaticCameraParameterBlockExtrinsics(camera_name);
+      }
 
-	    camera_name = camera->camera_name_;
-	    if (camera->isMoving())
+    BOOST_FOREACH(shared_ptr<Target> target, targets)
+      {
+	std::string target_name = target->target_name_;
+	if (captured.targets.count(target_name)) continue;
+	SceneTargetBlocks &blocks = captured.targets[target_name];
+	if (target->is_moving_)
+	  {
+	    blocks.pose = ceres_blocks_.getMovingTargetPoseParameterBlock(target_name, scene_id);
+	    for (int pnt_id = 0; pnt_id < (int) target->num_points_; pnt_id++)
 	      {
-		// next line does nothing if camera already exist in blocks
-		ceres_blocks_.addMovingCamera(camera, scene_id);
-		pullTransforms(scene_id); // gets transforms of targets and cameras from their interfaces
-		intrinsics = ceres_blocks_.getMovingCameraParameterBlockIntrinsics(camera_name);
-		extrinsics = ceres_blocks_.getMovingCameraParameterBlockExtrinsics(camera_name, scene_id);
+		blocks.points.push_back(ceres_blocks_.getMovingTargetPointParameterBlock(target_name, pnt_id));
 	      }
-	    else
+	  }
+	else
+	  {
+	    blocks.pose = ceres_blocks_.getStaticTargetPoseParameterBlock(target_name);
+	    for (int pnt_id = 0; pnt_id < (int) target->num_points_; pnt_id++)
 	      {
-		// next line does nothing if camera already exist in blocks
-		ceres_blocks_.addStaticCamera(camera);
-		intrinsics = ceres_blocks_.getStaticCameraParameterBlockIntrinsics(camera_name);
-		extrinsics = ceres_blocks_.getStaticCameraParameterBlockExtrinsics(camera_name);
+		blocks.points.push_back(ceres_blocks_.getStaticTargetPointParameterBlock(target_name, pnt_id));
 	      }
+	  }
+      }
 
-	    // Get the observations from this camera whose P_BLOCKs are intrinsics and extrinsics
-	    CameraObservations camera_observations;
-	    int number_returned;
-	    number_returned = camera->getObservations(camera_observations);
+    // the intermediate frame as pulled for this scene and stamp, the camera's copy changes with the next scene
+    captured.intermediate_frame = camera->intermediate_frame_;
+  }
 
-	    ROS_DEBUG_STREAM("Processing " << camera_observations.size() << " Observations");
-	    ROS_INFO("Processing %d Observations ", (int) camera_observations.size());
-	    BOOST_FOREACH(Observation observation, camera_observations)
+  bool CalibrationJob::processCapturedScene(std::vector<CapturedCamera> &captured,
+					    ObservationDataPointList &observations)
+  {
+    bool all_found = true;
+    BOOST_FOREACH(CapturedCamera &camera_capture, captured)
+      {
+	if (!camera_capture.detected)
+	  {
+	    CAL_PHASE_TIMER("CalibrationJob::detect");
+	    ROSCameraObserver::detect(camera_capture.image, camera_capture.settings, camera_capture.observations);
+	    camera_capture.image = cv::Mat(); // the image is no longer needed
+	    camera_capture.detected = true;
+	  }
+
+	std::string camera_name = camera_capture.camera->camera_name_;
+	if (camera_capture.observations.empty())
+	  {
+	    ROS_WARN("camera %s did not find its target in scene %d", camera_name.c_str(), camera_capture.scene_id);
+	    all_found = false;
+	  }
+	ROS_DEBUG_STREAM("Processing " << camera_capture.observations.size() << " Observations");
+	ROS_INFO("Processing %d Observations ", (int) camera_capture.observations.size());
+	BOOST_FOREACH(Observation observation, camera_capture.observations)
+	  {
+	    std::string target_name = observation.target->target_name_;
+	    int target_type = observation.target->target_type_;
+	    Cost_function cost_type = observation.cost_type;
+	    double circle_dia=0.0;
+	    if(target_type == pattern_options::CircleGrid){
+	      circle_dia = observation.target->circle_grid_parameters_.circle_diameter;
+	    }
+	    int pnt_id = observation.point_id;
+	    std::map<std::string, SceneTargetBlocks>::const_iterator blocks = camera_capture.targets.find(target_name);
+	    if (blocks == camera_capture.targets.end() || pnt_id < 0 || pnt_id >= (int) blocks->second.points.size())
 	      {
-		target_name = observation.target->target_name_;
-		target_type = observation.target->target_type_;
-		cost_type = observation.cost_type;
-		double circle_dia=0.0;
-		if(target_type == pattern_options::CircleGrid){
-		  circle_dia = observation.target->circle_grid_parameters_.circle_diameter;
-		}
-		int pnt_id = observation.point_id;
-		double observation_x = observation.image_loc_x;
-		double observation_y = observation.image_loc_y;
-		if (observation.target->is_moving_)
-		  {
-		    ceres_blocks_.addMovingTarget(observation.target, scene_id);
-		    target_pose = ceres_blocks_.getMovingTargetPoseParameterBlock(target_name, scene_id);
-		    pnt_pos = ceres_blocks_.getMovingTargetPointParameterBlock(target_name, pnt_id);
-		  }
-		else
-		  {
-		    ceres_blocks_.addStaticTarget(observation.target); // if exist, does nothing
-		    target_pose = ceres_blocks_.getStaticTargetPoseParameterBlock(target_name);
-		    pnt_pos = ceres_blocks_.getStaticTargetPointParameterBlock(target_name, pnt_id);
-		  }
-		ObservationDataPoint temp_ODP(camera_name, target_name, target_type,
-					      scene_id, intrinsics, extrinsics, pnt_id, target_pose,
-					      pnt_pos, observation_x, observation_y, 
-					      cost_type, observation.intermediate_frame,
-					      circle_dia);
-		listpercamera.addObservationPoint(temp_ODP);
-	      }//end for each observed point
-	  }//end for each camera
-	observation_data_point_list_.push_back(listpercamera);
-      } //end for each scene
+		ROS_ERROR("camera %s observed point %d of target %s which has no block in scene %d",
+			  camera_name.c_str(), pnt_id, target_name.c_str(), camera_capture.scene_id);
+		continue;
+	      }
+	    ObservationDataPoint temp_ODP(camera_name, target_name, target_type,
+					  camera_capture.scene_id, camera_capture.intrinsics, camera_capture.extrinsics,
+					  pnt_id, blocks->second.pose, blocks->second.points[pnt_id],
+					  observation.image_loc_x, observation.image_loc_y,
+					  cost_type, camera_capture.intermediate_frame,
+					  circle_dia);
+	    observations.addObservationPoint(temp_ODP);
+	  }//end for each observed point
+      }//end for each camera
+    return all_found;
+  }
+
+  void CalibrationJob::processCapturedSceneJob(shared_ptr<std::vector<CapturedCamera> > captured,
+					       ObservationDataPointList *observations,
+					       boost::mutex *found_mutex, char *found)
+  {
+    bool all_found = processCapturedScene(*captured, *observations);
+    boost::mutex::scoped_lock lock(*found_mutex);
+    *found = all_found;
+  }
+
+  bool CalibrationJob::addCameraObservations(shared_ptr<Camera> camera, int scene_id, const ros::Time &stamp,
+					     CameraObservations &camera_observations,
+					     ObservationDataPointList &observations)
+  {
+    std::vector<shared_ptr<Target> > targets;
+    BOOST_FOREACH(Observation &observation, camera_observations)
+      {
+	targets.push_back(observation.target);
+      }
+    addCameraBlocks(camera, scene_id, targets);
+    if (!pullTransforms(scene_id, stamp)) return false; // once, after the scene's blocks exist
+    std::vector<CapturedCamera> captured(1);
+    getCameraBlocks(camera, scene_id, targets, captured[0]);
+    captured[0].detected = true;
+    captured[0].observations = camera_observations;
+    processCapturedScene(captured, observations);
     return true;
   }
 
+  bool CalibrationJob::captureContinuousScene(ObservationScene &current_scene, int &next_scene_id,
+					      std::vector<ObservationDataPointList> &scenes)
+  {
+    CAL_PHASE_TIMER("CalibrationJob::captureContinuousScene");
+    int scene_id = current_scene.get_id();
+
+    BOOST_FOREACH(shared_ptr<Camera> current_camera, current_scene.cameras_in_scene_)
+      {
+	current_camera->camera_observer_->clearObservations();
+	current_camera->camera_observer_->clearTargets();
+      }
+    BOOST_FOREACH(ObservationCmd o_command, current_scene.observation_command_list_)
+      {
+	o_command.camera->camera_observer_->addTarget(o_command.target, o_command.roi, o_command.cost_type);
+      }
+
+    // each frame's poses are snapshot by the workers while the frame is still in the tf buffer, the frames are
+    // those of the static blocks already in the job and of the scene's own cameras and targets
+    std::vector<TFFramePair> frames;
+    std::vector<std::string> joint_names;
+    ceres_blocks_.getTFFrames(-1, frames, joint_names);
+    BOOST_FOREACH(shared_ptr<Camera> current_camera, current_scene.cameras_in_scene_)
+      {
+	current_camera->getTransformInterface()->getTFFrames(frames);
+      }
+    BOOST_FOREACH(ObservationCmd o_command, current_scene.observation_command_list_)
+      {
+	o_command.target->getTransformInterface()->getTFFrames(frames);
+      }
+    SharedTransformListener::instance().clearSnapshots();
+
+    // every camera streams for the whole trajectory, detection keeps up in the capture's workers
+    std::vector<shared_ptr<ContinuousCapture> > captures;
+    BOOST_FOREACH(shared_ptr<Camera> current_camera, current_scene.cameras_in_scene_)
+      {
+	shared_ptr<ContinuousCapture> capture =
+	  make_shared<ContinuousCapture>(current_camera, continuous_capture_parameters_);
+	capture->setTFFrames(frames);
+	if (!capture->start())
+	  {
+	    ROS_ERROR("scene %d can not be captured continuously", scene_id);
+	    return false;
+	  }
+	captures.push_back(capture);
+      }
+
+    bool trajectory_done;
+    {
+      CAL_PHASE_TIMER("trigger wait");
+      // returns once the robot has moved through the trajectory
+      trajectory_done = current_scene.get_trigger()->waitForTrigger();
+    }
+    BOOST_FOREACH(shared_ptr<ContinuousCapture> capture, captures)
+      {
+	capture->stop();
+      }
+    if (!trajectory_done)
+      {
+	ROS_ERROR("trigger of continuous scene %d failed", scene_id);
+	return false;
+      }
+
+    bool every_camera_kept = true;
+    for (int i = 0; i < (int) captures.size(); i++)
+      {
+	shared_ptr<Camera> camera = current_scene.cameras_in_scene_[i];
+	std::vector<CapturedFrame> frames = captures[i]->selectFrames();
+	ROS_INFO("scene %d camera %s kept %d frames as scenes %d to %d", scene_id, camera->camera_name_.c_str(),
+		 (int) frames.size(), next_scene_id, next_scene_id + (int) frames.size() - 1);
+	if (frames.empty()) every_camera_kept = false;
+	BOOST_FOREACH(CapturedFrame &frame, frames)
+	  {
+	    ObservationDataPointList listpercamera;
+	    if (!addCameraObservations(camera, next_scene_id, frame.stamp, frame.observations, listpercamera))
+	      {
+		ROS_ERROR("scene %d camera %s has no poses for its frame at %.3lf", scene_id, camera->camera_name_.c_str(),
+			  frame.stamp.toSec());
+		return false;
+	      }
+	    scenes.push_back(listpercamera);
+	    next_scene_id++;
+	  }
+      }
+    SharedTransformListener::instance().clearSnapshots();
+    return every_camera_kept;
+  }
+
   bool CalibrationJob::runOptimization()
   {
+    CAL_PHASE_TIMER("CalibrationJob::runOptimization");
     int total_observations =0;
     for(int i=0;i<observation_data_point_list_.size();i++){
       total_observations += observation_data_point_list_[i].items_.size();
@@ -812,378 +1706,6 @@ namespace industrial_extrinsic_cal
     // take all the data collected and create a Ceres optimization problem and run it
     ROS_INFO("Running Optimization with %d scenes",(int)scene_list_.size());
     ROS_DEBUG_STREAM("Optimizing "<<scene_list_.size()<<" scenes");
-    BOOST_FOREACH(ObservationScene current_scene, scene_list_)
-      {
-
-	int scene_id = current_scene.get_id();
-	BOOST_FOREACH(shared_ptr<Camera> camera, current_scene.cameras_in_scene_)
-	  {
-	    ROS_DEBUG_STREAM("Current observation data point list size: "<<observation_data_point_list_.at(scene_id).items_.size());
-	    // take all the data collected and create a Ceres optimization problem and run it
-	    P_BLOCK extrinsics;
-	    P_BLOCK intrinsics;
-	    P_BLOCK target_pose_params;
-	    P_BLOCK point_position;
-	    BOOST_FOREACH(ObservationDataPoint ODP, observation_data_point_list_.at(scene_id).items_)
-	      {
-		// create cost function
-		// there are several options
-		// 1. the complete reprojection error cost function "Create(obs_x,obs_y)"
-		//    this cost function has the following parameters:
-		//      a. camera intrinsics
-		//      b. camera extrinsics
-		//      c. target pose
-		//      d. point location in target frame
-		// 2. the same as 1, but without d  "Create(obs_x,obs_y,t_pnt_x, t_pnt_y, t_pnt_z)
-		// 3. the same as 1, but without a  "Create(obs_x,obs_y,fx,fy,cx,cy,cz)"
-		//    Note that this one assumes we are using rectified images to compute the observations
-		// 4. the same as 3, point location fixed too "Create(obs_x,obs_y,fx,fy,cx,cy,cz,t_x,t_y,t_z)"
-		//        implemented in TargetCameraReprjErrorNoDistortion
-		// 5. the same as 4, but with target in known location
-		//    "Create(obs_x,obs_y,fx,fy,cx,cy,cz,t_x,t_y,t_z,p_tx,p_ty,p_tz,p_ax,p_ay,p_az)"
-		// pull out the constants from the observation point data
-		intrinsics = ODP.camera_intrinsics_;
-		double focal_length_x = ODP.camera_intrinsics_[0]; // TODO, make this not so ugly
-		double focal_length_y = ODP.camera_intrinsics_[1];
-		double center_x   = ODP.camera_intrinsics_[2];
-		double center_y   = ODP.camera_intrinsics_[3];
-		double image_x        = ODP.image_x_;
-		double image_y        = ODP.image_y_;
-		Point3d point;
-		Pose6d camera_mounting_pose = ODP.intermediate_frame_; // identity except when camera mounted on robot
-		point.x = ODP.point_position_[0];// location of point within target frame
-		point.y = ODP.point_position_[1];
-		point.z = ODP.point_position_[2];
-		unsigned int target_type    = ODP.target_type_;
-		double circle_dia = ODP.circle_dia_; // sometimes this is not needed
-	      
-		// pull out pointers to the parameter blocks in the observation point data
-		extrinsics        = ODP.camera_extrinsics_;
-		target_pose_params     = ODP.target_pose_;
-		Pose6d target_pose;
-		target_pose.setAngleAxis(target_pose_params[0],target_pose_params[1], target_pose_params[2]);
-		target_pose.setOrigin(target_pose_params[3],target_pose_params[4], target_pose_params[5]);
-		point_position = ODP.point_position_;
-		bool point_zero=false;
-		/*
-		if(point.x == 0.0 && point.y == 0.0 && point.z == 0.0){
-		  point_zero=true;
-		  ROS_ERROR("Observing Target Origin");
-		  showPose(target_pose_params, "target");
-		  showPose(extrinsics,"extrinsics");
-		  showPose((P_BLOCK) &camera_mounting_pose.pb_pose[0], "camera_mounting_pose");
-		}
-        */
-		
-		switch( ODP.cost_type_ ){
-		case cost_functions::CameraReprjErrorWithDistortion:
-		  {
-		    CostFunction* cost_function =
-		      CameraReprjErrorWithDistortion::Create(image_x, image_y);
-		    problem_.AddResidualBlock(cost_function, NULL , extrinsics, intrinsics, point.pb);
-		  }
-		  break;
-		case cost_functions::CameraReprjErrorWithDistortionPK:
-		  {
-		    CostFunction* cost_function =
-		      CameraReprjErrorWithDistortionPK::Create(image_x, image_y, 
-							       point);
-		    problem_.AddResidualBlock(cost_function, NULL , extrinsics, intrinsics);
-		  }
-		  break;
-		case cost_functions::CameraReprjError:
-		  {
-		    CostFunction* cost_function =
-		      CameraReprjError::Create(image_x, image_y, 
-					       focal_length_x, focal_length_y,
-					       center_x, center_y);
-		    problem_.AddResidualBlock(cost_function, NULL , extrinsics, point.pb);
-		  }
-		  break;
-		case cost_functions::CameraReprjErrorPK:
-		  {
-		    CostFunction* cost_function =
-		      CameraReprjErrorPK::Create(image_x, image_y, 
-						 focal_length_x, focal_length_y,
-						 center_x, center_y,
-						 point);
-		    problem_.AddResidualBlock(cost_function, NULL , extrinsics);
-		  }
-		  break;
-		case cost_functions::TargetCameraReprjError:
-		  {
-		    CostFunction* cost_function =
-		      TargetCameraReprjError::Create(image_x, image_y, 
-						     focal_length_x, focal_length_y,
-						     center_x, center_y);
-
-		    problem_.AddResidualBlock(cost_function, NULL , extrinsics, target_pose_params, point.pb);
-		  }
-		  break;
-		case cost_functions::TargetCameraReprjErrorPK:
-		  {
-		    CostFunction* cost_function = 
-		      TargetCameraReprjErrorPK::Create(image_x, image_y,
-						       focal_length_x,
-						       focal_length_y,
-						       center_x,
-						       center_y,
-						       point);
-		    // add it as a residual using parameter blocks
-		    problem_.AddResidualBlock(cost_function, NULL , extrinsics, target_pose_params);
-		  }
-		  break;
-		case cost_functions::LinkTargetCameraReprjError:
-		  {
-		    CostFunction* cost_function =
-		      LinkTargetCameraReprjError::Create(image_x, image_y, 
-							 focal_length_x,
-							 focal_length_y,
-							 center_x,
-							 center_y,
-							 camera_mounting_pose);
-		      problem_.AddResidualBlock(cost_function, NULL , extrinsics, target_pose_params, point.pb);
-		  }
-		  break;
-		case cost_functions::LinkTargetCameraReprjErrorPK:
-		  {
-		    CostFunction* cost_function =
-		      LinkTargetCameraReprjErrorPK::Create(image_x, image_y, 
-							   focal_length_x,
-							   focal_length_y,
-							   center_x,
-							   center_y,
-							   camera_mounting_pose,
-							   point);
-		    problem_.AddResidualBlock(cost_function, NULL , extrinsics, target_pose_params);
-		  }
-		  break;
-		case cost_functions::LinkCameraTargetReprjError:
-		  {
-		    CostFunction* cost_function =
-		      LinkCameraTargetReprjError::Create(image_x, image_y, 
-							 focal_length_x,
-							 focal_length_y,
-							 center_x,
-							 center_y,
-							 camera_mounting_pose);
-		    problem_.AddResidualBlock(cost_function, NULL , extrinsics, target_pose_params, point.pb);
-		  }
-		  break;
-		case cost_functions::LinkCameraTargetReprjErrorPK:
-		    {
-		      CostFunction* cost_function =
-			LinkCameraTargetReprjErrorPK::Create(image_x, image_y, 
-							     focal_length_x,
-							     focal_length_y,
-							     center_x,
-							     center_y,
-							     camera_mounting_pose,
-							     point);
-		      
-		      problem_.AddResidualBlock(cost_function, NULL , extrinsics, target_pose_params);
-		    }
-		    break;
-		case cost_functions::CircleCameraReprjErrorWithDistortion:
-		  {
-		    CostFunction* cost_function =
-		      CircleCameraReprjErrorWithDistortion::Create(image_x, image_y, circle_dia);
-		    problem_.AddResidualBlock(cost_function, NULL , extrinsics, intrinsics, point.pb);
-		  }
-		  break;
-		case cost_functions::CircleCameraReprjErrorWithDistortionPK:
-		  {
-		    CostFunction* cost_function =
-		      CircleCameraReprjErrorWithDistortionPK::Create(image_x, image_y,
-								     circle_dia,
-								     point);
-		    problem_.AddResidualBlock(cost_function, NULL , extrinsics, intrinsics, point.pb);
-		  }
-		  break;
-		case cost_functions::CircleCameraReprjError:
-		  {
-		    CostFunction* cost_function =
-		      CircleCameraReprjError::Create(image_x, image_y, 
-						     circle_dia,
-						     focal_length_x,
-						     focal_length_y,
-						     center_x,
-						     center_y);
-		    problem_.AddResidualBlock(cost_function, NULL , extrinsics, point.pb);
-		  }
-		  break;
-		case cost_functions::CircleCameraReprjErrorPK:
-		  {
-		    CostFunction* cost_function =
-		      CircleCameraReprjErrorPK::Create(image_x, image_y, 
-						       circle_dia,
-						       focal_length_x,
-						       focal_length_y,
-						       center_x,
-						       center_y,
-						       point);
-		    problem_.AddResidualBlock(cost_function, NULL , extrinsics);
-		  }
-		  break;
-		case cost_functions::CircleTargetCameraReprjErrorWithDistortion:
-		  {
-		    CostFunction* cost_function =
-		      CircleTargetCameraReprjErrorWithDistortion::Create(image_x, image_y,
-									 circle_dia);
-		    problem_.AddResidualBlock(cost_function, NULL , extrinsics, intrinsics, target_pose_params, point.pb);
-		  }
-		  break;
-		case cost_functions::CircleTargetCameraReprjErrorWithDistortionPK:
-		  {
-		    CostFunction* cost_function =
-		      CircleTargetCameraReprjErrorWithDistortionPK::Create(image_x, image_y, 
-									   circle_dia,
-									   point);
-		    problem_.AddResidualBlock(cost_function, NULL , extrinsics, intrinsics, target_pose_params);
-		  }
-		  break;
-		case cost_functions::CircleTargetCameraReprjError:
-		  {
-		    CostFunction* cost_function =
-		      CircleTargetCameraReprjError::Create(image_x, image_y, 
-							   circle_dia,
-							   focal_length_x,
-							   focal_length_y,
-							   center_x,
-							   center_y);
-		    problem_.AddResidualBlock(cost_function, NULL , extrinsics, target_pose_params, point.pb);
-		  }
-		  break;
-		case cost_functions::CircleTargetCameraReprjErrorPK:
-		  {
-		    CostFunction* cost_function = 
-		      CircleTargetCameraReprjErrorPK::Create(image_x,  image_y,
-							     circle_dia,
-							     focal_length_x,
-							     focal_length_y,
-							     center_x,
-							     center_y,
-							     point);
-		    problem_.AddResidualBlock(cost_function, NULL , extrinsics, target_pose_params);
-		  }
-		  break;
-		case cost_functions::LinkCircleTargetCameraReprjError:
-		  {
-		    CostFunction* cost_function =
-		      LinkCircleTargetCameraReprjError::Create(image_x, image_y, 
-							       circle_dia,
-							       focal_length_x,
-							       focal_length_y,
-							       center_x,
-							       center_y,
-							       camera_mounting_pose);
-		    problem_.AddResidualBlock(cost_function, NULL , extrinsics, target_pose_params, point.pb);
-		  }
-		  break;
-		case cost_functions::LinkCircleTargetCameraReprjErrorPK:
-		  {
-		    CostFunction* cost_function =
-		      LinkCircleTargetCameraReprjErrorPK::Create(image_x, image_y, 
-								 circle_dia,
-								 focal_length_x,
-								 focal_length_y,
-								 center_x,
-								 center_y,
-								 camera_mounting_pose,
-								 point);
-		    problem_.AddResidualBlock(cost_function, NULL , extrinsics, target_pose_params);
-		  }
-		  break;
-		case cost_functions::LinkCameraCircleTargetReprjError:
-		  {
-		    CostFunction* cost_function =
-		      LinkCameraCircleTargetReprjError::Create(image_x, image_y, 
-							       circle_dia,
-							       focal_length_x,
-							       focal_length_y,
-							       center_x,
-							       center_y,
-							       camera_mounting_pose);
-		    problem_.AddResidualBlock(cost_function, NULL , extrinsics, target_pose_params, point.pb);
-		  }
-		  break;
-		case cost_functions::LinkCameraCircleTargetReprjErrorPK:
-		  {
-		    CostFunction* cost_function =
-		      LinkCameraCircleTargetReprjErrorPK::Create(image_x, image_y, 
-								 circle_dia,
-								 focal_length_x,
-								 focal_length_y,
-								 center_x,
-								 center_y,
-								 camera_mounting_pose,
-								 point);
-		    problem_.AddResidualBlock(cost_function, NULL , extrinsics, target_pose_params);
-		    if(point_zero){
-		      double residual[2];
-		      double *params[2];
-		      params[0] = &extrinsics[0];
-		      params[1] = &target_pose_params[0];
-		      cost_function->Evaluate(params, residual, NULL);
-		      ROS_INFO("Initial residual %6.3lf %6.3lf ix,iy = %6.3lf %6.3lf px,py = %6.3lf %6.3lf", residual[0], residual[1],image_x, image_y, residual[0]+image_x, residual[0]+image_y);
-		      point_zero=false;
-		      LinkCameraCircleTargetReprjErrorPK testIt(image_x, image_y, 
-								circle_dia,
-								focal_length_x,
-								focal_length_y,
-								center_x,
-								center_y,
-								camera_mounting_pose,
-								point);
-		      testIt.test_residual(extrinsics, target_pose_params, residual);
-
-		    }
-		  }
-		  break;
-		case cost_functions::FixedCircleTargetCameraReprjErrorPK:
-		  {
-		    CostFunction* cost_function =
-		      FixedCircleTargetCameraReprjErrorPK::Create(image_x, image_y, 
-								  circle_dia,
-								  focal_length_x,
-								  focal_length_y,
-								  center_x,
-								  center_y,
-								  target_pose,
-								  camera_mounting_pose,
-								  point);
-		    problem_.AddResidualBlock(cost_function, NULL , extrinsics);
-		    if(point_zero){
-		      double residual[2];
-		      double *params[2];
-		      params[0] = &extrinsics[0];
-		      cost_function->Evaluate(params, residual, NULL);
-		      ROS_ERROR("Initial residual %6.3lf %6.3lf ix,iy = %6.3lf %6.3lf px,py = %6.3lf %6.3lf", residual[0], residual[1],image_x, image_y, residual[0]+image_x, residual[0]+image_y);
-		      point_zero=false;
-		      FixedCircleTargetCameraReprjErrorPK testIt(image_x, image_y, 
-								 circle_dia,
-								 focal_length_x,
-								 focal_length_y,
-								 center_x,
-								 center_y,
-								 target_pose,
-								 camera_mounting_pose,
-								 point);
-		      testIt.test_residual(extrinsics, residual);
-
-		    }
-		  }
-		  break;
-		default:
-		  {
-		    std::string cost_type_string = costType2String(ODP.cost_type_);
-		    ROS_ERROR("No cost function of type %s", cost_type_string.c_str());
-		  }
-		  break;
-		}// end of switch
-	      }//for each observation
-	  }//for each camera
-      }//for each scene
   ROS_INFO("total observations: %d ",total_observations);
   
   // Make Ceres automatically detect the bundle structure. Note that the
@@ -1191,22 +1713,134 @@ namespace industrial_extrinsic_cal
   // for standard bundle adjustment problems.
   ceres::Solver::Options options;
   ceres::Solver::Summary summary;
-  options.linear_solver_type = ceres::DENSE_SCHUR;
+  options.linear_solver_type = linear_solver_type_;
   options.minimizer_progress_to_stdout = true;
   options.max_num_iterations = 1000;
-  ceres::Solve(options, &problem_, &summary);
+
+  if(multi_start_parameters_.num_starts > 1){
+    // each start gets its own perturbed copy of the blocks, the winner is copied back into ceres_blocks_
+    MultiStartOptimizer optimizer(multi_start_parameters_);
+    double best_cost;
+    bool solved = optimizer.solve(boost::bind(&CalibrationJob::addObservationsToProblem, this, _1, _2), options, best_cost);
+    const std::vector<StartSummary> &starts = optimizer.startSummaries();
+    for(int i=0; i<(int)starts.size(); i++){
+      ROS_INFO("start %d: initial cost %lf final cost %lf after %d iterations%s", i, starts[i].initial_cost,
+	       starts[i].final_cost, starts[i].iterations, starts[i].usable ? "" : ", not usable");
+    }
+    if(!solved){
+      ROS_ERROR("none of the %d starts produced a usable solution", (int)starts.size());
+      return(false);
+    }
+    ROS_INFO("start %d has the best cost of %d starts: %lf", optimizer.bestStart(), (int)starts.size(), best_cost);
+    // polish and trim starting from the best start, which was copied back into ceres_blocks_
+    // this also leaves problem_ holding the solution for the quality report
+  }
+
+  // a fresh problem each run, the blocks and cached rotations of an earlier run are not carried along
+  rotation_cache_.clear();
+  problem_ = make_shared<ceres::Problem>(trimProblemOptions());
+  residuals_.clear();
+  addObservationsToProblem(*problem_, NULL);
+  SchurOrdering ordering; // target points and moving target poses are eliminated, the cameras form the reduced system
+  ceres_blocks_.addSchurEliminationBlocks(ordering);
+  int num_eliminated = ordering.apply(*problem_, options);
+  if(num_eliminated > 0) ROS_INFO("Schur ordering eliminates %d parameter blocks", num_eliminated);
+  rotation_cache_.attach(options); // each pose block is converted to a rotation matrix once per evaluation
+  OutlierTrimmer trimmer(outlier_trim_parameters_);
+  bool solved = trimmer.solve(*problem_, residuals_, options, summary);
+  trimmed_observations_ = trimmer.trimmed();
+  if(trimmed_observations_.size() > 0){
+    ROS_INFO("%s", trimmer.report().c_str());
+  }
+  if(!solved){
+    ROS_ERROR("no usable solution");
+    return false;
+  }
   ROS_INFO("PROBLEM SOLVED");
+
+  quality_report_ = make_shared<QualityReport>(quality_parameters_);
+  BOOST_FOREACH(const ObservationDataPointList &observations, observation_data_point_list_)
+    {
+      quality_report_->addExtrinsics(observations);
+    }
+  if(quality_report_->compute(*problem_, residuals_)){
+    ROS_INFO("%s", quality_report_->summary().c_str());
+  }
+  else{
+    ROS_ERROR("could not evaluate the quality of the solution");
+  }
   return true;
 }//end runOptimization
 
+  void CalibrationJob::addObservationsToProblem(ceres::Problem &problem, ParameterBlockCopies *copies)
+  {
+    addScenesToProblem(observation_data_point_list_, problem, copies);
+  }
+
+  void CalibrationJob::addScenesToProblem(const std::vector<ObservationDataPointList> &scenes,
+					  ceres::Problem &problem, ParameterBlockCopies *copies)
+  {
+    CAL_PHASE_TIMER("CalibrationJob::addScenesToProblem");
+    // each scene's list already holds the observations of all its cameras, so every observation is added once
+    BOOST_FOREACH(const ObservationDataPointList &scene_observations, scenes)
+      {
+	BOOST_FOREACH(const ObservationDataPoint &ODP, scene_observations.items_)
+	  {
+	    // pull out pointers to the parameter blocks in the observation point data, they point into ceres_blocks_
+	    // a multi-start solve substitutes its own copy of each block
+	    P_BLOCK extrinsics = ODP.camera_extrinsics_;
+	    P_BLOCK intrinsics = ODP.camera_intrinsics_;
+	    P_BLOCK target_pose_params = ODP.target_pose_;
+	    P_BLOCK point_position = ODP.point_position_;
+	    if(copies != NULL){
+	      extrinsics = copies->extrinsics(ODP.camera_extrinsics_);
+	      intrinsics = copies->intrinsics(ODP.camera_intrinsics_);
+	      target_pose_params = copies->targetPose(ODP.target_pose_);
+	      point_position = copies->point(ODP.point_position_);
+	    }
+
+	    // the rotation cache follows ceres_blocks_, a multi-start's copies are solved without it
+	    std::vector<P_BLOCK> parameter_blocks;
+	    CostFunction* cost_function = createObservationCost(ODP, extrinsics, intrinsics,
+								target_pose_params, point_position,
+								parameter_blocks,
+								copies == NULL ? &rotation_cache_ : NULL);
+	    if(cost_function != NULL){
+	      ceres::ResidualBlockId id = problem.AddResidualBlock(cost_function,
+								   robust_losses_.create(ODP.cost_type_),
+								   parameter_blocks);
+	      if(copies == NULL) residuals_.push_back(observationResidual(id, ODP));
+	    }
+	  }//for each observation
+      }//for each scene
+
+    // poses and points of targets defined as known keep their values
+    int num_constant = ceres_blocks_.holdConstantTargetBlocks(problem, copies);
+    if(copies == NULL) ROS_INFO("%d target blocks held constant", num_constant);
+  }
+
   bool CalibrationJob::store()
   {
-    std::string path = ros::package::getPath("industrial_extrinsic_cal");
-    std::string file_path = "/launch/target_to_camera_optical_transform_publisher.launch";
-    std::string filepath = path+file_path;
+    // a relative results file is in the package's launch directory
+    std::string filepath = results_file_.empty() ? "target_to_camera_optical_transform_publisher.launch" : results_file_;
+    if(filepath[0] != '/'){
+      filepath = ros::package::getPath("industrial_extrinsic_cal") + "/launch/" + filepath;
+    }
+    std::string directory = filepath.substr(0, filepath.rfind('/'));
+
+    bool rtn =  ceres_blocks_.writeAllStaticTransforms(filepath, results_format_);
 
-    bool rnt =  ceres_blocks_.writeAllStaticTransforms(filepath);
-    bool rtn = true;
+    // the calibration is final, its transforms move to /tf_static, latched for late subscribers
+    SharedTransformBroadcaster::instance().publishStatic();
+
+    // the quality report sits next to the transforms so the calibration can be judged without re-running it
+    if(quality_report_){
+      std::string quality_path = directory + "/calibration_quality.yaml";
+      if(!quality_report_->write(quality_path)){
+	ROS_ERROR("could not write %s", quality_path.c_str());
+	rtn = false;
+      }
+    }
     return rtn;
   }
 
@@ -1215,9 +1849,10 @@ namespace industrial_extrinsic_cal
     ceres_blocks_.pullTransforms(-1); // since we don't know which scene for any moving objects, only pull static transforms
     ceres_blocks_.displayAllCamerasAndTargets();
   }
-  void CalibrationJob::pullTransforms(int scene_id)
+  bool CalibrationJob::pullTransforms(int scene_id, const ros::Time &stamp)
   {
-    ceres_blocks_.pullTransforms( scene_id);
+    CAL_PHASE_TIMER("CalibrationJob::pullTransforms");
+    return ceres_blocks_.pullTransforms( scene_id, stamp);
   }
   void CalibrationJob::pushTransforms()
   {
@@ -18,6 +18,7 @@
 
 
 #include <industrial_extrinsic_cal/ceres_blocks.h>
+#include <industrial_extrinsic_cal/ros_transform_interface.h>
 #include <boost/shared_ptr.hpp>
 
 using std::string;
@@ -27,7 +28,7 @@ namespace industrial_extrinsic_cal
 {
 
   void  showPose(Pose6d pose, std::string message){
-    tf::Matrix3x3 basis = pose.getBasis();
+    RotationMatrix basis = pose.getBasis();
     double ez_yaw, ey_pitch, ex_roll;
     double qx,qy,qz,qw;
     pose.getEulerZYX(ez_yaw,ey_pitch,ex_roll);
@@ -51,7 +52,7 @@ void  showPose(P_BLOCK extrinsics, std::string message){
     py  = extrinsics[4]; 
     pz  = extrinsics[5];
     Pose6d pose(px,py,pz,ax,ay,az);
-    tf::Matrix3x3 basis = pose.getBasis();
+    RotationMatrix basis = pose.getBasis();
     double ez_yaw, ey_pitch, ex_roll;
     double qx, qy, qz, qw;
     pose.getEulerZYX(ez_yaw,ey_pitch,ex_roll);
@@ -197,7 +198,7 @@ P_BLOCK CeresBlocks::getMovingTargetPoseParameterBlock(string target_name, int s
 P_BLOCK CeresBlocks::getMovingTargetPointParameterBlock(string target_name, int pnt_id)
 {
   // note scene_id unnecessary here since regarless of scene th point's location relative to
-  // the target frame does not change
+  // the target frame does not change, the first copy's points are shared by all scenes
   BOOST_FOREACH(shared_ptr<MovingTarget> moving_target, moving_targets_)
   {
     if (target_name == moving_target->targ_->target_name_)
@@ -209,6 +210,61 @@ P_BLOCK CeresBlocks::getMovingTargetPointParameterBlock(string target_name, int
   return (NULL);
 }
 
+void CeresBlocks::addSchurEliminationBlocks(SchurOrdering &ordering)
+{
+  // points first, each residual has at most one so they never share one
+  BOOST_FOREACH(shared_ptr<Target> target, static_targets_)
+  {
+    for (int i = 0; i < (int)target->pts_.size(); i++)
+      ordering.eliminate(&(target->pts_[i].pb[0]));
+  }
+  BOOST_FOREACH(shared_ptr<MovingTarget> moving_target, moving_targets_)
+  {
+    for (int i = 0; i < (int)moving_target->targ_->pts_.size(); i++)
+      ordering.eliminate(&(moving_target->targ_->pts_[i].pb[0]));
+  }
+  BOOST_FOREACH(shared_ptr<MovingTarget> moving_target, moving_targets_)
+  {
+    ordering.eliminate(&(moving_target->targ_->pose_.pb_pose[0]));
+  }
+}
+
+void CeresBlocks::getConstantTargetBlocks(std::vector<P_BLOCK> &blocks)
+{
+  std::vector<shared_ptr<Target> > targets(static_targets_.begin(), static_targets_.end());
+  BOOST_FOREACH(shared_ptr<MovingTarget> moving_target, moving_targets_)
+  {
+    targets.push_back(moving_target->targ_);
+  }
+  BOOST_FOREACH(shared_ptr<Target> target, targets)
+  {
+    if (target->fixed_pose_)
+      blocks.push_back(&(target->pose_.pb_pose[0]));
+    if (target->fixed_points_)
+    {
+      for (int i = 0; i < (int)target->pts_.size(); i++)
+	blocks.push_back(&(target->pts_[i].pb[0]));
+    }
+  }
+}
+
+int CeresBlocks::holdConstantTargetBlocks(ceres::Problem &problem, ParameterBlockCopies *copies)
+{
+  std::vector<P_BLOCK> constant_blocks;
+  getConstantTargetBlocks(constant_blocks);
+  int num_constant = 0;
+  BOOST_FOREACH(P_BLOCK block, constant_blocks)
+  {
+    if (copies != NULL)
+      block = copies->unperturbed(block); // a start must not move a known target
+    if (block == NULL || !problem.HasParameterBlock(block))
+      continue;
+    problem.SetParameterBlockConstant(block);
+    num_constant++;
+  }
+  return (num_constant);
+}
+
 bool CeresBlocks::addStaticCamera(shared_ptr<Camera> camera_to_add)
 {
   BOOST_FOREACH(shared_ptr<Camera> cam, static_cameras_)
@@ -275,9 +331,9 @@ bool CeresBlocks::addMovingTarget(shared_ptr<Target> target_to_add, int scene_id
     if (targ->targ_->target_name_ == target_to_add->target_name_ && targ->scene_id_ == scene_id)
       return (false); // target already exists
   }
+  // each scene gets its own copy, and with it its own pose block, the points stay those of the first copy
   shared_ptr<MovingTarget> temp_moving_target = boost::make_shared<MovingTarget>();
-  shared_ptr<Target> temp_camera = boost::make_shared<Target>();
-  temp_moving_target->targ_ = target_to_add;
+  temp_moving_target->targ_ = boost::make_shared<Target>(*target_to_add);
   temp_moving_target->scene_id_ = scene_id;
   temp_moving_target->targ_->setTIReferenceFrame(reference_frame_);
   moving_targets_.push_back(temp_moving_target);
@@ -364,7 +420,7 @@ const boost::shared_ptr<Target> CeresBlocks::getTargetByName(const std::string &
 }
 void CeresBlocks::displayMovingCameras()
 {
-  tf::Matrix3x3 R;
+  RotationMatrix R;
   double aa[3];
   double camera_to_world[3];
   double world_to_camera[3];
@@ -407,92 +463,139 @@ void CeresBlocks::displayMovingTargets()
     }
 }
 using std::string;
-using std::ofstream;
 using std::endl;
 
-bool CeresBlocks::writeAllStaticTransforms(string filePath)
+bool CeresBlocks::writeAllStaticTransforms(string filePath, ResultsFormat format)
 {
-  std::ofstream outputFile(filePath.c_str(), std::ios::out);// | std::ios::app);
-  if (outputFile.is_open())
-    {
-      ROS_INFO_STREAM("Storing results in: "<<filePath);
-    }
-  else
-    {
-      ROS_ERROR_STREAM("Unable to open file:" <<filePath);
-      return false;
-    }//end if writing to file
-  outputFile << "<launch>\n";
-  outputFile.close();
-  
-  bool rtn = true;
+  // every transform is collected first and the file written once, an interrupted store leaves the previous results
+  std::vector<shared_ptr<TransformInterface> > interfaces;
   BOOST_FOREACH(shared_ptr<Camera> cam, static_cameras_)
     {
-      rtn = cam->transform_interface_->store(filePath);
+      interfaces.push_back(cam->transform_interface_);
     }
   BOOST_FOREACH(shared_ptr<MovingCamera> mcam, moving_cameras_)
     {
-      rtn = mcam->cam->transform_interface_->store(filePath);
+      interfaces.push_back(mcam->cam->transform_interface_);
     }
   BOOST_FOREACH(shared_ptr<Target> targ, static_targets_)
     {
-      rtn = targ->transform_interface_->store(filePath);
+      interfaces.push_back(targ->transform_interface_);
     }
   BOOST_FOREACH(shared_ptr<MovingTarget> mtarg, moving_targets_)
     {
-      rtn = mtarg->targ_->transform_interface_->store(filePath);
+      interfaces.push_back(mtarg->targ_->transform_interface_);
+    }
+
+  ResultsWriter writer;
+  bool rtn = true;
+  BOOST_FOREACH(shared_ptr<TransformInterface> transform_interface, interfaces)
+    {
+      if(!transform_interface->hasStoredTransform()){
+	// e.g. the mutable joint state publisher stores its own yaml file, a listener stores nothing
+	if(!transform_interface->store(filePath)) rtn = false;
+	continue;
+      }
+      string parent_frame, child_frame;
+      Pose6d pose;
+      if(!transform_interface->getStoredTransform(parent_frame, child_frame, pose)){
+	ROS_ERROR_STREAM("No transform to store for frame " << transform_interface->getTransformFrame() <<
+			 ", " << filePath << " is left as it was");
+	return false;
+      }
+      writer.add(parent_frame, child_frame, pose);
     }
-  
   if(!rtn){
-    ROS_ERROR("Couldn't write the static tranform publishers");
+    ROS_ERROR("Couldn't store all transforms");
   }
-  std::ofstream outputFileagain(filePath.c_str(), std::ios::app);
-  if (!outputFileagain.is_open())
+
+  ROS_INFO_STREAM("Storing "<<writer.transforms().size()<<" transforms in: "<<filePath);
+  if(!writer.write(filePath, format))
     {
-      ROS_ERROR_STREAM("Unable to re-open file:" <<filePath);
+      ROS_ERROR_STREAM("Unable to write file:" <<filePath);
       return false;
-    }//end if writing to file
-  else{
-    outputFileagain << "\n</launch> \n";
-    outputFileagain.close();
-  }
+    }
   return(rtn);
 }
 
 void CeresBlocks::pushTransforms()
+{
+  // the mutable joints set by the interfaces below go to the publisher in one transaction, when write ends
+  {
+    ScopedMutableJointWrite write;
+    BOOST_FOREACH(shared_ptr<Camera> cam, static_cameras_)
+      {
+        ROS_DEBUG("pushing static camera %s",cam->camera_name_.c_str());
+        cam->pushTransform();
+      }
+    BOOST_FOREACH(shared_ptr<MovingCamera> mcam, moving_cameras_)
+      {
+        ROS_DEBUG("pushing moving camera %s",mcam->cam->camera_name_.c_str());
+        Pose6d pose;
+        pose.setAngleAxis(mcam->cam->camera_parameters_.angle_axis[0], 
+			  mcam->cam->camera_parameters_.angle_axis[1], 
+			  mcam->cam->camera_parameters_.angle_axis[2]);
+        pose.setOrigin(mcam->cam->camera_parameters_.position[0],
+		       mcam->cam->camera_parameters_.position[1],
+		       mcam->cam->camera_parameters_.position[2]);
+        pose.show("moving camera");
+        mcam->cam->pushTransform();
+      }
+    BOOST_FOREACH(shared_ptr<Target> targ, static_targets_)
+      {
+        ROS_DEBUG("pushing static target %s",targ->target_name_.c_str());
+        targ->pushTransform();
+      }
+    BOOST_FOREACH(shared_ptr<MovingTarget> mtarg, moving_targets_)
+      {
+        ROS_DEBUG("pushing moving target %s from scene %d",mtarg->targ_->target_name_.c_str(), mtarg->scene_id_);
+        mtarg->targ_->pushTransform();
+      }
+  }
+  SharedTransformBroadcaster::instance().update(); // the new poses go out together, without waiting for the next period
+}
+void CeresBlocks::getTFFrames(int scene_id, std::vector<TFFramePair> &frames, std::vector<std::string> &joint_names)
 {
   BOOST_FOREACH(shared_ptr<Camera> cam, static_cameras_)
     {
-      ROS_ERROR("pushing static camera %s",cam->camera_name_.c_str());
-      cam->pushTransform();
+      cam->getTransformInterface()->getTFFrames(frames);
+      cam->getTransformInterface()->getMutableJoints(joint_names);
     }
   BOOST_FOREACH(shared_ptr<MovingCamera> mcam, moving_cameras_)
     {
-      ROS_ERROR("pushing moving camera %s",mcam->cam->camera_name_.c_str());
-      Pose6d pose;
-      pose.setAngleAxis(mcam->cam->camera_parameters_.angle_axis[0], 
-			mcam->cam->camera_parameters_.angle_axis[1], 
-			mcam->cam->camera_parameters_.angle_axis[2]);
-      pose.setOrigin(mcam->cam->camera_parameters_.position[0],
-		     mcam->cam->camera_parameters_.position[1],
-		     mcam->cam->camera_parameters_.position[2]);
-      pose.show("moving camera");
-      mcam->cam->pushTransform();
+      if(mcam->scene_id == scene_id){
+	mcam->cam->getTransformInterface()->getTFFrames(frames);
+	mcam->cam->getTransformInterface()->getMutableJoints(joint_names);
+      }
     }
   BOOST_FOREACH(shared_ptr<Target> targ, static_targets_)
     {
-      ROS_ERROR("pushing static target %s",targ->target_name_.c_str());
-      targ->pushTransform();
+      targ->getTransformInterface()->getTFFrames(frames);
+      targ->getTransformInterface()->getMutableJoints(joint_names);
     }
   BOOST_FOREACH(shared_ptr<MovingTarget> mtarg, moving_targets_)
     {
-      ROS_ERROR("pushing moving target %s from scene %d",mtarg->targ_->target_name_.c_str(), mtarg->scene_id_);
-      mtarg->targ_->pushTransform();
+      if(mtarg->scene_id_ == scene_id){
+	mtarg->targ_->getTransformInterface()->getTFFrames(frames);
+	mtarg->targ_->getTransformInterface()->getMutableJoints(joint_names);
+      }
     }
-
 }
-void CeresBlocks::pullTransforms(int scene_id)
+
+bool CeresBlocks::pullTransforms(int scene_id, const ros::Time &stamp)
 {
+  // the frames of every interface pulled below are fetched from tf together, at one time stamp,
+  // and their mutable joints from the mutable joint state publisher in one transaction
+  std::vector<TFFramePair> frames;
+  std::vector<std::string> joint_names;
+  getTFFrames(scene_id, frames, joint_names);
+  ScopedTransformBatch batch(frames, stamp);
+  if(!batch.ok()){
+    ROS_ERROR("the transforms of scene %d are not available at %.3lf", scene_id, stamp.toSec());
+    return(false);
+  }
+  ScopedMutableJointRead joints(joint_names);
+  int failures = SharedTransformListener::instance().failures();
+
   BOOST_FOREACH(shared_ptr<Camera> cam, static_cameras_)
     {
       cam->pullTransform();
@@ -513,6 +616,7 @@ void CeresBlocks::pullTransforms(int scene_id)
 	mtarg->targ_->pullTransform();
       }
     }
+  return(SharedTransformListener::instance().failures() == failures); // lookups of frames outside the batch
 }
 void CeresBlocks::setReferenceFrame(std::string ref_frame)
 {
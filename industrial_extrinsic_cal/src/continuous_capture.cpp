@@ -0,0 +1,243 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <industrial_extrinsic_cal/continuous_capture.h>
+#include <industrial_extrinsic_cal/phase_timer.h>
+#include <cv_bridge/cv_bridge.h>
+#include <opencv2/calib3d/calib3d.hpp>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <math.h>
+
+namespace industrial_extrinsic_cal
+{
+  namespace
+  {
+    bool earlierFrame(const CapturedFrame &a, const CapturedFrame &b)
+    {
+      return(a.stamp < b.stamp);
+    }
+  }
+
+  ContinuousCaptureParameters defaultContinuousCaptureParameters()
+  {
+    ContinuousCaptureParameters parameters;
+    parameters.num_threads = boost::thread::hardware_concurrency();
+    if(parameters.num_threads < 1) parameters.num_threads = 1;
+    parameters.queue_size = 8;
+    parameters.selection = defaultPoseDiversityParameters();
+    return(parameters);
+  }
+
+  ContinuousCapture::ContinuousCapture(boost::shared_ptr<Camera> camera, const ContinuousCaptureParameters &parameters) :
+    camera_(camera), parameters_(parameters), check_frames_(false), running_(false), stopping_(false), received_(0),
+    dropped_(0), unposed_(0)
+  {
+    if(parameters_.num_threads < 1) parameters_.num_threads = 1;
+    if(parameters_.queue_size < 1) parameters_.queue_size = 1;
+    nh_.setCallbackQueue(&callback_queue_);
+  }
+
+  ContinuousCapture::~ContinuousCapture()
+  {
+    stop();
+  }
+
+  bool ContinuousCapture::start()
+  {
+    if(running_) return(true);
+    observer_ = boost::dynamic_pointer_cast<ROSCameraObserver>(camera_->camera_observer_);
+    if(!observer_){
+      ROS_ERROR("camera %s can not capture continuously, its observer is not a ROSCameraObserver",
+		camera_->camera_name_.c_str());
+      return(false);
+    }
+    check_frames_ = frameChecksEnabled(observer_->getFrameQualityParameters());
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      waiting_.clear();
+      frames_.clear();
+      stopping_ = false;
+      received_ = 0;
+      dropped_ = 0;
+      unposed_ = 0;
+    }
+    for(int i=0; i<parameters_.num_threads; i++){
+      workers_.create_thread(boost::bind(&ContinuousCapture::worker, this));
+    }
+    image_sub_ = nh_.subscribe(observer_->getImageTopic(), parameters_.queue_size, &ContinuousCapture::imageCallback, this);
+    spinner_ = boost::make_shared<ros::AsyncSpinner>(1, &callback_queue_);
+    spinner_->start();
+    running_ = true;
+    ROS_INFO("continuous capture of %s started on %s with %d workers", camera_->camera_name_.c_str(),
+	     observer_->getImageTopic().c_str(), parameters_.num_threads);
+    return(true);
+  }
+
+  void ContinuousCapture::stop()
+  {
+    if(!running_) return;
+    spinner_->stop();
+    image_sub_.shutdown();
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      stopping_ = true;
+    }
+    image_ready_.notify_all();
+    workers_.join_all();
+    running_ = false;
+
+    int received, detected, dropped;
+    counts(received, detected, dropped);
+    ROS_INFO("continuous capture of %s stopped: %d images, target found in %d, %d dropped, %d without poses",
+	     camera_->camera_name_.c_str(), received, detected, dropped, unposed_);
+  }
+
+  void ContinuousCapture::imageCallback(const sensor_msgs::ImageConstPtr &image)
+  {
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      received_++;
+      // the workers fell behind, the robot has barely moved since the images already waiting
+      if((int)waiting_.size() >= parameters_.queue_size){
+	dropped_++;
+	return;
+      }
+      waiting_.push_back(image);
+    }
+    image_ready_.notify_one();
+  }
+
+  void ContinuousCapture::worker()
+  {
+    while(true){
+      sensor_msgs::ImageConstPtr image;
+      {
+	boost::mutex::scoped_lock lock(mutex_);
+	while(waiting_.empty() && !stopping_) image_ready_.wait(lock);
+	if(waiting_.empty()) return;
+	image = waiting_.front();
+	waiting_.pop_front();
+      }
+
+      CAL_PHASE_TIMER("ContinuousCapture::detect");
+      cv_bridge::CvImageConstPtr bridge;
+      try{
+	bridge = cv_bridge::toCvShare(image, "mono8");
+      }
+      catch (cv_bridge::Exception& ex){
+	ROS_ERROR("continuous capture of %s could not convert an image: %s", camera_->camera_name_.c_str(), ex.what());
+	continue;
+      }
+
+      // a frame blurred by the motion is skipped before the search, the next one is only a few ms away
+      FrameQuality quality;
+      if(check_frames_ && !observer_->checkFrame(bridge->image, quality)) continue;
+
+      CapturedFrame frame;
+      frame.stamp = image->header.stamp;
+      if(!observer_->detect(bridge->image, frame.observations)) continue;
+      if(!estimatePose(frame.observations, frame.candidate)) continue;
+
+      // the scenes are built after the trajectory, by then an early stamp may have left the tf buffer
+      if(!tf_frames_.empty() && !SharedTransformListener::instance().snapshot(tf_frames_, frame.stamp)){
+	boost::mutex::scoped_lock lock(mutex_);
+	unposed_++;
+	continue;
+      }
+
+      boost::mutex::scoped_lock lock(mutex_);
+      frames_.push_back(frame);
+    }
+  }
+
+  bool ContinuousCapture::estimatePose(const CameraObservations &observations, FrameCandidate &candidate) const
+  {
+    std::vector<cv::Point3f> object_points;
+    std::vector<cv::Point2f> image_points;
+    for(int i=0; i<(int)observations.size(); i++){
+      const Observation &obs = observations[i];
+      if(obs.point_id < 0 || obs.point_id >= (int)obs.target->pts_.size()) return(false);
+      const Point3d &p = obs.target->pts_[obs.point_id];
+      object_points.push_back(cv::Point3f(p.x, p.y, p.z));
+      image_points.push_back(cv::Point2f(obs.image_loc_x, obs.image_loc_y));
+    }
+    if(object_points.size() < 4) return(false);
+
+    // opencv orders the distortion k1 k2 p1 p2 k3
+    const CameraParameters &cp = camera_->camera_parameters_;
+    cv::Mat camera_matrix(3, 3, CV_64F, cv::Scalar(0));
+    camera_matrix.at<double>(0, 0) = cp.focal_length_x;
+    camera_matrix.at<double>(1, 1) = cp.focal_length_y;
+    camera_matrix.at<double>(0, 2) = cp.center_x;
+    camera_matrix.at<double>(1, 2) = cp.center_y;
+    camera_matrix.at<double>(2, 2) = 1.0;
+    cv::Mat distortion(1, 5, CV_64F, cv::Scalar(0));
+    distortion.at<double>(0, 0) = cp.distortion_k1;
+    distortion.at<double>(0, 1) = cp.distortion_k2;
+    distortion.at<double>(0, 2) = cp.distortion_p1;
+    distortion.at<double>(0, 3) = cp.distortion_p2;
+    distortion.at<double>(0, 4) = cp.distortion_k3;
+
+    cv::Mat rvec, tvec;
+    if(!cv::solvePnP(object_points, image_points, camera_matrix, distortion, rvec, tvec)) return(false);
+
+    std::vector<cv::Point2f> projected;
+    cv::projectPoints(object_points, rvec, tvec, camera_matrix, distortion, projected);
+    if(projected.size() != image_points.size()) return(false);
+    double sum_squares = 0.0;
+    for(int i=0; i<(int)projected.size(); i++){
+      double dx = projected[i].x - image_points[i].x;
+      double dy = projected[i].y - image_points[i].y;
+      sum_squares += dx*dx + dy*dy;
+    }
+    double rms = sqrt(sum_squares/projected.size());
+
+    candidate.pose = Pose6d(tvec.at<double>(0, 0), tvec.at<double>(1, 0), tvec.at<double>(2, 0),
+			    rvec.at<double>(0, 0), rvec.at<double>(1, 0), rvec.at<double>(2, 0));
+    candidate.quality = 1.0/(1.0 + rms);
+    return(true);
+  }
+
+  std::vector<CapturedFrame> ContinuousCapture::selectFrames() const
+  {
+    std::vector<CapturedFrame> frames;
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      frames = frames_;
+    }
+    std::vector<FrameCandidate> candidates;
+    for(int i=0; i<(int)frames.size(); i++) candidates.push_back(frames[i].candidate);
+    std::vector<int> chosen = selectDiverseFrames(candidates, parameters_.selection);
+
+    // the workers finish out of order, the frames are returned in time order
+    std::vector<CapturedFrame> selected;
+    for(int i=0; i<(int)chosen.size(); i++) selected.push_back(frames[chosen[i]]);
+    std::sort(selected.begin(), selected.end(), earlierFrame);
+    return(selected);
+  }
+
+  void ContinuousCapture::counts(int &received, int &detected, int &dropped) const
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    received = received_;
+    detected = (int)frames_.size();
+    dropped = dropped_;
+  }
+
+}//end namespace industrial_extrinsic_cal
@@ -0,0 +1,99 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <industrial_extrinsic_cal/drift_monitor.h>
+#include <industrial_extrinsic_cal/phase_timer.h>
+#include <boost/foreach.hpp>
+#include <set>
+#include <stdio.h>
+
+namespace industrial_extrinsic_cal
+{
+  DriftParameters defaultDriftParameters()
+  {
+    DriftParameters parameters;
+    parameters.threshold = 2.0;
+    parameters.consecutive = 3;
+    parameters.min_observations = 4;
+    parameters.max_observations = 200;
+    return(parameters);
+  }
+
+  DriftMonitor::DriftMonitor(const DriftParameters &parameters) :
+    parameters_(parameters)
+  {
+  }
+
+  bool DriftMonitor::update(const ObservationDataPointList &observations, const std::vector<P_BLOCK> &known_target_blocks)
+  {
+    CAL_PHASE_TIMER("DriftMonitor::update");
+    std::set<P_BLOCK> known_targets(known_target_blocks.begin(), known_target_blocks.end());
+    std::map<std::string, ReprojectionStatistics> statistics;
+    std::vector<P_BLOCK> blocks;
+    double residuals[RESIDUALS_PER_OBSERVATION];
+    bool ok = true;
+    BOOST_FOREACH(const ObservationDataPoint &ODP, observations.items_){
+      if(known_targets.find(ODP.target_pose_) == known_targets.end()) continue;
+      if(statistics.find(ODP.camera_name_) == statistics.end()) statistics[ODP.camera_name_] = QualityReport::emptyStatistics();
+      ReprojectionStatistics &s = statistics[ODP.camera_name_];
+      if(parameters_.max_observations > 0 && s.num_observations >= parameters_.max_observations) continue;
+
+      // the stored calibration is evaluated as it is, nothing is estimated
+      ceres::CostFunction *cost = createObservationCost(ODP, ODP.camera_extrinsics_, ODP.camera_intrinsics_,
+							ODP.target_pose_, ODP.point_position_, blocks);
+      if(cost == NULL || cost->num_residuals() != RESIDUALS_PER_OBSERVATION){
+	fprintf(stderr, "DriftMonitor: no reprojection cost for cost type %d\n", ODP.cost_type_);
+	delete cost;
+	ok = false;
+	continue;
+      }
+      bool evaluated = cost->Evaluate(&blocks[0], residuals, NULL);
+      delete cost;
+      if(!evaluated){
+	ok = false;
+	continue;
+      }
+      QualityReport::accumulate(s, residuals);
+    }
+
+    std::map<std::string, ReprojectionStatistics>::const_iterator it;
+    for(it = statistics.begin(); it != statistics.end(); ++it){
+      if(it->second.num_observations < parameters_.min_observations) continue;
+      CameraDrift &camera = cameras_[it->first];
+      camera.last = it->second;
+      if(QualityReport::rms(it->second) > parameters_.threshold){
+	camera.above_threshold++;
+      }
+      else{
+	camera.above_threshold = 0;
+      }
+      camera.drifted = camera.above_threshold >= parameters_.consecutive;
+    }
+    return(ok);
+  }
+
+  bool DriftMonitor::drifted() const
+  {
+    std::map<std::string, CameraDrift>::const_iterator it;
+    for(it = cameras_.begin(); it != cameras_.end(); ++it){
+      if(it->second.drifted) return(true);
+    }
+    return(false);
+  }
+
+}//end namespace industrial_extrinsic_cal
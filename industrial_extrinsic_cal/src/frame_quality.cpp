@@ -0,0 +1,110 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <industrial_extrinsic_cal/frame_quality.h>
+#include <industrial_extrinsic_cal/observation_data_point.h>
+#include <industrial_extrinsic_cal/phase_timer.h>
+#include <math.h>
+#include <string>
+
+namespace industrial_extrinsic_cal
+{
+
+  FrameQualityParameters defaultFrameQualityParameters()
+  {
+    FrameQualityParameters parameters;
+    parameters.min_focus = 0.0;
+    parameters.saturation_level = 250;
+    parameters.max_saturated_fraction = 1.0;
+    parameters.max_viewing_angle = 0.0;
+    parameters.max_regrabs = 2;
+    parameters.stride = 2;
+    return(parameters);
+  }
+
+  bool frameChecksEnabled(const FrameQualityParameters &parameters)
+  {
+    return(parameters.min_focus > 0.0 || parameters.max_saturated_fraction < 1.0);
+  }
+
+  bool checkFrameQuality(const cv::Mat &image, const FrameQualityParameters &parameters, FrameQuality &quality)
+  {
+    CAL_PHASE_TIMER("checkFrameQuality");
+    quality.focus = 0.0;
+    quality.saturated_fraction = 0.0;
+    quality.failure = NULL;
+    if(image.type() != CV_8UC1 || image.rows < 3 || image.cols < 3) return(true);
+
+    // the 4 neighbour Laplacian of every sampled pixel, blur flattens it, glare saturates the center
+    int stride = parameters.stride > 0 ? parameters.stride : 1;
+    double sum = 0.0;
+    double sum_squares = 0.0;
+    int num_samples = 0;
+    int num_saturated = 0;
+    for(int r=1; r<image.rows-1; r+=stride){
+      const unsigned char *above = image.ptr<unsigned char>(r-1);
+      const unsigned char *row = image.ptr<unsigned char>(r);
+      const unsigned char *below = image.ptr<unsigned char>(r+1);
+      for(int c=1; c<image.cols-1; c+=stride){
+	int laplacian = 4*row[c] - row[c-1] - row[c+1] - above[c] - below[c];
+	sum += laplacian;
+	sum_squares += (double)laplacian*laplacian;
+	if(row[c] >= parameters.saturation_level) num_saturated++;
+	num_samples++;
+      }
+    }
+    if(num_samples == 0) return(true);
+    double mean = sum/num_samples;
+    quality.focus = sum_squares/num_samples - mean*mean;
+    quality.saturated_fraction = (double)num_saturated/num_samples;
+
+    if(parameters.min_focus > 0.0 && quality.focus < parameters.min_focus){
+      quality.failure = "blurred";
+    }
+    else if(quality.saturated_fraction > parameters.max_saturated_fraction){
+      quality.failure = "saturated";
+    }
+    return(quality.failure == NULL);
+  }
+
+  bool predictTargetInCamera(Cost_function cost_type, const double *extrinsics, const double *target_pose,
+			     const Pose6d &intermediate_frame, Pose6d &target_in_camera)
+  {
+    // without a target the points are in reference coordinates, there is no target normal to predict
+    CostChain chain;
+    if(!costChain(cost_type, chain) || !chain.target_present) return(false);
+
+    Pose6d pose(extrinsics[3], extrinsics[4], extrinsics[5], extrinsics[0], extrinsics[1], extrinsics[2]);
+    if(chain.camera_on_link) pose = pose * intermediate_frame.getInverse();
+    if(chain.target_on_link) pose = pose * intermediate_frame;
+    target_in_camera = pose * Pose6d(target_pose[3], target_pose[4], target_pose[5],
+				     target_pose[0], target_pose[1], target_pose[2]);
+    return(true);
+  }
+
+  double viewingAngle(const Pose6d &target_in_camera)
+  {
+    double distance = sqrt(target_in_camera.x*target_in_camera.x + target_in_camera.y*target_in_camera.y +
+			   target_in_camera.z*target_in_camera.z);
+    if(distance < 1e-9) return(-1.0);
+    RotationMatrix R = target_in_camera.getBasis();
+    double cosine = (R[0][2]*target_in_camera.x + R[1][2]*target_in_camera.y + R[2][2]*target_in_camera.z)/distance;
+    return(acos(fabs(cosine) > 1.0 ? 1.0 : fabs(cosine)));
+  }
+
+}//end namespace industrial_extrinsic_cal
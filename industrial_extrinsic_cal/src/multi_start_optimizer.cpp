@@ -0,0 +1,193 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <industrial_extrinsic_cal/multi_start_optimizer.h>
+#include <industrial_extrinsic_cal/phase_timer.h>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <algorithm>
+#include <set>
+
+namespace industrial_extrinsic_cal
+{
+
+  MultiStartParameters defaultMultiStartParameters()
+  {
+    MultiStartParameters parameters;
+    parameters.num_starts = 1;
+    parameters.num_threads = boost::thread::hardware_concurrency();
+    if(parameters.num_threads < 1) parameters.num_threads = 1;
+    parameters.rotation_noise = 0.1;
+    parameters.translation_noise = 0.05;
+    parameters.seed = 1;
+    return(parameters);
+  }
+
+  ParameterBlockCopies::ParameterBlockCopies(double rotation_noise, double translation_noise, unsigned int seed) :
+    rotation_noise_(rotation_noise), translation_noise_(translation_noise), rng_(seed)
+  {
+  }
+
+  P_BLOCK ParameterBlockCopies::extrinsics(const P_BLOCK original)
+  {
+    return(getCopy(original, 6, true));
+  }
+
+  P_BLOCK ParameterBlockCopies::intrinsics(const P_BLOCK original)
+  {
+    return(getCopy(original, 9, false));
+  }
+
+  P_BLOCK ParameterBlockCopies::targetPose(const P_BLOCK original)
+  {
+    return(getCopy(original, 6, true));
+  }
+
+  P_BLOCK ParameterBlockCopies::point(const P_BLOCK original)
+  {
+    return(getCopy(original, 3, false));
+  }
+
+  P_BLOCK ParameterBlockCopies::getCopy(const P_BLOCK original, int size, bool perturb)
+  {
+    std::map<P_BLOCK, std::vector<double> >::iterator it = copies_.find(original);
+    if(it != copies_.end()){
+      return(&(it->second[0]));
+    }
+    std::vector<double> & copy = copies_[original];
+    copy.assign(original, original+size);
+
+    // pose blocks are angle axis followed by position
+    if(perturb){
+      boost::normal_distribution<double> unit_normal(0.0, 1.0);
+      boost::variate_generator<boost::mt19937&, boost::normal_distribution<double> > noise(rng_, unit_normal);
+      for(int i=0; i<3; i++) copy[i] += rotation_noise_*noise();
+      for(int i=3; i<6; i++) copy[i] += translation_noise_*noise();
+    }
+    return(&copy[0]);
+  }
+
+  P_BLOCK ParameterBlockCopies::unperturbed(const P_BLOCK original)
+  {
+    std::map<P_BLOCK, std::vector<double> >::iterator it = copies_.find(original);
+    if(it == copies_.end()) return(NULL);
+    std::copy(original, original + it->second.size(), it->second.begin());
+    return(&(it->second[0]));
+  }
+
+  void ParameterBlockCopies::keepOnly(const std::vector<double*> &problem_blocks)
+  {
+    std::set<double*> used(problem_blocks.begin(), problem_blocks.end());
+    std::map<P_BLOCK, std::vector<double> >::iterator it = copies_.begin();
+    while(it != copies_.end()){
+      if(used.find(&(it->second[0])) == used.end()){
+	copies_.erase(it++);
+      }
+      else{
+	++it;
+      }
+    }
+  }
+
+  void ParameterBlockCopies::copyBack()
+  {
+    for(std::map<P_BLOCK, std::vector<double> >::iterator it=copies_.begin(); it!=copies_.end(); ++it){
+      std::copy(it->second.begin(), it->second.end(), it->first);
+    }
+  }
+
+  MultiStartOptimizer::MultiStartOptimizer(const MultiStartParameters &parameters) :
+    parameters_(parameters), best_start_(-1), next_start_(0)
+  {
+  }
+
+  bool MultiStartOptimizer::solve(ProblemBuilder builder, const ceres::Solver::Options &options, double &best_cost)
+  {
+    int num_starts = parameters_.num_starts < 1 ? 1 : parameters_.num_starts;
+    int num_threads = parameters_.num_threads < 1 ? 1 : parameters_.num_threads;
+    if(num_threads > num_starts) num_threads = num_starts;
+
+    // start 0 is the unperturbed initial condition, so multi-start never does worse than a single solve
+    starts_.clear();
+    starts_.push_back(ParameterBlockCopies(0.0, 0.0, parameters_.seed));
+    for(int i=1; i<num_starts; i++){
+      starts_.push_back(ParameterBlockCopies(parameters_.rotation_noise, parameters_.translation_noise,
+					     parameters_.seed + i));
+    }
+    StartSummary unsolved = {0.0, 0.0, 0, false};
+    summaries_.assign(num_starts, unsolved);
+    best_start_ = -1;
+    next_start_ = 0;
+
+    boost::thread_group workers;
+    for(int i=0; i<num_threads; i++){
+      workers.create_thread(boost::bind(&MultiStartOptimizer::solveStarts, this, builder, options));
+    }
+    workers.join_all();
+
+    // the caller reports the outcome of each start from startSummaries()
+    for(int i=0; i<num_starts; i++){
+      if(!summaries_[i].usable) continue;
+      if(best_start_ < 0 || summaries_[i].final_cost < summaries_[best_start_].final_cost){
+	best_start_ = i;
+      }
+    }
+    if(best_start_ < 0) return(false);
+
+    starts_[best_start_].copyBack();
+    best_cost = summaries_[best_start_].final_cost;
+    return(true);
+  }
+
+  void MultiStartOptimizer::solveStarts(ProblemBuilder builder, const ceres::Solver::Options &options)
+  {
+    // starts run side by side, so each solve is kept single threaded and quiet
+    ceres::Solver::Options start_options = options;
+    start_options.num_threads = 1;
+    start_options.minimizer_progress_to_stdout = false;
+
+    while(true){
+      int start;
+      {
+	boost::mutex::scoped_lock lock(mutex_);
+	if(next_start_ >= (int) starts_.size()) return;
+	start = next_start_++;
+      }
+
+      ceres::Problem problem;
+      builder(problem, &starts_[start]);
+      std::vector<double*> problem_blocks;
+      problem.GetParameterBlocks(&problem_blocks);
+      starts_[start].keepOnly(problem_blocks);
+      ceres::Solver::Summary summary;
+      {
+	CAL_PHASE_TIMER("ceres::Solve");
+	ceres::Solve(start_options, &problem, &summary);
+      }
+
+      boost::mutex::scoped_lock lock(mutex_);
+      summaries_[start].initial_cost = summary.initial_cost;
+      summaries_[start].final_cost = summary.final_cost;
+      summaries_[start].iterations = (int) summary.iterations.size();
+      summaries_[start].usable = summary.IsSolutionUsable();
+    }
+  }
+
+}//end namespace industrial_extrinsic_cal
@@ -0,0 +1,160 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Solves an observation dataset written by a calibration job, without ROS or a roscore.
+ *
+ * usage: batch_solver input_dataset output_dataset [--starts N] [--threads T] [--trace file]
+ *                     [--loss none|huber|cauchy] [--loss_scale pixels] [--trim_rounds N] [--chi_square threshold]
+ *                     [--quality file] [--linear_solver DENSE_SCHUR|SPARSE_SCHUR|ITERATIVE_SCHUR|...]
+ *
+ * The output dataset holds the same observations with the solved parameter blocks.
+ * The optional quality file holds the reprojection errors and the covariance of the camera extrinsics.
+ */
+
+#include <industrial_extrinsic_cal/observation_dataset.h>
+#include <industrial_extrinsic_cal/multi_start_optimizer.h>
+#include <industrial_extrinsic_cal/phase_timer.h>
+#include <industrial_extrinsic_cal/rotation_cache.h>
+#include <industrial_extrinsic_cal/robust_loss.h>
+#include <industrial_extrinsic_cal/outlier_trimmer.h>
+#include <industrial_extrinsic_cal/quality_report.h>
+#include <boost/bind.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+using namespace industrial_extrinsic_cal;
+
+namespace
+{
+  void usage(const char *program)
+  {
+    fprintf(stderr, "usage: %s input_dataset output_dataset [--starts N] [--threads T] [--trace file]\n"
+	    "          [--loss none|huber|cauchy] [--loss_scale pixels] [--trim_rounds N] [--chi_square threshold]\n"
+	    "          [--quality file] [--linear_solver name]\n",
+	    program);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  if(argc < 3){
+    usage(argv[0]);
+    return(1);
+  }
+  std::string input_file(argv[1]);
+  std::string output_file(argv[2]);
+  std::string trace_file;
+  std::string quality_file;
+  ceres::LinearSolverType linear_solver_type = ceres::DENSE_SCHUR;
+  MultiStartParameters multi_start = defaultMultiStartParameters();
+  OutlierTrimParameters trim = defaultOutlierTrimParameters();
+  RobustLoss loss;
+  loss.type = loss_functions::NoLoss;
+  loss.scale = 1.0;
+  for(int i=3; i<argc; i++){
+    if(i+1 >= argc){ usage(argv[0]); return(1); }
+    std::string key(argv[i]);
+    const char *value = argv[++i];
+    if(key == "--starts") multi_start.num_starts = atoi(value);
+    else if(key == "--threads") multi_start.num_threads = atoi(value);
+    else if(key == "--trace") trace_file = value;
+    else if(key == "--loss"){
+      std::string loss_name(value);
+      loss.type = string2LossType(loss_name);
+      if(loss.type == loss_functions::NullLossType){ usage(argv[0]); return(1); }
+    }
+    else if(key == "--loss_scale") loss.scale = atof(value);
+    else if(key == "--trim_rounds") trim.max_rounds = atoi(value);
+    else if(key == "--chi_square") trim.chi_square_threshold = atof(value);
+    else if(key == "--quality") quality_file = value;
+    else if(key == "--linear_solver"){
+      if(!ceres::StringToLinearSolverType(value, &linear_solver_type)){ usage(argv[0]); return(1); }
+    }
+    else { usage(argv[0]); return(1); }
+  }
+  if(!trace_file.empty()) PhaseTracer::instance().enable(true);
+
+  ObservationDataset dataset;
+  {
+    CAL_PHASE_TIMER("ObservationDataset::read");
+    if(!dataset.read(input_file)) return(1);
+  }
+  RobustLossTable losses;
+  losses.setDefault(loss);
+  dataset.setRobustLosses(losses);
+  printf("%s: %d parameter blocks, %d observations\n", input_file.c_str(),
+	 (int)dataset.blocks().size(), (int)dataset.observations().items_.size());
+
+  ceres::Solver::Options options;
+  options.linear_solver_type = linear_solver_type;
+  options.minimizer_progress_to_stdout = true;
+  options.max_num_iterations = 1000;
+
+  bool solved = true;
+  if(multi_start.num_starts > 1){
+    MultiStartOptimizer optimizer(multi_start);
+    double best_cost;
+    solved = optimizer.solve(boost::bind(&ObservationDataset::addToProblem, &dataset, _1, _2,
+					 (RotationCache*)NULL, (std::vector<ObservationResidual>*)NULL),
+			     options, best_cost);
+    const std::vector<StartSummary> &starts = optimizer.startSummaries();
+    for(int i=0; i<(int)starts.size(); i++){
+      printf("Start %d: initial cost %lf final cost %lf after %d iterations%s\n", i, starts[i].initial_cost,
+	     starts[i].final_cost, starts[i].iterations, starts[i].usable ? "" : ", not usable");
+    }
+    if(solved) printf("Start %d has the lowest final cost %lf\n", optimizer.bestStart(), best_cost);
+    else fprintf(stderr, "None of the %d starts produced a usable solution\n", (int)starts.size());
+  }
+  // a single start, or trimming or measuring the best of several
+  if(solved && (multi_start.num_starts <= 1 || trim.max_rounds > 0 || !quality_file.empty())){
+    ceres::Problem problem(trimProblemOptions());
+    RotationCache rotation_cache;
+    std::vector<ObservationResidual> residuals;
+    dataset.addToProblem(problem, NULL, &rotation_cache, &residuals);
+    SchurOrdering ordering;
+    dataset.addSchurEliminationBlocks(ordering);
+    int num_eliminated = ordering.apply(problem, options);
+    if(num_eliminated > 0) printf("Schur ordering eliminates %d parameter blocks\n", num_eliminated);
+    rotation_cache.attach(options);
+    ceres::Solver::Summary summary;
+    OutlierTrimmer trimmer(trim);
+    solved = trimmer.solve(problem, residuals, options, summary);
+    printf("%s\n", summary.BriefReport().c_str());
+    if(trimmer.trimmed().size() > 0) printf("%s", trimmer.report().c_str());
+    if(solved && !quality_file.empty()){
+      QualityParameters quality_parameters = defaultQualityParameters();
+      quality_parameters.pixel_sigma = trim.pixel_sigma;
+      QualityReport quality(quality_parameters);
+      quality.addExtrinsics(dataset.observations());
+      if(!quality.compute(problem, residuals) || !quality.write(quality_file)) return(1);
+      printf("%s", quality.summary().c_str());
+    }
+  }
+  if(!solved){
+    fprintf(stderr, "no usable solution for %s\n", input_file.c_str());
+    return(1);
+  }
+
+  if(!dataset.write(output_file)) return(1);
+  if(!trace_file.empty()){
+    printf("%s", PhaseTracer::instance().summary().c_str());
+    PhaseTracer::instance().writeChromeTrace(trace_file);
+  }
+  return(0);
+}
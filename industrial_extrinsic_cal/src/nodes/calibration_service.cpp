@@ -35,6 +35,7 @@ public:
     std::string caljob_file;
     std::string ros_package_name;
     std::string launch_file_name;
+    std::string trace_file_name;
     std::string yaml_file_path = ros::package::getPath("industrial_extrinsic_cal") + "/yaml/";
     priv_nh.getParam("yaml_file_path", yaml_file_path);
     priv_nh.getParam("camera_file", camera_file);
@@ -42,6 +43,9 @@ public:
     priv_nh.getParam("cal_job_file", caljob_file);
     priv_nh.getParam("store_results_package_name", ros_package_name);
     priv_nh.getParam("store_results_file_name", launch_file_name);
+    priv_nh.getParam("trace_file", trace_file_name);
+    priv_nh.getParam("dataset_file", dataset_file_name_);
+    priv_nh.getParam("incremental_scenes", incremental_scenes_);
 
     ROS_INFO("yaml_file_path: %s",yaml_file_path.c_str());
     ROS_INFO("camera_file: %s",camera_file.c_str());
@@ -53,6 +57,13 @@ public:
     cal_job_ = new industrial_extrinsic_cal::CalibrationJob(yaml_file_path + camera_file,
 							    yaml_file_path +  target_file,
 							    yaml_file_path + caljob_file);
+
+    // phase timing is off unless a trace file is requested
+    if(!trace_file_name.empty())
+      {
+	ROS_INFO("trace_file: %s",trace_file_name.c_str());
+	cal_job_->enableTracing(trace_file_name);
+      }
   
     if (cal_job_->load())
       {
@@ -66,10 +77,13 @@ public:
     delete( cal_job_);
   }
   bool callback(std_srvs::Empty::Request& request, std_srvs::Empty::Response& response);
+  bool incrementalCallback(std_srvs::Empty::Request& request, std_srvs::Empty::Response& response);
   bool is_calibrated(){return(calibrated_);};
 private:
   ros::NodeHandle nh_;
   bool calibrated_;
+  std::string dataset_file_name_;
+  std::vector<int> incremental_scenes_;
   industrial_extrinsic_cal::CalibrationJob * cal_job_;
 };
 
@@ -93,6 +107,12 @@ bool CalibrationServiceNode::callback(std_srvs::Empty::Request& request, std_srv
       return(false);
     }
   
+  // Keep the observations so the job can be solved again offline
+  if (!dataset_file_name_.empty())
+    {
+      cal_job_->saveObservationDataset(dataset_file_name_);
+    }
+
   // Show Results
   cal_job_->show();
   
@@ -105,6 +125,32 @@ bool CalibrationServiceNode::callback(std_srvs::Empty::Request& request, std_srv
   return true;
 }
 
+bool CalibrationServiceNode::incrementalCallback(std_srvs::Empty::Request& request, std_srvs::Empty::Response& response)
+{
+  if (!calibrated_)
+    {
+      ROS_ERROR("incremental calibration needs a full calibration first");
+      return(false);
+    }
+  if (incremental_scenes_.empty())
+    {
+      ROS_ERROR("no incremental_scenes configured");
+      return(false);
+    }
+
+  // the scenes are captured right away, the cell is between production cycles
+  if (!cal_job_->runIncremental(incremental_scenes_, false))
+    {
+      ROS_INFO_STREAM("Incremental calibration failed");
+      return(false);
+    }
+  if (!cal_job_->store())
+    {
+      ROS_INFO_STREAM(" Trouble storing calibration job optimization results ");
+    }
+  return true;
+}
+
 int main(int argc, char **argv)
 {
   ros::init(argc, argv, "calibration_service_node");
@@ -112,6 +158,9 @@ int main(int argc, char **argv)
   CalibrationServiceNode cal_service_node(nh);
 
   ros::ServiceServer service=nh.advertiseService("calibration_service", &CalibrationServiceNode::callback, &cal_service_node);
+  ros::ServiceServer incremental_service=nh.advertiseService("incremental_calibration_service",
+							     &CalibrationServiceNode::incrementalCallback,
+							     &cal_service_node);
 
   ros::spin();
     
@@ -0,0 +1,195 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <std_srvs/Empty.h>
+#include <ros/ros.h>
+#include <ros/package.h>
+#include <industrial_extrinsic_cal/calibration_job_definition.h>
+#include <industrial_extrinsic_cal/drift_monitor.h>
+#include <industrial_extrinsic_cal/CalibrationDrift.h>
+
+using industrial_extrinsic_cal::CalibrationJob;
+using industrial_extrinsic_cal::DriftMonitor;
+using industrial_extrinsic_cal::DriftParameters;
+using industrial_extrinsic_cal::ObservationDataPointList;
+
+/* Periodically observes one scene of a calibrated job, compares the observations with the stored calibration
+ * and publishes the reprojection error of each camera. When a camera drifts the re-calibration service is called.
+ * Only the residuals are evaluated, there is no solve, and the rate is low so the node uses little CPU.
+ * The job is loaded with listeners only, the calibration is read from tf where the calibration's publisher puts it.
+ */
+class DriftMonitorNode
+{
+public:
+  explicit DriftMonitorNode(const ros::NodeHandle& nh):
+    nh_(nh), monitor_(industrial_extrinsic_cal::defaultDriftParameters())
+  {
+    ros::NodeHandle priv_nh("~");
+    yaml_file_path_ = ros::package::getPath("industrial_extrinsic_cal") + "/yaml/";
+    priv_nh.getParam("yaml_file_path", yaml_file_path_);
+    priv_nh.getParam("camera_file", camera_file_);
+    priv_nh.getParam("target_file", target_file_);
+    priv_nh.getParam("cal_job_file", caljob_file_);
+
+    scene_id_ = 0;
+    double rate = 0.2;
+    cooldown_ = 60.0;
+    recalibrate_service_ = "calibration_service";
+    DriftParameters parameters = industrial_extrinsic_cal::defaultDriftParameters();
+    priv_nh.getParam("scene_id", scene_id_);
+    priv_nh.getParam("rate", rate);
+    priv_nh.getParam("threshold", parameters.threshold);
+    priv_nh.getParam("consecutive", parameters.consecutive);
+    priv_nh.getParam("min_observations", parameters.min_observations);
+    priv_nh.getParam("max_observations", parameters.max_observations);
+    priv_nh.getParam("recalibrate_service", recalibrate_service_);
+    priv_nh.getParam("cooldown", cooldown_);
+    monitor_ = DriftMonitor(parameters);
+    if (rate <= 0.0)
+      {
+	ROS_WARN("rate %.2f is not positive, using 0.2", rate);
+	rate = 0.2;
+      }
+
+    ROS_INFO("cal_job_file: %s scene %d, every %.1f s, threshold %.2f pixels %d times",
+	     caljob_file_.c_str(), scene_id_, 1.0/rate, parameters.threshold, parameters.consecutive);
+    loadJob();
+
+    drift_pub_ = nh_.advertise<industrial_extrinsic_cal::CalibrationDrift>("calibration_drift", 1, true);
+    if(!recalibrate_service_.empty())
+      {
+	recalibrate_client_ = nh_.serviceClient<std_srvs::Empty>(recalibrate_service_);
+      }
+    timer_ = nh_.createTimer(ros::Duration(1.0/rate), &DriftMonitorNode::update, this);
+  };
+
+  void update(const ros::TimerEvent& event);
+
+private:
+  void loadJob();
+  void publish();
+  void recalibrate();
+
+  ros::NodeHandle nh_;
+  ros::Publisher drift_pub_;
+  ros::ServiceClient recalibrate_client_;
+  ros::Timer timer_;
+  ros::Time last_recalibration_;
+  std::string yaml_file_path_;
+  std::string camera_file_;
+  std::string target_file_;
+  std::string caljob_file_;
+  std::string recalibrate_service_;
+  int scene_id_;
+  double cooldown_;
+  boost::shared_ptr<CalibrationJob> cal_job_;
+  DriftMonitor monitor_;
+};
+
+void DriftMonitorNode::loadJob()
+{
+  cal_job_ = boost::make_shared<CalibrationJob>(yaml_file_path_ + camera_file_,
+						yaml_file_path_ + target_file_,
+						yaml_file_path_ + caljob_file_);
+  cal_job_->setListenOnly(true); // the monitor must not publish the calibration it checks
+  if (cal_job_->load())
+    {
+      ROS_INFO_STREAM("Calibration job (cal_job, target and camera) yaml parameters loaded.");
+    }
+}
+
+void DriftMonitorNode::update(const ros::TimerEvent& event)
+{
+  // capture right away, the cell is running and nobody is there to trigger the scene
+  ObservationDataPointList observations;
+  if (!cal_job_->observeScene(scene_id_, false, observations))
+    {
+      return;
+    }
+  std::vector<industrial_extrinsic_cal::P_BLOCK> known_target_blocks;
+  cal_job_->getKnownTargetBlocks(known_target_blocks);
+  if (known_target_blocks.empty())
+    {
+      ROS_WARN_THROTTLE(60.0, "no target of scene %d has a fixed_pose, there is nothing to compare against", scene_id_);
+    }
+  if (!monitor_.update(observations, known_target_blocks))
+    {
+      ROS_WARN("drift monitor could not evaluate every observation of scene %d", scene_id_);
+    }
+  publish();
+
+  if (monitor_.drifted())
+    {
+      recalibrate();
+    }
+}
+
+void DriftMonitorNode::publish()
+{
+  industrial_extrinsic_cal::CalibrationDrift msg;
+  msg.header.stamp = ros::Time::now();
+  msg.drifted = monitor_.drifted();
+  std::map<std::string, industrial_extrinsic_cal::CameraDrift>::const_iterator it;
+  for (it = monitor_.cameras().begin(); it != monitor_.cameras().end(); ++it)
+    {
+      msg.camera_names.push_back(it->first);
+      msg.rms_error.push_back(industrial_extrinsic_cal::QualityReport::rms(it->second.last));
+      msg.observations.push_back(it->second.last.num_observations);
+      msg.camera_drifted.push_back(it->second.drifted);
+      if (it->second.drifted)
+	{
+	  ROS_WARN("camera %s drifted, rms reprojection error %.2f pixels",
+		   it->first.c_str(), industrial_extrinsic_cal::QualityReport::rms(it->second.last));
+	}
+    }
+  drift_pub_.publish(msg);
+}
+
+void DriftMonitorNode::recalibrate()
+{
+  if (recalibrate_service_.empty())
+    {
+      return;
+    }
+  ros::Time now = ros::Time::now();
+  if (!last_recalibration_.isZero() && (now - last_recalibration_).toSec() < cooldown_)
+    {
+      return;
+    }
+  last_recalibration_ = now;
+
+  ROS_INFO("calling %s to re-calibrate", recalibrate_service_.c_str());
+  std_srvs::Empty srv;
+  if (!recalibrate_client_.call(srv))
+    {
+      ROS_ERROR("re-calibration service %s failed", recalibrate_service_.c_str());
+      return;
+    }
+
+  // the new calibration is published as transforms, the listeners compare against it from the next update
+  monitor_.reset();
+}
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "drift_monitor_node");
+  ros::NodeHandle nh;
+  DriftMonitorNode drift_monitor_node(nh);
+  ros::spin();
+}
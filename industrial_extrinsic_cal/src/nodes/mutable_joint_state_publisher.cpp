@@ -25,7 +25,7 @@ namespace industrial_extrinsic_cal
   using std::string;
   using std::vector;
 
-  MutableJointStatePublisher::MutableJointStatePublisher(ros::NodeHandle nh): nh_(nh)
+  MutableJointStatePublisher::MutableJointStatePublisher(ros::NodeHandle nh): nh_(nh), changed_(true), keep_alive_rate_(10.0)
   {
     node_name_ = ros::this_node::getName();
 
@@ -39,10 +39,28 @@ namespace industrial_extrinsic_cal
     if(!loadFromYamlFile()){
       ROS_ERROR("MutableJointStatePublisher constructor can't read yaml file %s",yaml_file_name_.c_str());
     }
+
+    // the joints never change after loading, only their values, so each keeps its place in the message
+    for (std::map<std::string, double>::iterator it= joints_.begin(); it != joints_.end(); ++it){
+      joint_index_[it->first] = (int)back_.name.size();
+      back_.name.push_back(it->first);
+      back_.position.push_back(it->second);
+      back_.velocity.push_back(0.0);
+      back_.effort.push_back(0.0);
+    }
+
+    // changes are published at once, this rate only keeps late subscribers and robot_state_publisher current
+    nh_.getParam(node_name_ + "/keep_alive_rate", keep_alive_rate_);
+    if(keep_alive_rate_ <= 0.0){
+      ROS_ERROR("keep_alive_rate must be positive, using 10 Hz");
+      keep_alive_rate_ = 10.0;
+    }
     // advertise the services for getting, setting, and storing the mutable joint values
     set_server_ = nh_.advertiseService( "/set_mutable_joint_states", &MutableJointStatePublisher::setCallBack, this);
     get_server_ = nh_.advertiseService("/get_mutable_joint_states", &MutableJointStatePublisher::getCallBack,this);
     store_server_ = nh_.advertiseService("/store_mutable_joint_states", &MutableJointStatePublisher::storeCallBack, this);
+    transaction_server_ = nh_.advertiseService("/mutable_joint_states_transaction",
+					       &MutableJointStatePublisher::transactionCallBack, this);
 
     // advertise the topic for continious publication of all the mutable joint states
     int queue_size = 10;
@@ -56,9 +74,9 @@ namespace industrial_extrinsic_cal
 					       industrial_extrinsic_cal::set_mutable_joint_states::Response &res)
   {
     bool return_val= true;
-    for(int i=0; i<(int)req.joint_names.size(); i++){
-      if(joints_.find(req.joint_names[i]) != joints_.end()){
-	joints_[req.joint_names[i]] = req.joint_values[i];
+    boost::mutex::scoped_lock lock(mutex_);
+    for(int i=0; i<(int)req.joint_names.size() && i<(int)req.joint_values.size(); i++){
+      if(setJoint(req.joint_names[i], req.joint_values[i])){
 	ROS_INFO("setting %s to %lf",req.joint_names[i].c_str(), req.joint_values[i]);
       }
       else{
@@ -66,6 +84,7 @@ namespace industrial_extrinsic_cal
 	return_val= false;
       }
     }
+    notifyChanged();
 
     return(return_val);
   }
@@ -76,6 +95,7 @@ namespace industrial_extrinsic_cal
     bool return_val=true;
     res.joint_names.clear();
     res.joint_values.clear();
+    boost::mutex::scoped_lock lock(mutex_);
     for(int i=0; i<(int)req.joint_names.size(); i++){ // for each name asked for
       if(joints_.find(req.joint_names[i]) != joints_.end()){ // see if it can be found
 	res.joint_names.push_back(req.joint_names[i]); // use the asked for name in resposne
@@ -89,17 +109,66 @@ namespace industrial_extrinsic_cal
     return(return_val);
   }
 
+  bool MutableJointStatePublisher::transactionCallBack(industrial_extrinsic_cal::mutable_joint_states_transaction::Request &req,
+						       industrial_extrinsic_cal::mutable_joint_states_transaction::Response &res)
+  {
+    res.unknown_joint_names.clear();
+    res.joint_names.clear();
+    res.joint_values.clear();
+    if(req.set_joint_names.size() != req.set_joint_values.size()){
+      ROS_ERROR("%s transaction has %d joint names but %d values", node_name_.c_str(),
+		(int)req.set_joint_names.size(), (int)req.set_joint_values.size());
+      res.success = false;
+      return(true);
+    }
+
+    boost::mutex::scoped_lock lock(mutex_);
+    // all or nothing, a transform is never left half updated
+    for(int i=0; i<(int)req.set_joint_names.size(); i++){
+      if(joints_.find(req.set_joint_names[i]) == joints_.end()) res.unknown_joint_names.push_back(req.set_joint_names[i]);
+    }
+    for(int i=0; i<(int)req.get_joint_names.size(); i++){
+      if(joints_.find(req.get_joint_names[i]) == joints_.end()) res.unknown_joint_names.push_back(req.get_joint_names[i]);
+    }
+    if(!res.unknown_joint_names.empty()){
+      for(int i=0; i<(int)res.unknown_joint_names.size(); i++){
+	ROS_ERROR("%s does not have joint named %s",node_name_.c_str(),res.unknown_joint_names[i].c_str());
+      }
+      res.success = false;
+      return(true);
+    }
+
+    for(int i=0; i<(int)req.set_joint_names.size(); i++){
+      setJoint(req.set_joint_names[i], req.set_joint_values[i]);
+    }
+    if(!req.set_joint_names.empty()){
+      notifyChanged();
+      ROS_INFO("set %d mutable joints in one transaction", (int)req.set_joint_names.size());
+    }
+    for(int i=0; i<(int)req.get_joint_names.size(); i++){
+      res.joint_names.push_back(req.get_joint_names[i]);
+      res.joint_values.push_back(joints_[req.get_joint_names[i]]);
+    }
+    res.success = true;
+    return(true);
+  }
+
   bool MutableJointStatePublisher::storeCallBack(industrial_extrinsic_cal::store_mutable_joint_states::Request &req,
 						 industrial_extrinsic_cal::store_mutable_joint_states::Response &res)
   {
     std::string new_file_name =  yaml_file_name_ + "new";
+    std::map<std::string, double> joints;
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      joints = joints_;
+    }
     std::ofstream fout(new_file_name.c_str());
     YAML::Emitter yaml_emitter;
     yaml_emitter << YAML::Comment << "This is a simple list of mutable joint states";
     yaml_emitter << YAML::Comment << "each line has the form";
     yaml_emitter << YAML::Comment << "joint_name: <double_value>";
     yaml_emitter << YAML::BeginMap;
-    for (std::map<std::string, double>::iterator it= joints_.begin(); it != joints_.end(); ++it){
+    for (std::map<std::string, double>::iterator it= joints.begin(); it != joints.end(); ++it){
       yaml_emitter << YAML::Key << it->first.c_str() << YAML::Value << it->second;
       ROS_INFO("mutable joint %s has value %lf",it->first.c_str(), it->second);
     }
@@ -144,21 +213,47 @@ namespace industrial_extrinsic_cal
     return(true);
   } 					     
 
+  bool MutableJointStatePublisher::setJoint(const std::string &name, double value)
+  {
+    std::map<std::string, int>::const_iterator it = joint_index_.find(name);
+    if(it == joint_index_.end()) return(false);
+    joints_[name] = value;
+    back_.position[it->second] = value;
+    return(true);
+  }
+
+  void MutableJointStatePublisher::notifyChanged()
+  {
+    changed_ = true;
+    changed_cond_.notify_one();
+  }
+
   bool MutableJointStatePublisher::publishJointStates()
   {
-    sensor_msgs::JointState joint_states;
-    joint_states.header.stamp = ros::Time::now();
-    joint_states.name.clear();
-    joint_states.position.clear();
-    joint_states.velocity.clear();
-    joint_states.effort.clear();
-    for (std::map<string, double>::iterator it=joints_.begin(); it!=joints_.end(); ++it){
-      joint_states.name.push_back(it->first);
-      joint_states.position.push_back(it->second);
-      joint_states.velocity.push_back(0.0);
-      joint_states.effort.push_back(0.0);
-    }
-    joint_state_pub_.publish(joint_states);
+    {
+      // only the copy is made under the lock, the services are never held up by publishing
+      boost::mutex::scoped_lock lock(mutex_);
+      if(front_.name.size() != back_.name.size()){ // names, velocities and efforts are copied once
+	front_.name = back_.name;
+	front_.velocity = back_.velocity;
+	front_.effort = back_.effort;
+      }
+      front_.position = back_.position;
+      changed_ = false;
+    }
+    front_.header.stamp = ros::Time::now();
+    joint_state_pub_.publish(front_);
+    return(true);
+  }
+
+  void MutableJointStatePublisher::run()
+  {
+    boost::posix_time::time_duration period = boost::posix_time::microseconds((long)(1.0e6/keep_alive_rate_));
+    while(ros::ok()){
+      publishJointStates();
+      boost::mutex::scoped_lock lock(mutex_);
+      if(!changed_) changed_cond_.timed_wait(lock, period);
+    }
   }
 } // end namespace industrial_extrinsic_cal
 int main(int argc, char **argv)
@@ -166,12 +261,14 @@ int main(int argc, char **argv)
   ros::init(argc, argv, "mutable_joint_state_publisher");
   ros::NodeHandle nh;
   industrial_extrinsic_cal::MutableJointStatePublisher MJSP(nh);
-  ros::Rate loop_rate(10);
-  while(ros::ok()){
-    MJSP.publishJointStates();
-    ros::spinOnce();
-    loop_rate.sleep();
-  }
+
+  // services are answered in the spinner's threads while this one publishes
+  int spinner_threads = 2;
+  nh.getParam(ros::this_node::getName() + "/spinner_threads", spinner_threads);
+  ros::AsyncSpinner spinner(spinner_threads > 0 ? spinner_threads : 2);
+  spinner.start();
+  MJSP.run();
+  spinner.stop();
 }
 
 
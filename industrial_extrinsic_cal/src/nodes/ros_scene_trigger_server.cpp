@@ -21,6 +21,7 @@
 #include <ros/console.h>
 #include <actionlib/server/simple_action_server.h>
 #include <industrial_extrinsic_cal/manual_triggerAction.h>
+#include <industrial_extrinsic_cal/ros_triggers.h>
 
 typedef actionlib::SimpleActionServer<industrial_extrinsic_cal::manual_triggerAction> Server;
 
@@ -28,12 +29,8 @@ void execute(const industrial_extrinsic_cal::manual_triggerGoalConstPtr& goal, S
 {
   // Do lots of awesome groundbreaking robot stuff here
   ROS_ERROR("Scene Action Trigger is waiting for you to type: rosparam set test_scene_trigger true");
-  bool test_scene_trigger_bool=false;
-  ros::NodeHandle nh;
-  nh.setParam("test_scene_trigger",false);
-  while(test_scene_trigger_bool == false){
-    nh.getParam("test_scene_trigger",test_scene_trigger_bool);
-  }
+  industrial_extrinsic_cal::ROSParamTrigger trigger("test_scene_trigger");
+  trigger.waitForTrigger();
   ROS_ERROR("Scene Action Trigger has executed successfully");
   as->setSucceeded();
 }
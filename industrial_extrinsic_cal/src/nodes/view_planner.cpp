@@ -0,0 +1,130 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Plans the scenes of a calibration job from an observation dataset of an earlier run, without ROS or a roscore.
+ *
+ * usage: view_planner input_dataset plan_file [--max_views N] [--rotation_std rad] [--position_std m]
+ *                     [--pixel_sigma pixels] [--criterion trace|determinant] [--observed id,id,...]
+ *
+ * Each scene of the dataset is a candidate, linearized at the dataset's parameter values, a solved dataset gives
+ * the best prediction. The plan file holds a view_plan block for the caljob, the scenes in the order they should
+ * be taken, and the predicted std deviation of every camera's extrinsics.
+ */
+
+#include <industrial_extrinsic_cal/observation_dataset.h>
+#include <industrial_extrinsic_cal/view_planner.h>
+#include <boost/foreach.hpp>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+using namespace industrial_extrinsic_cal;
+
+namespace
+{
+  void usage(const char *program)
+  {
+    fprintf(stderr, "usage: %s input_dataset plan_file [--max_views N] [--rotation_std rad] [--position_std m]\n"
+	    "          [--pixel_sigma pixels] [--criterion trace|determinant] [--observed id,id,...]\n",
+	    program);
+  }
+
+  bool writePlan(const std::string &file_name, const std::string &dataset_name, int num_scenes,
+		 const std::vector<int> &scenes, bool met, const ViewPlanner &planner)
+  {
+    std::ofstream out(file_name.c_str());
+    if(!out.is_open()){
+      fprintf(stderr, "could not open %s\n", file_name.c_str());
+      return(false);
+    }
+    out.precision(6);
+    out << "# " << scenes.size() << " of " << num_scenes << " scenes of " << dataset_name << "\n";
+    out << "# the uncertainty target " << (met ? "is met" : "is NOT met") << "\n";
+    out << "# predicted extrinsics std dev, ax ay az (rad) x y z (m)\n";
+    BOOST_FOREACH(const ExtrinsicsUncertainty &u, planner.uncertainty()){
+      out << "#   " << u.name << ": [";
+      for(int j=0; j<6; j++) out << (j ? ", " : "") << u.std_dev[j];
+      out << "]\n";
+    }
+    out << "view_plan:\n";
+    out << "  scenes: [";
+    for(int i=0; i<(int)scenes.size(); i++) out << (i ? ", " : "") << scenes[i];
+    out << "]\n";
+    out.close();
+    return(!out.fail());
+  }
+}
+
+int main(int argc, char **argv)
+{
+  if(argc < 3){
+    usage(argv[0]);
+    return(1);
+  }
+  std::string input_file(argv[1]);
+  std::string plan_file(argv[2]);
+  ViewPlanParameters parameters = defaultViewPlanParameters();
+  std::vector<int> observed;
+  for(int i=3; i<argc; i++){
+    if(i+1 >= argc){ usage(argv[0]); return(1); }
+    std::string key(argv[i]);
+    const char *value = argv[++i];
+    if(key == "--max_views") parameters.max_views = atoi(value);
+    else if(key == "--rotation_std") parameters.max_rotation_std = atof(value);
+    else if(key == "--position_std") parameters.max_position_std = atof(value);
+    else if(key == "--pixel_sigma") parameters.pixel_sigma = atof(value);
+    else if(key == "--criterion"){
+      if(!string2ViewPlanCriterion(value, parameters.criterion)){ usage(argv[0]); return(1); }
+    }
+    else if(key == "--observed"){
+      std::stringstream ids(value);
+      std::string id;
+      while(std::getline(ids, id, ',')) observed.push_back(atoi(id.c_str()));
+    }
+    else { usage(argv[0]); return(1); }
+  }
+
+  ObservationDataset dataset;
+  if(!dataset.read(input_file)) return(1);
+
+  // every scene of the dataset is a candidate view
+  std::map<int, ObservationDataPointList> scenes;
+  BOOST_FOREACH(const ObservationDataPoint &ODP, dataset.observations().items_){
+    scenes[ODP.scene_id_].addObservationPoint(ODP);
+  }
+  ViewPlanner planner(parameters);
+  std::map<int, ObservationDataPointList>::const_iterator it;
+  for(it = scenes.begin(); it != scenes.end(); ++it){
+    if(!planner.addView(it->first, it->second)) fprintf(stderr, "scene %d could not be fully linearized\n", it->first);
+  }
+  printf("%s: %d scenes, %d observations\n", input_file.c_str(), (int)scenes.size(),
+	 (int)dataset.observations().items_.size());
+
+  std::vector<int> selected;
+  bool met = planner.plan(observed, selected);
+  printf("%d scenes planned, the uncertainty target %s\n", (int)selected.size(), met ? "is met" : "is NOT met");
+  printf("%s", planner.summary().c_str());
+
+  std::vector<int> plan(observed);
+  plan.insert(plan.end(), selected.begin(), selected.end());
+  if(!writePlan(plan_file, input_file, (int)scenes.size(), plan, met, planner)) return(1);
+  return(0);
+}
@@ -17,6 +17,9 @@
  */
 
 #include <industrial_extrinsic_cal/observation_data_point.h>
+#include <industrial_extrinsic_cal/ceres_costs_utils.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <stdio.h>
 
 namespace industrial_extrinsic_cal
 {
@@ -38,6 +41,120 @@ void ObservationDataPointList::addObservationPoint(ObservationDataPoint new_data
   items_.push_back(new_data_point);
 }
 
+namespace
+{
+  typedef ceres::CostFunction* (*CostFactory)(const ReprojectionInputs &inputs,
+					      P_BLOCK extrinsics, P_BLOCK intrinsics,
+					      P_BLOCK target_pose, P_BLOCK point,
+					      std::vector<P_BLOCK> &parameter_blocks,
+					      RotationCache *rotation_cache);
+
+  // the chain of a cost type, read from the policies it is instantiated with
+  template<class Cost> CostChain costChainOf()
+  {
+    CostChain chain;
+    chain.target_present = Cost::TargetPolicy::PRESENT;
+    chain.camera_on_link = boost::is_same<typename Cost::LinkPolicy, CameraOnLink>::value;
+    chain.target_on_link = boost::is_same<typename Cost::LinkPolicy, TargetOnLink>::value;
+    return(chain);
+  }
+
+  // one entry per Cost_function, in enum order, so a cost type indexes the table directly
+  const struct
+  {
+    Cost_function type;
+    CostFactory create;
+    CostChain (*chain)();
+  } COST_FACTORIES[] =
+  {
+    { cost_functions::CameraReprjErrorWithDistortion, &CameraReprjErrorWithDistortion::Create,
+      &costChainOf<CameraReprjErrorWithDistortion> },
+    { cost_functions::CameraReprjErrorWithDistortionPK, &CameraReprjErrorWithDistortionPK::Create,
+      &costChainOf<CameraReprjErrorWithDistortionPK> },
+    { cost_functions::CameraReprjError, &CameraReprjError::Create,
+      &costChainOf<CameraReprjError> },
+    { cost_functions::CameraReprjErrorPK, &CameraReprjErrorPK::Create,
+      &costChainOf<CameraReprjErrorPK> },
+    { cost_functions::TargetCameraReprjError, &TargetCameraReprjError::Create,
+      &costChainOf<TargetCameraReprjError> },
+    { cost_functions::TargetCameraReprjErrorPK, &TargetCameraReprjErrorPK::Create,
+      &costChainOf<TargetCameraReprjErrorPK> },
+    { cost_functions::LinkTargetCameraReprjError, &LinkTargetCameraReprjError::Create,
+      &costChainOf<LinkTargetCameraReprjError> },
+    { cost_functions::LinkTargetCameraReprjErrorPK, &LinkTargetCameraReprjErrorPK::Create,
+      &costChainOf<LinkTargetCameraReprjErrorPK> },
+    { cost_functions::LinkCameraTargetReprjError, &LinkCameraTargetReprjError::Create,
+      &costChainOf<LinkCameraTargetReprjError> },
+    { cost_functions::LinkCameraTargetReprjErrorPK, &LinkCameraTargetReprjErrorPK::Create,
+      &costChainOf<LinkCameraTargetReprjErrorPK> },
+    { cost_functions::CircleCameraReprjErrorWithDistortion, &CircleCameraReprjErrorWithDistortion::Create,
+      &costChainOf<CircleCameraReprjErrorWithDistortion> },
+    { cost_functions::CircleCameraReprjErrorWithDistortionPK, &CircleCameraReprjErrorWithDistortionPK::Create,
+      &costChainOf<CircleCameraReprjErrorWithDistortionPK> },
+    { cost_functions::CircleCameraReprjError, &CircleCameraReprjError::Create,
+      &costChainOf<CircleCameraReprjError> },
+    { cost_functions::CircleCameraReprjErrorPK, &CircleCameraReprjErrorPK::Create,
+      &costChainOf<CircleCameraReprjErrorPK> },
+    { cost_functions::CircleTargetCameraReprjErrorWithDistortion, &CircleTargetCameraReprjErrorWithDistortion::Create,
+      &costChainOf<CircleTargetCameraReprjErrorWithDistortion> },
+    { cost_functions::CircleTargetCameraReprjErrorWithDistortionPK, &CircleTargetCameraReprjErrorWithDistortionPK::Create,
+      &costChainOf<CircleTargetCameraReprjErrorWithDistortionPK> },
+    { cost_functions::CircleTargetCameraReprjError, &CircleTargetCameraReprjError::Create,
+      &costChainOf<CircleTargetCameraReprjError> },
+    { cost_functions::CircleTargetCameraReprjErrorPK, &CircleTargetCameraReprjErrorPK::Create,
+      &costChainOf<CircleTargetCameraReprjErrorPK> },
+    { cost_functions::LinkCircleTargetCameraReprjError, &LinkCircleTargetCameraReprjError::Create,
+      &costChainOf<LinkCircleTargetCameraReprjError> },
+    { cost_functions::LinkCircleTargetCameraReprjErrorPK, &LinkCircleTargetCameraReprjErrorPK::Create,
+      &costChainOf<LinkCircleTargetCameraReprjErrorPK> },
+    { cost_functions::LinkCameraCircleTargetReprjError, &LinkCameraCircleTargetReprjError::Create,
+      &costChainOf<LinkCameraCircleTargetReprjError> },
+    { cost_functions::LinkCameraCircleTargetReprjErrorPK, &LinkCameraCircleTargetReprjErrorPK::Create,
+      &costChainOf<LinkCameraCircleTargetReprjErrorPK> },
+    { cost_functions::FixedCircleTargetCameraReprjErrorPK, &FixedCircleTargetCameraReprjErrorPK::Create,
+      &costChainOf<FixedCircleTargetCameraReprjErrorPK> }
+  };
+  const int NUM_COST_FACTORIES = sizeof(COST_FACTORIES)/sizeof(COST_FACTORIES[0]);
+}
+
+ceres::CostFunction* createObservationCost(const ObservationDataPoint &ODP,
+					   P_BLOCK extrinsics, P_BLOCK intrinsics,
+					   P_BLOCK target_pose, P_BLOCK point_position,
+					   std::vector<P_BLOCK> &parameter_blocks,
+					   RotationCache *rotation_cache)
+{
+  parameter_blocks.clear();
+  int type = ODP.cost_type_;
+  if(type < 0 || type >= NUM_COST_FACTORIES || COST_FACTORIES[type].type != ODP.cost_type_){
+    std::string cost_type_string = costType2String(ODP.cost_type_);
+    fprintf(stderr, "No cost function of type %s\n", cost_type_string.c_str());
+    return(NULL);
+  }
+
+  // every cost type takes its known values from the observation's own blocks,
+  // the cost type decides which of them are estimated instead
+  ReprojectionInputs inputs = reprojectionInputs(ODP.image_x_, ODP.image_y_);
+  inputs.circle_diameter = ODP.circle_dia_; // sometimes this is not needed
+  for(int i=0; i<9; i++) inputs.intrinsics[i] = ODP.camera_intrinsics_[i];
+  inputs.target_pose.setAngleAxis(ODP.target_pose_[0], ODP.target_pose_[1], ODP.target_pose_[2]);
+  inputs.target_pose.setOrigin(ODP.target_pose_[3], ODP.target_pose_[4], ODP.target_pose_[5]);
+  inputs.link_pose = ODP.intermediate_frame_; // identity except when camera or target is mounted on a robot
+  inputs.point.x = ODP.point_position_[0]; // location of point within target frame
+  inputs.point.y = ODP.point_position_[1];
+  inputs.point.z = ODP.point_position_[2];
+
+  return(COST_FACTORIES[type].create(inputs, extrinsics, intrinsics, target_pose, point_position,
+				      parameter_blocks, rotation_cache));
+}
+
+bool costChain(Cost_function cost_type, CostChain &chain)
+{
+  int type = cost_type;
+  if(type < 0 || type >= NUM_COST_FACTORIES || COST_FACTORIES[type].type != cost_type) return(false);
+  chain = COST_FACTORIES[type].chain();
+  return(true);
+}
+
 }//end namespace industrial_extrinsic_cal
 
 
@@ -0,0 +1,238 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <industrial_extrinsic_cal/observation_dataset.h>
+#include <stdio.h>
+#include <fstream>
+#include <map>
+#include <set>
+
+namespace industrial_extrinsic_cal
+{
+  namespace
+  {
+    const char *DATASET_HEADER = "industrial_extrinsic_cal_dataset";
+    const int DATASET_VERSION = 1;
+    const int EXTRINSICS_SIZE = 6;
+    const int INTRINSICS_SIZE = 9;
+    const int TARGET_POSE_SIZE = 6;
+    const int POINT_SIZE = 3;
+
+    /* registers a block on first use, returns its index */
+    int addBlock(P_BLOCK block, int size, std::map<P_BLOCK, int> &indices,
+		 std::vector<P_BLOCK> &originals, std::vector<int> &sizes)
+    {
+      std::map<P_BLOCK, int>::iterator it = indices.find(block);
+      if(it != indices.end()) return(it->second);
+      int index = originals.size();
+      indices[block] = index;
+      originals.push_back(block);
+      sizes.push_back(size);
+      return(index);
+    }
+  }
+
+  void ObservationDataset::setObservations(const std::vector<ObservationDataPointList> &lists)
+  {
+    // first find every distinct block, then size the storage once so the observations can point into it
+    std::map<P_BLOCK, int> indices;
+    std::vector<P_BLOCK> originals;
+    std::vector<int> sizes;
+    for(int i=0; i<(int)lists.size(); i++){
+      for(int j=0; j<(int)lists[i].items_.size(); j++){
+	const ObservationDataPoint &ODP = lists[i].items_[j];
+	addBlock(ODP.camera_extrinsics_, EXTRINSICS_SIZE, indices, originals, sizes);
+	addBlock(ODP.camera_intrinsics_, INTRINSICS_SIZE, indices, originals, sizes);
+	addBlock(ODP.target_pose_, TARGET_POSE_SIZE, indices, originals, sizes);
+	addBlock(ODP.point_position_, POINT_SIZE, indices, originals, sizes);
+      }
+    }
+
+    blocks_.assign(originals.size(), std::vector<double>());
+    for(int i=0; i<(int)originals.size(); i++){
+      blocks_[i].assign(originals[i], originals[i] + sizes[i]);
+    }
+
+    observations_.items_.clear();
+    for(int i=0; i<(int)lists.size(); i++){
+      for(int j=0; j<(int)lists[i].items_.size(); j++){
+	ObservationDataPoint ODP = lists[i].items_[j];
+	ODP.camera_extrinsics_ = &blocks_[indices[ODP.camera_extrinsics_]][0];
+	ODP.camera_intrinsics_ = &blocks_[indices[ODP.camera_intrinsics_]][0];
+	ODP.target_pose_ = &blocks_[indices[ODP.target_pose_]][0];
+	ODP.point_position_ = &blocks_[indices[ODP.point_position_]][0];
+	observations_.addObservationPoint(ODP);
+      }
+    }
+  }
+
+  bool ObservationDataset::write(const std::string &file_name) const
+  {
+    std::ofstream fout(file_name.c_str());
+    if(!fout.is_open()){
+      fprintf(stderr, "could not open %s\n", file_name.c_str());
+      return(false);
+    }
+    fout.precision(17);
+
+    std::map<const double*, int> indices;
+    fout << DATASET_HEADER << " " << DATASET_VERSION << "\n";
+    fout << "blocks " << blocks_.size() << "\n";
+    for(int i=0; i<(int)blocks_.size(); i++){
+      indices[&blocks_[i][0]] = i;
+      fout << blocks_[i].size();
+      for(int j=0; j<(int)blocks_[i].size(); j++) fout << " " << blocks_[i][j];
+      fout << "\n";
+    }
+
+    fout << "observations " << observations_.items_.size() << "\n";
+    for(int i=0; i<(int)observations_.items_.size(); i++){
+      const ObservationDataPoint &ODP = observations_.items_[i];
+      const Pose6d &frame = ODP.intermediate_frame_;
+      fout << ODP.camera_name_ << " " << ODP.target_name_ << " " << ODP.target_type_ << " "
+	   << ODP.scene_id_ << " " << ODP.point_id_ << " " << costType2String(ODP.cost_type_) << " "
+	   << indices[ODP.camera_extrinsics_] << " " << indices[ODP.camera_intrinsics_] << " "
+	   << indices[ODP.target_pose_] << " " << indices[ODP.point_position_] << " "
+	   << ODP.image_x_ << " " << ODP.image_y_ << " " << ODP.circle_dia_ << " "
+	   << frame.x << " " << frame.y << " " << frame.z << " "
+	   << frame.ax << " " << frame.ay << " " << frame.az << "\n";
+    }
+    fout.close();
+    return(!fout.fail());
+  }
+
+  bool ObservationDataset::read(const std::string &file_name)
+  {
+    std::ifstream fin(file_name.c_str());
+    if(!fin.is_open()){
+      fprintf(stderr, "could not open %s\n", file_name.c_str());
+      return(false);
+    }
+
+    std::string header, keyword;
+    int version = 0;
+    int num_blocks = 0;
+    fin >> header >> version >> keyword >> num_blocks;
+    if(!fin || header != DATASET_HEADER || version != DATASET_VERSION || keyword != "blocks" || num_blocks < 0){
+      fprintf(stderr, "%s is not an observation dataset\n", file_name.c_str());
+      return(false);
+    }
+
+    blocks_.assign(num_blocks, std::vector<double>());
+    for(int i=0; i<num_blocks; i++){
+      int size = 0;
+      fin >> size;
+      if(size <= 0) break;
+      blocks_[i].resize(size);
+      for(int j=0; j<size; j++) fin >> blocks_[i][j];
+    }
+
+    int num_observations = 0;
+    fin >> keyword >> num_observations;
+    if(!fin || keyword != "observations"){
+      fprintf(stderr, "%s: bad parameter block section\n", file_name.c_str());
+      blocks_.clear();
+      return(false);
+    }
+
+    observations_.items_.clear();
+    for(int i=0; i<num_observations; i++){
+      std::string camera_name, target_name, cost_type_name;
+      int target_type, scene_id, point_id;
+      int block_index[4];
+      double image_x, image_y, circle_dia;
+      Pose6d frame;
+      fin >> camera_name >> target_name >> target_type >> scene_id >> point_id >> cost_type_name
+	  >> block_index[0] >> block_index[1] >> block_index[2] >> block_index[3]
+	  >> image_x >> image_y >> circle_dia
+	  >> frame.x >> frame.y >> frame.z >> frame.ax >> frame.ay >> frame.az;
+      if(!fin){
+	fprintf(stderr, "%s: observation %d is incomplete\n", file_name.c_str(), i);
+	observations_.items_.clear();
+	return(false);
+      }
+
+      const int expected_size[4] = { EXTRINSICS_SIZE, INTRINSICS_SIZE, TARGET_POSE_SIZE, POINT_SIZE };
+      for(int k=0; k<4; k++){
+	if(block_index[k] < 0 || block_index[k] >= num_blocks ||
+	   (int)blocks_[block_index[k]].size() != expected_size[k]){
+	  fprintf(stderr, "%s: observation %d refers to a bad parameter block\n", file_name.c_str(), i);
+	  observations_.items_.clear();
+	  return(false);
+	}
+      }
+      Cost_function cost_type = string2CostType(cost_type_name);
+      if(cost_type == cost_functions::NullCostType){
+	fprintf(stderr, "%s: observation %d has unknown cost type %s\n", file_name.c_str(), i, cost_type_name.c_str());
+	observations_.items_.clear();
+	return(false);
+      }
+
+      ObservationDataPoint ODP(camera_name, target_name, target_type, scene_id,
+			       &blocks_[block_index[1]][0], &blocks_[block_index[0]][0],
+			       point_id, &blocks_[block_index[2]][0], &blocks_[block_index[3]][0],
+			       image_x, image_y, cost_type, frame, circle_dia);
+      observations_.addObservationPoint(ODP);
+    }
+    return(true);
+  }
+
+  void ObservationDataset::addSchurEliminationBlocks(SchurOrdering &ordering) const
+  {
+    // the dataset does not record which targets move, a pose observed in one scene only is taken to be a moving one
+    std::map<const double*, std::set<int> > pose_scenes;
+    std::set<const double*> points;
+    for(int i=0; i<(int)observations_.items_.size(); i++){
+      const ObservationDataPoint &ODP = observations_.items_[i];
+      if(points.insert(ODP.point_position_).second) ordering.eliminate(ODP.point_position_);
+      pose_scenes[ODP.target_pose_].insert(ODP.scene_id_);
+    }
+    std::map<const double*, std::set<int> >::const_iterator it;
+    for(it = pose_scenes.begin(); it != pose_scenes.end(); ++it){
+      if(it->second.size() == 1) ordering.eliminate(it->first);
+    }
+  }
+
+  void ObservationDataset::addToProblem(ceres::Problem &problem, ParameterBlockCopies *copies,
+					  RotationCache *rotation_cache, std::vector<ObservationResidual> *residuals)
+  {
+    for(int i=0; i<(int)observations_.items_.size(); i++){
+      const ObservationDataPoint &ODP = observations_.items_[i];
+      P_BLOCK extrinsics = ODP.camera_extrinsics_;
+      P_BLOCK intrinsics = ODP.camera_intrinsics_;
+      P_BLOCK target_pose = ODP.target_pose_;
+      P_BLOCK point_position = ODP.point_position_;
+      if(copies != NULL){
+	extrinsics = copies->extrinsics(ODP.camera_extrinsics_);
+	intrinsics = copies->intrinsics(ODP.camera_intrinsics_);
+	target_pose = copies->targetPose(ODP.target_pose_);
+	point_position = copies->point(ODP.point_position_);
+      }
+      std::vector<P_BLOCK> parameter_blocks;
+      ceres::CostFunction *cost_function = createObservationCost(ODP, extrinsics, intrinsics,
+								 target_pose, point_position,
+								 parameter_blocks, rotation_cache);
+      if(cost_function != NULL){
+	ceres::ResidualBlockId id = problem.AddResidualBlock(cost_function, robust_losses_.create(ODP.cost_type_),
+							     parameter_blocks);
+	if(residuals != NULL) residuals->push_back(observationResidual(id, ODP));
+      }
+    }
+  }
+
+}//end namespace industrial_extrinsic_cal
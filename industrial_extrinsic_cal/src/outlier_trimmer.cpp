@@ -0,0 +1,133 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <industrial_extrinsic_cal/outlier_trimmer.h>
+#include <industrial_extrinsic_cal/phase_timer.h>
+#include <map>
+#include <sstream>
+#include <stdio.h>
+
+namespace industrial_extrinsic_cal
+{
+  OutlierTrimParameters defaultOutlierTrimParameters()
+  {
+    OutlierTrimParameters parameters;
+    parameters.max_rounds = 0;
+    parameters.chi_square_threshold = 5.991;
+    parameters.pixel_sigma = 1.0;
+    return(parameters);
+  }
+
+  ceres::Problem::Options trimProblemOptions()
+  {
+    ceres::Problem::Options options;
+    options.enable_fast_removal = true;
+    return(options);
+  }
+
+  ObservationResidual observationResidual(ceres::ResidualBlockId id, const ObservationDataPoint &ODP)
+  {
+    ObservationResidual residual;
+    residual.id = id;
+    residual.camera_name = ODP.camera_name_;
+    residual.target_name = ODP.target_name_;
+    residual.scene_id = ODP.scene_id_;
+    residual.point_id = ODP.point_id_;
+    return(residual);
+  }
+
+  OutlierTrimmer::OutlierTrimmer(const OutlierTrimParameters &parameters) :
+    parameters_(parameters)
+  {
+  }
+
+  bool OutlierTrimmer::solve(ceres::Problem &problem, std::vector<ObservationResidual> &residuals,
+			     const ceres::Solver::Options &options, ceres::Solver::Summary &summary)
+  {
+    trimmed_.clear();
+    double sigma_squared = parameters_.pixel_sigma*parameters_.pixel_sigma;
+    for(int round=1; ; round++){
+      {
+	CAL_PHASE_TIMER("ceres::Solve");
+	ceres::Solve(options, &problem, &summary);
+      }
+      if(!summary.IsSolutionUsable()) return(false);
+      if(round > parameters_.max_rounds || residuals.empty()) return(true);
+
+      // the threshold applies to the reprojection error itself, not to its robust loss
+      std::vector<double> values;
+      {
+	CAL_PHASE_TIMER("OutlierTrimmer::evaluate");
+	ceres::Problem::EvaluateOptions evaluate_options;
+	for(int i=0; i<(int)residuals.size(); i++) evaluate_options.residual_blocks.push_back(residuals[i].id);
+	evaluate_options.apply_loss_function = false;
+	if(!problem.Evaluate(evaluate_options, NULL, &values, NULL, NULL)) return(false);
+      }
+      if((int)values.size() != RESIDUALS_PER_OBSERVATION*(int)residuals.size()){
+	fprintf(stderr, "OutlierTrimmer: expected %d residuals per observation\n", RESIDUALS_PER_OBSERVATION);
+	return(false);
+      }
+
+      std::vector<ObservationResidual> kept;
+      int num_removed = 0;
+      for(int i=0; i<(int)residuals.size(); i++){
+	double squared_norm = 0.0;
+	for(int j=0; j<RESIDUALS_PER_OBSERVATION; j++){
+	  double r = values[RESIDUALS_PER_OBSERVATION*i + j];
+	  squared_norm += r*r;
+	}
+	double chi_square = squared_norm/sigma_squared;
+	if(chi_square <= parameters_.chi_square_threshold){
+	  kept.push_back(residuals[i]);
+	  continue;
+	}
+	TrimmedObservation trimmed;
+	trimmed.observation = residuals[i];
+	trimmed.chi_square = chi_square;
+	trimmed.round = round;
+	trimmed_.push_back(trimmed);
+	problem.RemoveResidualBlock(residuals[i].id);
+	num_removed++;
+      }
+      if(num_removed == 0) return(true);
+      residuals.swap(kept);
+    }
+  }
+
+  std::string OutlierTrimmer::report() const
+  {
+    std::ostringstream out;
+    std::map<std::pair<int, std::string>, int> counts;
+    for(int i=0; i<(int)trimmed_.size(); i++){
+      counts[std::make_pair(trimmed_[i].observation.scene_id, trimmed_[i].observation.camera_name)]++;
+    }
+    out << trimmed_.size() << " observations removed as outliers\n";
+    std::map<std::pair<int, std::string>, int>::const_iterator it;
+    for(it = counts.begin(); it != counts.end(); ++it){
+      out << "  scene " << it->first.first << " camera " << it->first.second << ": " << it->second << "\n";
+    }
+    for(int i=0; i<(int)trimmed_.size(); i++){
+      const TrimmedObservation &t = trimmed_[i];
+      out << "  round " << t.round << " scene " << t.observation.scene_id << " camera " << t.observation.camera_name
+	  << " target " << t.observation.target_name << " point " << t.observation.point_id
+	  << " chi_square " << t.chi_square << "\n";
+    }
+    return(out.str());
+  }
+
+}//end namespace industrial_extrinsic_cal
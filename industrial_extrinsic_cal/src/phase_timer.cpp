@@ -0,0 +1,148 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <industrial_extrinsic_cal/phase_timer.h>
+#include <boost/chrono.hpp>
+#include <boost/thread/thread.hpp>
+#include <stdio.h>
+#include <fstream>
+#include <map>
+
+namespace industrial_extrinsic_cal
+{
+  namespace
+  {
+    /* accumulated durations of one phase, used by summary() */
+    typedef struct
+    {
+      int count;
+      boost::int64_t total_us;
+      boost::int64_t max_us;
+    } PhaseTotals;
+
+    boost::int64_t steadyMicroseconds()
+    {
+      using namespace boost::chrono;
+      return(duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+    }
+
+    /* chrome://tracing wants small integer thread ids, hand them out in order of first use */
+    unsigned int threadIndex()
+    {
+      static boost::mutex index_mutex;
+      static std::map<boost::thread::id, unsigned int> indices;
+      boost::mutex::scoped_lock lock(index_mutex);
+      std::map<boost::thread::id, unsigned int>::iterator it = indices.find(boost::this_thread::get_id());
+      if(it != indices.end()) return(it->second);
+      unsigned int index = indices.size();
+      indices[boost::this_thread::get_id()] = index;
+      return(index);
+    }
+  }
+
+  PhaseTracer& PhaseTracer::instance()
+  {
+    static PhaseTracer tracer;
+    return(tracer);
+  }
+
+  PhaseTracer::PhaseTracer() : enabled_(false)
+  {
+    origin_us_ = steadyMicroseconds();
+  }
+
+  boost::int64_t PhaseTracer::now() const
+  {
+    return(steadyMicroseconds() - origin_us_);
+  }
+
+  void PhaseTracer::record(const char *name, boost::int64_t start_us, boost::int64_t duration_us)
+  {
+    PhaseEvent event;
+    event.name = name;
+    event.start_us = start_us;
+    event.duration_us = duration_us;
+    event.thread = threadIndex();
+    boost::mutex::scoped_lock lock(mutex_);
+    events_.push_back(event);
+  }
+
+  void PhaseTracer::clear()
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    events_.clear();
+  }
+
+  bool PhaseTracer::writeChromeTrace(const std::string &file_name) const
+  {
+    std::ofstream fout(file_name.c_str());
+    if(!fout.is_open()) return(false);
+
+    boost::mutex::scoped_lock lock(mutex_);
+    fout << "{\"traceEvents\":[\n";
+    for(int i=0; i<(int)events_.size(); i++){
+      const PhaseEvent &e = events_[i];
+      fout << "{\"name\":\"" << e.name << "\",\"cat\":\"calibration\",\"ph\":\"X\""
+	   << ",\"ts\":" << e.start_us << ",\"dur\":" << e.duration_us
+	   << ",\"pid\":1,\"tid\":" << e.thread << "}";
+      if(i+1 < (int)events_.size()) fout << ",";
+      fout << "\n";
+    }
+    fout << "],\"displayTimeUnit\":\"ms\"}\n";
+    fout.close();
+    return(!fout.fail());
+  }
+
+  std::string PhaseTracer::summary() const
+  {
+    // keep phases in order of first appearance, which follows the pipeline
+    std::vector<std::string> order;
+    std::map<std::string, PhaseTotals> totals;
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      for(int i=0; i<(int)events_.size(); i++){
+	const PhaseEvent &e = events_[i];
+	std::map<std::string, PhaseTotals>::iterator it = totals.find(e.name);
+	if(it == totals.end()){
+	  order.push_back(e.name);
+	  PhaseTotals t;
+	  t.count = 0;
+	  t.total_us = 0;
+	  t.max_us = 0;
+	  it = totals.insert(std::make_pair(std::string(e.name), t)).first;
+	}
+	it->second.count++;
+	it->second.total_us += e.duration_us;
+	if(e.duration_us > it->second.max_us) it->second.max_us = e.duration_us;
+      }
+    }
+
+    std::string table;
+    char line[256];
+    snprintf(line, sizeof(line), "%-40s %8s %12s %12s %12s\n", "phase", "count", "total(ms)", "mean(ms)", "max(ms)");
+    table += line;
+    for(int i=0; i<(int)order.size(); i++){
+      const PhaseTotals &t = totals[order[i]];
+      snprintf(line, sizeof(line), "%-40s %8d %12.3lf %12.3lf %12.3lf\n", order[i].c_str(), t.count,
+	       t.total_us/1000.0, t.total_us/1000.0/t.count, t.max_us/1000.0);
+      table += line;
+    }
+    return(table);
+  }
+
+}//end namespace industrial_extrinsic_cal
@@ -0,0 +1,83 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <industrial_extrinsic_cal/pose_diversity.h>
+#include <math.h>
+
+namespace industrial_extrinsic_cal
+{
+
+  PoseDiversityParameters defaultPoseDiversityParameters()
+  {
+    PoseDiversityParameters parameters;
+    parameters.max_frames = 20;
+    parameters.min_rotation = 0.1;
+    parameters.min_translation = 0.05;
+    parameters.min_quality = 0.25;
+    return(parameters);
+  }
+
+  double poseDistance(const Pose6d &a, const Pose6d &b, const PoseDiversityParameters &parameters)
+  {
+    Pose6d relative = a.getInverse() * b;
+    double rotation = sqrt(relative.ax*relative.ax + relative.ay*relative.ay + relative.az*relative.az);
+    double dx = a.x - b.x;
+    double dy = a.y - b.y;
+    double dz = a.z - b.z;
+    double translation = sqrt(dx*dx + dy*dy + dz*dz);
+    double r = rotation/parameters.min_rotation;
+    double t = translation/parameters.min_translation;
+    return(r > t ? r : t);
+  }
+
+  std::vector<int> selectDiverseFrames(const std::vector<FrameCandidate> &candidates,
+				       const PoseDiversityParameters &parameters)
+  {
+    std::vector<int> selected;
+    int n = (int)candidates.size();
+
+    // distance of each candidate to the nearest kept frame, negative once kept or rejected
+    std::vector<double> nearest(n, HUGE_VAL);
+    for(int i=0; i<n; i++){
+      if(candidates[i].quality < parameters.min_quality) nearest[i] = -1.0;
+    }
+
+    while((int)selected.size() < parameters.max_frames){
+      int best = -1;
+      double best_score = 0.0;
+      for(int i=0; i<n; i++){
+	if(nearest[i] < 1.0) continue; // too close to a kept frame
+	double score = selected.empty() ? candidates[i].quality : nearest[i]*candidates[i].quality;
+	if(best < 0 || score > best_score){
+	  best = i;
+	  best_score = score;
+	}
+      }
+      if(best < 0) break;
+      selected.push_back(best);
+      nearest[best] = -1.0;
+      for(int i=0; i<n; i++){
+	if(nearest[i] < 0.0) continue;
+	double d = poseDistance(candidates[best].pose, candidates[i].pose, parameters);
+	if(d < nearest[i]) nearest[i] = d;
+      }
+    }
+    return(selected);
+  }
+
+}//end namespace industrial_extrinsic_cal
@@ -0,0 +1,236 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <industrial_extrinsic_cal/quality_report.h>
+#include <industrial_extrinsic_cal/phase_timer.h>
+#include <industrial_extrinsic_cal/results_writer.h>
+#include <boost/foreach.hpp>
+#include <boost/thread.hpp>
+#include <math.h>
+#include <set>
+#include <sstream>
+#include <stdio.h>
+
+namespace industrial_extrinsic_cal
+{
+  namespace
+  {
+    void writeStatistics(std::ostream &out, const ReprojectionStatistics &statistics, const char *indent)
+    {
+      out << indent << "observations: " << statistics.num_observations << "\n";
+      out << indent << "rms: " << QualityReport::rms(statistics) << "\n";
+      out << indent << "max: " << statistics.max_error << "\n";
+    }
+  }
+
+  QualityParameters defaultQualityParameters()
+  {
+    QualityParameters parameters;
+    parameters.num_threads = boost::thread::hardware_concurrency();
+    if(parameters.num_threads < 1) parameters.num_threads = 1;
+    parameters.compute_covariance = true;
+    parameters.covariance_algorithm = ceres::SUITE_SPARSE_QR;
+    parameters.pixel_sigma = 1.0;
+    return(parameters);
+  }
+
+  QualityReport::QualityReport(const QualityParameters &parameters) :
+    parameters_(parameters)
+  {
+    overall_ = emptyStatistics();
+  }
+
+  void QualityReport::addExtrinsics(const ObservationDataPointList &observations)
+  {
+    BOOST_FOREACH(const ObservationDataPoint &ODP, observations.items_){
+      bool known_block = false;
+      bool known_name = false;
+      for(int i=0; i<(int)extrinsics_.size(); i++){
+	if(extrinsics_[i].block == ODP.camera_extrinsics_) known_block = true;
+	if(extrinsics_[i].name == ODP.camera_name_) known_name = true;
+      }
+      if(known_block) continue;
+
+      // a camera which moves between scenes has a block per scene
+      ExtrinsicsCovariance entry;
+      entry.name = ODP.camera_name_;
+      if(known_name){
+	std::ostringstream name;
+	name << ODP.camera_name_ << "_scene_" << ODP.scene_id_;
+	entry.name = name.str();
+      }
+      entry.block = ODP.camera_extrinsics_;
+      entry.valid = false;
+      for(int i=0; i<36; i++) entry.covariance[i] = 0.0;
+      extrinsics_.push_back(entry);
+    }
+  }
+
+  double QualityReport::rms(const ReprojectionStatistics &statistics)
+  {
+    if(statistics.num_observations == 0) return(0.0);
+    return(sqrt(statistics.sum_squares/statistics.num_observations));
+  }
+
+  ReprojectionStatistics QualityReport::emptyStatistics()
+  {
+    ReprojectionStatistics statistics;
+    statistics.num_observations = 0;
+    statistics.sum_squares = 0.0;
+    statistics.max_error = 0.0;
+    return(statistics);
+  }
+
+  void QualityReport::accumulate(ReprojectionStatistics &statistics, const double *residuals)
+  {
+    double squared_error = 0.0;
+    for(int i=0; i<RESIDUALS_PER_OBSERVATION; i++) squared_error += residuals[i]*residuals[i];
+    statistics.num_observations++;
+    statistics.sum_squares += squared_error;
+    double error = sqrt(squared_error);
+    if(error > statistics.max_error) statistics.max_error = error;
+  }
+
+  bool QualityReport::compute(ceres::Problem &problem, const std::vector<ObservationResidual> &residuals)
+  {
+    overall_ = emptyStatistics();
+    cameras_.clear();
+    scenes_.clear();
+
+    // one multi-threaded evaluation of every residual block, without its robust loss
+    std::vector<double> values;
+    {
+      CAL_PHASE_TIMER("QualityReport::evaluate");
+      ceres::Problem::EvaluateOptions evaluate_options;
+      evaluate_options.residual_blocks.reserve(residuals.size());
+      for(int i=0; i<(int)residuals.size(); i++) evaluate_options.residual_blocks.push_back(residuals[i].id);
+      evaluate_options.apply_loss_function = false;
+      evaluate_options.num_threads = parameters_.num_threads;
+      if(!residuals.empty() && !problem.Evaluate(evaluate_options, NULL, &values, NULL, NULL)) return(false);
+    }
+    if((int)values.size() != RESIDUALS_PER_OBSERVATION*(int)residuals.size()){
+      fprintf(stderr, "QualityReport: expected %d residuals per observation\n", RESIDUALS_PER_OBSERVATION);
+      return(false);
+    }
+
+    for(int i=0; i<(int)residuals.size(); i++){
+      const double *observation = &values[RESIDUALS_PER_OBSERVATION*i];
+      accumulate(overall_, observation);
+      if(cameras_.find(residuals[i].camera_name) == cameras_.end()) cameras_[residuals[i].camera_name] = emptyStatistics();
+      accumulate(cameras_[residuals[i].camera_name], observation);
+      if(scenes_.find(residuals[i].scene_id) == scenes_.end()) scenes_[residuals[i].scene_id] = emptyStatistics();
+      accumulate(scenes_[residuals[i].scene_id], observation);
+    }
+
+    if(parameters_.compute_covariance && !computeCovariance(problem)){
+      fprintf(stderr, "QualityReport: covariance of the extrinsics is unavailable\n");
+    }
+    return(true);
+  }
+
+  bool QualityReport::computeCovariance(ceres::Problem &problem)
+  {
+    CAL_PHASE_TIMER("QualityReport::covariance");
+    for(int i=0; i<(int)extrinsics_.size(); i++) extrinsics_[i].valid = false;
+
+    // only the diagonal blocks of the extrinsics, the sparse algorithm never forms the full covariance
+    std::vector<std::pair<const double*, const double*> > blocks;
+    std::set<const double*> requested;
+    for(int i=0; i<(int)extrinsics_.size(); i++){
+      const double *block = extrinsics_[i].block;
+      if(!problem.HasParameterBlock(block) || requested.count(block)) continue;
+      requested.insert(block);
+      blocks.push_back(std::make_pair(block, block));
+    }
+    if(blocks.empty()) return(true);
+
+    ceres::Covariance::Options options;
+    options.num_threads = parameters_.num_threads;
+    options.algorithm_type = parameters_.covariance_algorithm;
+    ceres::Covariance covariance(options);
+    if(!covariance.Compute(blocks, &problem)) return(false);
+
+    // the covariance assumes unit variance residuals
+    double sigma_squared = parameters_.pixel_sigma*parameters_.pixel_sigma;
+    for(int i=0; i<(int)extrinsics_.size(); i++){
+      if(!requested.count(extrinsics_[i].block)) continue;
+      if(!covariance.GetCovarianceBlock(extrinsics_[i].block, extrinsics_[i].block, extrinsics_[i].covariance)) continue;
+      for(int j=0; j<36; j++) extrinsics_[i].covariance[j] *= sigma_squared;
+      extrinsics_[i].valid = true;
+    }
+    return(true);
+  }
+
+  std::string QualityReport::summary() const
+  {
+    std::ostringstream out;
+    out << "reprojection error of " << overall_.num_observations << " observations: rms " << rms(overall_)
+	<< " max " << overall_.max_error << " pixels\n";
+    std::map<std::string, ReprojectionStatistics>::const_iterator it;
+    for(it = cameras_.begin(); it != cameras_.end(); ++it){
+      out << "  camera " << it->first << ": rms " << rms(it->second) << " max " << it->second.max_error << "\n";
+    }
+    for(int i=0; i<(int)extrinsics_.size(); i++){
+      const ExtrinsicsCovariance &e = extrinsics_[i];
+      if(!e.valid){
+	out << "  " << e.name << " extrinsics covariance unavailable\n";
+	continue;
+      }
+      out << "  " << e.name << " extrinsics std dev: rotation " << sqrt(e.covariance[0]) << " " << sqrt(e.covariance[7])
+	  << " " << sqrt(e.covariance[14]) << " rad, position " << sqrt(e.covariance[21]) << " "
+	  << sqrt(e.covariance[28]) << " " << sqrt(e.covariance[35]) << " m\n";
+    }
+    return(out.str());
+  }
+
+  bool QualityReport::write(const std::string &file_name) const
+  {
+    std::ostringstream out; // written as a whole, see writeFileAtomically()
+    out.precision(9);
+    out << "# reprojection errors in pixels, extrinsics are angle axis (rad) then position (m)\n";
+    out << "pixel_sigma: " << parameters_.pixel_sigma << "\n";
+    writeStatistics(out, overall_, "");
+    out << "cameras:\n";
+    std::map<std::string, ReprojectionStatistics>::const_iterator cit;
+    for(cit = cameras_.begin(); cit != cameras_.end(); ++cit){
+      out << "  - camera: " << cit->first << "\n";
+      writeStatistics(out, cit->second, "    ");
+    }
+    out << "scenes:\n";
+    std::map<int, ReprojectionStatistics>::const_iterator sit;
+    for(sit = scenes_.begin(); sit != scenes_.end(); ++sit){
+      out << "  - scene_id: " << sit->first << "\n";
+      writeStatistics(out, sit->second, "    ");
+    }
+    out << "extrinsics:\n";
+    for(int i=0; i<(int)extrinsics_.size(); i++){
+      const ExtrinsicsCovariance &e = extrinsics_[i];
+      out << "  - camera: " << e.name << "\n";
+      out << "    covariance_valid: " << (e.valid ? "true" : "false") << "\n";
+      if(!e.valid) continue;
+      out << "    std_dev: [";
+      for(int j=0; j<6; j++) out << (j ? ", " : "") << sqrt(e.covariance[7*j]);
+      out << "]\n";
+      out << "    covariance: [";
+      for(int j=0; j<36; j++) out << (j ? ", " : "") << e.covariance[j];
+      out << "]\n";
+    }
+    return(writeFileAtomically(file_name, out.str()));
+  }
+
+}//end namespace industrial_extrinsic_cal
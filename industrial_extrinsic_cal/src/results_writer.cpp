@@ -0,0 +1,150 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <industrial_extrinsic_cal/results_writer.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace industrial_extrinsic_cal
+{
+
+  bool string2ResultsFormat(const std::string &name, ResultsFormat &format)
+  {
+    if(name == "launch") format = RESULTS_LAUNCH;
+    else if(name == "yaml") format = RESULTS_YAML;
+    else if(name == "xacro") format = RESULTS_XACRO;
+    else return(false);
+    return(true);
+  }
+
+  bool writeFileAtomically(const std::string &file_name, const std::string &contents)
+  {
+    // the temporary file must be on the same file system for the rename to be atomic
+    std::string temp_name = file_name + ".XXXXXX";
+    std::vector<char> temp(temp_name.begin(), temp_name.end());
+    temp.push_back('\0');
+    int fd = mkstemp(&temp[0]);
+    if(fd < 0){
+      fprintf(stderr, "could not create a temporary file for %s: %s\n", file_name.c_str(), strerror(errno));
+      return(false);
+    }
+    fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH); // mkstemp makes it private, results are read by other users
+
+    const char *data = contents.c_str();
+    size_t remaining = contents.size();
+    bool ok = true;
+    while(ok && remaining > 0){
+      ssize_t written = ::write(fd, data, remaining);
+      if(written < 0 && errno == EINTR) continue;
+      ok = written > 0;
+      if(ok){
+	data += written;
+	remaining -= written;
+      }
+    }
+    ok = ok && fsync(fd) == 0; // on disk before it replaces the old file
+    ok = (close(fd) == 0) && ok;
+    ok = ok && rename(&temp[0], file_name.c_str()) == 0;
+    if(!ok){
+      fprintf(stderr, "could not write %s: %s\n", file_name.c_str(), strerror(errno));
+      unlink(&temp[0]);
+    }
+    return(ok);
+  }
+
+  void ResultsWriter::add(const std::string &parent_frame, const std::string &child_frame, const Pose6d &pose)
+  {
+    StoredTransform transform;
+    transform.parent_frame = parent_frame;
+    transform.child_frame = child_frame;
+    transform.pose = pose;
+    for(int i=0; i<(int)transforms_.size(); i++){
+      if(transforms_[i].child_frame == child_frame){
+	transforms_[i] = transform;
+	return;
+      }
+    }
+    transforms_.push_back(transform);
+  }
+
+  std::string ResultsWriter::format(ResultsFormat format) const
+  {
+    std::ostringstream out;
+    out.precision(9);
+    switch(format){
+    case RESULTS_LAUNCH:
+      out << "<launch>\n";
+      for(int i=0; i<(int)transforms_.size(); i++){
+	StoredTransform t = transforms_[i]; // getQuaternion() is not const
+	double qx, qy, qz, qw;
+	t.pose.getQuaternion(qx, qy, qz, qw);
+	out << "<node pkg=\"tf\" type=\"static_transform_publisher\" name=\"" << t.child_frame << "_tf_broadcaster\" args=\"";
+	out << t.pose.x << ' ' << t.pose.y << ' ' << t.pose.z << ' ';
+	out << qx << ' ' << qy << ' ' << qz << ' ' << qw;
+	out << " " << t.parent_frame << " " << t.child_frame << " 100\" />\n";
+      }
+      out << "</launch>\n";
+      break;
+    case RESULTS_YAML:
+      out << "# position (m) and quaternion x y z w of each child frame in its parent frame\n";
+      out << "transforms:\n";
+      for(int i=0; i<(int)transforms_.size(); i++){
+	StoredTransform t = transforms_[i]; // getQuaternion() is not const
+	double qx, qy, qz, qw;
+	t.pose.getQuaternion(qx, qy, qz, qw);
+	out << "  - parent_frame: " << t.parent_frame << "\n";
+	out << "    child_frame: " << t.child_frame << "\n";
+	out << "    position: [" << t.pose.x << ", " << t.pose.y << ", " << t.pose.z << "]\n";
+	out << "    quaternion: [" << qx << ", " << qy << ", " << qz << ", " << qw << "]\n";
+      }
+      break;
+    case RESULTS_XACRO:
+      out << "<?xml version=\"1.0\"?>\n";
+      out << "<robot xmlns:xacro=\"http://ros.org/wiki/xacro\">\n";
+      out << "  <xacro:macro name=\"calibrated_transforms\">\n";
+      for(int i=0; i<(int)transforms_.size(); i++){
+	const StoredTransform &t = transforms_[i];
+	double ez, ey, ex;
+	t.pose.getEulerZYX(ez, ey, ex); // urdf's fixed axis roll pitch yaw
+	out << "    <joint name=\"" << t.parent_frame << "_to_" << t.child_frame << "_joint\" type=\"fixed\">\n";
+	out << "      <parent link=\"" << t.parent_frame << "\"/>\n";
+	out << "      <child link=\"" << t.child_frame << "\"/>\n";
+	out << "      <origin xyz=\"" << t.pose.x << " " << t.pose.y << " " << t.pose.z << "\" rpy=\"";
+	out << ex << " " << ey << " " << ez << "\"/>\n";
+	out << "    </joint>\n";
+      }
+      out << "  </xacro:macro>\n";
+      out << "</robot>\n";
+      break;
+    }
+    return(out.str());
+  }
+
+  bool ResultsWriter::write(const std::string &file_name, ResultsFormat format) const
+  {
+    return(writeFileAtomically(file_name, this->format(format)));
+  }
+
+}//end namespace industrial_extrinsic_cal
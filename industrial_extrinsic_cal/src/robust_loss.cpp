@@ -0,0 +1,65 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <industrial_extrinsic_cal/robust_loss.h>
+
+namespace industrial_extrinsic_cal
+{
+  Loss_function string2LossType(std::string &loss_type_str)
+  {
+    if(loss_type_str == "none") return(loss_functions::NoLoss);
+    if(loss_type_str == "huber") return(loss_functions::HuberLoss);
+    if(loss_type_str == "cauchy") return(loss_functions::CauchyLoss);
+    return(loss_functions::NullLossType);
+  }
+
+  std::string lossType2String(Loss_function loss_type)
+  {
+    if(loss_type == loss_functions::NoLoss) return("none");
+    if(loss_type == loss_functions::HuberLoss) return("huber");
+    if(loss_type == loss_functions::CauchyLoss) return("cauchy");
+    return("unknown");
+  }
+
+  RobustLossTable::RobustLossTable()
+  {
+    default_loss_.type = loss_functions::NoLoss;
+    default_loss_.scale = 1.0;
+  }
+
+  RobustLoss RobustLossTable::get(Cost_function cost_type) const
+  {
+    std::map<Cost_function, RobustLoss>::const_iterator it = losses_.find(cost_type);
+    if(it != losses_.end()) return(it->second);
+    return(default_loss_);
+  }
+
+  ceres::LossFunction* RobustLossTable::create(Cost_function cost_type) const
+  {
+    RobustLoss loss = get(cost_type);
+    switch(loss.type){
+    case loss_functions::HuberLoss:
+      return(new ceres::HuberLoss(loss.scale));
+    case loss_functions::CauchyLoss:
+      return(new ceres::CauchyLoss(loss.scale));
+    default:
+      return(NULL);
+    }
+  }
+
+}//end namespace industrial_extrinsic_cal
@@ -17,11 +17,14 @@
  */
 
 #include <industrial_extrinsic_cal/ros_camera_observer.h>
+#include <industrial_extrinsic_cal/phase_timer.h>
+#include <algorithm>
 namespace industrial_extrinsic_cal
 {
 
 ROSCameraObserver::ROSCameraObserver(const std::string &camera_topic) :
-    sym_circle_(true), pattern_(pattern_options::Chessboard), pattern_rows_(0), pattern_cols_(0)
+    sym_circle_(true), pattern_(pattern_options::Chessboard), pattern_rows_(0), pattern_cols_(0),
+    frame_quality_parameters_(defaultFrameQualityParameters()), frame_usable_(true)
 {
   image_topic_ = camera_topic;
   //ROS_DEBUG_STREAM("ROSCameraObserver created with image topic: "<<image_topic_);
@@ -106,6 +109,7 @@ void ROSCameraObserver::clearObservations()
 
 int ROSCameraObserver::getObservations(CameraObservations &cam_obs)
 {
+  CAL_PHASE_TIMER("ROSCameraObserver::getObservations");
   bool successful_find = false;
 
   ROS_INFO_STREAM("image ROI region created: "<<input_roi_.x<<" "<<input_roi_.y<<" "<<input_roi_.width<<" "<<input_roi_.height);
@@ -115,33 +119,16 @@ int ROSCameraObserver::getObservations(CameraObservations &cam_obs)
     return 0;
   }
 
+  if (!frame_usable_)
+  {
+    ROS_WARN_STREAM("No usable frame from "<<image_topic_<<", detection skipped");
+    return 0;
+  }
+
   image_roi_ = input_bridge_->image(input_roi_);
 
-  observation_pts_.clear();
-  std::vector<cv::KeyPoint> key_points;
   ROS_INFO("Pattern type %d, rows %d, cols %d",pattern_,pattern_rows_,pattern_cols_);
-  
-  cv::Size pattern_size(pattern_cols_, pattern_rows_); // note they use cols then rows for some unknown reason
-  switch (pattern_)
-    {
-    case pattern_options::Chessboard:
-      ROS_INFO_STREAM("Finding Chessboard Corners...");
-      successful_find = cv::findChessboardCorners(image_roi_, pattern_size, observation_pts_, cv::CALIB_CB_ADAPTIVE_THRESH);
-      break;
-    case pattern_options::CircleGrid:
-      if (sym_circle_) // symetric circle grid
-	{
-	  ROS_INFO_STREAM("Finding Circles in grid, symmetric...");
-	  successful_find = cv::findCirclesGrid(image_roi_, pattern_size, observation_pts_, cv::CALIB_CB_SYMMETRIC_GRID);
-	}
-      else         // asymetric circle grid
-	{
-	  ROS_INFO_STREAM("Finding Circles in grid, asymmetric...");
-	  successful_find = cv::findCirclesGrid(image_roi_, pattern_size , observation_pts_, 
-						cv::CALIB_CB_ASYMMETRIC_GRID | cv::CALIB_CB_CLUSTERING);
-	}
-      break;
-    }
+  successful_find = findPattern(image_roi_, getDetectionSettings(), observation_pts_);
   
   if(successful_find)  ROS_INFO_STREAM("FOUND");
   ROS_INFO_STREAM("Number of keypoints found: "<<observation_pts_.size());
@@ -178,40 +165,142 @@ int ROSCameraObserver::getObservations(CameraObservations &cam_obs)
   }
 
   // copy the points found into a camera observation structure indicating their corresponece with target points
-  camera_obs_.resize(observation_pts_.size());
-  for (int i = 0; i < observation_pts_.size(); i++)
-  {
-    camera_obs_.at(i).target = instance_target_;
-    camera_obs_.at(i).point_id = i;
-    camera_obs_.at(i).image_loc_x = observation_pts_.at(i).x;
-    camera_obs_.at(i).image_loc_y = observation_pts_.at(i).y;
-    camera_obs_.at(i).cost_type = cost_type_;
-  }
+  toObservations(observation_pts_, getDetectionSettings(), camera_obs_);
 
   cam_obs = camera_obs_;
   return 1;
 }
 
-void ROSCameraObserver::triggerCamera()
+bool ROSCameraObserver::findPattern(const cv::Mat &image_roi, const DetectionSettings &settings,
+				    std::vector<cv::Point2f> &points)
 {
-  ROS_INFO("rosCameraObserver, waiting for image from topic %s",image_topic_.c_str());
-  sensor_msgs::ImageConstPtr recent_image = ros::topic::waitForMessage<sensor_msgs::Image>(image_topic_);
+  points.clear();
+  bool successful_find = false;
+  cv::Size pattern_size(settings.pattern_cols, settings.pattern_rows); // note they use cols then rows for some unknown reason
+  switch (settings.pattern)
+    {
+    case pattern_options::Chessboard:
+      successful_find = cv::findChessboardCorners(image_roi, pattern_size, points, cv::CALIB_CB_ADAPTIVE_THRESH);
+      break;
+    case pattern_options::CircleGrid:
+      if (settings.sym_circle) // symetric circle grid
+	{
+	  successful_find = cv::findCirclesGrid(image_roi, pattern_size, points, cv::CALIB_CB_SYMMETRIC_GRID);
+	}
+      else         // asymetric circle grid
+	{
+	  successful_find = cv::findCirclesGrid(image_roi, pattern_size , points, 
+						cv::CALIB_CB_ASYMMETRIC_GRID | cv::CALIB_CB_CLUSTERING);
+	}
+      break;
+    }
+  return successful_find;
+}
 
-  ROS_INFO("GOT IT");
-  try
+void ROSCameraObserver::toObservations(const std::vector<cv::Point2f> &points, const DetectionSettings &settings,
+				       CameraObservations &cam_obs)
+{
+  cam_obs.resize(points.size());
+  for (int i = 0; i < (int) points.size(); i++)
   {
-    input_bridge_ = cv_bridge::toCvCopy(recent_image, "mono8");
-    output_bridge_ = cv_bridge::toCvCopy(recent_image, "bgr8");
-    out_bridge_ = cv_bridge::toCvCopy(recent_image, "mono8");
-    ROS_INFO_STREAM("cv image created based on ros image");
+    cam_obs.at(i).target = settings.target;
+    cam_obs.at(i).point_id = i;
+    cam_obs.at(i).image_loc_x = points.at(i).x;
+    cam_obs.at(i).image_loc_y = points.at(i).y;
+    cam_obs.at(i).cost_type = settings.cost_type;
   }
-  catch (cv_bridge::Exception& ex)
+}
+
+DetectionSettings ROSCameraObserver::getDetectionSettings() const
+{
+  DetectionSettings settings;
+  settings.target = instance_target_;
+  settings.roi = input_roi_;
+  settings.pattern = pattern_;
+  settings.pattern_rows = pattern_rows_;
+  settings.pattern_cols = pattern_cols_;
+  settings.sym_circle = sym_circle_;
+  settings.cost_type = cost_type_;
+  return settings;
+}
+
+cv::Mat ROSCameraObserver::getImage() const
+{
+  // each trigger copies into a new bridge, the returned image is not overwritten by the next one
+  if (!input_bridge_)
   {
-    ROS_ERROR("Failed to convert image");
-    ROS_WARN_STREAM("cv_bridge exception: "<<ex.what());
-    return;
+    return cv::Mat();
   }
+  return input_bridge_->image;
+}
 
+bool ROSCameraObserver::checkFrame(const cv::Mat &image, FrameQuality &quality) const
+{
+  if (image.cols < input_roi_.x + input_roi_.width || image.rows < input_roi_.y + input_roi_.height)
+  {
+    return checkFrameQuality(image, frame_quality_parameters_, quality);
+  }
+  return checkFrameQuality(image(input_roi_), frame_quality_parameters_, quality);
+}
+
+bool ROSCameraObserver::detect(const cv::Mat &image, CameraObservations &cam_obs) const
+{
+  return detect(image, getDetectionSettings(), cam_obs);
+}
+
+bool ROSCameraObserver::detect(const cv::Mat &image, const DetectionSettings &settings, CameraObservations &cam_obs)
+{
+  cam_obs.clear();
+  if (!settings.target || image.cols < settings.roi.width || image.rows < settings.roi.height)
+  {
+    return false;
+  }
+  std::vector<cv::Point2f> points;
+  if (!findPattern(image(settings.roi), settings, points))
+  {
+    return false;
+  }
+  toObservations(points, settings, cam_obs);
+  return true;
+}
+
+void ROSCameraObserver::triggerCamera()
+{
+  CAL_PHASE_TIMER("ROSCameraObserver::triggerCamera");
+  ROS_INFO("rosCameraObserver, waiting for image from topic %s",image_topic_.c_str());
+  bool check = frameChecksEnabled(frame_quality_parameters_);
+  int max_grabs = check ? 1 + std::max(frame_quality_parameters_.max_regrabs, 0) : 1;
+  frame_usable_ = false;
+  for (int grab = 1; grab <= max_grabs && !frame_usable_; grab++)
+  {
+    sensor_msgs::ImageConstPtr recent_image = ros::topic::waitForMessage<sensor_msgs::Image>(image_topic_);
+    image_stamp_ = recent_image->header.stamp;
+
+    ROS_INFO("GOT IT");
+    try
+    {
+      input_bridge_ = cv_bridge::toCvCopy(recent_image, "mono8");
+      output_bridge_ = cv_bridge::toCvCopy(recent_image, "bgr8");
+      out_bridge_ = cv_bridge::toCvCopy(recent_image, "mono8");
+      ROS_INFO_STREAM("cv image created based on ros image");
+    }
+    catch (cv_bridge::Exception& ex)
+    {
+      ROS_ERROR("Failed to convert image");
+      ROS_WARN_STREAM("cv_bridge exception: "<<ex.what());
+      return;
+    }
+
+    // a blurred or washed out frame is replaced by the next one rather than searched
+    frame_usable_ = true;
+    FrameQuality quality;
+    if (check && !checkFrame(input_bridge_->image, quality))
+    {
+      ROS_WARN("frame %d of %d from %s is %s (focus %.1lf, saturated %.3lf)", grab, max_grabs, image_topic_.c_str(),
+	       quality.failure, quality.focus, quality.saturated_fraction);
+      frame_usable_ = false;
+    }
+  }
 }
 
 bool ROSCameraObserver::observationsDone()
@@ -17,30 +17,388 @@
  */
 
 #include <industrial_extrinsic_cal/ros_transform_interface.h>
+#include <industrial_extrinsic_cal/phase_timer.h>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 namespace industrial_extrinsic_cal
 {
-  /*! @brief uses tf listener to get a Pose6d. The pose returned transform points in the to_frame into the from_frame.
-   *   @param from_frame the starting frame
-   *   @param to_frame  the ending frame
-   *   @param tf_listener  the listener object, so we don't have to keep creating it
-   */
-  Pose6d getPoseFromTF(const std::string &from_frame, const std::string &to_frame, const tf::TransformListener &tf_listener)
+  Pose6d poseFromTF(const tf::Transform &transform)
   {
-    // get all the information from tf and from the mutable joint state publisher
-    tf::StampedTransform tf_transform; 
+    const tf::Matrix3x3 &basis = transform.getBasis();
+    RotationMatrix R;
+    for(int i=0; i<3; i++){
+      for(int j=0; j<3; j++){
+	R[i][j] = basis[i][j];
+      }
+    }
+    Pose6d pose;
+    pose.setBasis(R);
+    pose.setOrigin(transform.getOrigin().x(), transform.getOrigin().y(), transform.getOrigin().z());
+    return(pose);
+  }
+
+  tf::Transform poseToTF(const Pose6d &pose)
+  {
+    RotationMatrix R = pose.getBasis();
+    tf::Matrix3x3 basis(R[0][0], R[0][1], R[0][2],
+			R[1][0], R[1][1], R[1][2],
+			R[2][0], R[2][1], R[2][2]);
+    return(tf::Transform(basis, tf::Vector3(pose.x, pose.y, pose.z)));
+  }
+
+  SharedTransformBroadcaster::SharedTransformBroadcaster()
+  {
+    double rate = 10.0;
+    ros::NodeHandle("~").getParam("tf_broadcast_rate", rate);
+    setRate(rate);
+  }
+
+  SharedTransformBroadcaster& SharedTransformBroadcaster::instance()
+  {
+    static SharedTransformBroadcaster shared_broadcaster;
+    return(shared_broadcaster);
+  }
+
+  void SharedTransformBroadcaster::add(TransformBroadcastSource *source)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    if(std::find(sources_.begin(), sources_.end(), source) == sources_.end()) sources_.push_back(source);
+  }
+
+  void SharedTransformBroadcaster::remove(TransformBroadcastSource *source)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    sources_.erase(std::remove(sources_.begin(), sources_.end(), source), sources_.end());
+    static_sources_.erase(source);
+  }
+
+  void SharedTransformBroadcaster::setRate(double rate)
+  {
+    if(rate <= 0.0){
+      ROS_ERROR("tf broadcast rate must be positive, keeping the current rate");
+      return;
+    }
+    timer_ = nh_.createTimer(ros::Duration(1.0/rate), &SharedTransformBroadcaster::timerCallback, this);
+  }
+
+  void SharedTransformBroadcaster::timerCallback(const ros::TimerEvent & timer_event)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    send(false);
+  }
+
+  void SharedTransformBroadcaster::update()
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    // a stored frame stays on /tf_static, sending its new pose on /tf as well would give tf two parents to choose from
+    send(true);
+  }
+
+  void SharedTransformBroadcaster::publishStatic()
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    static_sources_.insert(sources_.begin(), sources_.end());
+    send(true);
+  }
+
+  void SharedTransformBroadcaster::send(bool latch)
+  {
+    // one message, one stamp for all frames
     ros::Time now = ros::Time::now();
-    while(! tf_listener.waitForTransform(from_frame, to_frame, now, ros::Duration(1.0))){
-      ROS_INFO("waiting for tranform from  %s to  %s",from_frame.c_str(),to_frame.c_str());
+    std::vector<tf::StampedTransform> transforms;
+    std::vector<geometry_msgs::TransformStamped> messages;
+    tf::StampedTransform transform;
+    for(int i=0; i<(int)sources_.size(); i++){
+      bool stored = static_sources_.count(sources_[i]) > 0;
+      if(stored && !latch) continue; // latched already, a static frame never expires
+      if(!sources_[i]->getBroadcastTransform(transform)) continue;
+      transform.stamp_ = now;
+      if(!stored){
+	transforms.push_back(transform);
+	continue;
+      }
+      messages.push_back(geometry_msgs::TransformStamped());
+      tf::transformStampedTFToMsg(transform, messages.back());
+    }
+    if(!transforms.empty()) tf_broadcaster_.sendTransform(transforms);
+    // the static broadcaster keeps one transform per child frame, a frame latched again replaces its old pose
+    if(!messages.empty()) static_broadcaster_.sendTransform(messages);
+  }
+
+  SharedTransformListener::SharedTransformListener() :
+    tf_listener_(cacheTime()), wait_time_(5.0), failures_(0)
+  {
+    double wait_time = wait_time_.toSec();
+    ros::NodeHandle("~").getParam("tf_wait_time", wait_time);
+    wait_time_ = ros::Duration(wait_time);
+  }
+
+  ros::Duration SharedTransformListener::cacheTime()
+  {
+    // poses are looked up at image stamps, which lag the latest data by the detection time
+    double cache_time = 10.0;
+    ros::NodeHandle("~").getParam("tf_cache_time", cache_time);
+    return(ros::Duration(cache_time));
+  }
+
+  SharedTransformListener& SharedTransformListener::instance()
+  {
+    static SharedTransformListener shared_listener;
+    return(shared_listener);
+  }
+
+  bool SharedTransformListener::lookupAt(const std::string &from_frame, const std::string &to_frame,
+					 const ros::Time &stamp, Pose6d &pose)
+  {
+    // a stamp older than the buffer never becomes available, so the wait is bounded
+    std::string error;
+    if(!tf_listener_.waitForTransform(from_frame, to_frame, stamp, wait_time_, ros::Duration(0.01), &error)){
+      ROS_ERROR("no transform from %s to %s at %.3lf within %.1lf s: %s", from_frame.c_str(), to_frame.c_str(),
+		stamp.toSec(), wait_time_.toSec(), error.c_str());
+      return(false);
+    }
+    tf::StampedTransform tf_transform; 
+    try{
+      tf_listener_.lookupTransform(from_frame, to_frame, stamp, tf_transform);
     }
-    tf_listener.lookupTransform(from_frame, to_frame, now, tf_transform);
+    catch (tf::TransformException &ex){
+      ROS_ERROR("transform from %s to %s: %s", from_frame.c_str(), to_frame.c_str(), ex.what());
+      return(false);
+    }
+    pose = poseFromTF(tf_transform);
+    return(true);
+  }
+
+  Pose6d SharedTransformListener::lookup(const std::string &from_frame, const std::string &to_frame)
+  {
+    std::map<TFFramePair, Pose6d>::const_iterator it = batch_.find(TFFramePair(from_frame, to_frame));
+    if(it != batch_.end()) return(it->second);
     Pose6d pose;
-    pose.setBasis(tf_transform.getBasis());
-    pose.setOrigin(tf_transform.getOrigin());
+    if(!lookupAt(from_frame, to_frame, ros::Time::now(), pose)) failures_++;
     return(pose);
   }
 
+  bool SharedTransformListener::beginBatch(const std::vector<TFFramePair> &frames, const ros::Time &batch_stamp)
+  {
+    CAL_PHASE_TIMER("SharedTransformListener::beginBatch");
+    batch_.clear();
+    // once the tree reaches the stamp for the first pair, the others are usually available without waiting
+    ros::Time stamp = batch_stamp.isZero() ? ros::Time::now() : batch_stamp;
+    if(!batch_stamp.isZero()){
+      boost::mutex::scoped_lock lock(snapshot_mutex_);
+      std::map<ros::Time, std::map<TFFramePair, Pose6d> >::const_iterator it = snapshots_.find(batch_stamp);
+      if(it != snapshots_.end()) batch_ = it->second;
+    }
+    bool rtn = true;
+    for(int i=0; i<(int)frames.size(); i++){
+      if(batch_.count(frames[i])) continue;
+      Pose6d pose;
+      if(!lookupAt(frames[i].first, frames[i].second, stamp, pose)){
+	failures_++;
+	rtn = false;
+	continue;
+      }
+      batch_[frames[i]] = pose;
+    }
+    return(rtn);
+  }
+
+  void SharedTransformListener::endBatch()
+  {
+    batch_.clear();
+  }
+
+  bool SharedTransformListener::snapshot(const std::vector<TFFramePair> &frames, const ros::Time &stamp)
+  {
+    CAL_PHASE_TIMER("SharedTransformListener::snapshot");
+    std::map<TFFramePair, Pose6d> poses;
+    for(int i=0; i<(int)frames.size(); i++){
+      if(poses.count(frames[i])) continue;
+      Pose6d pose;
+      if(!lookupAt(frames[i].first, frames[i].second, stamp, pose)) return(false);
+      poses[frames[i]] = pose;
+    }
+    boost::mutex::scoped_lock lock(snapshot_mutex_);
+    snapshots_[stamp] = poses;
+    return(true);
+  }
+
+  void SharedTransformListener::clearSnapshots()
+  {
+    boost::mutex::scoped_lock lock(snapshot_mutex_);
+    snapshots_.clear();
+  }
+
+  ScopedTransformBatch::ScopedTransformBatch(const std::vector<TFFramePair> &frames, const ros::Time &stamp) :
+    active_(!frames.empty()), ok_(true)
+  {
+    if(active_) ok_ = SharedTransformListener::instance().beginBatch(frames, stamp);
+  }
+
+  ScopedTransformBatch::~ScopedTransformBatch()
+  {
+    if(active_) SharedTransformListener::instance().endBatch();
+  }
+
+  SharedMutableJoints::SharedMutableJoints() :
+    writing_(false)
+  {
+    transaction_client_ = nh_.serviceClient<industrial_extrinsic_cal::mutable_joint_states_transaction>("mutable_joint_states_transaction");
+    get_client_ = nh_.serviceClient<industrial_extrinsic_cal::get_mutable_joint_states>("get_mutable_joint_states");
+    set_client_ = nh_.serviceClient<industrial_extrinsic_cal::set_mutable_joint_states>("set_mutable_joint_states");
+  }
+
+  SharedMutableJoints& SharedMutableJoints::instance()
+  {
+    static SharedMutableJoints shared_joints;
+    return(shared_joints);
+  }
+
+  bool SharedMutableJoints::call(industrial_extrinsic_cal::mutable_joint_states_transaction::Request &request,
+				 industrial_extrinsic_cal::mutable_joint_states_transaction::Response &response)
+  {
+    if(transaction_client_.call(request, response)) return(response.success);
+
+    // a publisher older than the transaction service, still two calls instead of two per interface
+    if(transaction_client_.exists()) return(false);
+    response.joint_names.clear();
+    response.joint_values.clear();
+    if(!request.set_joint_names.empty()){
+      industrial_extrinsic_cal::set_mutable_joint_states::Request set_request;
+      industrial_extrinsic_cal::set_mutable_joint_states::Response set_response;
+      set_request.joint_names = request.set_joint_names;
+      set_request.joint_values = request.set_joint_values;
+      if(!set_client_.call(set_request, set_response)) return(false);
+    }
+    if(!request.get_joint_names.empty()){
+      industrial_extrinsic_cal::get_mutable_joint_states::Request get_request;
+      industrial_extrinsic_cal::get_mutable_joint_states::Response get_response;
+      get_request.joint_names = request.get_joint_names;
+      if(!get_client_.call(get_request, get_response)) return(false);
+      response.joint_names = get_response.joint_names;
+      response.joint_values = get_response.joint_values;
+    }
+    response.success = true;
+    return(true);
+  }
+
+  bool SharedMutableJoints::beginRead(const std::vector<std::string> &joint_names)
+  {
+    CAL_PHASE_TIMER("SharedMutableJoints::beginRead");
+    boost::mutex::scoped_lock lock(mutex_);
+    values_.clear();
+    industrial_extrinsic_cal::mutable_joint_states_transaction::Request request;
+    industrial_extrinsic_cal::mutable_joint_states_transaction::Response response;
+    std::map<std::string, double> requested;
+    for(int i=0; i<(int)joint_names.size(); i++){
+      if(requested.count(joint_names[i])) continue;
+      requested[joint_names[i]] = 0.0;
+      request.get_joint_names.push_back(joint_names[i]);
+    }
+    if(!call(request, response) || response.joint_names.size() != response.joint_values.size()){
+      ROS_ERROR("could not read %d mutable joints in one transaction", (int)request.get_joint_names.size());
+      return(false);
+    }
+    for(int i=0; i<(int)response.joint_names.size(); i++){
+      values_[response.joint_names[i]] = response.joint_values[i];
+    }
+    return(true);
+  }
+
+  void SharedMutableJoints::endRead()
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    values_.clear();
+  }
+
+  bool SharedMutableJoints::cached(const std::vector<std::string> &joint_names, std::vector<double> &joint_values)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    joint_values.clear();
+    for(int i=0; i<(int)joint_names.size(); i++){
+      std::map<std::string, double>::const_iterator it = values_.find(joint_names[i]);
+      if(it == values_.end()) return(false);
+      joint_values.push_back(it->second);
+    }
+    return(true);
+  }
+
+  void SharedMutableJoints::beginWrite()
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    writing_ = true;
+    write_names_.clear();
+    write_values_.clear();
+  }
+
+  bool SharedMutableJoints::queue(const std::vector<std::string> &joint_names, const std::vector<double> &joint_values)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    if(!writing_) return(false);
+    for(int i=0; i<(int)joint_names.size() && i<(int)joint_values.size(); i++){
+      if(!write_values_.count(joint_names[i])) write_names_.push_back(joint_names[i]);
+      write_values_[joint_names[i]] = joint_values[i];
+      // a read in progress sees the new value, as it would after a set
+      if(values_.count(joint_names[i])) values_[joint_names[i]] = joint_values[i];
+    }
+    return(true);
+  }
+
+  bool SharedMutableJoints::commitWrite()
+  {
+    CAL_PHASE_TIMER("SharedMutableJoints::commitWrite");
+    boost::mutex::scoped_lock lock(mutex_);
+    writing_ = false;
+    if(write_names_.empty()) return(true);
+    industrial_extrinsic_cal::mutable_joint_states_transaction::Request request;
+    industrial_extrinsic_cal::mutable_joint_states_transaction::Response response;
+    for(int i=0; i<(int)write_names_.size(); i++){
+      request.set_joint_names.push_back(write_names_[i]);
+      request.set_joint_values.push_back(write_values_[write_names_[i]]);
+    }
+    write_names_.clear();
+    write_values_.clear();
+    bool rtn = call(request, response);
+    if(!rtn){
+      ROS_ERROR("could not set %d mutable joints in one transaction", (int)request.set_joint_names.size());
+      for(int i=0; i<(int)response.unknown_joint_names.size(); i++){
+	ROS_ERROR("unknown mutable joint %s", response.unknown_joint_names[i].c_str());
+      }
+    }
+    return(rtn);
+  }
+
+  ScopedMutableJointRead::ScopedMutableJointRead(const std::vector<std::string> &joint_names) :
+    active_(!joint_names.empty())
+  {
+    if(active_) SharedMutableJoints::instance().beginRead(joint_names);
+  }
+
+  ScopedMutableJointRead::~ScopedMutableJointRead()
+  {
+    if(active_) SharedMutableJoints::instance().endRead();
+  }
+
+  ScopedMutableJointWrite::ScopedMutableJointWrite()
+  {
+    SharedMutableJoints::instance().beginWrite();
+  }
+
+  ScopedMutableJointWrite::~ScopedMutableJointWrite()
+  {
+    SharedMutableJoints::instance().commitWrite();
+  }
+
+  /*! @brief uses the shared tf listener to get a Pose6d. The pose returned transform points in the to_frame into the from_frame.
+   *   @param from_frame the starting frame
+   *   @param to_frame  the ending frame
+   */
+  Pose6d getPoseFromTF(const std::string &from_frame, const std::string &to_frame)
+  {
+    return(SharedTransformListener::instance().lookup(from_frame, to_frame));
+  }
+
   using std::string;
 
   ROSListenerTransInterface::ROSListenerTransInterface(const string & transform_frame) 
@@ -52,17 +410,23 @@ namespace industrial_extrinsic_cal
 
   Pose6d  ROSListenerTransInterface::pullTransform()
   {
+    CAL_PHASE_TIMER("TransformInterface::pullTransform");
     if(!ref_frame_initialized_){
       Pose6d pose(0,0,0,0,0,0);
       ROS_ERROR("Trying to pull transform from interface without setting reference frame");
       return(pose);
     }
     else{
-      pose_ = getPoseFromTF(ref_frame_, transform_frame_, tf_listener_);
+      pose_ = getPoseFromTF(ref_frame_, transform_frame_);
       return(pose_);
     }
   }
 
+  void ROSListenerTransInterface::getTFFrames(std::vector<TFFramePair> &frames)
+  {
+    if(ref_frame_initialized_) frames.push_back(TFFramePair(ref_frame_, transform_frame_));
+  }
+
   ROSCameraListenerTransInterface::ROSCameraListenerTransInterface(const string & transform_frame) 
   {
     transform_frame_ = transform_frame;
@@ -72,17 +436,23 @@ namespace industrial_extrinsic_cal
 
   Pose6d  ROSCameraListenerTransInterface::pullTransform()
   {
+    CAL_PHASE_TIMER("TransformInterface::pullTransform");
     if(!ref_frame_initialized_){
       Pose6d pose(0,0,0,0,0,0);
       ROS_ERROR("Trying to pull transform from interface without setting reference frame");
       return(pose);
     }
     else{
-      pose_ = getPoseFromTF(transform_frame_, ref_frame_, tf_listener_);
+      pose_ = getPoseFromTF(transform_frame_, ref_frame_);
       return(pose_);
     }
   }
 
+  void ROSCameraListenerTransInterface::getTFFrames(std::vector<TFFramePair> &frames)
+  {
+    if(ref_frame_initialized_) frames.push_back(TFFramePair(transform_frame_, ref_frame_));
+  }
+
   /** @brief this object is intened to be used for cameras not targets
    *            It simply listens to a pose from camera's optical frame to reference frame, this must be set in a urdf
    *            This is the inverse of the transform from world to camera's optical frame
@@ -98,19 +468,31 @@ namespace industrial_extrinsic_cal
 
   Pose6d  ROSCameraHousingListenerTInterface::pullTransform()
   {
+    CAL_PHASE_TIMER("TransformInterface::pullTransform");
     if(!ref_frame_initialized_){
       Pose6d pose(0,0,0,0,0,0);
       ROS_ERROR("Trying to pull transform from interface without setting reference frame");
       return(pose);
     }
     else{
-      pose_ = getPoseFromTF(transform_frame_, ref_frame_, tf_listener_);
+      pose_ = getPoseFromTF(transform_frame_, ref_frame_);
       return(pose_);
     }
   }
 
+  void ROSCameraHousingListenerTInterface::getTFFrames(std::vector<TFFramePair> &frames)
+  {
+    if(ref_frame_initialized_) frames.push_back(TFFramePair(transform_frame_, ref_frame_));
+  }
+
+  ROSBroadcastTransInterface::~ROSBroadcastTransInterface()
+  {
+    SharedTransformBroadcaster::instance().remove(this);
+  }
+
   ROSBroadcastTransInterface::ROSBroadcastTransInterface(const string & transform_frame, const Pose6d & pose)
   {
+    ref_frame_defined_            = false;
     transform_frame_                = transform_frame;
     transform_.child_frame_id_ = transform_frame_;
     ref_frame_initialized_         = false;    // still need to initialize ref_frame_
@@ -120,56 +502,48 @@ namespace industrial_extrinsic_cal
   bool   ROSBroadcastTransInterface::pushTransform(Pose6d & pose)
   {
     pose_ = pose; 
-    if(!ref_frame_initialized_){ 
-      return(false);		// timer won't start publishing until ref_frame_ is defined
+    if(!ref_frame_defined_){ 
+      return(false);		// nothing is broadcast until ref_frame_ is defined
     }
     return(true);
   }
 
-  bool  ROSBroadcastTransInterface::store(std::string & filePath)
-  {
-    std::ofstream outputFile(filePath.c_str(), std::ios::app); // open for appending
-    if (outputFile.is_open())
-      {
-	double qx,qy,qz,qw;
-	pose_.getQuaternion(qx, qy, qz, qw);
-	outputFile<<"<node pkg=\"tf\" type=\"static_transform_publisher\" name=\"";
-	outputFile<< transform_frame_ <<"_tf_broadcaster"<<"\" args=\"";
-	outputFile<< pose_.x << ' '<< pose_.y << ' '<< pose_.z << ' ';
-	outputFile<< qx << ' '<< qy << ' '<<qz << ' ' << qw ;
-	outputFile<<" "<< ref_frame_;
-	outputFile<<" "<<transform_frame_;
-	outputFile<<" 100\" />"<<std::endl;
-	outputFile.close();	
-	return(true);
-      }
-    else
-      {
-	ROS_ERROR_STREAM("Unable to open file:" <<filePath);
-	return false;
-      }//end if writing to file
-  }
-
   void  ROSBroadcastTransInterface::setReferenceFrame(string &ref_frame)
   {
-    static ros::NodeHandle nh;
     ref_frame_              = ref_frame;
     ref_frame_defined_ = true;
-    timer_                     = nh.createTimer(ros::Rate(1.0),&ROSBroadcastTransInterface::timerCallback, this);
+    SharedTransformBroadcaster::instance().add(this);
   }
 
-  void  ROSBroadcastTransInterface::timerCallback(const ros::TimerEvent & timer_event)
-  { // broadcast current value of pose as a transform each time called
-    transform_.setBasis(pose_.getBasis());
-    transform_.setOrigin(pose_.getOrigin());
+  bool ROSBroadcastTransInterface::getStoredTransform(std::string &parent_frame, std::string &child_frame, Pose6d &pose)
+  {
+    if(!ref_frame_defined_) return(false); // there is no parent frame to store it in
+    parent_frame = ref_frame_;
+    child_frame = transform_frame_;
+    pose = pose_;
+    return(true);
+  }
+
+  bool  ROSBroadcastTransInterface::getBroadcastTransform(tf::StampedTransform &transform)
+  { // current value of pose as a transform
+    if(!ref_frame_defined_) return(false);
+    tf::Transform pose_transform = poseToTF(pose_);
+    transform_.setBasis(pose_transform.getBasis());
+    transform_.setOrigin(pose_transform.getOrigin());
     transform_.child_frame_id_ = transform_frame_;
     transform_.frame_id_ = ref_frame_;
-    //    ROS_INFO("broadcasting %s in %s",transform_frame_.c_str(),ref_frame_.c_str());
-    tf_broadcaster_.sendTransform(tf::StampedTransform(transform_, ros::Time::now(), transform_frame_, ref_frame_));
+    transform = tf::StampedTransform(transform_, ros::Time::now(), transform_frame_, ref_frame_);
+    return(true);
+  }
+
+  ROSCameraBroadcastTransInterface::~ROSCameraBroadcastTransInterface()
+  {
+    SharedTransformBroadcaster::instance().remove(this);
   }
 
   ROSCameraBroadcastTransInterface::ROSCameraBroadcastTransInterface(const string & transform_frame, const Pose6d & pose)
   {
+    ref_frame_defined_            = false;
     transform_frame_                = transform_frame;
     transform_.child_frame_id_ = transform_frame_;
     ref_frame_initialized_         = false;    // still need to initialize ref_frame_
@@ -179,56 +553,48 @@ namespace industrial_extrinsic_cal
   bool   ROSCameraBroadcastTransInterface::pushTransform(Pose6d & pose)
   {
     pose_ = pose; 
-    if(!ref_frame_initialized_){ 
-      return(false);		// timer won't start publishing until ref_frame_ is defined
+    if(!ref_frame_defined_){ 
+      return(false);		// nothing is broadcast until ref_frame_ is defined
     }
     return(true);
   }
 
-  bool  ROSCameraBroadcastTransInterface::store(std::string & filePath)
-  {
-    std::ofstream outputFile(filePath.c_str(), std::ios::app); // open for appending
-    if (outputFile.is_open())
-      {
-	double qx,qy,qz,qw;
-	pose_.getInverse().getQuaternion(qx, qy, qz, qw);
-	outputFile<<"<node pkg=\"tf\" type=\"static_transform_publisher\" name=\"";
-	outputFile<<transform_frame_<<"_tf_broadcaster"<<"\" args=\"";
-	outputFile<< pose_.getInverse().x << ' '<< pose_.getInverse().y << ' '<< pose_.getInverse().z << ' ';
-	outputFile<< qx << ' '<< qy << ' '<<qz << ' ' << qw ;
-	outputFile<<" "<<ref_frame_;
-	outputFile<<" "<<transform_frame_;
-	outputFile<<" 100\" />"<<std::endl;
-	outputFile.close();	
-	return(true);
-      }
-    else
-      {
-	ROS_ERROR_STREAM("Unable to open file:" <<filePath);
-	return false;
-      }//end if writing to file
-  }
-
   void ROSCameraBroadcastTransInterface::setReferenceFrame(string &ref_frame)
   {
-    static ros::NodeHandle nh;
     ref_frame_              = ref_frame;
     ref_frame_defined_ = true;
-    timer_                     = nh.createTimer(ros::Rate(1.0),&ROSCameraBroadcastTransInterface::timerCallback, this);
+    SharedTransformBroadcaster::instance().add(this);
   }
 
-  void  ROSCameraBroadcastTransInterface::timerCallback(const ros::TimerEvent & timer_event)
-  { // broadcast current value of pose.inverse() as a transform each time called
-    transform_.setBasis(pose_.getInverse().getBasis());
-    transform_.setOrigin(pose_.getInverse().getOrigin());
+  bool ROSCameraBroadcastTransInterface::getStoredTransform(std::string &parent_frame, std::string &child_frame, Pose6d &pose)
+  {
+    if(!ref_frame_defined_) return(false); // there is no parent frame to store it in
+    parent_frame = ref_frame_;
+    child_frame = transform_frame_;
+    pose = pose_.getInverse();
+    return(true);
+  }
+
+  bool  ROSCameraBroadcastTransInterface::getBroadcastTransform(tf::StampedTransform &transform)
+  { // current value of pose.inverse() as a transform
+    if(!ref_frame_defined_) return(false);
+    tf::Transform inverse_transform = poseToTF(pose_.getInverse());
+    transform_.setBasis(inverse_transform.getBasis());
+    transform_.setOrigin(inverse_transform.getOrigin());
     transform_.child_frame_id_ = transform_frame_;
     transform_.frame_id_ = ref_frame_;
-    //    ROS_INFO("broadcasting %s in %s",transform_frame_.c_str(),ref_frame_.c_str());
-    tf_broadcaster_.sendTransform(tf::StampedTransform(transform_, ros::Time::now(), transform_frame_, ref_frame_));
+    transform = tf::StampedTransform(transform_, ros::Time::now(), transform_frame_, ref_frame_);
+    return(true);
+  }
+
+  ROSCameraHousingBroadcastTInterface::~ROSCameraHousingBroadcastTInterface()
+  {
+    SharedTransformBroadcaster::instance().remove(this);
   }
 
   ROSCameraHousingBroadcastTInterface::ROSCameraHousingBroadcastTInterface(const string & transform_frame, const Pose6d & pose)
   {
+    ref_frame_defined_            = false;
     transform_frame_                = transform_frame;
     transform_.child_frame_id_ = transform_frame_;
     ref_frame_initialized_         = false;    // still need to initialize ref_frame_
@@ -238,66 +604,53 @@ namespace industrial_extrinsic_cal
   bool   ROSCameraHousingBroadcastTInterface::pushTransform(Pose6d & pose)
   {
     pose_ = pose; 
-    if(!ref_frame_initialized_){ 
-      return(false);		// timer won't start publishing until ref_frame_ is defined
+    if(!ref_frame_defined_){ 
+      return(false);		// nothing is broadcast until ref_frame_ is defined
     }
+    resolveHousing();
     return(true);
   }
 
-  bool  ROSCameraHousingBroadcastTInterface::store(std::string & filePath)
-  {
-    std::ofstream outputFile(filePath.c_str(), std::ios::app); // open for appending
-    if (outputFile.is_open()){
-      // Camer optical frame to ref is estimated by bundle adjustment  optical2ref
-      // Camer housing to camera optical frame is specified by urdf   optical2housing
-      // Desired ref2optical = optical2ref^-1 * optical2housing
-      
-      Pose6d optical2housing = getPoseFromTF(transform_frame_, housing_frame_, tf_listener_);
-      Pose6d ref2housing        = pose_.getInverse() * optical2housing;
-      
-      // append the transform to a launch file
-      double qx,qy,qz,qw;
-      ref2housing.getQuaternion(qx, qy, qz, qw);
-      outputFile<<"<node pkg=\"tf\" type=\"static_transform_publisher\" name=\"";
-      outputFile<<transform_frame_<<"_tf_broadcaster"<<"\" args=\"";
-      outputFile<< ref2housing.x << ' '<< ref2housing.y << ' '<< ref2housing.z << ' ';
-      outputFile<< qx << ' '<< qy << ' '<<qz << ' ' << qw ;
-      outputFile<<" "<<ref_frame_;
-      outputFile<<" "<<transform_frame_;
-      outputFile<<" 100\" />"<<std::endl;
-      outputFile.close();	
-      return(true);
-    }
-    else{
-      ROS_ERROR_STREAM("Unable to open file:" <<filePath);
-      return false;
-    }//end if writing to file
-  }
-
   void  ROSCameraHousingBroadcastTInterface::setReferenceFrame(std::string &ref_frame)
   {
-    static ros::NodeHandle nh;
     ref_frame_              = ref_frame;
     ref_frame_defined_ = true;
-    timer_                     = nh.createTimer(ros::Rate(1.0),&ROSCameraHousingBroadcastTInterface::timerCallback, this);
+    resolveHousing();
+    SharedTransformBroadcaster::instance().add(this);
   }
 
-  void  ROSCameraHousingBroadcastTInterface::timerCallback(const ros::TimerEvent & timer_event)
-  { // broadcast current value of pose.inverse() as a transform each time called
-
+  void ROSCameraHousingBroadcastTInterface::resolveHousing()
+  {
     // Camer optical frame to ref is estimated by bundle adjustment  pose_ = optical2ref
     // Camer housing to camera optical frame is specified by urdf   optical2housing
     // Desired ref2housing = optical2ref^-1 * optical2housing
+    Pose6d optical2housing = getPoseFromTF(transform_frame_, housing_frame_);
+    ref2housing_ = pose_.getInverse() * optical2housing;
+  }
+
+  bool ROSCameraHousingBroadcastTInterface::getStoredTransform(std::string &parent_frame, std::string &child_frame, Pose6d &pose)
+  {
+    if(!ref_frame_defined_) return(false); // there is no parent frame to store it in
+    // the housing is what gets published, as getBroadcastTransform() does, ref2housing = optical2ref^-1 * optical2housing
+    Pose6d optical2housing = getPoseFromTF(transform_frame_, housing_frame_);
+    parent_frame = ref_frame_;
+    child_frame = housing_frame_;
+    pose = pose_.getInverse() * optical2housing;
+    return(true);
+  }
+
+  bool  ROSCameraHousingBroadcastTInterface::getBroadcastTransform(tf::StampedTransform &transform)
+  { // the housing pose resolved by the last push, a tf lookup here would block the broadcaster of every frame
+    if(!ref_frame_defined_) return(false);
 
-    Pose6d optical2housing = getPoseFromTF(transform_frame_, housing_frame_, tf_listener_);
-    Pose6d ref2housing = pose_.getInverse() * optical2housing;
-    
     // copy into the stamped transform
-    transform_.setBasis(ref2housing.getBasis());
-    transform_.setOrigin(ref2housing.getOrigin());
+    tf::Transform housing_transform = poseToTF(ref2housing_);
+    transform_.setBasis(housing_transform.getBasis());
+    transform_.setOrigin(housing_transform.getOrigin());
     transform_.child_frame_id_ = housing_frame_;
     transform_.frame_id_ = ref_frame_;
-    tf_broadcaster_.sendTransform(tf::StampedTransform(transform_, ros::Time::now(), housing_frame_, ref_frame_));
+    transform = tf::StampedTransform(transform_, ros::Time::now(), housing_frame_, ref_frame_);
+    return(true);
   }
 
   ROSCameraHousingCalTInterface::ROSCameraHousingCalTInterface(const string &transform_frame, 
@@ -340,6 +693,7 @@ namespace industrial_extrinsic_cal
 
   Pose6d  ROSCameraHousingCalTInterface::pullTransform()
   {
+    CAL_PHASE_TIMER("TransformInterface::pullTransform");
     // The computed transform from the optical frame to the mounting frame is composed of 2 transforms
     // one from the optical frame to the housing, and
     // one from the housing to the mounting frame which is composed of the 6DOF unknowns we are trying to calibrate
@@ -352,13 +706,20 @@ namespace industrial_extrinsic_cal
     }
 
     // get all the information from tf and from the mutable joint state publisher
-    Pose6d optical2housing = getPoseFromTF( transform_frame_, housing_frame_, tf_listener_);
+    Pose6d optical2housing = getPoseFromTF( transform_frame_, housing_frame_);
 
-    // get the transform from housing 2 mount  from the client
+    // get the transform from housing 2 mount from the joints read for the scene, or from the client
     Pose6d mount2housing;
-    get_client_.call(get_request_,get_response_);
-    mount2housing.setOrigin(get_response_.joint_values[0],get_response_.joint_values[1],get_response_.joint_values[2]);
-    mount2housing.setEulerZYX(get_response_.joint_values[3],get_response_.joint_values[4],get_response_.joint_values[5]);
+    if(!SharedMutableJoints::instance().cached(get_request_.joint_names, joint_values_)){
+      get_client_.call(get_request_,get_response_);
+      joint_values_ = get_response_.joint_values;
+    }
+    if(joint_values_.size() != 6){
+      ROS_ERROR("could not get the joints of %s", housing_frame_.c_str());
+      return(pose_);
+    }
+    mount2housing.setOrigin(joint_values_[0],joint_values_[1],joint_values_[2]);
+    mount2housing.setEulerZYX(joint_values_[3],joint_values_[4],joint_values_[5]);
     Pose6d housing2mount = mount2housing.getInverse();
     Pose6d optical2mount = optical2housing * housing2mount;
     pose_ = optical2mount;
@@ -366,13 +727,25 @@ namespace industrial_extrinsic_cal
     return(optical2mount);
   }
 
+  void ROSCameraHousingCalTInterface::getTFFrames(std::vector<TFFramePair> &frames)
+  {
+    if(!ref_frame_initialized_) return;
+    frames.push_back(TFFramePair(transform_frame_, housing_frame_));
+    frames.push_back(TFFramePair(ref_frame_, mounting_frame_));
+  }
+
+  void ROSCameraHousingCalTInterface::getMutableJoints(std::vector<std::string> &joint_names)
+  {
+    joint_names.insert(joint_names.end(), get_request_.joint_names.begin(), get_request_.joint_names.end());
+  }
+
   bool  ROSCameraHousingCalTInterface::pushTransform(Pose6d &pose)
   {
     Pose6d pose_inverse = pose.getInverse();
     pose_inverse.show("results being pushed");
 
     // get transform from optical frame to housing frame from tf
-    Pose6d optical2housing = getPoseFromTF(transform_frame_, housing_frame_, tf_listener_);
+    Pose6d optical2housing = getPoseFromTF(transform_frame_, housing_frame_);
     
     // compute the desired transform
     Pose6d mount2housing =  pose_inverse * optical2housing;
@@ -388,7 +761,9 @@ namespace industrial_extrinsic_cal
     set_request_.joint_values.push_back(ez);
     set_request_.joint_values.push_back(ey);
     set_request_.joint_values.push_back(ex);
-    set_client_.call(set_request_,set_response_);
+    if(!SharedMutableJoints::instance().queue(set_request_.joint_names, set_request_.joint_values)){
+      set_client_.call(set_request_,set_response_);
+    }
     return(true);
   }
 
@@ -408,7 +783,7 @@ namespace industrial_extrinsic_cal
   Pose6d ROSCameraHousingCalTInterface::getIntermediateFrame()
   {
     ROS_ERROR("intermediate frame from %s to %s",ref_frame_.c_str(), mounting_frame_.c_str());
-    Pose6d pose =  getPoseFromTF(ref_frame_, mounting_frame_, tf_listener_);
+    Pose6d pose =  getPoseFromTF(ref_frame_, mounting_frame_);
     return(pose);
   }
 
@@ -451,6 +826,7 @@ namespace industrial_extrinsic_cal
 
   Pose6d  ROSSimpleCalTInterface::pullTransform()
   {
+    CAL_PHASE_TIMER("TransformInterface::pullTransform");
     // The computed transform from the reference frame to the optical frame is composed of 3 transforms
     // one from reference frame to mounting frame
     // one composed of the 6DOF unknowns we are trying to calibrate
@@ -463,12 +839,24 @@ namespace industrial_extrinsic_cal
       return(pose);
     }
 
-    get_client_.call(get_request_,get_response_);
-    pose_.setOrigin(get_response_.joint_values[0],get_response_.joint_values[1],get_response_.joint_values[2]);
-    pose_.setEulerZYX(get_response_.joint_values[3],get_response_.joint_values[4],get_response_.joint_values[5]);
+    if(!SharedMutableJoints::instance().cached(get_request_.joint_names, joint_values_)){
+      get_client_.call(get_request_,get_response_);
+      joint_values_ = get_response_.joint_values;
+    }
+    if(joint_values_.size() != 6){
+      ROS_ERROR("could not get the joints of %s", transform_frame_.c_str());
+      return(pose_);
+    }
+    pose_.setOrigin(joint_values_[0],joint_values_[1],joint_values_[2]);
+    pose_.setEulerZYX(joint_values_[3],joint_values_[4],joint_values_[5]);
     return(pose_);
   }
 
+  void ROSSimpleCalTInterface::getMutableJoints(std::vector<std::string> &joint_names)
+  {
+    joint_names.insert(joint_names.end(), get_request_.joint_names.begin(), get_request_.joint_names.end());
+  }
+
   bool  ROSSimpleCalTInterface::pushTransform(Pose6d &pose)
   {
     double ez,ey,ex;
@@ -481,7 +869,9 @@ namespace industrial_extrinsic_cal
     set_request_.joint_values.push_back(ez);
     set_request_.joint_values.push_back(ey);
     set_request_.joint_values.push_back(ex);
-    set_client_.call(set_request_,set_response_);
+    if(!SharedMutableJoints::instance().queue(set_request_.joint_names, set_request_.joint_values)){
+      set_client_.call(set_request_,set_response_);
+    }
 
     return(true);
   }
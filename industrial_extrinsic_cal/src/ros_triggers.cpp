@@ -0,0 +1,199 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <industrial_extrinsic_cal/ros_triggers.h>
+#include <algorithm>
+
+namespace industrial_extrinsic_cal
+{
+  namespace
+  {
+    /* one callback queue and one spinner thread serve the subscriptions and services of all event triggers,
+       the callbacks only notify the waiting thread */
+    class TriggerSpinner
+    {
+    public:
+      static ros::CallbackQueue* queue()
+      {
+	static TriggerSpinner trigger_spinner;
+	return(&trigger_spinner.callback_queue_);
+      }
+
+    private:
+      TriggerSpinner() : spinner_(1, &callback_queue_)
+      {
+	spinner_.start();
+      }
+
+      ~TriggerSpinner()
+      {
+	spinner_.stop();
+      }
+
+      ros::CallbackQueue callback_queue_;
+      ros::AsyncSpinner spinner_; /**< serves callback_queue_ */
+    };
+  }
+
+  ROSEventTrigger::ROSEventTrigger(double min_poll_interval, double max_poll_interval) :
+    waiting_(false), triggered_(false), min_poll_interval_(min_poll_interval), max_poll_interval_(max_poll_interval)
+  {
+    if(max_poll_interval_ < min_poll_interval_) max_poll_interval_ = min_poll_interval_;
+    nh_.setCallbackQueue(TriggerSpinner::queue());
+  }
+
+  ROSEventTrigger::~ROSEventTrigger()
+  {
+  }
+
+  bool ROSEventTrigger::waitForTrigger()
+  {
+    ROS_INFO("%s", description().c_str());
+    beginWait();
+    double interval = min_poll_interval_;
+    int attempt = 1;
+    ros::WallTime attempt_start = ros::WallTime::now();
+    boost::mutex::scoped_lock lock(mutex_);
+    waiting_ = true;
+    triggered_ = false;
+    while(!triggered_ && ros::ok()){
+      notified_.timed_wait(lock, boost::posix_time::milliseconds((long)(interval*1000.0)));
+      if(triggered_) break;
+      lock.unlock();
+      bool polled = poll();
+      lock.lock();
+      if(polled) triggered_ = true;
+      interval = std::min(2.0*interval, max_poll_interval_);
+      if(!triggered_ && timeout_ > 0.0 && (ros::WallTime::now() - attempt_start).toSec() >= timeout_){
+	ROS_ERROR("%s, not triggered within %.1f seconds, attempt %d of %d", description().c_str(), timeout_,
+		  attempt, retries_+1);
+	if(++attempt > retries_+1) break;
+	attempt_start = ros::WallTime::now();
+      }
+    }
+    bool was_triggered = triggered_;
+    waiting_ = false;
+    triggered_ = false;
+    lock.unlock();
+    endWait();
+    if(was_triggered) consumed();
+    return(was_triggered);
+  }
+
+  void ROSEventTrigger::notify()
+  {
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      if(!waiting_) return;
+      triggered_ = true;
+    }
+    notified_.notify_all();
+  }
+
+  // the waits only wake to notice a shutdown
+  ROSTopicTrigger::ROSTopicTrigger(const std::string & topic_name) :
+    ROSEventTrigger(1.0, 1.0), topic_name_(topic_name)
+  {
+  }
+
+  void ROSTopicTrigger::beginWait()
+  {
+    sub_ = nh_.subscribe(topic_name_, 1, &ROSTopicTrigger::callback, this);
+  }
+
+  void ROSTopicTrigger::endWait()
+  {
+    sub_.shutdown();
+  }
+
+  void ROSTopicTrigger::callback(const std_msgs::EmptyConstPtr &msg)
+  {
+    notify();
+  }
+
+  std::string ROSTopicTrigger::description() const
+  {
+    return("ROSTopicTrigger: waiting for a message on " + topic_name_);
+  }
+
+  ROSServiceTrigger::ROSServiceTrigger(const std::string & service_name) :
+    ROSEventTrigger(1.0, 1.0), service_name_(service_name)
+  {
+  }
+
+  void ROSServiceTrigger::beginWait()
+  {
+    server_ = nh_.advertiseService(service_name_, &ROSServiceTrigger::callback, this);
+  }
+
+  void ROSServiceTrigger::endWait()
+  {
+    server_.shutdown();
+  }
+
+  bool ROSServiceTrigger::callback(std_srvs::Empty::Request &req, std_srvs::Empty::Response &res)
+  {
+    notify();
+    return(true);
+  }
+
+  std::string ROSServiceTrigger::description() const
+  {
+    return("ROSServiceTrigger: waiting for a call of " + service_name_);
+  }
+
+  ROSParamTrigger::ROSParamTrigger(const std::string & parameter_name) :
+    ROSEventTrigger(0.01, 0.5), parameter_name_(parameter_name)
+  {
+    nh_.setParam(parameter_name_, false);
+  }
+
+  void ROSParamTrigger::beginWait()
+  {
+    sub_ = nh_.subscribe(parameter_name_, 1, &ROSParamTrigger::topicCallback, this);
+  }
+
+  void ROSParamTrigger::endWait()
+  {
+    sub_.shutdown();
+  }
+
+  bool ROSParamTrigger::poll()
+  {
+    // the cached value is pushed by the master, the poll does not call the parameter server
+    bool pval = false;
+    nh_.getParamCached(parameter_name_, pval);
+    return(pval);
+  }
+
+  void ROSParamTrigger::consumed()
+  {
+    nh_.setParam(parameter_name_, false);
+  }
+
+  void ROSParamTrigger::topicCallback(const std_msgs::EmptyConstPtr &msg)
+  {
+    notify();
+  }
+
+  std::string ROSParamTrigger::description() const
+  {
+    return("ROSParamTrigger: waiting for " + parameter_name_ + " to be true");
+  }
+
+}// end of namespace
@@ -0,0 +1,71 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <industrial_extrinsic_cal/rotation_cache.h>
+#include "ceres/jet.h"
+
+namespace industrial_extrinsic_cal
+{
+  namespace
+  {
+    typedef ceres::Jet<double, 3> Jet3;
+
+    void computeEntry(RotationCacheEntry &entry)
+    {
+      Jet3 aa[3], R[9];
+      for(int k=0; k<3; k++){
+	entry.aa[k] = entry.angle_axis[k];
+	aa[k] = Jet3(entry.aa[k], k);
+      }
+      ceres::AngleAxisToRotationMatrix(aa, R);
+      for(int i=0; i<9; i++){
+	entry.R[i] = R[i].a;
+	for(int k=0; k<3; k++) entry.dR[i][k] = R[i].v[k];
+      }
+    }
+  }
+
+  const RotationCacheEntry* RotationCache::add(const double *angle_axis)
+  {
+    std::map<const double*, RotationCacheEntry>::iterator it = entries_.find(angle_axis);
+    if(it != entries_.end()) return(&it->second);
+    RotationCacheEntry &entry = entries_[angle_axis];
+    entry.angle_axis = angle_axis;
+    computeEntry(entry);
+    return(&entry);
+  }
+
+  void RotationCache::update()
+  {
+    std::map<const double*, RotationCacheEntry>::iterator it;
+    for(it = entries_.begin(); it != entries_.end(); ++it){
+      computeEntry(it->second);
+    }
+  }
+
+  void RotationCache::PrepareForEvaluation(bool evaluate_jacobians, bool new_evaluation_point)
+  {
+    if(new_evaluation_point) update();
+  }
+
+  void RotationCache::attach(ceres::Solver::Options &options)
+  {
+    options.evaluation_callback = this;
+  }
+
+}//end namespace industrial_extrinsic_cal
@@ -0,0 +1,91 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <industrial_extrinsic_cal/schur_ordering.h>
+#include <map>
+#include <set>
+
+namespace industrial_extrinsic_cal
+{
+  namespace
+  {
+    const int ELIMINATED_GROUP = 0;
+    const int REDUCED_GROUP = 1;
+  }
+
+  void SchurOrdering::eliminate(const double *block)
+  {
+    eliminate_.push_back(block);
+  }
+
+  int SchurOrdering::apply(ceres::Problem &problem, ceres::Solver::Options &options) const
+  {
+    if(options.linear_solver_type != ceres::DENSE_SCHUR &&
+       options.linear_solver_type != ceres::SPARSE_SCHUR &&
+       options.linear_solver_type != ceres::ITERATIVE_SCHUR) return(0);
+
+    // rank of each declared block in the problem, lower ranks are eliminated first
+    std::map<const double*, int> rank;
+    for(int i=0; i<(int)eliminate_.size(); i++){
+      if(problem.HasParameterBlock(eliminate_[i]) && rank.find(eliminate_[i]) == rank.end()){
+	rank[eliminate_[i]] = i;
+      }
+    }
+    if(rank.empty()) return(0);
+
+    // declared blocks which share a residual
+    std::map<const double*, std::vector<const double*> > neighbors;
+    std::vector<ceres::ResidualBlockId> residual_blocks;
+    problem.GetResidualBlocks(&residual_blocks);
+    for(int r=0; r<(int)residual_blocks.size(); r++){
+      std::vector<double*> blocks;
+      problem.GetParameterBlocksForResidualBlock(residual_blocks[r], &blocks);
+      for(int i=0; i<(int)blocks.size(); i++){
+	if(rank.find(blocks[i]) == rank.end()) continue;
+	for(int j=0; j<(int)blocks.size(); j++){
+	  if(j != i && rank.find(blocks[j]) != rank.end()) neighbors[blocks[i]].push_back(blocks[j]);
+	}
+      }
+    }
+
+    // greedy independent set in declaration order
+    std::set<const double*> eliminated;
+    for(int i=0; i<(int)eliminate_.size(); i++){
+      const double *block = eliminate_[i];
+      if(rank.find(block) == rank.end() || rank[block] != i) continue;
+      bool independent = true;
+      const std::vector<const double*> &adjacent = neighbors[block];
+      for(int j=0; j<(int)adjacent.size() && independent; j++){
+	if(eliminated.count(adjacent[j])) independent = false;
+      }
+      if(independent) eliminated.insert(block);
+    }
+
+    std::vector<double*> parameter_blocks;
+    problem.GetParameterBlocks(&parameter_blocks);
+    if(eliminated.size() == parameter_blocks.size()) return(0); // the reduced system may not be empty
+    ceres::ParameterBlockOrdering *ordering = new ceres::ParameterBlockOrdering;
+    for(int i=0; i<(int)parameter_blocks.size(); i++){
+      int group = eliminated.count(parameter_blocks[i]) ? ELIMINATED_GROUP : REDUCED_GROUP;
+      ordering->AddElementToGroup(parameter_blocks[i], group);
+    }
+    options.linear_solver_ordering.reset(ordering);
+    return((int)eliminated.size());
+  }
+
+}//end namespace industrial_extrinsic_cal
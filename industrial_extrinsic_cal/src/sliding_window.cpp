@@ -0,0 +1,131 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <industrial_extrinsic_cal/sliding_window.h>
+#include <boost/foreach.hpp>
+#include <set>
+
+namespace industrial_extrinsic_cal
+{
+  namespace
+  {
+    /* the scene of a list, -1 when it is empty */
+    int sceneId(const ObservationDataPointList &scene)
+    {
+      if(scene.items_.empty()) return(-1);
+      return(scene.items_[0].scene_id_);
+    }
+  }
+
+  SlidingWindowParameters defaultSlidingWindowParameters()
+  {
+    SlidingWindowParameters parameters;
+    parameters.window_scenes = 8;
+    parameters.max_num_iterations = 20;
+    parameters.max_solver_time = 0.5;
+    return(parameters);
+  }
+
+  SlidingWindow::SlidingWindow(const SlidingWindowParameters &parameters) :
+    parameters_(parameters), num_new_(0)
+  {
+  }
+
+  void SlidingWindow::seed(const std::vector<ObservationDataPointList> &scenes)
+  {
+    scenes_.clear();
+    BOOST_FOREACH(const ObservationDataPointList &scene, scenes){
+      if(!scene.items_.empty()) scenes_.push_back(scene);
+    }
+    num_new_ = 0;
+    trim();
+  }
+
+  void SlidingWindow::add(const std::vector<ObservationDataPointList> &scenes)
+  {
+    // a scene observed again replaces its old observations, they predate the shift being corrected
+    std::set<int> new_ids;
+    BOOST_FOREACH(const ObservationDataPointList &scene, scenes){
+      if(!scene.items_.empty()) new_ids.insert(sceneId(scene));
+    }
+    std::vector<ObservationDataPointList> kept;
+    BOOST_FOREACH(const ObservationDataPointList &scene, scenes_){
+      if(!new_ids.count(sceneId(scene))) kept.push_back(scene);
+    }
+    scenes_.swap(kept);
+
+    num_new_ = 0;
+    BOOST_FOREACH(const ObservationDataPointList &scene, scenes){
+      if(scene.items_.empty()) continue;
+      scenes_.push_back(scene);
+      num_new_++;
+    }
+    trim();
+  }
+
+  void SlidingWindow::clear()
+  {
+    scenes_.clear();
+    num_new_ = 0;
+  }
+
+  void SlidingWindow::trim()
+  {
+    int window = parameters_.window_scenes > 0 ? parameters_.window_scenes : 1;
+    int excess = (int)scenes_.size() - window;
+    if(excess > 0) scenes_.erase(scenes_.begin(), scenes_.begin() + excess);
+    if(num_new_ > (int)scenes_.size()) num_new_ = (int)scenes_.size();
+  }
+
+  int SlidingWindow::holdUnaffectedConstant(ceres::Problem &problem) const
+  {
+    int first_new = (int)scenes_.size() - num_new_;
+    std::set<const double*> anchored_poses;
+    for(int i=0; i<first_new; i++){
+      BOOST_FOREACH(const ObservationDataPoint &ODP, scenes_[i].items_) anchored_poses.insert(ODP.target_pose_);
+    }
+    std::set<const double*> free_blocks;
+    for(int i=first_new; i<(int)scenes_.size(); i++){
+      BOOST_FOREACH(const ObservationDataPoint &ODP, scenes_[i].items_){
+	free_blocks.insert(ODP.camera_extrinsics_);
+	if(!anchored_poses.count(ODP.target_pose_)) free_blocks.insert(ODP.target_pose_);
+      }
+    }
+
+    std::vector<double*> blocks;
+    problem.GetParameterBlocks(&blocks);
+    int num_free = 0;
+    BOOST_FOREACH(double *block, blocks){
+      if(problem.IsParameterBlockConstant(block)) continue; // e.g. a known target, the window does not free it
+      if(free_blocks.count(block)){
+	num_free++;
+	continue;
+      }
+      problem.SetParameterBlockConstant(block);
+    }
+    return(num_free);
+  }
+
+  void SlidingWindow::configure(ceres::Solver::Options &options) const
+  {
+    options.linear_solver_type = ceres::DENSE_NORMAL_CHOLESKY;
+    options.max_num_iterations = parameters_.max_num_iterations;
+    options.max_solver_time_in_seconds = parameters_.max_solver_time;
+  }
+
+}//end namespace industrial_extrinsic_cal
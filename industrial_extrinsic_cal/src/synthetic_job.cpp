@@ -0,0 +1,274 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <industrial_extrinsic_cal/synthetic_job.h>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/uniform_real.hpp>
+#include <boost/random/variate_generator.hpp>
+#include "ceres/rotation.h"
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+
+namespace industrial_extrinsic_cal
+{
+  namespace
+  {
+    const double IMAGE_WIDTH = 640.0;
+    const double IMAGE_HEIGHT = 480.0;
+
+    /* extrinsics of a camera at position c looking at the origin, these transform world points into the camera frame */
+    void lookAtOrigin(const double c[3], double extrinsics[6])
+    {
+      double z[3] = { -c[0], -c[1], -c[2] };
+      double nz = sqrt(z[0]*z[0] + z[1]*z[1] + z[2]*z[2]);
+      for(int i=0; i<3; i++) z[i] /= nz;
+
+      // any x perpendicular to z will do, use the one in the world's xy plane
+      double x[3] = { z[1], -z[0], 0.0 };
+      double nx = sqrt(x[0]*x[0] + x[1]*x[1]);
+      if(nx < 1e-9){ x[0] = 1.0; x[1] = 0.0; nx = 1.0; }
+      for(int i=0; i<3; i++) x[i] /= nx;
+      double y[3] = { z[1]*x[2] - z[2]*x[1], z[2]*x[0] - z[0]*x[2], z[0]*x[1] - z[1]*x[0] };
+
+      // rows of R_WtoC are the camera axes, ceres wants column major
+      double R[9];
+      for(int col=0; col<3; col++){
+	R[col*3+0] = x[col];
+	R[col*3+1] = y[col];
+	R[col*3+2] = z[col];
+      }
+      ceres::RotationMatrixToAngleAxis(R, extrinsics);
+      for(int row=0; row<3; row++){
+	extrinsics[3+row] = -(R[row]*c[0] + R[3+row]*c[1] + R[6+row]*c[2]);
+      }
+    }
+  }
+
+  SyntheticJobParameters defaultSyntheticJobParameters()
+  {
+    SyntheticJobParameters parameters;
+    parameters.num_cameras = 4;
+    parameters.num_scenes = 10;
+    parameters.target_rows = 5;
+    parameters.target_cols = 7;
+    parameters.point_spacing = 0.05;
+    parameters.circle_diameter = 0.02;
+    parameters.pixel_noise = 0.2;
+    parameters.outlier_fraction = 0.0;
+    parameters.outlier_magnitude = 20.0;
+    parameters.rotation_noise = 0.05;
+    parameters.translation_noise = 0.02;
+    parameters.cost_type = cost_functions::CircleTargetCameraReprjErrorWithDistortion;
+    parameters.seed = 1;
+    return(parameters);
+  }
+
+  SyntheticJob::SyntheticJob(const SyntheticJobParameters &parameters) :
+    parameters_(parameters), rng_(parameters.seed)
+  {
+  }
+
+  bool SyntheticJob::targetMovesEachScene() const
+  {
+    // Link* cost types move the link instead, the fixed target never moves
+    std::string name = costType2String(parameters_.cost_type);
+    return(name.find("Link") == std::string::npos && name.find("Fixed") == std::string::npos);
+  }
+
+  void SyntheticJob::perturb(P_BLOCK pose, double rotation_sigma, double translation_sigma)
+  {
+    boost::normal_distribution<double> unit_normal(0.0, 1.0);
+    boost::variate_generator<boost::mt19937&, boost::normal_distribution<double> > noise(rng_, unit_normal);
+    for(int i=0; i<3; i++) pose[i] += rotation_sigma*noise();
+    for(int i=3; i<6; i++) pose[i] += translation_sigma*noise();
+  }
+
+  bool SyntheticJob::generate()
+  {
+    rng_.seed(parameters_.seed);
+    observations_.items_.clear();
+
+    // cameras on a ring 1m out and 1m up, all looking at the target
+    truth_.cameras.resize(parameters_.num_cameras);
+    for(int i=0; i<parameters_.num_cameras; i++){
+      double angle = 2.0*M_PI*i/parameters_.num_cameras;
+      double c[3] = { cos(angle), sin(angle), 1.0 };
+      CameraParameters &camera = truth_.cameras[i];
+      lookAtOrigin(c, camera.pb_extrinsics);
+      camera.focal_length_x = 525.0;
+      camera.focal_length_y = 525.0;
+      camera.center_x = IMAGE_WIDTH/2.0;
+      camera.center_y = IMAGE_HEIGHT/2.0;
+      camera.distortion_k1 = -0.05;
+      camera.distortion_k2 = 0.01;
+      camera.distortion_k3 = 0.0;
+      camera.distortion_p1 = 0.001;
+      camera.distortion_p2 = -0.001;
+    }
+
+    // planar grid centered on the target origin
+    truth_.points.resize(parameters_.target_rows*parameters_.target_cols);
+    for(int r=0; r<parameters_.target_rows; r++){
+      for(int c=0; c<parameters_.target_cols; c++){
+	Point3d &p = truth_.points[r*parameters_.target_cols + c];
+	p.x = (c - (parameters_.target_cols-1)/2.0)*parameters_.point_spacing;
+	p.y = (r - (parameters_.target_rows-1)/2.0)*parameters_.point_spacing;
+	p.z = 0.0;
+      }
+    }
+
+    // the target or the link wanders a little about the origin from scene to scene
+    int num_target_poses = targetMovesEachScene() ? parameters_.num_scenes : 1;
+    truth_.target_poses.assign(num_target_poses, Pose6d(0, 0, 0, 0, 0, 0));
+    for(int i=0; i<num_target_poses; i++){
+      perturb(truth_.target_poses[i].pb_pose, 0.2, 0.1);
+    }
+    link_poses_.assign(parameters_.num_scenes, Pose6d(0, 0, 0, 0, 0, 0));
+    if(!targetMovesEachScene()){
+      for(int i=0; i<parameters_.num_scenes; i++){
+	perturb(link_poses_[i].pb_pose, 0.1, 0.05);
+      }
+    }
+
+    // initial guess: poses are off, a known target pose stays exact, intrinsics and points start at the truth
+    initial_ = truth_;
+    bool fixed_target = (parameters_.cost_type == cost_functions::FixedCircleTargetCameraReprjErrorPK);
+    for(int i=0; i<(int)initial_.cameras.size(); i++){
+      perturb(initial_.cameras[i].pb_extrinsics, parameters_.rotation_noise, parameters_.translation_noise);
+    }
+    if(!fixed_target){
+      for(int i=0; i<(int)initial_.target_poses.size(); i++){
+	perturb(initial_.target_poses[i].pb_pose, parameters_.rotation_noise, parameters_.translation_noise);
+      }
+    }
+    estimate_ = initial_;
+
+    // project every point with the job's own cost function at the true values, residual = projection - observation
+    boost::normal_distribution<double> unit_normal(0.0, 1.0);
+    boost::variate_generator<boost::mt19937&, boost::normal_distribution<double> > noise(rng_, unit_normal);
+    boost::uniform_real<double> unit_uniform(0.0, 1.0);
+    boost::variate_generator<boost::mt19937&, boost::uniform_real<double> > uniform(rng_, unit_uniform);
+    std::string target_name("synthetic_target");
+    for(int s=0; s<parameters_.num_scenes; s++){
+      int t = targetMovesEachScene() ? s : 0;
+      for(int c=0; c<parameters_.num_cameras; c++){
+	char camera_name[32];
+	snprintf(camera_name, sizeof(camera_name), "camera_%d", c);
+	for(int p=0; p<(int)truth_.points.size(); p++){
+	  ObservationDataPoint true_ODP(camera_name, target_name, 1, s,
+					truth_.cameras[c].pb_intrinsics, truth_.cameras[c].pb_extrinsics,
+					p, truth_.target_poses[t].pb_pose, truth_.points[p].pb,
+					0.0, 0.0, parameters_.cost_type, link_poses_[s],
+					parameters_.circle_diameter);
+	  std::vector<P_BLOCK> blocks;
+	  ceres::CostFunction *cost_function = createObservationCost(true_ODP, true_ODP.camera_extrinsics_,
+								     true_ODP.camera_intrinsics_,
+								     true_ODP.target_pose_,
+								     true_ODP.point_position_, blocks);
+	  if(cost_function == NULL) return(false);
+	  double projection[2];
+	  bool ok = cost_function->Evaluate(&blocks[0], projection, NULL);
+	  delete cost_function;
+	  if(!ok || projection[0] < 0.0 || projection[0] >= IMAGE_WIDTH ||
+	     projection[1] < 0.0 || projection[1] >= IMAGE_HEIGHT){
+	    continue; // not seen by this camera
+	  }
+
+	  double image_x = projection[0] + parameters_.pixel_noise*noise();
+	  double image_y = projection[1] + parameters_.pixel_noise*noise();
+	  if(uniform() < parameters_.outlier_fraction){
+	    image_x += parameters_.outlier_magnitude*(2.0*uniform() - 1.0);
+	    image_y += parameters_.outlier_magnitude*(2.0*uniform() - 1.0);
+	  }
+	  ObservationDataPoint ODP(camera_name, target_name, 1, s,
+				   estimate_.cameras[c].pb_intrinsics, estimate_.cameras[c].pb_extrinsics,
+				   p, estimate_.target_poses[t].pb_pose, estimate_.points[p].pb,
+				   image_x, image_y, parameters_.cost_type, link_poses_[s],
+				   parameters_.circle_diameter);
+	  observations_.addObservationPoint(ODP);
+	}
+      }
+    }
+    return(observations_.items_.size() > 0);
+  }
+
+  void SyntheticJob::reset()
+  {
+    // copy in place, the observations point into estimate_
+    std::copy(initial_.cameras.begin(), initial_.cameras.end(), estimate_.cameras.begin());
+    std::copy(initial_.target_poses.begin(), initial_.target_poses.end(), estimate_.target_poses.begin());
+    std::copy(initial_.points.begin(), initial_.points.end(), estimate_.points.begin());
+  }
+
+  void SyntheticJob::displaceObservation(int index, double dx, double dy)
+  {
+    if(index < 0 || index >= (int)observations_.items_.size()) return;
+    observations_.items_[index].image_x_ += dx;
+    observations_.items_[index].image_y_ += dy;
+  }
+
+  int SyntheticJob::addToProblem(ceres::Problem &problem, RotationCache *rotation_cache,
+				 std::vector<ObservationResidual> *residuals)
+  {
+    int num_added = 0;
+    for(int i=0; i<(int)observations_.items_.size(); i++){
+      const ObservationDataPoint &ODP = observations_.items_[i];
+      std::vector<P_BLOCK> blocks;
+      ceres::CostFunction *cost_function = createObservationCost(ODP, ODP.camera_extrinsics_,
+								 ODP.camera_intrinsics_,
+								 ODP.target_pose_,
+								 ODP.point_position_, blocks,
+								 rotation_cache);
+      if(cost_function == NULL) continue;
+      ceres::ResidualBlockId id = problem.AddResidualBlock(cost_function, robust_losses_.create(ODP.cost_type_), blocks);
+      if(residuals != NULL) residuals->push_back(observationResidual(id, ODP));
+      num_added++;
+    }
+    return(num_added);
+  }
+
+  void SyntheticJob::addSchurEliminationBlocks(SchurOrdering &ordering)
+  {
+    for(int i=0; i<(int)estimate_.points.size(); i++) ordering.eliminate(estimate_.points[i].pb);
+    if(!targetMovesEachScene()) return;
+    for(int i=0; i<(int)estimate_.target_poses.size(); i++) ordering.eliminate(estimate_.target_poses[i].pb_pose);
+  }
+
+  double SyntheticJob::cameraPositionError() const
+  {
+    if(truth_.cameras.size() == 0) return(0.0);
+    double sum_squares = 0.0;
+    for(int i=0; i<(int)truth_.cameras.size(); i++){
+      // camera position in world = -R^T t
+      double position[2][3];
+      const CameraParameters *sets[2] = { &truth_.cameras[i], &estimate_.cameras[i] };
+      for(int j=0; j<2; j++){
+	double inverse_aa[3] = { -sets[j]->angle_axis[0], -sets[j]->angle_axis[1], -sets[j]->angle_axis[2] };
+	double negative_t[3] = { -sets[j]->position[0], -sets[j]->position[1], -sets[j]->position[2] };
+	ceres::AngleAxisRotatePoint(inverse_aa, negative_t, position[j]);
+      }
+      for(int k=0; k<3; k++){
+	double d = position[0][k] - position[1][k];
+	sum_squares += d*d;
+      }
+    }
+    return(sqrt(sum_squares/truth_.cameras.size()));
+  }
+
+}//end namespace industrial_extrinsic_cal
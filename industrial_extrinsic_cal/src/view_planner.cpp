@@ -0,0 +1,338 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <industrial_extrinsic_cal/view_planner.h>
+#include <industrial_extrinsic_cal/phase_timer.h>
+#include <boost/foreach.hpp>
+#include <Eigen/Dense>
+#include <algorithm>
+#include <math.h>
+#include <sstream>
+#include <stdio.h>
+
+namespace industrial_extrinsic_cal
+{
+  namespace
+  {
+    const int EXTRINSICS_SIZE = 6; /* ax ay az x y z */
+
+    /* the jacobian of one observation with respect to one estimated block */
+    typedef struct
+    {
+      const double *block;
+      int size;
+      int first_row;
+      std::vector<double> jacobian; /* row major, residuals by size */
+    } BlockJacobian;
+
+    /* the covariance rows of a view's blocks, and I + S C(v,v) where S is the view's information */
+    void viewRows(const Eigen::MatrixXd &covariance, const std::vector<int> &blocks, const Eigen::MatrixXd &information,
+		  Eigen::MatrixXd &rows, Eigen::MatrixXd &A)
+    {
+      int k = EXTRINSICS_SIZE*(int)blocks.size();
+      rows.resize(k, covariance.cols());
+      for(int i=0; i<(int)blocks.size(); i++){
+	rows.middleRows(EXTRINSICS_SIZE*i, EXTRINSICS_SIZE) = covariance.middleRows(EXTRINSICS_SIZE*blocks[i],
+										   EXTRINSICS_SIZE);
+      }
+      Eigen::MatrixXd C_vv(k, k);
+      for(int i=0; i<(int)blocks.size(); i++){
+	C_vv.middleCols(EXTRINSICS_SIZE*i, EXTRINSICS_SIZE) = rows.middleCols(EXTRINSICS_SIZE*blocks[i], EXTRINSICS_SIZE);
+      }
+      A = Eigen::MatrixXd::Identity(k, k) + information*C_vv;
+    }
+  }
+
+  bool string2ViewPlanCriterion(const std::string &name, ViewPlanCriterion &criterion)
+  {
+    if(name == "trace") criterion = MIN_TRACE;
+    else if(name == "determinant") criterion = MAX_DETERMINANT;
+    else return(false);
+    return(true);
+  }
+
+  ViewPlanParameters defaultViewPlanParameters()
+  {
+    ViewPlanParameters parameters;
+    parameters.max_views = 0;
+    parameters.max_rotation_std = 0.005;
+    parameters.max_position_std = 0.002;
+    parameters.pixel_sigma = 1.0;
+    parameters.prior_rotation_std = 1.0;
+    parameters.prior_position_std = 1.0;
+    parameters.criterion = MIN_TRACE;
+    return(parameters);
+  }
+
+  ViewPlanner::ViewPlanner(const ViewPlanParameters &parameters) :
+    parameters_(parameters)
+  {
+  }
+
+  void ViewPlanner::setConstantBlocks(const std::vector<P_BLOCK> &blocks)
+  {
+    constant_blocks_.clear();
+    constant_blocks_.insert(blocks.begin(), blocks.end());
+  }
+
+  void ViewPlanner::clear()
+  {
+    extrinsics_.clear();
+    extrinsics_index_.clear();
+    views_.clear();
+    uncertainty_.clear();
+  }
+
+  bool ViewPlanner::addView(int view_id, const ObservationDataPointList &observations)
+  {
+    CAL_PHASE_TIMER("ViewPlanner::addView");
+    views_.erase(view_id);
+
+    // the jacobian of every observation, at the current estimates
+    std::vector<BlockJacobian> jacobians;
+    std::vector<int> view_extrinsics;
+    std::map<const double*, int> nuisance_column;
+    int num_nuisance = 0;
+    int num_rows = 0;
+    bool ok = true;
+    BOOST_FOREACH(const ObservationDataPoint &ODP, observations.items_){
+      std::vector<P_BLOCK> blocks;
+      ceres::CostFunction *cost = createObservationCost(ODP, ODP.camera_extrinsics_, ODP.camera_intrinsics_,
+							ODP.target_pose_, ODP.point_position_, blocks);
+      if(cost == NULL){
+	fprintf(stderr, "ViewPlanner: no cost for cost type %d\n", ODP.cost_type_);
+	ok = false;
+	continue;
+      }
+      int num_residuals = cost->num_residuals();
+      const std::vector<ceres::int32> &sizes = cost->parameter_block_sizes();
+      std::vector<BlockJacobian> observation(blocks.size());
+      std::vector<double*> jacobian_pointers(blocks.size(), (double*)NULL);
+      for(int i=0; i<(int)blocks.size(); i++){
+	observation[i].block = blocks[i];
+	observation[i].size = sizes[i];
+	observation[i].first_row = num_rows;
+	if(constant_blocks_.count(blocks[i])) continue; // known exactly, adds no unknowns
+	observation[i].jacobian.resize(num_residuals*sizes[i]);
+	jacobian_pointers[i] = &observation[i].jacobian[0];
+      }
+      std::vector<double> residuals(num_residuals);
+      bool evaluated = cost->Evaluate(&blocks[0], &residuals[0], &jacobian_pointers[0]);
+      delete cost;
+      if(!evaluated){
+	ok = false;
+	continue;
+      }
+      num_rows += num_residuals;
+
+      for(int i=0; i<(int)observation.size(); i++){
+	const double *block = observation[i].block;
+	if(observation[i].jacobian.empty()) continue;
+	if(block == ODP.camera_extrinsics_ && observation[i].size == EXTRINSICS_SIZE){
+	  if(!extrinsics_index_.count(block)){
+	    // a camera which moves between scenes has a block per scene, named like the quality report does
+	    ExtrinsicsUncertainty entry;
+	    entry.name = ODP.camera_name_;
+	    for(int j=0; j<(int)extrinsics_.size(); j++){
+	      if(extrinsics_[j].name != ODP.camera_name_) continue;
+	      std::ostringstream name;
+	      name << ODP.camera_name_ << "_scene_" << ODP.scene_id_;
+	      entry.name = name.str();
+	    }
+	    entry.block = block;
+	    for(int j=0; j<EXTRINSICS_SIZE; j++) entry.std_dev[j] = 0.0;
+	    extrinsics_index_[block] = (int)extrinsics_.size();
+	    extrinsics_.push_back(entry);
+	  }
+	  int index = extrinsics_index_[block];
+	  if(std::find(view_extrinsics.begin(), view_extrinsics.end(), index) == view_extrinsics.end()){
+	    view_extrinsics.push_back(index);
+	  }
+	}
+	else if(!nuisance_column.count(block)){
+	  nuisance_column[block] = num_nuisance;
+	  num_nuisance += observation[i].size;
+	}
+	jacobians.push_back(observation[i]);
+      }
+    }
+    if(view_extrinsics.empty()) return(ok);
+
+    // the view's jacobian, its extrinsics first then every other estimated block
+    std::map<int, int> extrinsics_column;
+    for(int i=0; i<(int)view_extrinsics.size(); i++) extrinsics_column[view_extrinsics[i]] = EXTRINSICS_SIZE*i;
+    int num_extrinsics = EXTRINSICS_SIZE*(int)view_extrinsics.size();
+    Eigen::MatrixXd J = Eigen::MatrixXd::Zero(num_rows, num_extrinsics + num_nuisance);
+    BOOST_FOREACH(const BlockJacobian &b, jacobians){
+      int column;
+      if(extrinsics_index_.count(b.block) && extrinsics_column.count(extrinsics_index_[b.block])){
+	column = extrinsics_column[extrinsics_index_[b.block]];
+      }
+      else{
+	column = num_extrinsics + nuisance_column[b.block];
+      }
+      int num_residuals = (int)b.jacobian.size()/b.size;
+      for(int r=0; r<num_residuals; r++){
+	for(int c=0; c<b.size; c++) J(b.first_row + r, column + c) += b.jacobian[r*b.size + c];
+      }
+    }
+    Eigen::MatrixXd H = J.transpose()*J/(parameters_.pixel_sigma*parameters_.pixel_sigma);
+
+    // the other blocks are eliminated by the Schur complement, a pseudo inverse tolerates unobservable directions
+    ViewInformation view;
+    view.blocks = view_extrinsics;
+    view.information = H.topLeftCorner(num_extrinsics, num_extrinsics);
+    if(num_nuisance > 0){
+      Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eigen(H.bottomRightCorner(num_nuisance, num_nuisance));
+      const Eigen::VectorXd &values = eigen.eigenvalues();
+      double tolerance = 1e-12*values.cwiseAbs().maxCoeff();
+      Eigen::VectorXd inverse_values = Eigen::VectorXd::Zero(num_nuisance);
+      for(int i=0; i<num_nuisance; i++){
+	if(values(i) > tolerance) inverse_values(i) = 1.0/values(i);
+      }
+      Eigen::MatrixXd B = H.topRightCorner(num_extrinsics, num_nuisance)*eigen.eigenvectors();
+      view.information -= B*inverse_values.asDiagonal()*B.transpose();
+    }
+    view.information = 0.5*(view.information + view.information.transpose());
+    views_[view_id] = view;
+    return(ok);
+  }
+
+  Eigen::MatrixXd ViewPlanner::priorCovariance() const
+  {
+    int n = EXTRINSICS_SIZE*(int)extrinsics_.size();
+    Eigen::MatrixXd covariance = Eigen::MatrixXd::Zero(n, n);
+    double rotation_variance = parameters_.prior_rotation_std*parameters_.prior_rotation_std;
+    double position_variance = parameters_.prior_position_std*parameters_.prior_position_std;
+    for(int i=0; i<n; i++){
+      covariance(i, i) = (i%EXTRINSICS_SIZE < 3) ? rotation_variance : position_variance;
+    }
+    return(covariance);
+  }
+
+  void ViewPlanner::addToCovariance(Eigen::MatrixXd &covariance, const ViewInformation &view) const
+  {
+    // C' = C - C(:,v) (I + S C(v,v))^-1 S C(v,:), which never inverts the singular information S
+    Eigen::MatrixXd rows;
+    Eigen::MatrixXd A;
+    viewRows(covariance, view.blocks, view.information, rows, A);
+    Eigen::MatrixXd M = A.partialPivLu().solve(view.information);
+    covariance -= rows.transpose()*M*rows;
+    covariance = 0.5*(covariance + covariance.transpose());
+  }
+
+  double ViewPlanner::gain(const Eigen::MatrixXd &covariance, const ViewInformation &view) const
+  {
+    int n = (int)covariance.rows();
+    int k = EXTRINSICS_SIZE*(int)view.blocks.size();
+    Eigen::MatrixXd rows;
+    Eigen::MatrixXd A;
+    viewRows(covariance, view.blocks, view.information, rows, A);
+
+    if(parameters_.criterion == MAX_DETERMINANT){
+      // det(H + S) / det(H) = det(I + S C(v,v)), by the matrix determinant lemma
+      Eigen::PartialPivLU<Eigen::MatrixXd> lu(A);
+      double log_ratio = 0.0;
+      for(int i=0; i<k; i++) log_ratio += log(fabs(lu.matrixLU()(i, i)));
+      return(log_ratio);
+    }
+
+    // reduction of the trace, each variance weighted by its target so radians and meters are comparable
+    Eigen::VectorXd weights(n);
+    for(int i=0; i<n; i++){
+      double target = (i%EXTRINSICS_SIZE < 3) ? parameters_.max_rotation_std : parameters_.max_position_std;
+      weights(i) = 1.0/(target*target);
+    }
+    Eigen::MatrixXd M = A.partialPivLu().solve(view.information);
+    Eigen::MatrixXd G = rows*weights.asDiagonal()*rows.transpose();
+    return((M*G).trace());
+  }
+
+  bool ViewPlanner::setUncertainty(const Eigen::MatrixXd &covariance)
+  {
+    uncertainty_ = extrinsics_;
+    bool met = true;
+    for(int i=0; i<(int)uncertainty_.size(); i++){
+      for(int j=0; j<EXTRINSICS_SIZE; j++){
+	double variance = covariance(EXTRINSICS_SIZE*i + j, EXTRINSICS_SIZE*i + j);
+	uncertainty_[i].std_dev[j] = variance > 0.0 ? sqrt(variance) : 0.0;
+	double target = j < 3 ? parameters_.max_rotation_std : parameters_.max_position_std;
+	if(uncertainty_[i].std_dev[j] > target) met = false;
+      }
+    }
+    return(met);
+  }
+
+  bool ViewPlanner::predict(const std::vector<int> &views)
+  {
+    Eigen::MatrixXd covariance = priorCovariance();
+    BOOST_FOREACH(int view_id, views){
+      std::map<int, ViewInformation>::const_iterator it = views_.find(view_id);
+      if(it != views_.end()) addToCovariance(covariance, it->second);
+    }
+    return(setUncertainty(covariance));
+  }
+
+  bool ViewPlanner::plan(const std::vector<int> &observed, std::vector<int> &selected)
+  {
+    CAL_PHASE_TIMER("ViewPlanner::plan");
+    selected.clear();
+    Eigen::MatrixXd covariance = priorCovariance();
+    std::set<int> candidates;
+    std::map<int, ViewInformation>::const_iterator it;
+    for(it = views_.begin(); it != views_.end(); ++it) candidates.insert(it->first);
+    BOOST_FOREACH(int view_id, observed){
+      it = views_.find(view_id);
+      if(it == views_.end()) continue;
+      addToCovariance(covariance, it->second);
+      candidates.erase(view_id);
+    }
+
+    while(!setUncertainty(covariance)){
+      if(candidates.empty()) return(false);
+      if(parameters_.max_views > 0 && (int)selected.size() >= parameters_.max_views) return(false);
+      int best_view = -1;
+      double best_gain = 0.0;
+      BOOST_FOREACH(int view_id, candidates){
+	double view_gain = gain(covariance, views_[view_id]);
+	if(view_gain > best_gain){
+	  best_gain = view_gain;
+	  best_view = view_id;
+	}
+      }
+      if(best_view < 0) return(false); // no view adds information
+      addToCovariance(covariance, views_[best_view]);
+      candidates.erase(best_view);
+      selected.push_back(best_view);
+    }
+    return(true);
+  }
+
+  std::string ViewPlanner::summary() const
+  {
+    std::ostringstream out;
+    for(int i=0; i<(int)uncertainty_.size(); i++){
+      const ExtrinsicsUncertainty &u = uncertainty_[i];
+      out << "  " << u.name << " predicted extrinsics std dev: rotation " << u.std_dev[0] << " " << u.std_dev[1]
+	  << " " << u.std_dev[2] << " rad, position " << u.std_dev[3] << " " << u.std_dev[4] << " "
+	  << u.std_dev[5] << " m\n";
+    }
+    return(out.str());
+  }
+
+}//end namespace industrial_extrinsic_cal
@@ -0,0 +1,95 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <industrial_extrinsic_cal/work_queue.h>
+#include <boost/bind.hpp>
+#include <stdio.h>
+
+namespace industrial_extrinsic_cal
+{
+
+  WorkQueue::WorkQueue(int num_threads, int max_pending) :
+    running_(0), finishing_(false), finished_(false)
+  {
+    if(num_threads < 1) num_threads = 1;
+    max_pending_ = max_pending < num_threads ? num_threads : max_pending;
+    for(int i=0; i<num_threads; i++){
+      workers_.create_thread(boost::bind(&WorkQueue::worker, this));
+    }
+  }
+
+  WorkQueue::~WorkQueue()
+  {
+    finish();
+  }
+
+  void WorkQueue::push(const Job &job)
+  {
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      if(finishing_){
+	fprintf(stderr, "WorkQueue: job pushed after finish() is ignored\n");
+	return;
+      }
+      while((int)jobs_.size() + running_ >= max_pending_) job_done_.wait(lock);
+      jobs_.push_back(job);
+    }
+    job_ready_.notify_one();
+  }
+
+  void WorkQueue::finish()
+  {
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      if(finished_) return;
+      finishing_ = true;
+    }
+    job_ready_.notify_all();
+    workers_.join_all();
+    boost::mutex::scoped_lock lock(mutex_);
+    finished_ = true;
+  }
+
+  int WorkQueue::pending() const
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    return((int)jobs_.size() + running_);
+  }
+
+  void WorkQueue::worker()
+  {
+    while(true){
+      Job job;
+      {
+	boost::mutex::scoped_lock lock(mutex_);
+	while(jobs_.empty() && !finishing_) job_ready_.wait(lock);
+	if(jobs_.empty()) return;
+	job = jobs_.front();
+	jobs_.pop_front();
+	running_++;
+      }
+      job();
+      {
+	boost::mutex::scoped_lock lock(mutex_);
+	running_--;
+      }
+      job_done_.notify_all();
+    }
+  }
+
+}//end namespace industrial_extrinsic_cal
@@ -0,0 +1,183 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <industrial_extrinsic_cal/ceres_blocks.h>
+
+using namespace industrial_extrinsic_cal;
+
+// pulls a block of N values towards a goal
+template<int N>
+struct BlockGoal
+{
+  BlockGoal(double goal) : goal_(goal) {}
+
+  template<typename T>
+  bool operator()(const T* const block, T* residual) const
+  {
+    for(int i=0; i<N; i++) residual[i] = block[i] - T(goal_);
+    return true;
+  }
+
+  double goal_;
+};
+
+template<int N>
+void addGoal(ceres::Problem &problem, P_BLOCK block, double goal)
+{
+  problem.AddResidualBlock(new ceres::AutoDiffCostFunction<BlockGoal<N>, N, N>(new BlockGoal<N>(goal)), NULL, block);
+}
+
+boost::shared_ptr<Target> makeTarget(const std::string &name, bool fixed_pose, bool fixed_points)
+{
+  boost::shared_ptr<Target> target = boost::make_shared<Target>();
+  target->target_name_ = name;
+  target->pose_.setOrigin(0.0, 0.0, 1.0);
+  target->fixed_pose_ = fixed_pose;
+  target->fixed_points_ = fixed_points;
+  target->num_points_ = 2;
+  for(int i=0; i<2; i++){
+    Point3d point;
+    point.x = 0.1*i;
+    point.y = 0.2;
+    point.z = 0.0;
+    target->pts_.push_back(point);
+  }
+  target->setTransformInterface(boost::make_shared<DefaultTransformInterface>(target->pose_));
+  return(target);
+}
+
+TEST(IndustrialExtrinsicCalCeresBlocksSuite, movingTargetCopyPerScene)
+{
+  CeresBlocks blocks;
+  boost::shared_ptr<Target> target = makeTarget("moving", false, false);
+  ASSERT_TRUE(blocks.addMovingTarget(target, 0));
+  ASSERT_TRUE(blocks.addMovingTarget(target, 1));
+  EXPECT_FALSE(blocks.addMovingTarget(target, 1));
+
+  P_BLOCK pose0 = blocks.getMovingTargetPoseParameterBlock("moving", 0);
+  P_BLOCK pose1 = blocks.getMovingTargetPoseParameterBlock("moving", 1);
+  ASSERT_TRUE(pose0 != NULL);
+  ASSERT_TRUE(pose1 != NULL);
+  EXPECT_TRUE(pose0 != pose1);
+  EXPECT_TRUE(pose0 != &(target->pose_.pb_pose[0]));
+  for(int i=0; i<6; i++){
+    EXPECT_EQ(target->pose_.pb_pose[i], pose0[i]);
+    EXPECT_EQ(target->pose_.pb_pose[i], pose1[i]);
+  }
+  EXPECT_TRUE(blocks.getMovingTargetPoseParameterBlock("moving", 2) == NULL);
+
+  // estimating one scene's pose leaves the other scene and the original target alone
+  pose1[5] = 2.0;
+  EXPECT_EQ(1.0, pose0[5]);
+  EXPECT_EQ(1.0, target->pose_.pb_pose[5]);
+
+  // the points are a copy too, shared by every scene
+  P_BLOCK point = blocks.getMovingTargetPointParameterBlock("moving", 1);
+  ASSERT_TRUE(point != NULL);
+  EXPECT_TRUE(point != &(target->pts_[1].pb[0]));
+  EXPECT_EQ(0.1, point[0]);
+  EXPECT_EQ(0.2, point[1]);
+}
+
+TEST(IndustrialExtrinsicCalCeresBlocksSuite, constantTargetBlocks)
+{
+  CeresBlocks blocks;
+  boost::shared_ptr<Target> fixed_pose = makeTarget("fixed_pose", true, false);
+  boost::shared_ptr<Target> fixed_points = makeTarget("fixed_points", false, true);
+  ASSERT_TRUE(blocks.addStaticTarget(fixed_pose));
+  ASSERT_TRUE(blocks.addMovingTarget(fixed_points, 0));
+  ASSERT_TRUE(blocks.addMovingTarget(fixed_points, 1));
+
+  // the static pose and the points of both scene copies, never the moving poses
+  std::vector<P_BLOCK> constant_blocks;
+  blocks.getConstantTargetBlocks(constant_blocks);
+  ASSERT_EQ(5, (int)constant_blocks.size());
+  EXPECT_EQ(&(fixed_pose->pose_.pb_pose[0]), constant_blocks[0]);
+  EXPECT_TRUE(std::find(constant_blocks.begin(), constant_blocks.end(),
+			blocks.getMovingTargetPoseParameterBlock("fixed_points", 0)) == constant_blocks.end());
+  EXPECT_TRUE(std::find(constant_blocks.begin(), constant_blocks.end(),
+			blocks.getMovingTargetPointParameterBlock("fixed_points", 1)) != constant_blocks.end());
+}
+
+TEST(IndustrialExtrinsicCalCeresBlocksSuite, holdConstantTargetBlocks)
+{
+  CeresBlocks blocks;
+  boost::shared_ptr<Target> fixed_pose = makeTarget("fixed_pose", true, false);
+  boost::shared_ptr<Target> fixed_points = makeTarget("fixed_points", false, true);
+  ASSERT_TRUE(blocks.addStaticTarget(fixed_pose));
+  ASSERT_TRUE(blocks.addMovingTarget(fixed_points, 0));
+  ASSERT_TRUE(blocks.addMovingTarget(fixed_points, 1));
+
+  P_BLOCK static_pose = blocks.getStaticTargetPoseParameterBlock("fixed_pose");
+  P_BLOCK pose0 = blocks.getMovingTargetPoseParameterBlock("fixed_points", 0);
+  P_BLOCK pose1 = blocks.getMovingTargetPoseParameterBlock("fixed_points", 1);
+  P_BLOCK point0 = blocks.getMovingTargetPointParameterBlock("fixed_points", 0);
+  P_BLOCK point1 = blocks.getMovingTargetPointParameterBlock("fixed_points", 1);
+  ceres::Problem problem;
+  addGoal<6>(problem, static_pose, 0.5);
+  addGoal<6>(problem, pose0, 0.5);
+  addGoal<6>(problem, pose1, 0.5);
+  addGoal<3>(problem, point0, 0.5);
+  addGoal<3>(problem, point1, 0.5);
+
+  // the points of the second scene's copy are not in the problem
+  EXPECT_EQ(3, blocks.holdConstantTargetBlocks(problem, NULL));
+
+  ceres::Solver::Options options;
+  ceres::Solver::Summary summary;
+  ceres::Solve(options, &problem, &summary);
+  EXPECT_EQ(1.0, static_pose[5]);
+  EXPECT_EQ(0.0, point0[0]);
+  EXPECT_EQ(0.1, point1[0]);
+  for(int i=0; i<6; i++){
+    EXPECT_NEAR(0.5, pose0[i], 1e-6);
+    EXPECT_NEAR(0.5, pose1[i], 1e-6);
+  }
+}
+
+TEST(IndustrialExtrinsicCalCeresBlocksSuite, holdConstantTargetCopies)
+{
+  CeresBlocks blocks;
+  boost::shared_ptr<Target> fixed_pose = makeTarget("fixed_pose", true, false);
+  ASSERT_TRUE(blocks.addStaticTarget(fixed_pose));
+  P_BLOCK static_pose = blocks.getStaticTargetPoseParameterBlock("fixed_pose");
+  P_BLOCK point = blocks.getStaticTargetPointParameterBlock("fixed_pose", 0);
+
+  // a start perturbs the pose copy, holding it constant restores the known pose
+  ParameterBlockCopies copies(0.2, 0.1, 5);
+  ceres::Problem problem;
+  addGoal<6>(problem, copies.targetPose(static_pose), 0.5);
+  addGoal<3>(problem, copies.point(point), 0.5);
+  EXPECT_EQ(1, blocks.holdConstantTargetBlocks(problem, &copies));
+
+  ceres::Solver::Options options;
+  ceres::Solver::Summary summary;
+  ceres::Solve(options, &problem, &summary);
+  P_BLOCK pose_copy = copies.targetPose(static_pose);
+  for(int i=0; i<6; i++) EXPECT_EQ(static_pose[i], pose_copy[i]);
+  EXPECT_NEAR(0.5, copies.point(point)[0], 1e-6);
+}
+
+// Run all the tests that were declared with TEST()
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
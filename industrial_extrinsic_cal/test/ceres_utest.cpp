@@ -26,10 +26,350 @@
 #include <Eigen/Geometry>
 #include <Eigen/Core>
 #include <industrial_extrinsic_cal/ceres_costs_utils.hpp>
+#include <industrial_extrinsic_cal/observation_data_point.h>
+#include <industrial_extrinsic_cal/synthetic_job.h>
 
 using namespace industrial_extrinsic_cal;
 
 
+// The reference below writes out each cost type's chain and projection with Eigen, independently of the
+// policies behind the factory table. Only the circle correction is shared, it is the helper every
+// circle cost type called before the kernel existed.
+enum { NO_TARGET, FREE_TARGET, FIXED_TARGET };
+enum { NO_LINK, TARGET_ON_LINK, CAMERA_ON_LINK };
+
+// what each cost type estimates and how it chains the poses
+typedef struct
+{
+  Cost_function type;
+  bool distorted;		// the intrinsics are a parameter block and the lens distortion is applied
+  bool circle;			// the observation is the center of an imaged circle
+  int target;			// NO_TARGET, FREE_TARGET or FIXED_TARGET
+  int link;			// NO_LINK, TARGET_ON_LINK or CAMERA_ON_LINK
+  bool free_point;		// the point's location is a parameter block
+} CostTypeSpec;
+
+void PrintTo(const CostTypeSpec &spec, std::ostream *os)
+{
+  *os << costType2String(spec.type);
+}
+
+const CostTypeSpec COST_TYPE_SPECS[] = {
+  { cost_functions::CameraReprjErrorWithDistortion,		true,  false, NO_TARGET,    NO_LINK,        true  },
+  { cost_functions::CameraReprjErrorWithDistortionPK,		true,  false, NO_TARGET,    NO_LINK,        false },
+  { cost_functions::CameraReprjError,				false, false, NO_TARGET,    NO_LINK,        true  },
+  { cost_functions::CameraReprjErrorPK,				false, false, NO_TARGET,    NO_LINK,        false },
+  { cost_functions::TargetCameraReprjError,			false, false, FREE_TARGET,  NO_LINK,        true  },
+  { cost_functions::TargetCameraReprjErrorPK,			false, false, FREE_TARGET,  NO_LINK,        false },
+  { cost_functions::LinkTargetCameraReprjError,			false, false, FREE_TARGET,  TARGET_ON_LINK, true  },
+  { cost_functions::LinkTargetCameraReprjErrorPK,		false, false, FREE_TARGET,  TARGET_ON_LINK, false },
+  { cost_functions::LinkCameraTargetReprjError,			false, false, FREE_TARGET,  CAMERA_ON_LINK, true  },
+  { cost_functions::LinkCameraTargetReprjErrorPK,		false, false, FREE_TARGET,  CAMERA_ON_LINK, false },
+  { cost_functions::CircleCameraReprjErrorWithDistortion,	true,  true,  NO_TARGET,    NO_LINK,        true  },
+  { cost_functions::CircleCameraReprjErrorWithDistortionPK,	true,  true,  NO_TARGET,    NO_LINK,        false },
+  { cost_functions::CircleCameraReprjError,			false, true,  NO_TARGET,    NO_LINK,        true  },
+  { cost_functions::CircleCameraReprjErrorPK,			false, true,  NO_TARGET,    NO_LINK,        false },
+  { cost_functions::CircleTargetCameraReprjErrorWithDistortion,	true,  true,  FREE_TARGET,  NO_LINK,        true  },
+  { cost_functions::CircleTargetCameraReprjErrorWithDistortionPK, true, true, FREE_TARGET,  NO_LINK,        false },
+  { cost_functions::CircleTargetCameraReprjError,		false, true,  FREE_TARGET,  NO_LINK,        true  },
+  { cost_functions::CircleTargetCameraReprjErrorPK,		false, true,  FREE_TARGET,  NO_LINK,        false },
+  { cost_functions::LinkCircleTargetCameraReprjError,		false, true,  FREE_TARGET,  TARGET_ON_LINK, true  },
+  { cost_functions::LinkCircleTargetCameraReprjErrorPK,		false, true,  FREE_TARGET,  TARGET_ON_LINK, false },
+  { cost_functions::LinkCameraCircleTargetReprjError,		false, true,  FREE_TARGET,  CAMERA_ON_LINK, true  },
+  { cost_functions::LinkCameraCircleTargetReprjErrorPK,		false, true,  FREE_TARGET,  CAMERA_ON_LINK, false },
+  { cost_functions::FixedCircleTargetCameraReprjErrorPK,	false, true,  FIXED_TARGET, CAMERA_ON_LINK, false },
+};
+
+// angle axis and position to a transform
+Eigen::Isometry3d poseTransform(const double pose[6])
+{
+  Eigen::Vector3d angle_axis(pose[0], pose[1], pose[2]);
+  Eigen::Isometry3d transform = Eigen::Isometry3d::Identity();
+  if(angle_axis.norm() > 0.0) transform.linear() = Eigen::AngleAxisd(angle_axis.norm(), angle_axis.normalized()).toRotationMatrix();
+  transform.translation() = Eigen::Vector3d(pose[3], pose[4], pose[5]);
+  return(transform);
+}
+
+// where the cost type expects the observation, each quantity comes from the estimated block or from the known one
+Eigen::Vector2d referenceImagePoint(const CostTypeSpec &spec, const double extrinsics[6],
+				    const double intrinsics[9], const double known_intrinsics[9],
+				    const double target_pose[6], const double known_target_pose[6],
+				    const double point[3], const double known_point[3],
+				    const double link_pose[6], double circle_diameter)
+{
+  const double *k = spec.distorted ? intrinsics : known_intrinsics;
+  const double *p = spec.free_point ? point : known_point;
+  Eigen::Isometry3d target_to_camera = poseTransform(extrinsics);
+  if(spec.link == TARGET_ON_LINK) target_to_camera = target_to_camera * poseTransform(link_pose);
+  if(spec.link == CAMERA_ON_LINK) target_to_camera = target_to_camera * poseTransform(link_pose).inverse();
+  if(spec.target == FREE_TARGET) target_to_camera = target_to_camera * poseTransform(target_pose);
+  if(spec.target == FIXED_TARGET) target_to_camera = target_to_camera * poseTransform(known_target_pose);
+  Eigen::Vector3d camera_point = target_to_camera * Eigen::Vector3d(p[0], p[1], p[2]);
+
+  if(spec.circle){
+    double xyz[3] = { camera_point.x(), camera_point.y(), camera_point.z() };
+    double R_TtoC[9];
+    Eigen::Map<Eigen::Matrix3d> rotation(R_TtoC); // column major like the helpers
+    rotation = target_to_camera.linear();
+    double fx = k[0], fy = k[1], cx = k[2], cy = k[3], k1 = k[4], k2 = k[5], k3 = k[6], p1 = k[7], p2 = k[8];
+    double ox = 0.0, oy = 0.0, diameter = circle_diameter, image[2];
+    if(spec.distorted) cameraCircResidualDist(xyz, diameter, R_TtoC, k1, k2, k3, p1, p2, fx, fy, cx, cy, ox, oy, image);
+    else cameraCircResidual(xyz, diameter, R_TtoC, fx, fy, cx, cy, ox, oy, image);
+    return(Eigen::Vector2d(image[0], image[1]));
+  }
+
+  double x = camera_point.x()/camera_point.z();
+  double y = camera_point.y()/camera_point.z();
+  if(spec.distorted){
+    double r2 = x*x + y*y;
+    double radial = 1.0 + k[4]*r2 + k[5]*r2*r2 + k[6]*r2*r2*r2;
+    double xd = x*radial + 2.0*k[7]*x*y + k[8]*(r2 + 2.0*x*x);
+    double yd = y*radial + k[7]*(r2 + 2.0*y*y) + 2.0*k[8]*x*y;
+    x = xd;
+    y = yd;
+  }
+  return(Eigen::Vector2d(k[0]*x + k[2], k[1]*y + k[3]));
+}
+
+class ReprojectionCostTest : public ::testing::TestWithParam<CostTypeSpec> {};
+
+// every cost type built by createObservationCost must take its parameter blocks in order,
+// read the known quantities from the observation and land where the reference projects
+TEST_P(ReprojectionCostTest, matchesReference)
+{
+  const CostTypeSpec &spec = GetParam();
+  // the observation's blocks hold the known values, the estimates differ from them
+  double known_extrinsics[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  double known_intrinsics[9] = { 520.0, 515.0, 310.0, 245.0, -0.04, 0.01, 0.001, 0.002, -0.001 };
+  double known_target_pose[6] = { 0.35, -0.25, 0.1, 0.02, -0.03, 0.05 };
+  double known_point[3] = { 0.04, -0.03, 0.0 };
+  double extrinsics[6] = { 0.05, -0.08, 0.03, 0.02, 0.01, 1.0 };
+  double intrinsics[9] = { 530.0, 525.0, 320.0, 240.0, -0.05, 0.02, -0.002, 0.001, 0.002 };
+  double target_pose[6] = { 0.4, 0.2, -0.05, 0.05, -0.02, 0.03 };
+  double point[3] = { 0.06, 0.03, 0.0 };
+  double link_pose[6] = { 0.03, -0.02, 0.1, 0.04, 0.02, -0.03 };
+  double circle_diameter = 0.2; // large enough for the circle correction to be several pixels
+  Pose6d link;
+  link.setAngleAxis(link_pose[0], link_pose[1], link_pose[2]);
+  link.setOrigin(link_pose[3], link_pose[4], link_pose[5]);
+
+  Eigen::Vector2d expected = referenceImagePoint(spec, extrinsics, intrinsics, known_intrinsics,
+						 target_pose, known_target_pose, point, known_point,
+						 link_pose, circle_diameter);
+  // the observation is offset from the reference, so the residual is minus the offset
+  double dx = 1.5, dy = -2.5;
+  ObservationDataPoint ODP("camera", "target", 0, 0, known_intrinsics, known_extrinsics, 0,
+			   known_target_pose, known_point, expected.x()+dx, expected.y()+dy,
+			   spec.type, link, circle_diameter);
+  std::vector<P_BLOCK> blocks;
+  ceres::CostFunction *cost = createObservationCost(ODP, extrinsics, intrinsics, target_pose, point, blocks);
+  ASSERT_TRUE(cost != NULL);
+
+  // blocks come in the order extrinsics, intrinsics, target pose, point, leaving out the known ones
+  std::vector<P_BLOCK> expected_blocks(1, extrinsics);
+  std::vector<int> expected_sizes(1, 6);
+  if(spec.distorted){ expected_blocks.push_back(intrinsics); expected_sizes.push_back(9); }
+  if(spec.target == FREE_TARGET){ expected_blocks.push_back(target_pose); expected_sizes.push_back(6); }
+  if(spec.free_point){ expected_blocks.push_back(point); expected_sizes.push_back(3); }
+  ASSERT_EQ(expected_blocks, blocks);
+  const std::vector<ceres::int32> &sizes = cost->parameter_block_sizes();
+  ASSERT_EQ(expected_sizes.size(), sizes.size());
+  for(int i=0; i<(int)sizes.size(); i++) EXPECT_EQ(expected_sizes[i], sizes[i]);
+
+  double residual[2];
+  ASSERT_TRUE(cost->Evaluate(&blocks[0], residual, NULL));
+  EXPECT_NEAR(-dx, residual[0], 1e-8);
+  EXPECT_NEAR(-dy, residual[1], 1e-8);
+  delete cost;
+}
+
+INSTANTIATE_TEST_CASE_P(IndustrialExtrinsicCalCeresSuite, ReprojectionCostTest, ::testing::ValuesIn(COST_TYPE_SPECS));
+
+// known intrinsics, the principal point must come from the inputs like the focal lengths
+TEST(IndustrialExtrinsicCalCeresSuite, CircleTargetCameraReprjErrorPrincipalPoint)
+{
+  // without distortion the twin which estimates the intrinsics projects the same way
+  double extrinsics[6] = { 0.05, -0.1, 0.02, 0.01, -0.02, 1.0 };
+  double target_pose[6] = { 0.3, -0.2, 0.1, 0.01, 0.02, 0.0 };
+  double point[3] = { 0.1, -0.05, 0.0 };
+  double intrinsics[9] = { 525.0, 520.0, 300.0, 250.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  ReprojectionInputs inputs = reprojectionInputs(350.0, 230.0);
+  inputs.circle_diameter = 0.05;
+  for(int i=0; i<9; i++) inputs.intrinsics[i] = intrinsics[i];
+
+  CircleTargetCameraReprjError known_intrinsics(inputs);
+  CircleTargetCameraReprjErrorWithDistortion free_intrinsics(inputs);
+  double residual[2], residual_expected[2];
+  ASSERT_TRUE(known_intrinsics(extrinsics, target_pose, point, residual));
+  ASSERT_TRUE(free_intrinsics(extrinsics, intrinsics, target_pose, point, residual_expected));
+  ASSERT_NEAR(residual_expected[0], residual[0], 1e-9);
+  ASSERT_NEAR(residual_expected[1], residual[1], 1e-9);
+  // values of the reference projection, a principal point of zero would be off by (300, 250)
+  ASSERT_NEAR(13.624316747, residual[0], 1e-6);
+  ASSERT_NEAR(-0.055836622, residual[1], 1e-6);
+}
+
+// the known point version must rotate the circle the same way as its twin which estimates the point
+TEST(IndustrialExtrinsicCalCeresSuite, CircleCameraReprjErrorWithDistortionPKRotation)
+{
+  double extrinsics[6] = { 2.8, 0.3, 0.1, 0.02, -0.01, 1.0 };
+  double intrinsics[9] = { 525.0, 520.0, 320.0, 240.0, -0.05, 0.01, 0.0, 0.001, -0.001 };
+  double point[3] = { 0.05, 0.02, 0.0 };
+  ReprojectionInputs inputs = reprojectionInputs(330.0, 235.0);
+  inputs.circle_diameter = 0.05;
+  inputs.point.x = point[0];
+  inputs.point.y = point[1];
+  inputs.point.z = point[2];
+
+  CircleCameraReprjErrorWithDistortion free_point(inputs);
+  CircleCameraReprjErrorWithDistortionPK known_point(inputs);
+  double residual[2], residual_pk[2];
+  ASSERT_TRUE(free_point(extrinsics, intrinsics, point, residual));
+  ASSERT_TRUE(known_point(extrinsics, intrinsics, residual_pk));
+  ASSERT_NEAR(residual[0], residual_pk[0], 1e-9);
+  ASSERT_NEAR(residual[1], residual_pk[1], 1e-9);
+  // values of the reference projection, the camera is turned almost half a turn so a wrong rotation shows
+  ASSERT_NEAR(27.718410568, residual_pk[0], 1e-6);
+  ASSERT_NEAR(-4.135348816, residual_pk[1], 1e-6);
+}
+
+// a camera on a link sees what a camera with extrinsics E*L^-1 sees, for the circle's position and its rotation
+TEST(IndustrialExtrinsicCalCeresSuite, LinkCameraCircleTargetReprjErrorInverse)
+{
+  Pose6d camera(0.01, -0.02, 1.0, 0.05, -0.1, 0.02);
+  Pose6d link(0.05, -0.02, 0.03, 0.1, -0.05, 0.2);
+  Pose6d equivalent_camera = camera * link.getInverse();
+  double target_pose[6] = { 0.2, 0.1, -0.1, 0.01, 0.02, 0.0 };
+  double point[3] = { 0.03, 0.04, 0.0 };
+  ReprojectionInputs inputs = reprojectionInputs(330.0, 235.0);
+  inputs.circle_diameter = 0.05;
+  double intrinsics[9] = { 525.0, 525.0, 320.0, 240.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  for(int i=0; i<9; i++) inputs.intrinsics[i] = intrinsics[i];
+  inputs.point.x = point[0];
+  inputs.point.y = point[1];
+  inputs.point.z = point[2];
+
+  ReprojectionInputs link_inputs = inputs;
+  link_inputs.link_pose = link;
+  LinkCameraCircleTargetReprjError on_link(link_inputs);
+  LinkCameraCircleTargetReprjErrorPK on_link_pk(link_inputs);
+  CircleTargetCameraReprjError equivalent(inputs);
+  double residual[2], residual_pk[2], residual_expected[2];
+  ASSERT_TRUE(on_link(camera.pb_pose, target_pose, point, residual));
+  ASSERT_TRUE(on_link_pk(camera.pb_pose, target_pose, residual_pk));
+  ASSERT_TRUE(equivalent(equivalent_camera.pb_pose, target_pose, point, residual_expected));
+  for(int i=0; i<2; i++){
+    ASSERT_NEAR(residual_expected[i], residual[i], 1e-9);
+    ASSERT_NEAR(residual_expected[i], residual_pk[i], 1e-9);
+  }
+  // values of the reference projection through the inverted link
+  ASSERT_NEAR(0.457605459, residual[0], 1e-6);
+  ASSERT_NEAR(34.701087671, residual[1], 1e-6);
+}
+
+// the trim loop removes an observation displaced far beyond the noise, and nothing else
+TEST(IndustrialExtrinsicCalCeresSuite, outlierTrimmer)
+{
+  SyntheticJobParameters parameters = defaultSyntheticJobParameters();
+  parameters.cost_type = cost_functions::CircleTargetCameraReprjErrorWithDistortionPK;
+  SyntheticJob job(parameters);
+  ASSERT_TRUE(job.generate());
+  int num_observations = (int)job.observations().items_.size();
+  int outlier = num_observations/2;
+  job.displaceObservation(outlier, 30.0, -30.0);
+
+  ceres::Problem problem(trimProblemOptions());
+  std::vector<ObservationResidual> residuals;
+  job.addToProblem(problem, NULL, &residuals);
+  ceres::Solver::Options options;
+  options.linear_solver_type = ceres::DENSE_SCHUR;
+  options.minimizer_progress_to_stdout = false;
+  options.max_num_iterations = 100;
+  OutlierTrimParameters trim_parameters = defaultOutlierTrimParameters();
+  trim_parameters.max_rounds = 3;
+  trim_parameters.pixel_sigma = 1.0; // five times the generated noise, no inlier comes near the threshold
+  OutlierTrimmer trimmer(trim_parameters);
+  ceres::Solver::Summary summary;
+  ASSERT_TRUE(trimmer.solve(problem, residuals, options, summary));
+
+  ASSERT_EQ(1, (int)trimmer.trimmed().size());
+  const ObservationDataPoint &ODP = job.observations().items_[outlier];
+  const TrimmedObservation &trimmed = trimmer.trimmed()[0];
+  ASSERT_EQ(ODP.scene_id_, trimmed.observation.scene_id);
+  ASSERT_EQ(ODP.camera_name_, trimmed.observation.camera_name);
+  ASSERT_EQ(ODP.point_id_, trimmed.observation.point_id);
+  ASSERT_EQ(1, trimmed.round);
+  ASSERT_EQ(num_observations-1, (int)residuals.size());
+  ASSERT_EQ(num_observations-1, problem.NumResidualBlocks());
+}
+
+// points share every residual with the target pose, the greedy independent set keeps the first declared
+TEST(IndustrialExtrinsicCalCeresSuite, schurOrderingIndependentSet)
+{
+  double extrinsics[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 1.0 };
+  double target_pose[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  double point1[3] = { 0.1, 0.0, 0.0 };
+  double point2[3] = { 0.0, 0.1, 0.0 };
+  ReprojectionInputs inputs = reprojectionInputs(320.0, 240.0);
+  inputs.intrinsics[0] = inputs.intrinsics[1] = 525.0;
+  ceres::Problem problem;
+  problem.AddResidualBlock(TargetCameraReprjError::Create(inputs), NULL, extrinsics, target_pose, point1);
+  problem.AddResidualBlock(TargetCameraReprjError::Create(inputs), NULL, extrinsics, target_pose, point2);
+
+  // points declared first are eliminated, the pose they share residuals with joins the cameras
+  SchurOrdering points_first;
+  points_first.eliminate(point1);
+  points_first.eliminate(point2);
+  points_first.eliminate(target_pose);
+  ceres::Solver::Options options;
+  options.linear_solver_type = ceres::DENSE_SCHUR;
+  ASSERT_EQ(2, points_first.apply(problem, options));
+  ASSERT_EQ(0, options.linear_solver_ordering->GroupId(point1));
+  ASSERT_EQ(0, options.linear_solver_ordering->GroupId(point2));
+  ASSERT_EQ(1, options.linear_solver_ordering->GroupId(target_pose));
+  ASSERT_EQ(1, options.linear_solver_ordering->GroupId(extrinsics));
+
+  // the pose declared first is eliminated alone
+  SchurOrdering pose_first;
+  pose_first.eliminate(target_pose);
+  pose_first.eliminate(point1);
+  pose_first.eliminate(point2);
+  ceres::Solver::Options pose_options;
+  pose_options.linear_solver_type = ceres::DENSE_SCHUR;
+  ASSERT_EQ(1, pose_first.apply(problem, pose_options));
+  ASSERT_EQ(0, pose_options.linear_solver_ordering->GroupId(target_pose));
+  ASSERT_EQ(1, pose_options.linear_solver_ordering->GroupId(point1));
+
+  // only the Schur solvers take an ordering
+  ceres::Solver::Options qr_options;
+  qr_options.linear_solver_type = ceres::DENSE_QR;
+  ASSERT_EQ(0, points_first.apply(problem, qr_options));
+}
+
+// eliminating every block would leave an empty reduced system, Ceres then chooses its own ordering
+TEST(IndustrialExtrinsicCalCeresSuite, schurOrderingReducedSystemNotEmpty)
+{
+  double point1[3] = { 0.1, 0.0, 0.0 };
+  double point2[3] = { 0.0, 0.1, 0.0 };
+  double extrinsics[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 1.0 };
+  ceres::Problem problem;
+  problem.AddParameterBlock(point1, 3);
+  problem.AddParameterBlock(point2, 3);
+
+  SchurOrdering ordering;
+  ordering.eliminate(point1);
+  ordering.eliminate(point2);
+  ceres::Solver::Options options;
+  options.linear_solver_type = ceres::DENSE_SCHUR;
+  ASSERT_EQ(0, ordering.apply(problem, options));
+  ASSERT_TRUE(options.linear_solver_ordering.get() == NULL);
+
+  // one block left for the reduced system is enough
+  problem.AddParameterBlock(extrinsics, 6);
+  ASSERT_EQ(2, ordering.apply(problem, options));
+  ASSERT_EQ(1, options.linear_solver_ordering->GroupId(extrinsics));
+}
+
 Point3d xformPoint(Point3d &original_point, double &ax, double &ay, double &az, double &x, double&y, double &z);
 
 
@@ -305,6 +645,34 @@ TEST(IndustrialExtrinsicCalCeresSuite, poseRotationMatrix)
   ASSERT_NEAR(aa[2], az, .00001);
 }
 
+TEST(IndustrialExtrinsicCalCeresSuite, cachedRotationMatrix)
+{
+  double block[6] = { .5, .23, .45, 1.0, 2.0, 3.0 };
+  RotationCache cache;
+  const RotationCacheEntry *entry = cache.add(block);
+
+  // value and derivatives from the cache must match a direct conversion
+  typedef ceres::Jet<double, 6> Jet6;
+  Jet6 aa[3], R_direct[9], R_cached[9];
+  for(int k=0; k<3; k++) aa[k] = Jet6(block[k], k);
+  ceres::AngleAxisToRotationMatrix(aa, R_direct);
+  cachedRotationMatrix(entry, aa, R_cached);
+  for(int i=0; i<9; i++){
+    ASSERT_NEAR(R_direct[i].a, R_cached[i].a, 1e-12);
+    for(int k=0; k<6; k++) ASSERT_NEAR(R_direct[i].v[k], R_cached[i].v[k], 1e-12);
+  }
+
+  // a stale entry is not used
+  block[0] = .1;
+  double aa_new[3] = { block[0], block[1], block[2] };
+  double R_new[9], R_expected[9];
+  cachedRotationMatrix(entry, aa_new, R_new);
+  ceres::AngleAxisToRotationMatrix(aa_new, R_expected);
+  for(int i=0; i<9; i++) ASSERT_NEAR(R_expected[i], R_new[i], 1e-12);
+  cache.update();
+  ASSERT_EQ(entry->aa[0], block[0]);
+}
+
 TEST(IndustrialExtrinsicCalCeresSuite, cameraPntResidualDist)
 {
 }
@@ -474,10 +842,10 @@ TEST(IndustrialExtrinsicCalCeresSuite, points_costfunction)
     {
       double ox = observations[j].image_loc_x;
       double oy = observations[j].image_loc_y;
-      ceres::CostFunction* cost_function = CameraReprjErrorWithDistortion::Create(ox, oy);
+      ceres::CostFunction* cost_function = CameraReprjErrorWithDistortion::Create(reprojectionInputs(ox, oy));
       problem.AddResidualBlock(cost_function, NULL, extrinsics, intrinsics, transformed_points[j].pb);
       double residual[2];
-      CameraReprjErrorWithDistortion CFC(ox, oy);
+      CameraReprjErrorWithDistortion CFC(reprojectionInputs(ox, oy));
       CFC(extrinsics, intrinsics, transformed_points[j].pb, residual);
       // no reprojection error should be observed
       ASSERT_NEAR(0.0, residual[0], .1);
@@ -576,10 +944,10 @@ TEST(IndustrialExtrinsicCalCeresSuite, circle_cost)
     {
       double ox = observations[j].image_loc_x;
       double oy = observations[j].image_loc_y;
-      ceres::CostFunction* cost_function = CameraReprjErrorWithDistortion::Create(ox, oy);
+      ceres::CostFunction* cost_function = CameraReprjErrorWithDistortion::Create(reprojectionInputs(ox, oy));
       problem.AddResidualBlock(cost_function, NULL, extrinsics, intrinsics, transformed_points[j].pb);
       double residual[2];
-      CameraReprjErrorWithDistortion CFC(ox, oy);
+      CameraReprjErrorWithDistortion CFC(reprojectionInputs(ox, oy));
       CFC(extrinsics, intrinsics, transformed_points[j].pb, residual);
       // no reprojection error should be observed
       ASSERT_NEAR(0.0, residual[0], .1);
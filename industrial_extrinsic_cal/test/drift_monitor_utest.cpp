@@ -0,0 +1,161 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <industrial_extrinsic_cal/drift_monitor.h>
+
+using namespace industrial_extrinsic_cal;
+
+// a camera at the origin looking at a target at the origin, each point one meter down the optical axis
+// projects onto the principal point, so an observation error pixels to its right has exactly that error
+class DriftMonitorTest : public ::testing::Test
+{
+protected:
+  DriftMonitorTest()
+  {
+    double intrinsics[9] = { 500.0, 500.0, 320.0, 240.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    for(int i=0; i<9; i++) intrinsics_[i] = intrinsics[i];
+    for(int i=0; i<6; i++){
+      extrinsics_[i] = 0.0;
+      known_pose_[i] = 0.0;
+      estimated_pose_[i] = 0.0;
+    }
+    point_[0] = 0.0;
+    point_[1] = 0.0;
+    point_[2] = 1.0;
+    known_blocks_.push_back(known_pose_);
+    known_blocks_.push_back(point_);
+  }
+
+  ObservationDataPointList scene(const std::string &camera_name, int num_observations, double error,
+				 P_BLOCK target_pose)
+  {
+    ObservationDataPointList observations;
+    Pose6d identity(0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+    for(int i=0; i<num_observations; i++){
+      observations.addObservationPoint(ObservationDataPoint(camera_name, "target", 0, 0, intrinsics_, extrinsics_, i,
+							    target_pose, point_, 320.0 + error, 240.0,
+							    cost_functions::TargetCameraReprjError, identity));
+    }
+    return(observations);
+  }
+
+  ObservationDataPointList scene(const std::string &camera_name, int num_observations, double error)
+  {
+    return(scene(camera_name, num_observations, error, known_pose_));
+  }
+
+  double intrinsics_[9];
+  double extrinsics_[6];
+  double known_pose_[6];
+  double estimated_pose_[6];
+  double point_[3];
+  std::vector<P_BLOCK> known_blocks_;
+};
+
+TEST_F(DriftMonitorTest, measuresTheStoredCalibration)
+{
+  DriftMonitor monitor(defaultDriftParameters());
+  ASSERT_TRUE(monitor.update(scene("camera", 4, 1.5), known_blocks_));
+  ASSERT_EQ(1, (int)monitor.cameras().size());
+  const CameraDrift &camera = monitor.cameras().find("camera")->second;
+  EXPECT_EQ(4, camera.last.num_observations);
+  EXPECT_NEAR(1.5, QualityReport::rms(camera.last), 1e-9);
+  EXPECT_NEAR(1.5, camera.last.max_error, 1e-9);
+  EXPECT_EQ(0, camera.above_threshold);
+  EXPECT_FALSE(monitor.drifted());
+}
+
+TEST_F(DriftMonitorTest, fewObservationsAreIgnored)
+{
+  DriftParameters parameters = defaultDriftParameters();
+  parameters.min_observations = 4;
+  parameters.consecutive = 1;
+  DriftMonitor monitor(parameters);
+  ASSERT_TRUE(monitor.update(scene("camera", 3, 10.0), known_blocks_));
+  EXPECT_TRUE(monitor.cameras().empty());
+  EXPECT_FALSE(monitor.drifted());
+
+  ASSERT_TRUE(monitor.update(scene("camera", 4, 10.0), known_blocks_));
+  EXPECT_EQ(1, (int)monitor.cameras().size());
+  EXPECT_TRUE(monitor.drifted());
+}
+
+TEST_F(DriftMonitorTest, consecutiveViolations)
+{
+  DriftParameters parameters = defaultDriftParameters();
+  parameters.threshold = 2.0;
+  parameters.consecutive = 3;
+  DriftMonitor monitor(parameters);
+
+  // a good update between two violations starts the count again
+  ASSERT_TRUE(monitor.update(scene("camera", 4, 5.0), known_blocks_));
+  ASSERT_TRUE(monitor.update(scene("camera", 4, 5.0), known_blocks_));
+  EXPECT_EQ(2, monitor.cameras().find("camera")->second.above_threshold);
+  EXPECT_FALSE(monitor.drifted());
+  ASSERT_TRUE(monitor.update(scene("camera", 4, 1.0), known_blocks_));
+  EXPECT_EQ(0, monitor.cameras().find("camera")->second.above_threshold);
+
+  ASSERT_TRUE(monitor.update(scene("camera", 4, 5.0), known_blocks_));
+  ASSERT_TRUE(monitor.update(scene("camera", 4, 5.0), known_blocks_));
+  EXPECT_FALSE(monitor.drifted());
+  ASSERT_TRUE(monitor.update(scene("camera", 4, 5.0), known_blocks_));
+  EXPECT_TRUE(monitor.cameras().find("camera")->second.drifted);
+  EXPECT_TRUE(monitor.drifted());
+
+  // an update which does not see the camera leaves its state alone
+  ASSERT_TRUE(monitor.update(scene("other", 4, 0.0), known_blocks_));
+  EXPECT_TRUE(monitor.cameras().find("camera")->second.drifted);
+  EXPECT_FALSE(monitor.cameras().find("other")->second.drifted);
+
+  monitor.reset();
+  EXPECT_TRUE(monitor.cameras().empty());
+  EXPECT_FALSE(monitor.drifted());
+}
+
+TEST_F(DriftMonitorTest, onlyKnownTargetsAreEvaluated)
+{
+  DriftParameters parameters = defaultDriftParameters();
+  parameters.consecutive = 1;
+  DriftMonitor monitor(parameters);
+  ASSERT_TRUE(monitor.update(scene("camera", 10, 10.0, estimated_pose_), known_blocks_));
+  EXPECT_TRUE(monitor.cameras().empty());
+
+  ObservationDataPointList observations = scene("camera", 4, 1.0);
+  ObservationDataPointList estimated = scene("camera", 10, 10.0, estimated_pose_);
+  observations.items_.insert(observations.items_.end(), estimated.items_.begin(), estimated.items_.end());
+  ASSERT_TRUE(monitor.update(observations, known_blocks_));
+  EXPECT_EQ(4, monitor.cameras().find("camera")->second.last.num_observations);
+  EXPECT_FALSE(monitor.drifted());
+}
+
+TEST_F(DriftMonitorTest, maxObservations)
+{
+  DriftParameters parameters = defaultDriftParameters();
+  parameters.max_observations = 5;
+  DriftMonitor monitor(parameters);
+  ASSERT_TRUE(monitor.update(scene("camera", 8, 1.0), known_blocks_));
+  EXPECT_EQ(5, monitor.cameras().find("camera")->second.last.num_observations);
+}
+
+// Run all the tests that were declared with TEST()
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,198 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <math.h>
+#include <string>
+#include <industrial_extrinsic_cal/frame_quality.h>
+#include <industrial_extrinsic_cal/observation_data_point.h>
+
+using namespace industrial_extrinsic_cal;
+
+// a 10x10 mono image of one pixel wide vertical stripes, every interior Laplacian is +-2*contrast
+cv::Mat stripes(int dark, int bright)
+{
+  cv::Mat image(10, 10, CV_8UC1);
+  for(int r=0; r<image.rows; r++){
+    for(int c=0; c<image.cols; c++){
+      image.at<unsigned char>(r, c) = (c % 2 == 0) ? dark : bright;
+    }
+  }
+  return(image);
+}
+
+FrameQualityParameters everyPixel()
+{
+  FrameQualityParameters parameters = defaultFrameQualityParameters();
+  parameters.stride = 1;
+  return(parameters);
+}
+
+TEST(IndustrialExtrinsicCalFrameQualitySuite, defaultsDisableTheChecks)
+{
+  FrameQualityParameters parameters = defaultFrameQualityParameters();
+  EXPECT_FALSE(frameChecksEnabled(parameters));
+  parameters.min_focus = 10.0;
+  EXPECT_TRUE(frameChecksEnabled(parameters));
+  parameters = defaultFrameQualityParameters();
+  parameters.max_saturated_fraction = 0.5;
+  EXPECT_TRUE(frameChecksEnabled(parameters));
+}
+
+// the 8x8 interior alternates Laplacians of +200 and -200, their variance is 200^2
+TEST(IndustrialExtrinsicCalFrameQualitySuite, sharpFramePasses)
+{
+  FrameQualityParameters parameters = everyPixel();
+  parameters.min_focus = 1000.0;
+  FrameQuality quality;
+  EXPECT_TRUE(checkFrameQuality(stripes(0, 100), parameters, quality));
+  EXPECT_NEAR(40000.0, quality.focus, 1e-9);
+  EXPECT_EQ(0.0, quality.saturated_fraction);
+  EXPECT_TRUE(quality.failure == NULL);
+}
+
+TEST(IndustrialExtrinsicCalFrameQualitySuite, blurredFrameFails)
+{
+  FrameQualityParameters parameters = everyPixel();
+  parameters.min_focus = 1000.0;
+  FrameQuality quality;
+  // a low contrast copy of the same frame, as a defocused lens would give
+  EXPECT_FALSE(checkFrameQuality(stripes(40, 50), parameters, quality));
+  EXPECT_NEAR(400.0, quality.focus, 1e-9);
+  ASSERT_TRUE(quality.failure != NULL);
+  EXPECT_EQ(std::string("blurred"), quality.failure);
+}
+
+// the top half of the sampled rows is at 255
+TEST(IndustrialExtrinsicCalFrameQualitySuite, saturatedFrameFails)
+{
+  cv::Mat image(10, 10, CV_8UC1);
+  for(int r=0; r<image.rows; r++){
+    for(int c=0; c<image.cols; c++){
+      image.at<unsigned char>(r, c) = r < 5 ? 255 : 0;
+    }
+  }
+  FrameQualityParameters parameters = everyPixel();
+  parameters.max_saturated_fraction = 0.5;
+  FrameQuality quality;
+  EXPECT_TRUE(checkFrameQuality(image, parameters, quality));
+  EXPECT_NEAR(0.5, quality.saturated_fraction, 1e-12);
+
+  parameters.max_saturated_fraction = 0.4;
+  EXPECT_FALSE(checkFrameQuality(image, parameters, quality));
+  ASSERT_TRUE(quality.failure != NULL);
+  EXPECT_EQ(std::string("saturated"), quality.failure);
+}
+
+// with a stride of 2 only every other column is sampled, so the stripes look flat
+TEST(IndustrialExtrinsicCalFrameQualitySuite, strideSamples)
+{
+  FrameQualityParameters parameters = defaultFrameQualityParameters();
+  FrameQuality quality;
+  EXPECT_TRUE(checkFrameQuality(stripes(0, 100), parameters, quality));
+  EXPECT_NEAR(0.0, quality.focus, 1e-9);
+}
+
+TEST(IndustrialExtrinsicCalFrameQualitySuite, colorAndTinyFramesPass)
+{
+  FrameQualityParameters parameters = everyPixel();
+  parameters.min_focus = 1000.0;
+  FrameQuality quality;
+  EXPECT_TRUE(checkFrameQuality(cv::Mat(10, 10, CV_8UC3), parameters, quality));
+  EXPECT_TRUE(checkFrameQuality(cv::Mat(2, 10, CV_8UC1), parameters, quality));
+  EXPECT_EQ(0.0, quality.focus);
+  EXPECT_TRUE(quality.failure == NULL);
+}
+
+TEST(IndustrialExtrinsicCalFrameQualitySuite, costChains)
+{
+  CostChain chain;
+  ASSERT_TRUE(costChain(cost_functions::CameraReprjError, chain));
+  EXPECT_FALSE(chain.target_present);
+
+  ASSERT_TRUE(costChain(cost_functions::TargetCameraReprjErrorPK, chain));
+  EXPECT_TRUE(chain.target_present);
+  EXPECT_FALSE(chain.camera_on_link);
+  EXPECT_FALSE(chain.target_on_link);
+
+  ASSERT_TRUE(costChain(cost_functions::LinkTargetCameraReprjError, chain));
+  EXPECT_TRUE(chain.target_present);
+  EXPECT_FALSE(chain.camera_on_link);
+  EXPECT_TRUE(chain.target_on_link);
+
+  ASSERT_TRUE(costChain(cost_functions::LinkCameraTargetReprjErrorPK, chain));
+  EXPECT_TRUE(chain.target_present);
+  EXPECT_TRUE(chain.camera_on_link);
+  EXPECT_FALSE(chain.target_on_link);
+
+  EXPECT_FALSE(costChain((Cost_function)-1, chain));
+}
+
+// the camera looks down its z axis at a target 2m away, the link is shifted 0.5m along x
+TEST(IndustrialExtrinsicCalFrameQualitySuite, predictTargetInCamera)
+{
+  double extrinsics[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 2.0 };
+  double target_pose[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  Pose6d link(0.5, 0.0, 0.0, 0.0, 0.0, 0.0);
+  Pose6d target_in_camera;
+
+  EXPECT_FALSE(predictTargetInCamera(cost_functions::CameraReprjError, extrinsics, target_pose, link, target_in_camera));
+
+  ASSERT_TRUE(predictTargetInCamera(cost_functions::TargetCameraReprjError, extrinsics, target_pose, link,
+				    target_in_camera));
+  EXPECT_NEAR(0.0, target_in_camera.x, 1e-12);
+  EXPECT_NEAR(2.0, target_in_camera.z, 1e-12);
+  EXPECT_NEAR(0.0, viewingAngle(target_in_camera), 1e-9);
+
+  ASSERT_TRUE(predictTargetInCamera(cost_functions::LinkTargetCameraReprjError, extrinsics, target_pose, link,
+				    target_in_camera));
+  EXPECT_NEAR(0.5, target_in_camera.x, 1e-12);
+  EXPECT_NEAR(2.0, target_in_camera.z, 1e-12);
+
+  ASSERT_TRUE(predictTargetInCamera(cost_functions::LinkCameraTargetReprjError, extrinsics, target_pose, link,
+				    target_in_camera));
+  EXPECT_NEAR(-0.5, target_in_camera.x, 1e-12);
+  EXPECT_NEAR(2.0, target_in_camera.z, 1e-12);
+}
+
+TEST(IndustrialExtrinsicCalFrameQualitySuite, viewingAngle)
+{
+  // a target tilted 0.5 rad about x, straight ahead of the camera
+  double extrinsics[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  double target_pose[6] = { 0.5, 0.0, 0.0, 0.0, 0.0, 1.0 };
+  Pose6d identity(0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+  Pose6d target_in_camera;
+  ASSERT_TRUE(predictTargetInCamera(cost_functions::TargetCameraReprjErrorPK, extrinsics, target_pose, identity,
+				    target_in_camera));
+  EXPECT_NEAR(0.5, viewingAngle(target_in_camera), 1e-9);
+
+  // seen from behind the angle is the same, the target's normal has no preferred side
+  target_pose[0] = M_PI - 0.5;
+  ASSERT_TRUE(predictTargetInCamera(cost_functions::TargetCameraReprjErrorPK, extrinsics, target_pose, identity,
+				    target_in_camera));
+  EXPECT_NEAR(0.5, viewingAngle(target_in_camera), 1e-9);
+
+  EXPECT_EQ(-1.0, viewingAngle(identity));
+}
+
+// Run all the tests that were declared with TEST()
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
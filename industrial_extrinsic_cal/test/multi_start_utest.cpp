@@ -0,0 +1,175 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <boost/bind.hpp>
+#include <industrial_extrinsic_cal/multi_start_optimizer.h>
+
+using namespace industrial_extrinsic_cal;
+
+// pulls a 6 element pose block towards a goal pose
+struct PoseGoal
+{
+  PoseGoal(const double *goal)
+  {
+    for(int i=0; i<6; i++) goal_[i] = goal[i];
+  }
+
+  template<typename T>
+  bool operator()(const T* const pose, T* residual) const
+  {
+    for(int i=0; i<6; i++) residual[i] = pose[i] - T(goal_[i]);
+    return true;
+  }
+
+  double goal_[6];
+};
+
+// adds one PoseGoal residual on the pose block, or on a start's copy of it
+void addPoseGoal(ceres::Problem &problem, ParameterBlockCopies *copies, P_BLOCK pose, const double *goal, bool constant)
+{
+  P_BLOCK block = copies == NULL ? pose : copies->extrinsics(pose);
+  problem.AddResidualBlock(new ceres::AutoDiffCostFunction<PoseGoal, 6, 6>(new PoseGoal(goal)), NULL, block);
+  if(constant) problem.SetParameterBlockConstant(block);
+}
+
+TEST(IndustrialExtrinsicCalMultiStartSuite, exactCopy)
+{
+  double pose[6] = {0.1, 0.2, 0.3, 1.0, 2.0, 3.0};
+  ParameterBlockCopies copies(0.0, 0.0, 1);
+  P_BLOCK copy = copies.extrinsics(pose);
+  ASSERT_TRUE(copy != pose);
+  for(int i=0; i<6; i++) EXPECT_EQ(pose[i], copy[i]);
+  // the same block always maps to the same copy
+  EXPECT_EQ(copy, copies.extrinsics(pose));
+}
+
+TEST(IndustrialExtrinsicCalMultiStartSuite, onlyPosesArePerturbed)
+{
+  double extrinsics[6] = {0.1, 0.2, 0.3, 1.0, 2.0, 3.0};
+  double target_pose[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 1.0};
+  double intrinsics[9] = {500.0, 500.0, 320.0, 240.0, 0.1, 0.01, 0.001, 0.001, 0.0001};
+  double point[3] = {0.1, 0.2, 0.0};
+  ParameterBlockCopies copies(0.1, 0.05, 7);
+
+  P_BLOCK extrinsics_copy = copies.extrinsics(extrinsics);
+  P_BLOCK target_pose_copy = copies.targetPose(target_pose);
+  bool extrinsics_moved = false;
+  bool target_moved = false;
+  for(int i=0; i<6; i++){
+    if(extrinsics_copy[i] != extrinsics[i]) extrinsics_moved = true;
+    if(target_pose_copy[i] != target_pose[i]) target_moved = true;
+  }
+  EXPECT_TRUE(extrinsics_moved);
+  EXPECT_TRUE(target_moved);
+
+  P_BLOCK intrinsics_copy = copies.intrinsics(intrinsics);
+  for(int i=0; i<9; i++) EXPECT_EQ(intrinsics[i], intrinsics_copy[i]);
+  P_BLOCK point_copy = copies.point(point);
+  for(int i=0; i<3; i++) EXPECT_EQ(point[i], point_copy[i]);
+
+  // a start's perturbation only depends on its seed
+  ParameterBlockCopies same_seed(0.1, 0.05, 7);
+  P_BLOCK repeated = same_seed.extrinsics(extrinsics);
+  for(int i=0; i<6; i++) EXPECT_EQ(extrinsics_copy[i], repeated[i]);
+}
+
+TEST(IndustrialExtrinsicCalMultiStartSuite, unperturbed)
+{
+  double pose[6] = {0.1, 0.2, 0.3, 1.0, 2.0, 3.0};
+  double other[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  ParameterBlockCopies copies(0.5, 0.5, 3);
+  P_BLOCK copy = copies.targetPose(pose);
+  EXPECT_EQ(copy, copies.unperturbed(pose));
+  for(int i=0; i<6; i++) EXPECT_EQ(pose[i], copy[i]);
+  EXPECT_TRUE(copies.unperturbed(other) == NULL);
+}
+
+TEST(IndustrialExtrinsicCalMultiStartSuite, keepOnlyAndCopyBack)
+{
+  double used[6] = {0.1, 0.2, 0.3, 1.0, 2.0, 3.0};
+  double dropped[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 1.0};
+  ParameterBlockCopies copies(0.0, 0.0, 1);
+  P_BLOCK used_copy = copies.extrinsics(used);
+  P_BLOCK dropped_copy = copies.targetPose(dropped);
+  for(int i=0; i<6; i++){
+    used_copy[i] = 10.0 + i;
+    dropped_copy[i] = 20.0 + i;
+  }
+
+  std::vector<double*> problem_blocks(1, used_copy);
+  copies.keepOnly(problem_blocks);
+  copies.copyBack();
+  for(int i=0; i<6; i++) EXPECT_EQ(10.0 + i, used[i]);
+  EXPECT_EQ(0.0, dropped[0]);
+  EXPECT_EQ(1.0, dropped[5]);
+  // a dropped block is no longer copied
+  EXPECT_TRUE(copies.unperturbed(dropped) == NULL);
+}
+
+TEST(IndustrialExtrinsicCalMultiStartSuite, bestStartIsCopiedBack)
+{
+  double goal[6] = {0.1, -0.2, 0.3, 0.5, -1.0, 2.0};
+  double pose[6] = {0.3, 0.0, 0.1, 0.0, 0.0, 1.5};
+  MultiStartParameters parameters = defaultMultiStartParameters();
+  parameters.num_starts = 4;
+  parameters.num_threads = 2;
+  MultiStartOptimizer optimizer(parameters);
+  ceres::Solver::Options options;
+  double best_cost = -1.0;
+  ASSERT_TRUE(optimizer.solve(boost::bind(addPoseGoal, _1, _2, pose, goal, false), options, best_cost));
+
+  ASSERT_EQ(4, (int)optimizer.startSummaries().size());
+  for(int i=0; i<4; i++) EXPECT_TRUE(optimizer.startSummaries()[i].usable);
+  EXPECT_NEAR(0.0, best_cost, 1e-12);
+  for(int i=0; i<6; i++) EXPECT_NEAR(goal[i], pose[i], 1e-6);
+}
+
+TEST(IndustrialExtrinsicCalMultiStartSuite, lowestFinalCostWins)
+{
+  // the blocks are held constant, so each start's final cost is the cost of its perturbation
+  // and only the unperturbed start 0 sits on the goal
+  double goal[6] = {0.1, -0.2, 0.3, 0.5, -1.0, 2.0};
+  double pose[6] = {0.1, -0.2, 0.3, 0.5, -1.0, 2.0};
+  MultiStartParameters parameters = defaultMultiStartParameters();
+  parameters.num_starts = 5;
+  parameters.num_threads = 3;
+  parameters.rotation_noise = 0.2;
+  parameters.translation_noise = 0.1;
+  MultiStartOptimizer optimizer(parameters);
+  ceres::Solver::Options options;
+  double best_cost = -1.0;
+  ASSERT_TRUE(optimizer.solve(boost::bind(addPoseGoal, _1, _2, pose, goal, true), options, best_cost));
+
+  EXPECT_EQ(0, optimizer.bestStart());
+  EXPECT_EQ(0.0, best_cost);
+  const std::vector<StartSummary> &starts = optimizer.startSummaries();
+  ASSERT_EQ(5, (int)starts.size());
+  for(int i=1; i<5; i++){
+    EXPECT_GT(starts[i].final_cost, best_cost);
+    EXPECT_EQ(starts[i].initial_cost, starts[i].final_cost);
+  }
+  for(int i=0; i<6; i++) EXPECT_EQ(goal[i], pose[i]);
+}
+
+// Run all the tests that were declared with TEST()
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
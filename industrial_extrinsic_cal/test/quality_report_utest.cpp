@@ -0,0 +1,170 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <math.h>
+#include <industrial_extrinsic_cal/quality_report.h>
+
+using namespace industrial_extrinsic_cal;
+
+// an image error of two coordinates of the block, weighted, relative to a goal
+struct WeightedError
+{
+  WeightedError(int first, double weight, double goal_x, double goal_y) :
+    first_(first), weight_(weight), goal_x_(goal_x), goal_y_(goal_y) {}
+
+  template<typename T>
+  bool operator()(const T* const block, T* residual) const
+  {
+    residual[0] = T(weight_)*(block[first_] - T(goal_x_));
+    residual[1] = T(weight_)*(block[first_+1] - T(goal_y_));
+    return true;
+  }
+
+  int first_;
+  double weight_;
+  double goal_x_;
+  double goal_y_;
+};
+
+ObservationResidual addError(ceres::Problem &problem, double *block, ceres::LossFunction *loss,
+			     int first, double weight, double goal_x, double goal_y,
+			     const std::string &camera_name, int scene_id)
+{
+  ObservationResidual residual;
+  residual.id = problem.AddResidualBlock(new ceres::AutoDiffCostFunction<WeightedError, 2, 6>(
+					   new WeightedError(first, weight, goal_x, goal_y)), loss, block);
+  residual.camera_name = camera_name;
+  residual.target_name = "target";
+  residual.scene_id = scene_id;
+  residual.point_id = 0;
+  return(residual);
+}
+
+ObservationDataPoint observation(const std::string &camera_name, int scene_id, double *extrinsics)
+{
+  static double intrinsics[9] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  static double target_pose[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  static double point[3] = { 0.0, 0.0, 0.0 };
+  Pose6d identity(0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+  return(ObservationDataPoint(camera_name, "target", 0, scene_id, intrinsics, extrinsics, 0, target_pose, point,
+			      0.0, 0.0, cost_functions::CameraReprjError, identity));
+}
+
+// errors of 5, 1 and 10 pixels, the first behind a robust loss which the report must not apply
+TEST(IndustrialExtrinsicCalQualityReportSuite, reprojectionStatistics)
+{
+  double block[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  ceres::Problem problem;
+  std::vector<ObservationResidual> residuals;
+  residuals.push_back(addError(problem, block, new ceres::HuberLoss(1.0), 0, 1.0, 3.0, 4.0, "camera_a", 0));
+  residuals.push_back(addError(problem, block, NULL, 2, 1.0, 0.0, 1.0, "camera_a", 1));
+  residuals.push_back(addError(problem, block, NULL, 4, 1.0, 6.0, 8.0, "camera_b", 1));
+
+  QualityParameters parameters = defaultQualityParameters();
+  parameters.compute_covariance = false;
+  QualityReport report(parameters);
+  ASSERT_TRUE(report.compute(problem, residuals));
+
+  EXPECT_EQ(3, report.overall().num_observations);
+  EXPECT_NEAR(126.0, report.overall().sum_squares, 1e-9);
+  EXPECT_NEAR(10.0, report.overall().max_error, 1e-9);
+  EXPECT_NEAR(sqrt(42.0), QualityReport::rms(report.overall()), 1e-9);
+
+  ASSERT_EQ(2, (int)report.cameras().size());
+  const ReprojectionStatistics &camera_a = report.cameras().find("camera_a")->second;
+  EXPECT_EQ(2, camera_a.num_observations);
+  EXPECT_NEAR(sqrt(13.0), QualityReport::rms(camera_a), 1e-9);
+  EXPECT_NEAR(5.0, camera_a.max_error, 1e-9);
+  EXPECT_EQ(1, report.cameras().find("camera_b")->second.num_observations);
+
+  ASSERT_EQ(2, (int)report.scenes().size());
+  EXPECT_EQ(1, report.scenes().find(0)->second.num_observations);
+  EXPECT_NEAR(25.0, report.scenes().find(0)->second.sum_squares, 1e-9);
+  EXPECT_EQ(2, report.scenes().find(1)->second.num_observations);
+  EXPECT_NEAR(10.0, report.scenes().find(1)->second.max_error, 1e-9);
+}
+
+TEST(IndustrialExtrinsicCalQualityReportSuite, emptyStatistics)
+{
+  ReprojectionStatistics statistics;
+  statistics.num_observations = 0;
+  statistics.sum_squares = 0.0;
+  statistics.max_error = 0.0;
+  EXPECT_EQ(0.0, QualityReport::rms(statistics));
+}
+
+// a camera seen in two scenes with a block per scene gets a name per block, a shared block is registered once
+TEST(IndustrialExtrinsicCalQualityReportSuite, extrinsicsNames)
+{
+  double fixed_camera[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 1.0 };
+  double scene0_camera[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 1.0 };
+  double scene1_camera[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 1.0 };
+  ObservationDataPointList observations;
+  observations.addObservationPoint(observation("fixed", 0, fixed_camera));
+  observations.addObservationPoint(observation("fixed", 1, fixed_camera));
+  observations.addObservationPoint(observation("moving", 0, scene0_camera));
+  observations.addObservationPoint(observation("moving", 1, scene1_camera));
+
+  QualityReport report(defaultQualityParameters());
+  report.addExtrinsics(observations);
+  report.addExtrinsics(observations);
+  ASSERT_EQ(3, (int)report.extrinsics().size());
+  EXPECT_EQ("fixed", report.extrinsics()[0].name);
+  EXPECT_EQ(fixed_camera, report.extrinsics()[0].block);
+  EXPECT_EQ("moving", report.extrinsics()[1].name);
+  EXPECT_EQ("moving_scene_1", report.extrinsics()[2].name);
+  EXPECT_FALSE(report.extrinsics()[2].valid);
+}
+
+// each pair of extrinsics is observed once with weight 2, so the covariance is pixel_sigma^2/4 on the diagonal
+TEST(IndustrialExtrinsicCalQualityReportSuite, extrinsicsCovariance)
+{
+  double extrinsics[6] = { 0.1, 0.2, 0.3, 0.0, 0.0, 1.0 };
+  ceres::Problem problem;
+  std::vector<ObservationResidual> residuals;
+  for(int i=0; i<6; i+=2){
+    residuals.push_back(addError(problem, extrinsics, NULL, i, 2.0, extrinsics[i], extrinsics[i+1], "camera", 0));
+  }
+  ObservationDataPointList observations;
+  observations.addObservationPoint(observation("camera", 0, extrinsics));
+
+  QualityParameters parameters = defaultQualityParameters();
+  parameters.covariance_algorithm = ceres::DENSE_SVD;
+  parameters.pixel_sigma = 3.0;
+  QualityReport report(parameters);
+  report.addExtrinsics(observations);
+  ASSERT_TRUE(report.compute(problem, residuals));
+
+  EXPECT_EQ(0.0, report.overall().max_error);
+  ASSERT_EQ(1, (int)report.extrinsics().size());
+  const ExtrinsicsCovariance &covariance = report.extrinsics()[0];
+  ASSERT_TRUE(covariance.valid);
+  for(int row=0; row<6; row++){
+    for(int col=0; col<6; col++){
+      EXPECT_NEAR(row == col ? 9.0/4.0 : 0.0, covariance.covariance[6*row + col], 1e-9);
+    }
+  }
+}
+
+// Run all the tests that were declared with TEST()
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
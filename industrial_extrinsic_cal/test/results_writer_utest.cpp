@@ -0,0 +1,212 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <industrial_extrinsic_cal/results_writer.h>
+
+using namespace industrial_extrinsic_cal;
+
+// a fresh directory per test, removed with everything left in it
+class IndustrialExtrinsicCalResultsFileSuite : public ::testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    char name[] = "/tmp/results_writer_utest.XXXXXX";
+    ASSERT_TRUE(mkdtemp(name) != NULL);
+    directory_ = name;
+  }
+
+  virtual void TearDown()
+  {
+    std::vector<std::string> names = entries();
+    for(int i=0; i<(int)names.size(); i++){
+      std::string path = directory_ + "/" + names[i];
+      if(rmdir(path.c_str()) != 0) unlink(path.c_str());
+    }
+    rmdir(directory_.c_str());
+  }
+
+  // the names in the directory, a temporary file left behind shows up here
+  std::vector<std::string> entries() const
+  {
+    std::vector<std::string> names;
+    DIR *dir = opendir(directory_.c_str());
+    if(dir == NULL) return(names);
+    struct dirent *entry;
+    while((entry = readdir(dir)) != NULL){
+      std::string name = entry->d_name;
+      if(name != "." && name != "..") names.push_back(name);
+    }
+    closedir(dir);
+    return(names);
+  }
+
+  std::string read(const std::string &file_name) const
+  {
+    std::ifstream file(file_name.c_str());
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return(contents.str());
+  }
+
+  std::string directory_;
+};
+
+TEST_F(IndustrialExtrinsicCalResultsFileSuite, writeReplacesTheFile)
+{
+  std::string file_name = directory_ + "/results.launch";
+  ASSERT_TRUE(writeFileAtomically(file_name, "old results\n"));
+  EXPECT_EQ("old results\n", read(file_name));
+  ASSERT_TRUE(writeFileAtomically(file_name, "new results\n"));
+  EXPECT_EQ("new results\n", read(file_name));
+
+  std::vector<std::string> names = entries();
+  ASSERT_EQ(1, (int)names.size());
+  EXPECT_EQ("results.launch", names[0]);
+
+  // readable by the other users, unlike the private temporary file it was made from
+  struct stat status;
+  ASSERT_EQ(0, stat(file_name.c_str(), &status));
+  EXPECT_TRUE((status.st_mode & S_IROTH) != 0);
+}
+
+TEST_F(IndustrialExtrinsicCalResultsFileSuite, missingDirectoryWritesNothing)
+{
+  std::string file_name = directory_ + "/missing/results.launch";
+  EXPECT_FALSE(writeFileAtomically(file_name, "results\n"));
+  EXPECT_TRUE(entries().empty());
+}
+
+// a directory in the way makes the rename fail, after the temporary file was written
+TEST_F(IndustrialExtrinsicCalResultsFileSuite, failedRenameLeavesNoTemporaryFile)
+{
+  std::string file_name = directory_ + "/results.launch";
+  ASSERT_EQ(0, mkdir(file_name.c_str(), S_IRWXU));
+  EXPECT_FALSE(writeFileAtomically(file_name, "results\n"));
+
+  std::vector<std::string> names = entries();
+  ASSERT_EQ(1, (int)names.size());
+  EXPECT_EQ("results.launch", names[0]);
+  struct stat status;
+  ASSERT_EQ(0, stat(file_name.c_str(), &status));
+  EXPECT_TRUE(S_ISDIR(status.st_mode));
+}
+
+TEST_F(IndustrialExtrinsicCalResultsFileSuite, writerWritesItsFormat)
+{
+  ResultsWriter writer;
+  writer.add("world", "camera", Pose6d(1.0, 2.0, 3.0, 0.0, 0.0, 0.0));
+  std::string file_name = directory_ + "/results.yaml";
+  ASSERT_TRUE(writer.write(file_name, RESULTS_YAML));
+  EXPECT_EQ(writer.format(RESULTS_YAML), read(file_name));
+}
+
+TEST(IndustrialExtrinsicCalResultsWriterSuite, string2ResultsFormat)
+{
+  ResultsFormat format = RESULTS_LAUNCH;
+  ASSERT_TRUE(string2ResultsFormat("yaml", format));
+  EXPECT_EQ(RESULTS_YAML, format);
+  ASSERT_TRUE(string2ResultsFormat("xacro", format));
+  EXPECT_EQ(RESULTS_XACRO, format);
+  ASSERT_TRUE(string2ResultsFormat("launch", format));
+  EXPECT_EQ(RESULTS_LAUNCH, format);
+  EXPECT_FALSE(string2ResultsFormat("urdf", format));
+  EXPECT_EQ(RESULTS_LAUNCH, format);
+}
+
+// a child frame added again replaces the earlier transform in its place
+TEST(IndustrialExtrinsicCalResultsWriterSuite, addReplacesAChildFrame)
+{
+  ResultsWriter writer;
+  writer.add("world", "camera", Pose6d(1.0, 0.0, 0.0, 0.0, 0.0, 0.0));
+  writer.add("world", "target", Pose6d(0.0, 1.0, 0.0, 0.0, 0.0, 0.0));
+  writer.add("table", "camera", Pose6d(0.0, 0.0, 1.0, 0.0, 0.0, 0.0));
+  ASSERT_EQ(2, (int)writer.transforms().size());
+  EXPECT_EQ("table", writer.transforms()[0].parent_frame);
+  EXPECT_EQ("camera", writer.transforms()[0].child_frame);
+  EXPECT_EQ(1.0, writer.transforms()[0].pose.z);
+  EXPECT_EQ("target", writer.transforms()[1].child_frame);
+}
+
+TEST(IndustrialExtrinsicCalResultsWriterSuite, launchFormat)
+{
+  ResultsWriter writer;
+  writer.add("world", "camera", Pose6d(1.0, 2.0, 3.0, 0.0, 0.0, 0.0));
+  EXPECT_EQ("<launch>\n"
+	    "<node pkg=\"tf\" type=\"static_transform_publisher\" name=\"camera_tf_broadcaster\" "
+	    "args=\"1 2 3 0 0 0 1 world camera 100\" />\n"
+	    "</launch>\n", writer.format(RESULTS_LAUNCH));
+}
+
+TEST(IndustrialExtrinsicCalResultsWriterSuite, yamlFormat)
+{
+  ResultsWriter writer;
+  writer.add("world", "camera", Pose6d(1.0, 2.0, 3.0, 0.0, 0.0, 0.0));
+  writer.add("camera", "target", Pose6d(0.0, 0.0, 0.5, 0.0, 0.0, 0.0));
+  EXPECT_EQ("# position (m) and quaternion x y z w of each child frame in its parent frame\n"
+	    "transforms:\n"
+	    "  - parent_frame: world\n"
+	    "    child_frame: camera\n"
+	    "    position: [1, 2, 3]\n"
+	    "    quaternion: [0, 0, 0, 1]\n"
+	    "  - parent_frame: camera\n"
+	    "    child_frame: target\n"
+	    "    position: [0, 0, 0.5]\n"
+	    "    quaternion: [0, 0, 0, 1]\n", writer.format(RESULTS_YAML));
+}
+
+// urdf's rpy are the fixed axis angles, a yaw about z comes last, a zero angle may print as -0
+TEST(IndustrialExtrinsicCalResultsWriterSuite, xacroFormat)
+{
+  ResultsWriter writer;
+  writer.add("world", "camera", Pose6d(1.0, 2.0, 3.0, 0.0, 0.0, 0.5));
+  std::string xacro = writer.format(RESULTS_XACRO);
+  std::string origin = "      <origin xyz=\"1 2 3\" rpy=\"";
+  size_t start = xacro.find(origin);
+  ASSERT_NE(std::string::npos, start);
+  EXPECT_EQ("<?xml version=\"1.0\"?>\n"
+	    "<robot xmlns:xacro=\"http://ros.org/wiki/xacro\">\n"
+	    "  <xacro:macro name=\"calibrated_transforms\">\n"
+	    "    <joint name=\"world_to_camera_joint\" type=\"fixed\">\n"
+	    "      <parent link=\"world\"/>\n"
+	    "      <child link=\"camera\"/>\n", xacro.substr(0, start));
+
+  double roll, pitch, yaw;
+  ASSERT_EQ(3, sscanf(xacro.c_str() + start + origin.size(), "%lf %lf %lf", &roll, &pitch, &yaw));
+  EXPECT_NEAR(0.0, roll, 1e-9);
+  EXPECT_NEAR(0.0, pitch, 1e-9);
+  EXPECT_NEAR(0.5, yaw, 1e-9);
+  EXPECT_NE(std::string::npos, xacro.find("\"/>\n    </joint>\n  </xacro:macro>\n</robot>\n", start));
+}
+
+// Run all the tests that were declared with TEST()
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,152 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <industrial_extrinsic_cal/sliding_window.h>
+
+using namespace industrial_extrinsic_cal;
+
+// pulls a 6 element block towards zero, so the block is part of a problem
+struct ZeroGoal
+{
+  template<typename T>
+  bool operator()(const T* const block, T* residual) const
+  {
+    for(int i=0; i<6; i++) residual[i] = block[i];
+    return true;
+  }
+};
+
+// a scene of one observation, only its scene and blocks matter to the window
+ObservationDataPointList scene(int scene_id, P_BLOCK extrinsics, P_BLOCK target_pose)
+{
+  static double intrinsics[9] = { 500.0, 500.0, 320.0, 240.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  static double point[3] = { 0.0, 0.0, 0.0 };
+  Pose6d identity(0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+  ObservationDataPointList observations;
+  observations.addObservationPoint(ObservationDataPoint("camera", "target", 0, scene_id, intrinsics, extrinsics, 0,
+							target_pose, point, 320.0, 240.0,
+							cost_functions::TargetCameraReprjError, identity));
+  return(observations);
+}
+
+std::vector<int> sceneIds(const SlidingWindow &window)
+{
+  std::vector<int> ids;
+  for(int i=0; i<(int)window.scenes().size(); i++) ids.push_back(window.scenes()[i].items_[0].scene_id_);
+  return(ids);
+}
+
+TEST(IndustrialExtrinsicCalSlidingWindowSuite, seedKeepsTheMostRecentScenes)
+{
+  double extrinsics[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  double pose[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 1.0 };
+  SlidingWindowParameters parameters = defaultSlidingWindowParameters();
+  parameters.window_scenes = 3;
+  SlidingWindow window(parameters);
+  std::vector<ObservationDataPointList> scenes;
+  for(int i=0; i<4; i++) scenes.push_back(scene(i, extrinsics, pose));
+  scenes.push_back(ObservationDataPointList()); // an empty scene takes no place in the window
+  window.seed(scenes);
+
+  std::vector<int> ids = sceneIds(window);
+  ASSERT_EQ(3, (int)ids.size());
+  EXPECT_EQ(1, ids[0]);
+  EXPECT_EQ(3, ids[2]);
+  EXPECT_EQ(0, window.numNewScenes());
+}
+
+TEST(IndustrialExtrinsicCalSlidingWindowSuite, addReplacesAndTrims)
+{
+  double extrinsics[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  double pose[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 1.0 };
+  SlidingWindowParameters parameters = defaultSlidingWindowParameters();
+  parameters.window_scenes = 3;
+  SlidingWindow window(parameters);
+  std::vector<ObservationDataPointList> scenes;
+  for(int i=0; i<3; i++) scenes.push_back(scene(i, extrinsics, pose));
+  window.seed(scenes);
+
+  // scene 1 observed again moves to the end, the oldest scene is pushed out
+  std::vector<ObservationDataPointList> new_scenes;
+  new_scenes.push_back(scene(1, extrinsics, pose));
+  new_scenes.push_back(scene(3, extrinsics, pose));
+  window.add(new_scenes);
+  std::vector<int> ids = sceneIds(window);
+  ASSERT_EQ(3, (int)ids.size());
+  EXPECT_EQ(2, ids[0]);
+  EXPECT_EQ(1, ids[1]);
+  EXPECT_EQ(3, ids[2]);
+  EXPECT_EQ(2, window.numNewScenes());
+
+  // more new scenes than the window holds, only the most recent stay, all of them new
+  new_scenes.clear();
+  for(int i=4; i<8; i++) new_scenes.push_back(scene(i, extrinsics, pose));
+  window.add(new_scenes);
+  ids = sceneIds(window);
+  ASSERT_EQ(3, (int)ids.size());
+  EXPECT_EQ(5, ids[0]);
+  EXPECT_EQ(3, window.numNewScenes());
+
+  window.clear();
+  EXPECT_TRUE(window.scenes().empty());
+  EXPECT_EQ(0, window.numNewScenes());
+}
+
+TEST(IndustrialExtrinsicCalSlidingWindowSuite, holdUnaffectedConstant)
+{
+  double old_camera[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  double new_camera[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  double anchored_pose[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 1.0 };
+  double new_pose[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 1.0 };
+  double known_pose[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 1.0 };
+  SlidingWindow window(defaultSlidingWindowParameters());
+  std::vector<ObservationDataPointList> scenes;
+  scenes.push_back(scene(0, old_camera, anchored_pose));
+  window.seed(scenes);
+
+  // the new scene sees a target an older scene constrains, one no older scene does and a known one
+  std::vector<ObservationDataPointList> new_scenes;
+  ObservationDataPointList observations = scene(1, new_camera, anchored_pose);
+  observations.addObservationPoint(scene(1, new_camera, new_pose).items_[0]);
+  observations.addObservationPoint(scene(1, new_camera, known_pose).items_[0]);
+  new_scenes.push_back(observations);
+  window.add(new_scenes);
+
+  ceres::Problem problem;
+  P_BLOCK blocks[5] = { old_camera, new_camera, anchored_pose, new_pose, known_pose };
+  for(int i=0; i<5; i++){
+    problem.AddResidualBlock(new ceres::AutoDiffCostFunction<ZeroGoal, 6, 6>(new ZeroGoal), NULL, blocks[i]);
+  }
+  problem.SetParameterBlockConstant(known_pose);
+
+  // the known target stays constant and is not one of the blocks the window frees
+  EXPECT_EQ(2, window.holdUnaffectedConstant(problem));
+  EXPECT_TRUE(problem.IsParameterBlockConstant(old_camera));
+  EXPECT_FALSE(problem.IsParameterBlockConstant(new_camera));
+  EXPECT_TRUE(problem.IsParameterBlockConstant(anchored_pose));
+  EXPECT_FALSE(problem.IsParameterBlockConstant(new_pose));
+  EXPECT_TRUE(problem.IsParameterBlockConstant(known_pose));
+}
+
+// Run all the tests that were declared with TEST()
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,148 @@
+/*
+ * Software License Agreement (Apache License)
+ *
+ * Copyright (c) 2014, Southwest Research Institute
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <math.h>
+#include <industrial_extrinsic_cal/view_planner.h>
+
+using namespace industrial_extrinsic_cal;
+
+// one camera viewing known targets, each view a 3x3 grid of known points on a target whose pose is known,
+// so the views only inform the camera's extrinsics
+class ViewPlannerTest : public ::testing::Test
+{
+protected:
+  ViewPlannerTest()
+  {
+    double intrinsics[9] = { 500.0, 500.0, 320.0, 240.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    for(int i=0; i<9; i++) intrinsics_[i] = intrinsics[i];
+    for(int i=0; i<6; i++) extrinsics_[i] = 0.0;
+    // a small target straight ahead, and one tilted, further away and larger
+    double near_pose[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 1.0 };
+    double tilted_pose[6] = { 0.5, 0.0, 0.0, 0.2, 0.0, 1.5 };
+    for(int i=0; i<6; i++){
+      near_pose_[i] = near_pose[i];
+      tilted_pose_[i] = tilted_pose[i];
+    }
+    for(int i=0; i<9; i++){
+      near_points_[i][0] = 0.05*(i%3 - 1);
+      near_points_[i][1] = 0.05*(i/3 - 1);
+      near_points_[i][2] = 0.0;
+      tilted_points_[i][0] = 0.2*(i%3 - 1);
+      tilted_points_[i][1] = 0.2*(i/3 - 1);
+      tilted_points_[i][2] = 0.0;
+    }
+    constant_blocks_.push_back(near_pose_);
+    constant_blocks_.push_back(tilted_pose_);
+  }
+
+  // observations at the projections of the current estimates, the planner only needs their jacobians
+  ObservationDataPointList view(int scene_id, P_BLOCK target_pose, double points[9][3])
+  {
+    ObservationDataPointList observations;
+    Pose6d identity(0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+    for(int i=0; i<9; i++){
+      observations.addObservationPoint(ObservationDataPoint("camera", "target", 0, scene_id, intrinsics_, extrinsics_, i,
+							    target_pose, points[i], 320.0, 240.0,
+							    cost_functions::TargetCameraReprjErrorPK, identity));
+    }
+    return(observations);
+  }
+
+  ViewPlanParameters parameters(ViewPlanCriterion criterion)
+  {
+    ViewPlanParameters parameters = defaultViewPlanParameters();
+    parameters.criterion = criterion;
+    parameters.max_views = 1;
+    parameters.max_rotation_std = 1e-9; // never met, so plan() always picks its one view
+    parameters.max_position_std = 1e-9;
+    parameters.prior_rotation_std = 1e3; // so weak that only the views count
+    parameters.prior_position_std = 1e3;
+    return(parameters);
+  }
+
+  double intrinsics_[9];
+  double extrinsics_[6];
+  double near_pose_[6];
+  double tilted_pose_[6];
+  double near_points_[9][3];
+  double tilted_points_[9][3];
+  std::vector<P_BLOCK> constant_blocks_;
+};
+
+TEST_F(ViewPlannerTest, duplicateViewHalvesTheVariance)
+{
+  ViewPlanner planner(parameters(MIN_TRACE));
+  planner.setConstantBlocks(constant_blocks_);
+  ASSERT_TRUE(planner.addView(0, view(0, near_pose_, near_points_)));
+  ASSERT_TRUE(planner.addView(1, view(1, near_pose_, near_points_)));
+  EXPECT_EQ(2, planner.numViews());
+
+  std::vector<int> views(1, 0);
+  planner.predict(views);
+  ASSERT_EQ(1, (int)planner.uncertainty().size());
+  ExtrinsicsUncertainty once = planner.uncertainty()[0];
+  EXPECT_EQ("camera", once.name);
+  EXPECT_EQ(extrinsics_, once.block);
+
+  // twice the observations is half the variance
+  views.push_back(1);
+  planner.predict(views);
+  for(int i=0; i<6; i++){
+    EXPECT_GT(once.std_dev[i], 0.0);
+    EXPECT_NEAR(once.std_dev[i]/sqrt(2.0), planner.uncertainty()[0].std_dev[i], 1e-3*once.std_dev[i]);
+  }
+}
+
+TEST_F(ViewPlannerTest, newGeometryScoresHigherThanADuplicate)
+{
+  ViewPlanCriterion criteria[2] = { MIN_TRACE, MAX_DETERMINANT };
+  for(int c=0; c<2; c++){
+    ViewPlanner planner(parameters(criteria[c]));
+    planner.setConstantBlocks(constant_blocks_);
+    ASSERT_TRUE(planner.addView(0, view(0, near_pose_, near_points_)));
+    ASSERT_TRUE(planner.addView(1, view(1, near_pose_, near_points_)));
+    ASSERT_TRUE(planner.addView(2, view(2, tilted_pose_, tilted_points_)));
+
+    std::vector<int> observed(1, 0);
+    std::vector<int> selected;
+    EXPECT_FALSE(planner.plan(observed, selected));
+    ASSERT_EQ(1, (int)selected.size()) << "criterion " << c;
+    EXPECT_EQ(2, selected[0]) << "criterion " << c;
+  }
+}
+
+TEST_F(ViewPlannerTest, planStopsOnceTheTargetIsMet)
+{
+  ViewPlanParameters loose = defaultViewPlanParameters();
+  loose.max_rotation_std = 1.0;
+  loose.max_position_std = 1.0;
+  ViewPlanner planner(loose);
+  planner.setConstantBlocks(constant_blocks_);
+  ASSERT_TRUE(planner.addView(0, view(0, near_pose_, near_points_)));
+  std::vector<int> selected;
+  EXPECT_TRUE(planner.plan(std::vector<int>(), selected));
+  EXPECT_TRUE(selected.empty()); // the prior alone meets the target
+}
+
+// Run all the tests that were declared with TEST()
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}